@@ -98,7 +98,7 @@ if(HAVE_MKOSTEMP)
 endif()
 
 # Additional SYSTEM_DEFINES
-list(APPEND SYSTEM_DEFINES -DHAS_LINUX_NETWORK)
+list(APPEND SYSTEM_DEFINES -DHAS_LINUX_NETWORK -DHAS_INOTIFY)
 
 # Code Coverage
 if(CMAKE_BUILD_TYPE STREQUAL Coverage)
@@ -174,6 +174,10 @@
 #include "platform/posix/PlatformPosix.h"
 #endif
 
+#if defined(HAS_INOTIFY)
+#include "platform/linux/LibraryChangeMonitor.h"
+#endif
+
 #if defined(TARGET_ANDROID)
 #include <androidjni/Build.h>
 #include "platform/android/activity/XBMCApp.h"
@@ -2466,6 +2470,7 @@ bool CApplication::Cleanup()
     g_localizeStrings.Clear();
     g_LangCodeExpander.Clear();
     g_charsetConverter.clear();
+    g_directoryCache.PrintStats();
     g_directoryCache.Clear();
     //CServiceBroker::GetInputManager().ClearKeymaps(); //! @todo
     CEventServer::RemoveInstance();
@@ -2594,6 +2599,10 @@ void CApplication::Stop(int exitCode)
     if (CVideoLibraryQueue::GetInstance().IsRunning())
       CVideoLibraryQueue::GetInstance().CancelAllJobs();
 
+#if defined(HAS_INOTIFY)
+    CLibraryChangeMonitor::GetInstance().Stop();
+#endif
+
     CApplicationMessenger::GetInstance().Cleanup();
 
     StopServices();
@@ -4613,6 +4622,10 @@ void CApplication::UpdateLibraries()
     CLog::LogF(LOGNOTICE, "Starting music library startup scan");
     StartMusicScan("", !settings->GetBool(CSettings::SETTING_MUSICLIBRARY_BACKGROUNDUPDATE));
   }
+
+#if defined(HAS_INOTIFY)
+  CLibraryChangeMonitor::GetInstance().Start();
+#endif
 }
 
 void CApplication::UpdateCurrentPlayArt()
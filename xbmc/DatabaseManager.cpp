@@ -7,6 +7,8 @@
  */
 
 #include "DatabaseManager.h"
+#include "dbwrappers/DatabaseStatistics.h"
+#include "dbwrappers/sqlitedataset.h"
 #include "utils/log.h"
 #include "addons/AddonDatabase.h"
 #include "view/ViewDatabase.h"
@@ -21,6 +23,12 @@
 
 using namespace PVR;
 
+namespace
+{
+// How long to wait for a pooled read connection before falling back to the caller's own
+constexpr unsigned int READ_POOL_WAIT_MS = 250;
+}
+
 CDatabaseManager::CDatabaseManager() :
   m_bIsUpgrading(false)
 {
@@ -29,7 +37,10 @@ CDatabaseManager::CDatabaseManager() :
   UpdateDatabase(db);
 }
 
-CDatabaseManager::~CDatabaseManager() = default;
+CDatabaseManager::~CDatabaseManager()
+{
+  CloseReadConnections();
+}
 
 void CDatabaseManager::Initialize()
 {
@@ -37,10 +48,17 @@ void CDatabaseManager::Initialize()
 
   m_dbStatus.clear();
 
+  // the profile and thus the database folder may have changed
+  CloseReadConnections();
+
   CLog::Log(LOGDEBUG, "%s, updating databases...", __FUNCTION__);
 
   const std::shared_ptr<CAdvancedSettings> advancedSettings = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings();
 
+  // enable statistics first so that schema updates are timed as well
+  CDatabaseStatistics::GetInstance().SetEnabled(advancedSettings->m_databaseStatistics);
+  CDatabaseStatistics::GetInstance().SetSlowQueryTime(advancedSettings->m_databaseSlowQueryTime);
+
   // NOTE: Order here is important. In particular, CTextureDatabase has to be updated
   //       before CVideoDatabase.
   { CAddonDatabase db; UpdateDatabase(db); }
@@ -199,3 +217,89 @@ void CDatabaseManager::UpdateStatus(const std::string &name, DB_STATUS status)
   CSingleLock lock(m_section);
   m_dbStatus[name] = status;
 }
+
+std::unique_ptr<dbiplus::Database> CDatabaseManager::AcquireReadConnection(const std::string &host, const std::string &name, unsigned int maxConnections)
+{
+  if (maxConnections == 0)
+    return nullptr;
+
+  const std::string key = host + name;
+  CSingleLock lock(m_poolSection);
+  m_poolStats.requests++;
+
+  bool waited = false;
+  while (m_readPools[key].idle.empty() && m_readPools[key].busy >= maxConnections)
+  {
+    if (!waited)
+    {
+      m_poolStats.waits++;
+      waited = true;
+    }
+    if (!m_poolReleased.wait(lock, READ_POOL_WAIT_MS) &&
+        m_readPools[key].idle.empty() && m_readPools[key].busy >= maxConnections)
+    {
+      m_poolStats.timeouts++;
+      return nullptr;
+    }
+  }
+
+  ReadPool &pool = m_readPools[key];
+  pool.busy++;
+  if (!pool.idle.empty())
+  {
+    std::unique_ptr<dbiplus::Database> db = std::move(pool.idle.back());
+    pool.idle.pop_back();
+    m_poolStats.hits++;
+    return db;
+  }
+  m_poolStats.opened++;
+  lock.Leave();
+
+  std::unique_ptr<dbiplus::SqliteDatabase> db(new dbiplus::SqliteDatabase());
+  db->setHostName(host.c_str());
+  db->setDatabase(name.c_str());
+  db->setReadOnly(true);
+  if (db->connect(false) != DB_CONNECTION_OK)
+  {
+    CLog::Log(LOGERROR, "%s - unable to open read-only connection to %s", __FUNCTION__, name.c_str());
+    lock.Enter();
+    m_readPools[key].busy--;
+    m_poolReleased.notifyAll();
+    return nullptr;
+  }
+  return std::move(db);
+}
+
+void CDatabaseManager::ReleaseReadConnection(const std::string &host, const std::string &name, std::unique_ptr<dbiplus::Database> db)
+{
+  const std::string key = host + name;
+  CSingleLock lock(m_poolSection);
+  auto it = m_readPools.find(key);
+  // the pool was closed while the connection was handed out, just drop it
+  if (it == m_readPools.end() || it->second.busy == 0)
+    return;
+
+  it->second.busy--;
+  if (db && db->isActive())
+    it->second.idle.push_back(std::move(db));
+  m_poolReleased.notifyAll();
+}
+
+CDatabaseManager::ReadPoolStats CDatabaseManager::GetReadPoolStats() const
+{
+  CSingleLock lock(m_poolSection);
+  ReadPoolStats stats = m_poolStats;
+  for (const auto &pool : m_readPools)
+  {
+    stats.idle += pool.second.idle.size();
+    stats.busy += pool.second.busy;
+  }
+  return stats;
+}
+
+void CDatabaseManager::CloseReadConnections()
+{
+  CSingleLock lock(m_poolSection);
+  m_readPools.clear();
+  m_poolReleased.notifyAll();
+}
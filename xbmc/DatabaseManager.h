@@ -10,12 +10,21 @@
 
 #include <atomic>
 #include <map>
+#include <memory>
+#include <stdint.h>
 #include <string>
+#include <vector>
+#include "threads/Condition.h"
 #include "threads/CriticalSection.h"
 
 class CDatabase;
 class DatabaseSettings;
 
+namespace dbiplus
+{
+  class Database;
+}
+
 /*!
  \ingroup database
  \brief Database manager class for handling database updating
@@ -50,6 +59,38 @@ public:
 
   bool IsUpgrading() const { return m_bIsUpgrading; }
 
+  /*! \brief Statistics of the shared read-only connection pool.
+   */
+  struct ReadPoolStats
+  {
+    uint64_t requests = 0; ///< number of connections requested
+    uint64_t hits = 0;     ///< requests served by an idle pooled connection
+    uint64_t opened = 0;   ///< requests that opened a new connection
+    uint64_t waits = 0;    ///< requests that had to wait for a connection to be released
+    uint64_t timeouts = 0; ///< requests that gave up waiting
+    unsigned int idle = 0; ///< connections currently idle in the pool
+    unsigned int busy = 0; ///< connections currently handed out
+  };
+
+  /*! \brief Get a read-only connection to a sqlite database from the shared pool.
+
+   At most maxConnections connections are open per database. If all are in use, waits
+   a short while for one to be released before giving up.
+
+   \param host the folder holding the database.
+   \param name the database file name.
+   \param maxConnections the maximum number of connections to keep open for this database.
+   \return a connected read-only database, or nullptr if none is available.
+   \sa ReleaseReadConnection
+   */
+  std::unique_ptr<dbiplus::Database> AcquireReadConnection(const std::string &host, const std::string &name, unsigned int maxConnections);
+
+  /*! \brief Hand a connection obtained from AcquireReadConnection() back to the pool.
+   */
+  void ReleaseReadConnection(const std::string &host, const std::string &name, std::unique_ptr<dbiplus::Database> db);
+
+  ReadPoolStats GetReadPoolStats() const;
+
 private:
   std::atomic<bool> m_bIsUpgrading;
 
@@ -61,4 +102,16 @@ private:
 
   CCriticalSection            m_section;     ///< Critical section protecting m_dbStatus.
   std::map<std::string, DB_STATUS> m_dbStatus;    ///< Our database status map.
+
+  struct ReadPool
+  {
+    std::vector<std::unique_ptr<dbiplus::Database>> idle;
+    unsigned int busy = 0;
+  };
+  void CloseReadConnections();
+
+  mutable CCriticalSection m_poolSection; ///< Critical section protecting m_readPools and m_poolStats.
+  XbmcThreads::ConditionVariable m_poolReleased;
+  std::map<std::string, ReadPool> m_readPools; ///< Read-only connections keyed by database path.
+  ReadPoolStats m_poolStats;
 };
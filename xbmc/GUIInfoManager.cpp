@@ -860,6 +860,30 @@ const infomap player_times[] =   {{ "seektime",         PLAYER_SEEKTIME },
 ///     @skinning_v17 **[New Infolabel]** \link Player_Process_videodar `Player.Process(videodar)`\endlink
 ///     <p>
 ///   }
+///   \table_row3{   <b>`Player.Process(videodecodethreads)`</b>,
+///                  \anchor Player_Process_videodecodethreads
+///                  _string_,
+///     @return The threading of the video decoder, e.g. "frame x12", "slice x8" or "none".
+///     <p><hr>
+///     @skinning_v18 **[New Infolabel]** \link Player_Process_videodecodethreads `Player.Process(videodecodethreads)`\endlink
+///     <p>
+///   }
+///   \table_row3{   <b>`Player.Process(videodecodetime)`</b>,
+///                  \anchor Player_Process_videodecodetime
+///                  _string_,
+///     @return The average time in ms the video decoder needed per frame.
+///     <p><hr>
+///     @skinning_v18 **[New Infolabel]** \link Player_Process_videodecodetime `Player.Process(videodecodetime)`\endlink
+///     <p>
+///   }
+///   \table_row3{   <b>`Player.Process(videodecodehistogram)`</b>,
+///                  \anchor Player_Process_videodecodehistogram
+///                  _string_,
+///     @return The share of frames in percent per decode time in ms, e.g. "<1:0 <2:5 <4:60 ... >64:0".
+///     <p><hr>
+///     @skinning_v18 **[New Infolabel]** \link Player_Process_videodecodehistogram `Player.Process(videodecodehistogram)`\endlink
+///     <p>
+///   }
 ///   \table_row3{   <b>`Player.Process(audiodecoder)`</b>,
 ///                  \anchor Player_Process_audiodecoder
 ///                  _string_,
@@ -905,6 +929,9 @@ const infomap player_process[] =
   { "videoheight", PLAYER_PROCESS_VIDEOHEIGHT },
   { "videofps", PLAYER_PROCESS_VIDEOFPS },
   { "videodar", PLAYER_PROCESS_VIDEODAR },
+  { "videodecodethreads", PLAYER_PROCESS_VIDEODECODETHREADS },
+  { "videodecodetime", PLAYER_PROCESS_VIDEODECODETIME },
+  { "videodecodehistogram", PLAYER_PROCESS_VIDEODECODEHISTOGRAM },
   { "videohwdecoder", PLAYER_PROCESS_VIDEOHWDECODER },
   { "audiodecoder", PLAYER_PROCESS_AUDIODECODER },
   { "audiochannels", PLAYER_PROCESS_AUDIOCHANNELS },
@@ -1883,7 +1883,8 @@ void CUtil::GetItemsToScan(const std::string& videoPath,
                            const std::vector<std::string>& sub_dirs,
                            CFileItemList& items)
 {
-  int flags = DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_NO_FILE_INFO;
+  // the items are only read, so they can be shared with the directory cache
+  int flags = DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_NO_FILE_INFO | DIR_FLAG_SHARED_ITEMS;
 
   if (!videoPath.empty())
     CDirectory::GetDirectory(videoPath, items, item_exts, flags);
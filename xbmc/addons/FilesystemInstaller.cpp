@@ -8,9 +8,11 @@
 #include "FilesystemInstaller.h"
 #include "FileItem.h"
 #include "filesystem/Directory.h"
+#include "filesystem/File.h"
 #include "filesystem/SpecialProtocol.h"
+#include "filesystem/ZipManager.h"
+#include "URL.h"
 #include "utils/log.h"
-#include "utils/FileOperationJob.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
 
@@ -97,9 +99,9 @@ bool CFilesystemInstaller::UnpackArchive(std::string path, const std::string& de
   }
   CLog::Log(LOGDEBUG, "Unpacking %s to %s", path.c_str(), dest.c_str());
 
-  for (auto i = 0; i < files.Size(); ++i)
-    files[i]->Select(true);
-
-  CFileOperationJob job(CFileOperationJob::ActionCopy, files, dest);
-  return job.DoWork();
+  // extract straight from the archive, several files at once
+  const CURL url(path);
+  std::string destPath = dest;
+  URIUtils::AddSlashAtEnd(destPath);
+  return g_ZipManager.ExtractArchive(CURL(url.GetHostName()), destPath, url.GetFileName());
 }
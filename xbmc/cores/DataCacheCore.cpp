@@ -173,6 +173,34 @@ float CDataCacheCore::GetVideoDAR()
   return m_playerVideoInfo.dar;
 }
 
+void CDataCacheCore::SetVideoDecodeThreads(std::string threads)
+{
+  CSingleLock lock(m_videoPlayerSection);
+
+  m_playerVideoInfo.decodeThreads = threads;
+}
+
+std::string CDataCacheCore::GetVideoDecodeThreads()
+{
+  CSingleLock lock(m_videoPlayerSection);
+
+  return m_playerVideoInfo.decodeThreads;
+}
+
+void CDataCacheCore::SetVideoDecodeTimes(const CDecodeTimes& times)
+{
+  CSingleLock lock(m_videoPlayerSection);
+
+  m_playerVideoInfo.decodeTimes = times;
+}
+
+CDecodeTimes CDataCacheCore::GetVideoDecodeTimes()
+{
+  CSingleLock lock(m_videoPlayerSection);
+
+  return m_playerVideoInfo.decodeTimes;
+}
+
 // player audio info
 void CDataCacheCore::SetAudioDecoderName(std::string name)
 {
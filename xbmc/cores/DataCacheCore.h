@@ -10,6 +10,7 @@
 
 #include <atomic>
 #include <string>
+#include "cores/DecodeTimes.h"
 #include "threads/CriticalSection.h"
 
 class CDataCacheCore
@@ -40,6 +41,10 @@ public:
   float GetVideoFps();
   void SetVideoDAR(float dar);
   float GetVideoDAR();
+  void SetVideoDecodeThreads(std::string threads);
+  std::string GetVideoDecodeThreads();
+  void SetVideoDecodeTimes(const CDecodeTimes& times);
+  CDecodeTimes GetVideoDecodeTimes();
 
   // player audio info
   void SetAudioDecoderName(std::string name);
@@ -127,6 +132,8 @@ protected:
     int height;
     float fps;
     float dar;
+    std::string decodeThreads;
+    CDecodeTimes decodeTimes;
   } m_playerVideoInfo;
 
   CCriticalSection m_audioPlayerSection;
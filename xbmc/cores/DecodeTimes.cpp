@@ -0,0 +1,57 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "DecodeTimes.h"
+
+#include "utils/StringUtils.h"
+
+void CDecodeTimes::Add(int64_t us)
+{
+  if (us < 0)
+    us = 0;
+
+  int bucket = 0;
+  for (int64_t limit = 1000; bucket < BUCKETS - 1 && us >= limit; limit *= 2)
+    bucket++;
+
+  m_buckets[bucket]++;
+  m_count++;
+  m_total += us;
+  if (us > m_max)
+    m_max = us;
+}
+
+void CDecodeTimes::Reset()
+{
+  *this = CDecodeTimes();
+}
+
+double CDecodeTimes::GetAverageMs() const
+{
+  if (m_count == 0)
+    return 0.0;
+
+  return m_total / 1000.0 / m_count;
+}
+
+std::string CDecodeTimes::ToString() const
+{
+  std::string result;
+  for (int i = 0; i < BUCKETS; i++)
+  {
+    if (!result.empty())
+      result += " ";
+
+    const int percent = m_count ? static_cast<int>((m_buckets[i] * UINT64_C(100) + m_count / 2) / m_count) : 0;
+    if (i < BUCKETS - 1)
+      result += StringUtils::Format("<%d:%d", 1 << i, percent);
+    else
+      result += StringUtils::Format(">%d:%d", 1 << (i - 1), percent);
+  }
+  return result;
+}
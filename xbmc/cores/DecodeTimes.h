@@ -0,0 +1,45 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+/*!
+ \brief Histogram of the time a decoder spent per frame.
+
+ Bucket 0 counts frames below 1 ms, bucket n frames from 2^(n-1) up to 2^n ms
+ and the last bucket everything above. With frame threading the time is the
+ time the player thread waited for the decoder, which is what decides whether
+ the decoder keeps up.
+ */
+class CDecodeTimes
+{
+public:
+  static const int BUCKETS = 8;
+
+  void Add(int64_t us);
+  void Reset();
+
+  unsigned int GetCount() const { return m_count; }
+  unsigned int GetBucket(int bucket) const { return m_buckets[bucket]; }
+  double GetAverageMs() const;
+  double GetMaxMs() const { return m_max / 1000.0; }
+
+  /*!
+   \brief Share of the frames per bucket in percent, e.g. "<1:0 <2:5 <4:60 ..."
+   */
+  std::string ToString() const;
+
+private:
+  unsigned int m_buckets[BUCKETS] = {};
+  unsigned int m_count = 0;
+  int64_t m_total = 0;
+  int64_t m_max = 0;
+};
@@ -21,6 +21,7 @@
 #include "utils/log.h"
 #include "cores/VideoPlayer/VideoRenderers/RenderManager.h"
 #include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
 #include <memory>
 
 extern "C" {
@@ -364,12 +365,8 @@ bool CDVDVideoCodecFFmpeg::Open(CDVDStreamInfo &hints, CDVDCodecOptions &options
     }
     else
     {
-      int num_threads = g_cpuInfo.getCPUCount() * 3 / 2;
-      num_threads = std::max(1, std::min(num_threads, 16));
-      m_pCodecContext->thread_count = num_threads;
-      m_pCodecContext->thread_safe_callbacks = 1;
+      SetupThreading(hints);
       m_decoderState = STATE_SW_MULTI;
-      CLog::Log(LOGDEBUG, "CDVDVideoCodecFFmpeg - open frame threaded with %d threads", num_threads);
     }
   }
   else
@@ -433,15 +430,91 @@ bool CDVDVideoCodecFFmpeg::Open(CDVDStreamInfo &hints, CDVDCodecOptions &options
   }
 
   UpdateName();
+  UpdateThreadInfo();
   const char* pixFmtName = av_get_pix_fmt_name(m_pCodecContext->pix_fmt);
   m_processInfo.SetVideoDimensions(m_pCodecContext->coded_width, m_pCodecContext->coded_height);
   m_processInfo.SetVideoPixelFormat(pixFmtName ? pixFmtName : "");
 
   m_dropCtrl.Reset(true);
   m_eof = false;
+  m_decodeTimes.Reset();
+  m_decodeTime = 0;
+  m_processInfo.SetVideoDecodeTimes(m_decodeTimes);
   return true;
 }
 
+void CDVDVideoCodecFFmpeg::SetupThreading(const CDVDStreamInfo &hints)
+{
+  const std::shared_ptr<CAdvancedSettings> advancedSettings = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings();
+  const int cpuCount = g_cpuInfo.getCPUCount();
+
+  // ffmpeg prefers frame threading if the codec has it, every frame thread
+  // delays the output by one frame though
+  int threadType = FF_THREAD_FRAME | FF_THREAD_SLICE;
+  if (advancedSettings->m_videoDecodeLowLatency && hints.realtime)
+    threadType = FF_THREAD_SLICE;
+  else if (advancedSettings->m_videoDecodeThreadType == "frame")
+    threadType = FF_THREAD_FRAME;
+  else if (advancedSettings->m_videoDecodeThreadType == "slice")
+    threadType = FF_THREAD_SLICE;
+
+  int numThreads = advancedSettings->m_videoDecodeThreads;
+  if (numThreads <= 0)
+  {
+    const int pixels = hints.width * hints.height;
+    if (threadType == FF_THREAD_SLICE)
+    {
+      numThreads = cpuCount;
+    }
+    else if (pixels > 0 && pixels <= 720 * 576)
+    {
+      // sd is decoded fast enough, more threads only add latency
+      numThreads = std::min(cpuCount, 4);
+    }
+    else if (pixels > 1920 * 1088 &&
+             (hints.codec == AV_CODEC_ID_HEVC || hints.codec == AV_CODEC_ID_VP9))
+    {
+      // frames wait for rows of their references, more frames in flight
+      // keep all cores busy
+      numThreads = cpuCount * 2;
+    }
+    else
+    {
+      numThreads = cpuCount * 3 / 2;
+    }
+    numThreads = std::max(1, std::min(numThreads, 16));
+  }
+
+  m_pCodecContext->thread_count = numThreads;
+  m_pCodecContext->thread_type = threadType;
+  m_pCodecContext->thread_safe_callbacks = 1;
+}
+
+void CDVDVideoCodecFFmpeg::UpdateThreadInfo()
+{
+  std::string threads;
+  if (m_pCodecContext->active_thread_type & FF_THREAD_FRAME)
+    threads = StringUtils::Format("frame x%d", m_pCodecContext->thread_count);
+  else if (m_pCodecContext->active_thread_type & FF_THREAD_SLICE)
+    threads = StringUtils::Format("slice x%d", m_pCodecContext->thread_count);
+  else
+    threads = "none";
+
+  m_processInfo.SetVideoDecodeThreads(threads);
+
+  CLog::Log(LOGDEBUG, "CDVDVideoCodecFFmpeg - decoding threads: %s", threads.c_str());
+}
+
+void CDVDVideoCodecFFmpeg::UpdateDecodeTimes()
+{
+  m_decodeTimes.Add(m_decodeTime * 1000000 / CurrentHostFrequency());
+  m_decodeTime = 0;
+
+  // about once a second
+  if (m_decodeTimes.GetCount() % 32 == 0)
+    m_processInfo.SetVideoDecodeTimes(m_decodeTimes);
+}
+
 void CDVDVideoCodecFFmpeg::Dispose()
 {
   av_frame_free(&m_pFrame);
@@ -565,7 +638,9 @@ bool CDVDVideoCodecFFmpeg::AddData(const DemuxPacket &packet)
   avpkt.side_data = static_cast<AVPacketSideData*>(packet.pSideData);
   avpkt.side_data_elems = packet.iSideDataElems;
 
+  const int64_t start = CurrentHostCounter();
   int ret = avcodec_send_packet(m_pCodecContext, &avpkt);
+  m_decodeTime += CurrentHostCounter() - start;
 
   // try again
   if (ret == AVERROR(EAGAIN))
@@ -642,6 +717,7 @@ CDVDVideoCodec::VCReturn CDVDVideoCodecFFmpeg::GetPicture(VideoPicture* pVideoPi
   }
 
   // process ffmpeg
+  const int64_t start = CurrentHostCounter();
   if (m_codecControlFlags & DVD_CODEC_CTRL_DRAIN)
   {
     AVPacket avpkt;
@@ -654,6 +730,7 @@ CDVDVideoCodec::VCReturn CDVDVideoCodecFFmpeg::GetPicture(VideoPicture* pVideoPi
   }
 
   int ret = avcodec_receive_frame(m_pCodecContext, m_pDecodedFrame);
+  m_decodeTime += CurrentHostCounter() - start;
 
   if (m_decoderState == STATE_HW_FAILED && !m_pHardware)
     return VC_REOPEN;
@@ -719,6 +796,8 @@ CDVDVideoCodec::VCReturn CDVDVideoCodecFFmpeg::GetPicture(VideoPicture* pVideoPi
   }
 
   // here we got a frame
+  UpdateDecodeTimes();
+
   int64_t framePTS = m_pDecodedFrame->best_effort_timestamp;
 
   if (m_pCodecContext->skip_frame > AVDISCARD_DEFAULT)
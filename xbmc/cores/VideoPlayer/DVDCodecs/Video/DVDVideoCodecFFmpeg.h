@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include "cores/DecodeTimes.h"
 #include "cores/VideoPlayer/DVDCodecs/DVDCodecs.h"
 #include "cores/VideoPlayer/DVDStreamInfo.h"
 #include "DVDVideoCodec.h"
@@ -54,6 +55,9 @@ protected:
   CDVDVideoCodec::VCReturn FilterProcess(AVFrame* frame);
   void SetFilters();
   void UpdateName();
+  void SetupThreading(const CDVDStreamInfo &hints);
+  void UpdateThreadInfo();
+  void UpdateDecodeTimes();
   bool SetPictureParams(VideoPicture* pVideoPicture);
 
   bool HasHardware() { return m_pHardware != nullptr; };
@@ -98,6 +102,8 @@ protected:
   double m_DAR = 1.0;
   CDVDStreamInfo m_hints;
   CDVDCodecOptions m_options;
+  CDecodeTimes m_decodeTimes;
+  int64_t m_decodeTime = 0; ///< time spent in ffmpeg since the last frame, in host counter ticks
 
   struct CDropControl
   {
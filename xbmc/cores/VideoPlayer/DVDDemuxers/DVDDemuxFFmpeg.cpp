@@ -206,7 +206,8 @@ bool CDVDDemuxFFmpeg::Open(std::shared_ptr<CDVDInputStream> pInput, bool fileinf
 {
   AVInputFormat* iformat = NULL;
   std::string strFile;
-  m_streaminfo = !pInput->IsRealtime() && !m_reopen;
+  const bool reopen = m_reopen;
+  m_streaminfo = !pInput->IsRealtime() && !reopen;
   m_reopen = false;
   m_currentPts = DVD_NOPTS_VALUE;
   m_speed = DVD_PLAYSPEED_NORMAL;
@@ -482,14 +483,82 @@ bool CDVDDemuxFFmpeg::Open(std::shared_ptr<CDVDInputStream> pInput, bool fileinf
   m_bAVI = strcmp(m_pFormatContext->iformat->name, "avi") == 0;
   m_bSup = strcmp(m_pFormatContext->iformat->name, "sup") == 0;
 
+  // look up what probing found out about this input before, the transport
+  // stream pass reopens with the entry found by the first one
+  const std::shared_ptr<CAdvancedSettings> advancedSettings = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings();
+  if (!reopen)
+  {
+    m_probeKey.clear();
+    m_probeInfo.reset();
+    m_probeStored = false;
+    if (advancedSettings->m_videoProbeCache &&
+        CDemuxProbeCache::GetKey(*m_pInput, m_probeKey, m_probeSize, m_probeMtime))
+      m_probeInfo = CDemuxProbeCache::GetInstance().Get(m_probeKey, m_probeSize, m_probeMtime);
+  }
+  m_fastStart = m_probeInfo && m_pInput->IsRealtime() && advancedSettings->m_videoLiveFastStart;
+
+  bool probeSkipped = false;
+  bool probeShortened = false;
+  if (m_streaminfo && m_probeInfo)
+  {
+    if (m_checkTransportStream)
+    {
+      // streams are created when the program shows up in the reopened
+      // stream, the first pass is only needed for the duration
+      CLog::Log(LOGDEBUG, "%s - skipping first pass, using cached stream info", __FUNCTION__);
+      m_streaminfo = false;
+      m_probeStored = true;
+      if (m_pFormatContext->duration == AV_NOPTS_VALUE)
+        m_pFormatContext->duration = m_probeInfo->duration;
+    }
+    else if (!(m_pFormatContext->ctx_flags & AVFMTCTX_NOHEADER) &&
+             CDemuxProbeCache::Matches(*m_probeInfo, m_pFormatContext))
+    {
+      // the header lists the same streams as last time
+      CLog::Log(LOGDEBUG, "%s - skipping avformat_find_stream_info, using cached stream info", __FUNCTION__);
+      CDemuxProbeCache::Apply(*m_probeInfo, m_pFormatContext);
+      probeSkipped = true;
+      m_probeStored = true;
+    }
+    else
+    {
+      // streams may still show up, but there is no need to look for long
+      av_opt_set_int(m_pFormatContext, "analyzeduration", 500000, 0);
+      probeShortened = true;
+    }
+  }
+  else if (m_streaminfo && m_pInput->IsRealtime() && advancedSettings->m_videoLiveFastStart)
+  {
+    av_opt_set_int(m_pFormatContext, "analyzeduration", 500000, 0);
+  }
+
   if (m_streaminfo)
   {
     /* to speed up dvd switches, only analyse very short */
     if(m_pInput->IsStreamType(DVDSTREAM_TYPE_DVD))
       av_opt_set_int(m_pFormatContext, "analyzeduration", 500000, 0);
 
-    CLog::Log(LOGDEBUG, "%s - avformat_find_stream_info starting", __FUNCTION__);
-    int iErr = avformat_find_stream_info(m_pFormatContext, NULL);
+    int iErr = 0;
+    if (!probeSkipped)
+    {
+      CLog::Log(LOGDEBUG, "%s - avformat_find_stream_info starting", __FUNCTION__);
+      iErr = avformat_find_stream_info(m_pFormatContext, NULL);
+    }
+    if (iErr >= 0 && !m_probeKey.empty() && !m_probeStored)
+    {
+      if (!probeShortened)
+        CDemuxProbeCache::GetInstance().Set(m_probeKey, m_pFormatContext, m_probeSize, m_probeMtime);
+      else if (CDemuxProbeCache::Matches(*m_probeInfo, m_pFormatContext))
+        CDemuxProbeCache::Apply(*m_probeInfo, m_pFormatContext);
+      else
+      {
+        // the layout changed, the short probing may have missed streams,
+        // probe fully next time
+        CDemuxProbeCache::GetInstance().Remove(m_probeKey);
+        m_probeInfo.reset();
+      }
+      m_probeStored = true;
+    }
     if (iErr < 0)
     {
       CLog::Log(LOGWARNING,"could not find codec parameters for %s", CURL::GetRedacted(strFile).c_str());
@@ -1002,6 +1071,14 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
 
       if (IsTransportStreamReady())
       {
+        // live tv is never probed, remember the streams once they are complete
+        if (!m_probeStored && !m_probeKey.empty() && m_checkTransportStream)
+        {
+          if (!m_probeInfo || !CDemuxProbeCache::Matches(*m_probeInfo, m_pFormatContext))
+            CDemuxProbeCache::GetInstance().Set(m_probeKey, m_pFormatContext, m_probeSize, m_probeMtime);
+          m_probeStored = true;
+        }
+
         if (m_program != UINT_MAX)
         {
           /* check so packet belongs to selected program */
@@ -1009,7 +1086,7 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
           {
             if(m_pkt.pkt.stream_index == (int)m_pFormatContext->programs[m_program]->stream_index[i])
             {
-              pPacket = CDVDDemuxUtils::AllocateDemuxPacket(m_pkt.pkt.size);
+              pPacket = CDVDDemuxUtils::AllocateDemuxPacket(m_pkt.pkt);
               break;
             }
           }
@@ -1018,7 +1095,7 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
             bReturnEmpty = true;
         }
         else
-          pPacket = CDVDDemuxUtils::AllocateDemuxPacket(m_pkt.pkt.size);
+          pPacket = CDVDDemuxUtils::AllocateDemuxPacket(m_pkt.pkt);
       }
       else
         bReturnEmpty = true;
@@ -1032,13 +1109,6 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
           m_pkt.pkt.pts = AV_NOPTS_VALUE;
         }
 
-        // copy contents into our own packet
-        pPacket->iSize = m_pkt.pkt.size;
-
-        // maybe we can avoid a memcpy here by detecting where pkt.destruct is pointing too?
-        if (m_pkt.pkt.data)
-          memcpy(pPacket->pData, m_pkt.pkt.data, pPacket->iSize);
-
         pPacket->pts = ConvertTimestamp(m_pkt.pkt.pts, stream->time_base.den, stream->time_base.num);
         pPacket->dts = ConvertTimestamp(m_pkt.pkt.dts, stream->time_base.den, stream->time_base.num);
         pPacket->duration =  DVD_SEC_TO_TIME((double)m_pkt.pkt.duration * stream->time_base.num / stream->time_base.den);
@@ -2068,6 +2138,13 @@ void CDVDDemuxFFmpeg::ParsePacket(AVPacket *pkt)
 {
   AVStream *st = m_pFormatContext->streams[pkt->stream_index];
 
+  // don't wait for the parameters of live tv to show up in the stream
+  if (m_fastStart && m_probeInfo && st && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && !st->codecpar->extradata)
+  {
+    if (CDemuxProbeCache::Apply(*m_probeInfo, st) && st->codecpar->extradata)
+      CLog::Log(LOGDEBUG, "CDVDDemuxFFmpeg::ParsePacket() using cached parameters of stream %d", st->index);
+  }
+
   if (st && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
   {
     auto parser = m_parsers.find(st->index);
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "DVDDemux.h"
+#include "DemuxProbeCache.h"
 #include "threads/CriticalSection.h"
 #include "threads/SystemClock.h"
 #include <map>
@@ -175,5 +176,13 @@ protected:
   double m_dtsAtDisplayTime;
   bool m_seekToKeyFrame = false;
   double m_startTime = 0;
+
+  // stream info of the previous probing of the input, see CDemuxProbeCache
+  std::string m_probeKey;
+  int64_t m_probeSize = 0;
+  int64_t m_probeMtime = 0;
+  std::shared_ptr<const CDemuxProbeCache::SProbeInfo> m_probeInfo;
+  bool m_probeStored = false;
+  bool m_fastStart = false; ///< streams of live tv are completed from the cache
 };
 
@@ -8,22 +8,145 @@
 
 #include "DVDDemuxUtils.h"
 #include "cores/VideoPlayer/Interface/Addon/DemuxCrypto.h"
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
 #include "utils/log.h"
 
 #ifdef TARGET_POSIX
 #include "platform/linux/XMemUtils.h"
 #endif
 
+#include <array>
+#include <atomic>
+#include <new>
+#include <vector>
+
 extern "C" {
 #include <libavcodec/avcodec.h>
 }
 
+namespace
+{
+
+/*!
+ Every packet is allocated in one block: this header, the DemuxPacket and its
+ payload, each aligned to 16 bytes. Free blocks are kept in a pool per size
+ class of the payload, so the demuxer doesn't allocate memory for every packet.
+ */
+struct SPacketHeader
+{
+  unsigned int sizeClass;
+  AVBufferRef* buffer; ///< payload shared with ffmpeg, if any
+};
+
+constexpr size_t ALIGNMENT = 16;
+constexpr size_t Align(size_t size) { return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+constexpr size_t HEADER_SIZE = Align(sizeof(SPacketHeader));
+constexpr size_t PACKET_SIZE = Align(sizeof(DemuxPacket));
+
+// class 0 holds packets without payload, class n payloads of up to 128 << n
+// bytes, i.e. 256 bytes to 1 MiB. Larger payloads aren't pooled.
+constexpr unsigned int SIZE_CLASSES = 14;
+constexpr unsigned int UNPOOLED = SIZE_CLASSES;
+constexpr size_t POOL_MAX_BYTES = 16 * 1024 * 1024;
+
+unsigned int GetSizeClass(size_t size)
+{
+  if (size == 0)
+    return 0;
+  for (unsigned int sizeClass = 1; sizeClass < SIZE_CLASSES; sizeClass++)
+  {
+    if (size <= (static_cast<size_t>(128) << sizeClass))
+      return sizeClass;
+  }
+  return UNPOOLED;
+}
+
+size_t GetBlockSize(unsigned int sizeClass, size_t size)
+{
+  if (sizeClass == 0)
+    return HEADER_SIZE + PACKET_SIZE;
+  if (sizeClass != UNPOOLED)
+    size = static_cast<size_t>(128) << sizeClass;
+  return HEADER_SIZE + PACKET_SIZE + size + AV_INPUT_BUFFER_PADDING_SIZE;
+}
+
+SPacketHeader* GetHeader(DemuxPacket* pPacket)
+{
+  return reinterpret_cast<SPacketHeader*>(reinterpret_cast<uint8_t*>(pPacket) - HEADER_SIZE);
+}
+
+class CPacketPool
+{
+public:
+  static CPacketPool& GetInstance()
+  {
+    static CPacketPool pool;
+    return pool;
+  }
+
+  ~CPacketPool()
+  {
+    for (SSizeClass& sizeClass : m_classes)
+    {
+      for (void* block : sizeClass.blocks)
+        _aligned_free(block);
+    }
+  }
+
+  void* Get(unsigned int sizeClass)
+  {
+    if (sizeClass == UNPOOLED)
+      return nullptr;
+
+    SSizeClass& pool = m_classes[sizeClass];
+    CSingleLock lock(pool.lock);
+    if (pool.blocks.empty())
+      return nullptr;
+
+    void* block = pool.blocks.back();
+    pool.blocks.pop_back();
+    m_bytes -= GetBlockSize(sizeClass, 0);
+    return block;
+  }
+
+  bool Put(unsigned int sizeClass, void* block)
+  {
+    if (sizeClass == UNPOOLED)
+      return false;
+
+    // keep the pool from holding on to the peak usage forever, the bytes are
+    // reserved first so concurrent frees can't overshoot the limit together
+    const size_t size = GetBlockSize(sizeClass, 0);
+    if (m_bytes.fetch_add(size) + size > POOL_MAX_BYTES)
+    {
+      m_bytes -= size;
+      return false;
+    }
+
+    SSizeClass& pool = m_classes[sizeClass];
+    CSingleLock lock(pool.lock);
+    pool.blocks.push_back(block);
+    return true;
+  }
+
+private:
+  struct SSizeClass
+  {
+    CCriticalSection lock;
+    std::vector<void*> blocks;
+  };
+
+  std::array<SSizeClass, SIZE_CLASSES> m_classes;
+  std::atomic<size_t> m_bytes{0};
+};
+
+} // unnamed namespace
+
 void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 {
   if (pPacket)
   {
-    if (pPacket->pData)
-      _aligned_free(pPacket->pData);
     if (pPacket->iSideDataElems)
     {
       AVPacket avPkt;
@@ -32,13 +155,32 @@ void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
       avPkt.side_data_elems = pPacket->iSideDataElems;
       av_packet_free_side_data(&avPkt);
     }
-    delete pPacket;
+
+    SPacketHeader* header = GetHeader(pPacket);
+    if (header->buffer)
+      av_buffer_unref(&header->buffer);
+    pPacket->~DemuxPacket();
+
+    if (!CPacketPool::GetInstance().Put(header->sizeClass, header))
+      _aligned_free(header);
   }
 }
 
 DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
 {
-  DemuxPacket* pPacket = new DemuxPacket();
+  const size_t size = iDataSize > 0 ? iDataSize : 0;
+  const unsigned int sizeClass = GetSizeClass(size);
+
+  uint8_t* block = static_cast<uint8_t*>(CPacketPool::GetInstance().Get(sizeClass));
+  if (!block)
+  {
+    block = static_cast<uint8_t*>(_aligned_malloc(GetBlockSize(sizeClass, size), ALIGNMENT));
+    if (!block)
+      return NULL;
+  }
+
+  new (block) SPacketHeader{sizeClass, nullptr};
+  DemuxPacket* pPacket = new (block + HEADER_SIZE) DemuxPacket();
 
   if (iDataSize > 0)
   {
@@ -51,12 +193,7 @@ DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
      * Note, if the first 23 bits of the additional bytes are not 0 then damaged
      * MPEG bitstreams could cause overread and segfault
      */
-    pPacket->pData =(uint8_t*)_aligned_malloc(iDataSize + AV_INPUT_BUFFER_PADDING_SIZE, 16);
-    if (!pPacket->pData)
-    {
-      FreeDemuxPacket(pPacket);
-      return NULL;
-    }
+    pPacket->pData = block + HEADER_SIZE + PACKET_SIZE;
 
     // reset the last 8 bytes to 0;
     memset(pPacket->pData + iDataSize, 0, AV_INPUT_BUFFER_PADDING_SIZE);
@@ -73,6 +210,38 @@ DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(unsigned int iDataSize, unsigne
   return ret;
 }
 
+DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(const AVPacket& avPacket)
+{
+  // packets read by libavformat are refcounted and padded like ours
+  if (avPacket.buf && avPacket.data && avPacket.size > 0 &&
+      avPacket.data >= avPacket.buf->data &&
+      avPacket.data + avPacket.size + AV_INPUT_BUFFER_PADDING_SIZE <= avPacket.buf->data + avPacket.buf->size)
+  {
+    DemuxPacket* pPacket = AllocateDemuxPacket(0);
+    if (!pPacket)
+      return NULL;
+
+    SPacketHeader* header = GetHeader(pPacket);
+    header->buffer = av_buffer_ref(avPacket.buf);
+    if (header->buffer)
+    {
+      pPacket->pData = avPacket.data;
+      pPacket->iSize = avPacket.size;
+      return pPacket;
+    }
+    FreeDemuxPacket(pPacket);
+  }
+
+  DemuxPacket* pPacket = AllocateDemuxPacket(avPacket.size);
+  if (pPacket)
+  {
+    pPacket->iSize = avPacket.size;
+    if (avPacket.data)
+      memcpy(pPacket->pData, avPacket.data, avPacket.size);
+  }
+  return pPacket;
+}
+
 void CDVDDemuxUtils::StoreSideData(DemuxPacket *pkt, AVPacket *src)
 {
   AVPacket avPkt;
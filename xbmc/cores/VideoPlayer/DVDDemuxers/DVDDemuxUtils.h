@@ -19,6 +19,12 @@ public:
   static void FreeDemuxPacket(DemuxPacket* pPacket);
   static DemuxPacket* AllocateDemuxPacket(int iDataSize = 0);
   static DemuxPacket* AllocateDemuxPacket(unsigned int iDataSize, unsigned int encryptedSubsampleCount);
+
+  /*!
+   \brief Allocate a packet holding the payload of an ffmpeg packet.
+   Refcounted payloads with enough padding are shared instead of copied.
+   */
+  static DemuxPacket* AllocateDemuxPacket(const AVPacket& avPacket);
   static void StoreSideData(DemuxPacket *pkt, AVPacket *src);
 };
 
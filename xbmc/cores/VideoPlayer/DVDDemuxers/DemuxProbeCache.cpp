@@ -0,0 +1,586 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "DemuxProbeCache.h"
+
+#include "DVDInputStreams/DVDInputStream.h"
+#include "FileItem.h"
+#include "URL.h"
+#include "XBDateTime.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "threads/SingleLock.h"
+#include "utils/JobManager.h"
+#include "utils/Crc32.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "utils/log.h"
+
+#include <string.h>
+#include <type_traits>
+
+using namespace XFILE;
+
+static const char* PROBE_CACHE_FOLDER = "special://temp/probecache/";
+static const uint32_t PROBE_CACHE_MAGIC = 0x31425250; // "PRB1"
+static const uint32_t PROBE_CACHE_VERSION = 2;
+static const size_t PROBE_CACHE_RECENT = 32;
+static const uint32_t PROBE_CACHE_MAX_STREAMS = 256;
+static const int PROBE_CACHE_MAX_ENTRIES = 1000;
+static const int PROBE_CACHE_MAX_AGE_DAYS = 90;
+static const unsigned int PROBE_CACHE_PRUNE_INTERVAL = 100;
+
+namespace
+{
+
+/*!
+ \brief Appends fixed size fields to a buffer, see TransferParams().
+ */
+class CProbeWriter
+{
+public:
+  template<typename T>
+  bool Field(const T& value)
+  {
+    static_assert(std::is_integral<T>::value, "only fixed size integers are stored");
+    m_buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    return true;
+  }
+  bool Field(const AVRational& value)
+  {
+    const int32_t num = value.num;
+    const int32_t den = value.den;
+    return Field(num) && Field(den);
+  }
+  void Bytes(const void* data, uint32_t size)
+  {
+    Field(size);
+    m_buffer.append(static_cast<const char*>(data), size);
+  }
+
+  std::string m_buffer;
+};
+
+/*!
+ \brief Reads the fields written by CProbeWriter, false once the data ends.
+ */
+class CProbeReader
+{
+public:
+  CProbeReader(const char* data, size_t size) : m_pos(data), m_end(data + size) {}
+
+  template<typename T>
+  bool Field(T& value)
+  {
+    static_assert(std::is_integral<T>::value, "only fixed size integers are stored");
+    if (static_cast<size_t>(m_end - m_pos) < sizeof(value))
+      return false;
+    memcpy(&value, m_pos, sizeof(value));
+    m_pos += sizeof(value);
+    return true;
+  }
+  bool Field(AVRational& value)
+  {
+    int32_t num = 0, den = 0;
+    if (!Field(num) || !Field(den))
+      return false;
+    value = av_make_q(num, den);
+    return true;
+  }
+  template<typename T>
+  bool Bytes(T& value)
+  {
+    uint32_t size = 0;
+    if (!Field(size) || static_cast<size_t>(m_end - m_pos) < size)
+      return false;
+    value.assign(m_pos, m_pos + size);
+    m_pos += size;
+    return true;
+  }
+
+private:
+  const char* m_pos;
+  const char* m_end;
+};
+
+/*!
+ \brief The stored fields of a stream, in the order of the file.
+ Changing them requires a new PROBE_CACHE_VERSION.
+ */
+template<typename Archive, typename Params>
+bool TransferParams(Archive& archive, Params& params)
+{
+  return archive.Field(params.index) && archive.Field(params.id) &&
+         archive.Field(params.codecType) && archive.Field(params.codecId) &&
+         archive.Field(params.codecTag) && archive.Field(params.format) &&
+         archive.Field(params.bitRate) && archive.Field(params.bitsPerCodedSample) &&
+         archive.Field(params.bitsPerRawSample) && archive.Field(params.profile) &&
+         archive.Field(params.level) && archive.Field(params.width) &&
+         archive.Field(params.height) && archive.Field(params.sampleAspectRatio) &&
+         archive.Field(params.fieldOrder) && archive.Field(params.colorRange) &&
+         archive.Field(params.colorPrimaries) && archive.Field(params.colorTrc) &&
+         archive.Field(params.colorSpace) && archive.Field(params.chromaLocation) &&
+         archive.Field(params.channelLayout) && archive.Field(params.channels) &&
+         archive.Field(params.sampleRate) && archive.Field(params.blockAlign) &&
+         archive.Field(params.frameSize) && archive.Field(params.timeBase) &&
+         archive.Field(params.avgFrameRate) && archive.Field(params.rFrameRate) &&
+         archive.Field(params.startTime) && archive.Field(params.duration) &&
+         archive.Field(params.codecInfoFrames);
+}
+
+} // namespace
+
+CDemuxProbeCache::CDemuxProbeCache()
+{
+  // the queue of the writes cancels its jobs on destruction, the job manager
+  // has to outlive it
+  CJobManager::GetInstance();
+}
+
+CDemuxProbeCache& CDemuxProbeCache::GetInstance()
+{
+  static CDemuxProbeCache instance;
+  return instance;
+}
+
+bool CDemuxProbeCache::GetKey(CDVDInputStream& input, std::string& key, int64_t& size, int64_t& mtime)
+{
+  key = input.GetFileName();
+  size = 0;
+  mtime = 0;
+  if (key.empty())
+    return false;
+
+  // a channel keeps its layout between zaps, the check of the streams after
+  // opening catches changes
+  if (URIUtils::IsPVRChannel(key))
+    return true;
+
+  // other live streams and discs have nothing to identify the content by
+  if (input.IsRealtime() || !input.IsStreamType(DVDSTREAM_TYPE_FILE))
+    return false;
+
+  struct __stat64 buffer;
+  if (CFile::Stat(key, &buffer) != 0 || buffer.st_size <= 0)
+    return false;
+
+  size = buffer.st_size;
+  mtime = buffer.st_mtime;
+  return true;
+}
+
+std::shared_ptr<const CDemuxProbeCache::SProbeInfo> CDemuxProbeCache::Get(const std::string& key, int64_t size, int64_t mtime)
+{
+  CSingleLock lock(m_critSection);
+
+  std::shared_ptr<const SProbeInfo> info;
+  for (auto it = m_recent.begin(); it != m_recent.end(); ++it)
+  {
+    if (it->first == key)
+    {
+      info = it->second;
+      m_recent.erase(it);
+      break;
+    }
+  }
+
+  if (!info)
+  {
+    lock.Leave();
+    std::shared_ptr<SProbeInfo> loaded = std::make_shared<SProbeInfo>();
+    if (!Load(key, *loaded))
+      return nullptr;
+    info = loaded;
+    lock.Enter();
+  }
+
+  if (info->size != size || info->mtime != mtime)
+    return nullptr;
+
+  m_recent.emplace_front(key, info);
+  if (m_recent.size() > PROBE_CACHE_RECENT)
+    m_recent.pop_back();
+
+  return info;
+}
+
+void CDemuxProbeCache::Set(const std::string& key, const AVFormatContext* context, int64_t size, int64_t mtime)
+{
+  std::shared_ptr<SProbeInfo> info = std::make_shared<SProbeInfo>();
+  info->size = size;
+  info->mtime = mtime;
+  info->format = context->iformat && context->iformat->name ? context->iformat->name : "";
+  info->startTime = context->start_time;
+  info->duration = context->duration;
+  info->bitRate = context->bit_rate;
+
+  info->streams.resize(context->nb_streams);
+  for (unsigned int i = 0; i < context->nb_streams; i++)
+  {
+    const AVStream* st = context->streams[i];
+    const AVCodecParameters* codecpar = st->codecpar;
+    SStream& stream = info->streams[i];
+    SStreamParams& params = stream.params;
+
+    memset(&params, 0, sizeof(params));
+    params.index = st->index;
+    params.id = st->id;
+    params.codecType = codecpar->codec_type;
+    params.codecId = codecpar->codec_id;
+    params.codecTag = codecpar->codec_tag;
+    params.format = codecpar->format;
+    params.bitRate = codecpar->bit_rate;
+    params.bitsPerCodedSample = codecpar->bits_per_coded_sample;
+    params.bitsPerRawSample = codecpar->bits_per_raw_sample;
+    params.profile = codecpar->profile;
+    params.level = codecpar->level;
+    params.width = codecpar->width;
+    params.height = codecpar->height;
+    params.sampleAspectRatio = codecpar->sample_aspect_ratio;
+    params.fieldOrder = codecpar->field_order;
+    params.colorRange = codecpar->color_range;
+    params.colorPrimaries = codecpar->color_primaries;
+    params.colorTrc = codecpar->color_trc;
+    params.colorSpace = codecpar->color_space;
+    params.chromaLocation = codecpar->chroma_location;
+    params.channelLayout = codecpar->channel_layout;
+    params.channels = codecpar->channels;
+    params.sampleRate = codecpar->sample_rate;
+    params.blockAlign = codecpar->block_align;
+    params.frameSize = codecpar->frame_size;
+    params.timeBase = st->time_base;
+    params.avgFrameRate = st->avg_frame_rate;
+    params.rFrameRate = st->r_frame_rate;
+    params.startTime = st->start_time;
+    params.duration = st->duration;
+    params.codecInfoFrames = st->codec_info_nb_frames;
+
+    if (codecpar->extradata && codecpar->extradata_size > 0)
+      stream.extradata.assign(codecpar->extradata, codecpar->extradata + codecpar->extradata_size);
+  }
+
+  bool prune = false;
+  {
+    CSingleLock lock(m_critSection);
+    for (auto it = m_recent.begin(); it != m_recent.end(); ++it)
+    {
+      if (it->first == key)
+      {
+        m_recent.erase(it);
+        break;
+      }
+    }
+    m_recent.emplace_front(key, info);
+    if (m_recent.size() > PROBE_CACHE_RECENT)
+      m_recent.pop_back();
+
+    // with the first entry of a session and every so often after that
+    prune = m_saved++ % PROBE_CACHE_PRUNE_INTERVAL == 0;
+  }
+
+  // the demuxer calls this while reading, the file system is left to the
+  // queue, which also keeps the writes and removals of a key in order
+  const std::shared_ptr<const SProbeInfo> saved = info;
+  m_writes.Submit([key, saved, prune]()
+  {
+    Save(key, *saved);
+    if (prune)
+      Prune();
+  });
+}
+
+void CDemuxProbeCache::Remove(const std::string& key)
+{
+  {
+    CSingleLock lock(m_critSection);
+    for (auto it = m_recent.begin(); it != m_recent.end(); ++it)
+    {
+      if (it->first == key)
+      {
+        m_recent.erase(it);
+        break;
+      }
+    }
+  }
+
+  const std::string path = GetCachePath(key);
+  m_writes.Submit([path]()
+  {
+    if (CFile::Exists(path))
+      CFile::Delete(path);
+  });
+}
+
+bool CDemuxProbeCache::IsWriting() const
+{
+  return m_writes.IsProcessing();
+}
+
+bool CDemuxProbeCache::Matches(const SProbeInfo& info, const AVFormatContext* context)
+{
+  if (!context->iformat || !context->iformat->name || info.format != context->iformat->name)
+    return false;
+
+  if (info.streams.size() != context->nb_streams)
+    return false;
+
+  for (unsigned int i = 0; i < context->nb_streams; i++)
+  {
+    const AVStream* st = context->streams[i];
+    const SStreamParams& params = info.streams[i].params;
+    if (params.id != st->id ||
+        params.codecType != st->codecpar->codec_type ||
+        params.codecId != st->codecpar->codec_id)
+      return false;
+  }
+  return true;
+}
+
+int CDemuxProbeCache::Apply(const SProbeInfo& info, AVFormatContext* context)
+{
+  int applied = 0;
+  for (unsigned int i = 0; i < context->nb_streams; i++)
+  {
+    if (Apply(info, context->streams[i]))
+      applied++;
+  }
+
+  if (context->start_time == AV_NOPTS_VALUE)
+    context->start_time = info.startTime;
+  if (context->duration == AV_NOPTS_VALUE)
+    context->duration = info.duration;
+  if (context->bit_rate == 0)
+    context->bit_rate = info.bitRate;
+
+  return applied;
+}
+
+bool CDemuxProbeCache::Apply(const SProbeInfo& info, AVStream* st)
+{
+  const SStream* stream = nullptr;
+  for (const SStream& cached : info.streams)
+  {
+    if (cached.params.id == st->id &&
+        cached.params.codecType == st->codecpar->codec_type &&
+        cached.params.codecId == st->codecpar->codec_id)
+    {
+      stream = &cached;
+      break;
+    }
+  }
+  if (!stream)
+    return false;
+
+  // only what ffmpeg doesn't know yet is taken, whatever the container
+  // tells has precedence over the cache
+  const SStreamParams& params = stream->params;
+  AVCodecParameters* codecpar = st->codecpar;
+
+  if (!codecpar->extradata && !stream->extradata.empty())
+  {
+    codecpar->extradata = static_cast<uint8_t*>(av_mallocz(stream->extradata.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+    if (codecpar->extradata)
+    {
+      memcpy(codecpar->extradata, stream->extradata.data(), stream->extradata.size());
+      codecpar->extradata_size = stream->extradata.size();
+    }
+  }
+
+  if (codecpar->codec_tag == 0)
+    codecpar->codec_tag = params.codecTag;
+  if (codecpar->format < 0)
+    codecpar->format = params.format;
+  if (codecpar->bit_rate == 0)
+    codecpar->bit_rate = params.bitRate;
+  if (codecpar->bits_per_coded_sample == 0)
+    codecpar->bits_per_coded_sample = params.bitsPerCodedSample;
+  if (codecpar->bits_per_raw_sample == 0)
+    codecpar->bits_per_raw_sample = params.bitsPerRawSample;
+  if (codecpar->profile == FF_PROFILE_UNKNOWN)
+    codecpar->profile = params.profile;
+  if (codecpar->level == FF_LEVEL_UNKNOWN)
+    codecpar->level = params.level;
+
+  if (codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+  {
+    if (codecpar->width == 0 || codecpar->height == 0)
+    {
+      codecpar->width = params.width;
+      codecpar->height = params.height;
+    }
+    if (codecpar->sample_aspect_ratio.num == 0)
+      codecpar->sample_aspect_ratio = params.sampleAspectRatio;
+    if (codecpar->field_order == AV_FIELD_UNKNOWN)
+      codecpar->field_order = static_cast<AVFieldOrder>(params.fieldOrder);
+    if (codecpar->color_range == AVCOL_RANGE_UNSPECIFIED)
+      codecpar->color_range = static_cast<AVColorRange>(params.colorRange);
+    if (codecpar->color_primaries == AVCOL_PRI_UNSPECIFIED)
+      codecpar->color_primaries = static_cast<AVColorPrimaries>(params.colorPrimaries);
+    if (codecpar->color_trc == AVCOL_TRC_UNSPECIFIED)
+      codecpar->color_trc = static_cast<AVColorTransferCharacteristic>(params.colorTrc);
+    if (codecpar->color_space == AVCOL_SPC_UNSPECIFIED)
+      codecpar->color_space = static_cast<AVColorSpace>(params.colorSpace);
+    if (codecpar->chroma_location == AVCHROMA_LOC_UNSPECIFIED)
+      codecpar->chroma_location = static_cast<AVChromaLocation>(params.chromaLocation);
+    if (st->avg_frame_rate.num == 0)
+      st->avg_frame_rate = params.avgFrameRate;
+    if (st->r_frame_rate.num == 0)
+      st->r_frame_rate = params.rFrameRate;
+  }
+  else if (codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
+  {
+    if (codecpar->channels == 0)
+    {
+      codecpar->channels = params.channels;
+      codecpar->channel_layout = params.channelLayout;
+    }
+    if (codecpar->sample_rate == 0)
+      codecpar->sample_rate = params.sampleRate;
+    if (codecpar->block_align == 0)
+      codecpar->block_align = params.blockAlign;
+    if (codecpar->frame_size == 0)
+      codecpar->frame_size = params.frameSize;
+  }
+
+  // timestamps of the cached stream are only meaningful in its time base
+  if (st->time_base.num == params.timeBase.num && st->time_base.den == params.timeBase.den)
+  {
+    if (st->start_time == AV_NOPTS_VALUE)
+      st->start_time = params.startTime;
+    if (st->duration == AV_NOPTS_VALUE)
+      st->duration = params.duration;
+  }
+
+  if (st->codec_info_nb_frames == 0)
+    st->codec_info_nb_frames = params.codecInfoFrames;
+
+  return true;
+}
+
+std::string CDemuxProbeCache::GetCachePath(const std::string& key)
+{
+  return StringUtils::Format("%s%08x.info", PROBE_CACHE_FOLDER, Crc32::Compute(key));
+}
+
+void CDemuxProbeCache::Prune()
+{
+  CFileItemList items;
+  if (!CDirectory::GetDirectory(PROBE_CACHE_FOLDER, items, "", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_BYPASS_CACHE))
+    return;
+
+  // keep the most recently probed entries, leftovers of failed writes are
+  // removed once they are old enough
+  items.Sort(SortByDate, SortOrderDescending);
+  const CDateTime oldest = CDateTime::GetCurrentDateTime() - CDateTimeSpan(PROBE_CACHE_MAX_AGE_DAYS, 0, 0, 0);
+  int removed = 0;
+  for (int i = 0; i < items.Size(); i++)
+  {
+    const CFileItemPtr item = items[i];
+    if (item->m_bIsFolder)
+      continue;
+    if ((i >= PROBE_CACHE_MAX_ENTRIES || item->m_dateTime < oldest) && CFile::Delete(item->GetPath()))
+      removed++;
+  }
+
+  if (removed > 0)
+    CLog::Log(LOGDEBUG, "CDemuxProbeCache: removed %d of %d entries", removed, items.Size());
+}
+
+std::string CDemuxProbeCache::Serialize(const std::string& key, const SProbeInfo& info)
+{
+  // every field is stored with a fixed size, the layout of the structures in
+  // memory doesn't matter. The codec parameters are those of the ffmpeg the
+  // entry was probed with, another build probes again.
+  CProbeWriter writer;
+  writer.Field(PROBE_CACHE_MAGIC);
+  writer.Field(PROBE_CACHE_VERSION);
+  writer.Field(static_cast<uint32_t>(LIBAVCODEC_VERSION_INT));
+  writer.Bytes(key.data(), key.size());
+  writer.Field(info.size);
+  writer.Field(info.mtime);
+  writer.Bytes(info.format.data(), info.format.size());
+  writer.Field(info.startTime);
+  writer.Field(info.duration);
+  writer.Field(info.bitRate);
+  writer.Field(static_cast<uint32_t>(info.streams.size()));
+  for (const SStream& stream : info.streams)
+  {
+    TransferParams(writer, stream.params);
+    writer.Bytes(stream.extradata.data(), stream.extradata.size());
+  }
+  return writer.m_buffer;
+}
+
+bool CDemuxProbeCache::Deserialize(const std::string& key, const char* data, size_t size, SProbeInfo& info)
+{
+  CProbeReader reader(data, size);
+  uint32_t magic = 0, version = 0, avcodecVersion = 0, count = 0;
+  std::string cachedKey;
+  if (!reader.Field(magic) || magic != PROBE_CACHE_MAGIC ||
+      !reader.Field(version) || version != PROBE_CACHE_VERSION ||
+      !reader.Field(avcodecVersion) || avcodecVersion != LIBAVCODEC_VERSION_INT ||
+      !reader.Bytes(cachedKey) || cachedKey != key)
+    return false;
+
+  if (!reader.Field(info.size) || !reader.Field(info.mtime) ||
+      !reader.Bytes(info.format) ||
+      !reader.Field(info.startTime) || !reader.Field(info.duration) ||
+      !reader.Field(info.bitRate) || !reader.Field(count) ||
+      count > PROBE_CACHE_MAX_STREAMS)
+    return false;
+
+  info.streams.resize(count);
+  for (SStream& stream : info.streams)
+  {
+    if (!TransferParams(reader, stream.params) || !reader.Bytes(stream.extradata))
+      return false;
+  }
+  return true;
+}
+
+bool CDemuxProbeCache::Load(const std::string& key, SProbeInfo& info)
+{
+  const std::string path = GetCachePath(key);
+  if (!CFile::Exists(path))
+    return false;
+
+  CFile file;
+  auto_buffer buffer;
+  if (file.LoadFile(path, buffer) <= 0)
+    return false;
+
+  if (!Deserialize(key, buffer.get(), buffer.size(), info))
+  {
+    CLog::Log(LOGDEBUG, "CDemuxProbeCache: ignoring outdated or broken entry %s", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+void CDemuxProbeCache::Save(const std::string& key, const SProbeInfo& info)
+{
+  const std::string buffer = Serialize(key, info);
+
+  if (!CDirectory::Exists(PROBE_CACHE_FOLDER) && !CDirectory::Create(PROBE_CACHE_FOLDER))
+    return;
+
+  // written under a temporary name, an entry is either complete or missing
+  const std::string path = GetCachePath(key);
+  const std::string temp = path + "." + StringUtils::CreateUUID();
+  CFile file;
+  if (!file.OpenForWrite(temp, true))
+    return;
+  const bool written = file.Write(buffer.data(), buffer.size()) == static_cast<ssize_t>(buffer.size());
+  file.Close();
+
+  if (!written || (CFile::Exists(path) && !CFile::Delete(path)) || !CFile::Rename(temp, path))
+  {
+    CLog::Log(LOGWARNING, "CDemuxProbeCache: unable to write %s", path.c_str());
+    CFile::Delete(temp);
+  }
+}
@@ -0,0 +1,153 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#pragma once
+
+#include "threads/CriticalSection.h"
+#include "utils/JobManager.h"
+
+#include <list>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+class CDVDInputStream;
+
+/*!
+ \brief Remembers what avformat_find_stream_info found out about a file or
+ live TV channel, so the next open can skip or shorten the probing.
+
+ Entries of files are only valid for the size and modification time they were
+ probed with, entries of PVR channels until the layout of the channel changes.
+ They are kept in memory and in special://temp/probecache/, which is pruned
+ to the most recently written entries of the last months. The files are
+ written and removed in the background.
+ */
+class CDemuxProbeCache
+{
+public:
+  /*!
+   \brief Codec parameters and timings of a stream, plain data only.
+   */
+  struct SStreamParams
+  {
+    int32_t index;
+    int32_t id; ///< PID for transport streams
+    int32_t codecType;
+    int32_t codecId;
+    uint32_t codecTag;
+    int32_t format;
+    int64_t bitRate;
+    int32_t bitsPerCodedSample;
+    int32_t bitsPerRawSample;
+    int32_t profile;
+    int32_t level;
+    int32_t width;
+    int32_t height;
+    AVRational sampleAspectRatio;
+    int32_t fieldOrder;
+    int32_t colorRange;
+    int32_t colorPrimaries;
+    int32_t colorTrc;
+    int32_t colorSpace;
+    int32_t chromaLocation;
+    uint64_t channelLayout;
+    int32_t channels;
+    int32_t sampleRate;
+    int32_t blockAlign;
+    int32_t frameSize;
+    AVRational timeBase;
+    AVRational avgFrameRate;
+    AVRational rFrameRate;
+    int64_t startTime;
+    int64_t duration;
+    int32_t codecInfoFrames;
+  };
+
+  struct SStream
+  {
+    SStreamParams params;
+    std::vector<uint8_t> extradata;
+  };
+
+  struct SProbeInfo
+  {
+    int64_t size = 0; ///< size of the file, 0 for channels
+    int64_t mtime = 0; ///< modification time of the file, 0 for channels
+    std::string format;
+    int64_t startTime = AV_NOPTS_VALUE;
+    int64_t duration = AV_NOPTS_VALUE;
+    int64_t bitRate = 0;
+    std::vector<SStream> streams;
+  };
+
+  static CDemuxProbeCache& GetInstance();
+
+  /*!
+   \brief Returns the key and validity of the input, false if it can't be cached.
+   Local and network files are identified by path, size and modification time,
+   PVR channels by path.
+   */
+  static bool GetKey(CDVDInputStream& input, std::string& key, int64_t& size, int64_t& mtime);
+
+  std::shared_ptr<const SProbeInfo> Get(const std::string& key, int64_t size, int64_t mtime);
+  void Set(const std::string& key, const AVFormatContext* context, int64_t size, int64_t mtime);
+  void Remove(const std::string& key);
+
+  /*!
+   \brief Whether the streams of the opened context are the cached ones.
+   */
+  static bool Matches(const SProbeInfo& info, const AVFormatContext* context);
+
+  /*!
+   \brief Fills the parameters ffmpeg doesn't know yet from the cache.
+   Streams are matched by id and codec, other streams are left alone.
+   \return number of streams that were completed
+   */
+  static int Apply(const SProbeInfo& info, AVFormatContext* context);
+
+  /*!
+   \brief Fills the parameters of a single stream, see Apply().
+   */
+  static bool Apply(const SProbeInfo& info, AVStream* stream);
+
+  /*!
+   \brief Whether files of Set() or Remove() are still being written or removed.
+   */
+  bool IsWriting() const;
+
+  /*!
+   \brief The content of the file of an entry.
+   */
+  static std::string Serialize(const std::string& key, const SProbeInfo& info);
+
+  /*!
+   \brief Reads an entry written by Serialize().
+   \return false if the data is broken, of another key, format version or ffmpeg build
+   */
+  static bool Deserialize(const std::string& key, const char* data, size_t size, SProbeInfo& info);
+
+private:
+  CDemuxProbeCache();
+
+  static std::string GetCachePath(const std::string& key);
+  static bool Load(const std::string& key, SProbeInfo& info);
+  static void Save(const std::string& key, const SProbeInfo& info);
+  static void Prune();
+
+  CCriticalSection m_critSection;
+  std::list<std::pair<std::string, std::shared_ptr<const SProbeInfo>>> m_recent; ///< most recently used first
+  unsigned int m_saved = 0; ///< entries written in this session
+  CJobQueue m_writes;
+};
@@ -13,6 +13,7 @@
 #include "settings/AdvancedSettings.h"
 #include "settings/SettingsComponent.h"
 #include "pictures/Picture.h"
+#include "pictures/PictureConverter.h"
 #include "video/VideoInfoTag.h"
 #include "filesystem/StackDirectory.h"
 #include "utils/log.h"
@@ -250,27 +251,39 @@ bool CDVDFileInfo::ExtractThumb(const CFileItem& fileItem,
               aspect = hint.aspect;
             unsigned int nHeight = (unsigned int)((double)nWidth / aspect);
 
-            uint8_t *pOutBuf = (uint8_t*)av_malloc(nWidth * nHeight * 4);
-            struct SwsContext *context = sws_getContext(picture.iWidth, picture.iHeight,
-                  AV_PIX_FMT_YUV420P, nWidth, nHeight, AV_PIX_FMT_BGRA, SWS_FAST_BILINEAR, NULL, NULL, NULL);
+            // an aligned pitch keeps swscale on its simd code
+            const int pitch = CPictureConverter::GetAlignedStride(AV_PIX_FMT_BGRA, nWidth);
+            uint8_t *pOutBuf = (uint8_t*)av_malloc(pitch * nHeight);
+
+            uint8_t *planes[YuvImage::MAX_PLANES];
+            int stride[YuvImage::MAX_PLANES];
+            picture.videoBuffer->GetPlanes(planes);
+            picture.videoBuffer->GetStrides(stride);
+
+            SPictureBuffer src;
+            src.format = picture.videoBuffer->GetFormat();
+            src.width = picture.iWidth;
+            src.height = picture.iHeight;
+            src.fullRange = picture.color_range == 1;
+            for (int i = 0; i < YuvImage::MAX_PLANES; i++)
+            {
+              src.planes[i] = planes[i];
+              src.strides[i] = stride[i];
+            }
 
-            if (context)
+            SPictureBuffer dst;
+            dst.format = AV_PIX_FMT_BGRA;
+            dst.width = nWidth;
+            dst.height = nHeight;
+            dst.planes[0] = pOutBuf;
+            dst.strides[0] = pitch;
+
+            if (pOutBuf && CPictureConverter::GetInstance().Convert(src, dst, SWS_FAST_BILINEAR))
             {
-              uint8_t *planes[YuvImage::MAX_PLANES];
-              int stride[YuvImage::MAX_PLANES];
-              picture.videoBuffer->GetPlanes(planes);
-              picture.videoBuffer->GetStrides(stride);
-              uint8_t *src[4]= { planes[0], planes[1], planes[2], 0 };
-              int srcStride[] = { stride[0], stride[1], stride[2], 0 };
-              uint8_t *dst[] = { pOutBuf, 0, 0, 0 };
-              int dstStride[] = { (int)nWidth*4, 0, 0, 0 };
               int orientation = DegreeToOrientation(hint.orientation);
-              sws_scale(context, src, srcStride, 0, picture.iHeight, dst, dstStride);
-              sws_freeContext(context);
-
               details.width = nWidth;
               details.height = nHeight;
-              CPicture::CacheTexture(pOutBuf, nWidth, nHeight, nWidth * 4, orientation, nWidth, nHeight, CTextureCache::GetCachedPath(details.file));
+              CPicture::CacheTexture(pOutBuf, nWidth, nHeight, pitch, orientation, nWidth, nHeight, CTextureCache::GetCachedPath(details.file));
               bOk = true;
             }
             av_free(pOutBuf);
@@ -13,8 +13,69 @@
 #include "cores/VideoPlayer/Interface/Addon/TimingConstants.h"
 #include "math.h"
 
-CDVDMessageQueue::CDVDMessageQueue(const std::string &owner) : m_hEvent(true), m_owner(owner)
+// initial number of slots, the ring grows with the queue
+#define MSGQ_INITIAL_CAPACITY 256
+
+CDVDMessageQueue::CRing::CRing(size_t capacity)
+{
+  size_t size = 1;
+  while (size < capacity)
+    size <<= 1;
+  m_slots.resize(size);
+}
+
+void CDVDMessageQueue::CRing::PushFront(const SQueuedMessage& item)
+{
+  if (m_count == m_slots.size())
+    Grow();
+  m_count++;
+  Front() = item;
+}
+
+void CDVDMessageQueue::CRing::PushBack(const SQueuedMessage& item)
 {
+  if (m_count == m_slots.size())
+    Grow();
+  m_back = (m_back - 1) & (m_slots.size() - 1);
+  m_count++;
+  Back() = item;
+}
+
+void CDVDMessageQueue::CRing::PopBack()
+{
+  m_back = (m_back + 1) & (m_slots.size() - 1);
+  m_count--;
+}
+
+void CDVDMessageQueue::CRing::Remove(CDVDMsg::Message type)
+{
+  size_t kept = 0;
+  for (size_t i = 0; i < m_count; i++)
+  {
+    SQueuedMessage& item = At(i);
+    if (type == CDVDMsg::NONE || item.message->IsType(type))
+      item.message->Release();
+    else
+      At(kept++) = item;
+  }
+  m_count = kept;
+}
+
+void CDVDMessageQueue::CRing::Grow()
+{
+  // producers are held back by the level of the queue, control messages
+  // must never be refused, so a full ring grows instead
+  std::vector<SQueuedMessage> slots(m_slots.size() * 2);
+  for (size_t i = 0; i < m_count; i++)
+    slots[i] = At(i);
+  m_slots.swap(slots);
+  m_back = 0;
+}
+
+CDVDMessageQueue::CDVDMessageQueue(const std::string &owner) : m_hEvent(true), m_owner(owner), m_messages(MSGQ_INITIAL_CAPACITY)
+{
+  m_prioMessages.reserve(16);
+
   m_iDataSize     = 0;
   m_bAbortRequest = false;
   m_bInitialized = false;
@@ -45,13 +106,15 @@ void CDVDMessageQueue::Flush(CDVDMsg::Message type)
 {
   CSingleLock lock(m_section);
 
-  m_messages.remove_if([type](const DVDMessageListItem &item){
-    return type == CDVDMsg::NONE || item.message->IsType(type);
-  });
+  m_messages.Remove(type);
 
-  m_prioMessages.remove_if([type](const DVDMessageListItem &item){
-    return type == CDVDMsg::NONE || item.message->IsType(type);
+  auto it = std::remove_if(m_prioMessages.begin(), m_prioMessages.end(), [type](const SQueuedMessage &item){
+    if (type != CDVDMsg::NONE && !item.message->IsType(type))
+      return false;
+    item.message->Release();
+    return true;
   });
+  m_prioMessages.erase(it, m_prioMessages.end());
 
   if (type == CDVDMsg::DEMUXER_PACKET ||  type == CDVDMsg::NONE)
   {
@@ -115,14 +178,14 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front
       prio++;
 
     auto it = std::find_if(m_prioMessages.begin(), m_prioMessages.end(),
-                           [prio](const DVDMessageListItem &item){
+                           [prio](const SQueuedMessage &item){
                              return prio <= item.priority;
                            });
-    m_prioMessages.emplace(it, pMsg, priority);
+    m_prioMessages.insert(it, SQueuedMessage{pMsg->Acquire(), priority});
   }
   else
   {
-    if (m_messages.empty())
+    if (m_messages.Empty())
     {
       m_iDataSize = 0;
       m_TimeBack = DVD_NOPTS_VALUE;
@@ -130,9 +193,9 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front
     }
 
     if (front)
-      m_messages.emplace_front(pMsg, priority);
+      m_messages.PushFront(SQueuedMessage{pMsg->Acquire(), priority});
     else
-      m_messages.emplace_back(pMsg, priority);
+      m_messages.PushBack(SQueuedMessage{pMsg->Acquire(), priority});
   }
 
   if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET) && priority == 0)
@@ -172,24 +235,32 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
 
   while (!m_bAbortRequest)
   {
-    std::list<DVDMessageListItem> &msgs = (priority > 0 || !m_prioMessages.empty()) ? m_prioMessages : m_messages;
-
-    if (!msgs.empty() && (msgs.back().priority >= priority || m_drain))
+    const bool prio = priority > 0 || !m_prioMessages.empty();
+    SQueuedMessage* item = nullptr;
+    if (prio && !m_prioMessages.empty())
+      item = &m_prioMessages.back();
+    else if (!prio && !m_messages.Empty())
+      item = &m_messages.Back();
+
+    if (item && (item->priority >= priority || m_drain))
     {
-      DVDMessageListItem& item(msgs.back());
-      priority = item.priority;
+      priority = item->priority;
 
-      if (item.message->IsType(CDVDMsg::DEMUXER_PACKET) && item.priority == 0)
+      if (item->message->IsType(CDVDMsg::DEMUXER_PACKET) && item->priority == 0)
       {
-        DemuxPacket* packet = static_cast<CDVDMsgDemuxerPacket*>(item.message)->GetPacket();
+        DemuxPacket* packet = static_cast<CDVDMsgDemuxerPacket*>(item->message)->GetPacket();
         if (packet)
         {
           m_iDataSize -= packet->iSize;
         }
       }
 
-      *pMsg = item.message->Acquire();
-      msgs.pop_back();
+      // the reference of the queue is handed over
+      *pMsg = item->message;
+      if (prio)
+        m_prioMessages.pop_back();
+      else
+        m_messages.PopBack();
       UpdateTimeBack();
       ret = MSGQ_OK;
       break;
@@ -220,9 +291,9 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
 
 void CDVDMessageQueue::UpdateTimeFront()
 {
-  if (!m_messages.empty())
+  if (!m_messages.Empty())
   {
-    auto &item = m_messages.front();
+    auto &item = m_messages.Front();
     if (item.message->IsType(CDVDMsg::DEMUXER_PACKET))
     {
       DemuxPacket* packet = static_cast<CDVDMsgDemuxerPacket*>(item.message)->GetPacket();
@@ -242,9 +313,9 @@ void CDVDMessageQueue::UpdateTimeFront()
 
 void CDVDMessageQueue::UpdateTimeBack()
 {
-  if (!m_messages.empty())
+  if (!m_messages.Empty())
   {
-    auto &item = m_messages.back();
+    auto &item = m_messages.Back();
     if (item.message->IsType(CDVDMsg::DEMUXER_PACKET))
     {
       DemuxPacket* packet = static_cast<CDVDMsgDemuxerPacket*>(item.message)->GetPacket();
@@ -270,9 +341,9 @@ unsigned CDVDMessageQueue::GetPacketCount(CDVDMsg::Message type)
     return 0;
 
   unsigned count = 0;
-  for (const auto &item : m_messages)
+  for (size_t i = 0; i < m_messages.Size(); i++)
   {
-    if(item.message->IsType(type))
+    if(m_messages.At(i).message->IsType(type))
       count++;
   }
   for (const auto &item : m_prioMessages)
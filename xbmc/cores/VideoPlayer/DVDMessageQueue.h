@@ -12,6 +12,7 @@
 #include <atomic>
 #include <string>
 #include <list>
+#include <vector>
 #include <algorithm>
 #include "threads/CriticalSection.h"
 #include "threads/Event.h"
@@ -97,6 +98,46 @@ public:
   bool IsDataBased() const;
 
 private:
+  struct SQueuedMessage
+  {
+    CDVDMsg* message;
+    int priority;
+  };
+
+  /*!
+   \brief Ring of the queued messages, new messages are added at the front and
+   taken from the back. The slots are reused, so queueing doesn't allocate
+   once the ring has grown to the working size of the queue.
+   */
+  class CRing
+  {
+  public:
+    explicit CRing(size_t capacity);
+
+    bool Empty() const { return m_count == 0; }
+    size_t Size() const { return m_count; }
+    SQueuedMessage& Front() { return At(m_count - 1); }
+    SQueuedMessage& Back() { return At(0); }
+    SQueuedMessage& At(size_t i) { return m_slots[(m_back + i) & (m_slots.size() - 1)]; }
+    const SQueuedMessage& At(size_t i) const { return m_slots[(m_back + i) & (m_slots.size() - 1)]; }
+
+    void PushFront(const SQueuedMessage& item);
+    void PushBack(const SQueuedMessage& item);
+    void PopBack();
+
+    /*!
+     \brief Releases and removes the messages of the given type, keeps the order
+     of the others.
+     */
+    void Remove(CDVDMsg::Message type);
+
+  private:
+    void Grow();
+
+    std::vector<SQueuedMessage> m_slots; ///< size is a power of two
+    size_t m_back = 0; ///< slot of the oldest message
+    size_t m_count = 0;
+  };
 
   MsgQueueReturnCode Put(CDVDMsg* pMsg, int priority, bool front);
   void UpdateTimeFront();
@@ -117,7 +158,7 @@ private:
   int m_iMaxDataSize;
   std::string m_owner;
 
-  std::list<DVDMessageListItem> m_messages;
-  std::list<DVDMessageListItem> m_prioMessages;
+  CRing m_messages;
+  std::vector<SQueuedMessage> m_prioMessages; ///< sorted by priority, highest at the back
 };
 
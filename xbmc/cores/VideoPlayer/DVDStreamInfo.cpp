@@ -34,6 +34,7 @@ void CDVDStreamInfo::Clear()
   flags = 0;
   filename.clear();
   dvd = false;
+  realtime = false;
 
   if( extradata && extrasize ) free(extradata);
 
@@ -140,6 +141,7 @@ void CDVDStreamInfo::Assign(const CDVDStreamInfo& right, bool withextradata)
   flags = right.flags;
   filename = right.filename;
   dvd = right.dvd;
+  realtime = right.realtime;
 
   if( extradata && extrasize ) free(extradata);
 
@@ -43,6 +43,7 @@ public:
   int flags;
   std::string filename;
   bool dvd;
+  bool realtime; // live stream, latency matters more than throughput
   int codecOptions;
 
   // VIDEO
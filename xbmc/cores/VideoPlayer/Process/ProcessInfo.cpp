@@ -70,6 +70,8 @@ void CProcessInfo::ResetVideoCodecInfo()
   m_videoHeight = 0;
   m_videoFPS = 0.0;
   m_videoDAR = 0.0;
+  m_videoDecodeThreads.clear();
+  m_videoDecodeTimes.Reset();
   m_videoIsInterlaced = false;
   m_deintMethods.clear();
   m_deintMethods.push_back(EINTERLACEMETHOD::VS_INTERLACEMETHOD_NONE);
@@ -84,6 +86,8 @@ void CProcessInfo::ResetVideoCodecInfo()
     m_dataCache->SetVideoDimensions(m_videoWidth, m_videoHeight);
     m_dataCache->SetVideoFps(m_videoFPS);
     m_dataCache->SetVideoDAR(m_videoDAR);
+    m_dataCache->SetVideoDecodeThreads(m_videoDecodeThreads);
+    m_dataCache->SetVideoDecodeTimes(m_videoDecodeTimes);
     m_dataCache->SetStateSeeking(m_stateSeeking);
     m_dataCache->SetVideoStereoMode(m_videoStereoMode);
   }
@@ -218,6 +222,40 @@ float CProcessInfo::GetVideoDAR()
   return m_videoDAR;
 }
 
+void CProcessInfo::SetVideoDecodeThreads(const std::string &threads)
+{
+  CSingleLock lock(m_videoCodecSection);
+
+  m_videoDecodeThreads = threads;
+
+  if (m_dataCache)
+    m_dataCache->SetVideoDecodeThreads(m_videoDecodeThreads);
+}
+
+std::string CProcessInfo::GetVideoDecodeThreads()
+{
+  CSingleLock lock(m_videoCodecSection);
+
+  return m_videoDecodeThreads;
+}
+
+void CProcessInfo::SetVideoDecodeTimes(const CDecodeTimes &times)
+{
+  CSingleLock lock(m_videoCodecSection);
+
+  m_videoDecodeTimes = times;
+
+  if (m_dataCache)
+    m_dataCache->SetVideoDecodeTimes(m_videoDecodeTimes);
+}
+
+CDecodeTimes CProcessInfo::GetVideoDecodeTimes()
+{
+  CSingleLock lock(m_videoCodecSection);
+
+  return m_videoDecodeTimes;
+}
+
 void CProcessInfo::SetVideoInterlaced(bool interlaced)
 {
   CSingleLock lock(m_videoCodecSection);
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "VideoBuffer.h"
+#include "cores/DecodeTimes.h"
 #include "cores/VideoSettings.h"
 #include "cores/VideoPlayer/VideoRenderers/RenderInfo.h"
 #include "threads/CriticalSection.h"
@@ -47,6 +48,10 @@ public:
   float GetVideoFps();
   void SetVideoDAR(float dar);
   float GetVideoDAR();
+  void SetVideoDecodeThreads(const std::string &threads);
+  std::string GetVideoDecodeThreads();
+  void SetVideoDecodeTimes(const CDecodeTimes &times);
+  CDecodeTimes GetVideoDecodeTimes();
   void SetVideoInterlaced(bool interlaced);
   bool GetVideoInterlaced();
   virtual EINTERLACEMETHOD GetFallbackDeintMethod();
@@ -125,6 +130,8 @@ protected:
   int m_videoHeight;
   float m_videoFPS;
   float m_videoDAR;
+  std::string m_videoDecodeThreads;
+  CDecodeTimes m_videoDecodeTimes;
   bool m_videoIsInterlaced;
   std::list<EINTERLACEMETHOD> m_deintMethods;
   EINTERLACEMETHOD m_deintMethodDefault;
@@ -3730,6 +3730,10 @@ bool CVideoPlayer::OpenVideoStream(CDVDStreamInfo& hint, bool reset)
   if(pMenus && pMenus->IsInMenu())
     hint.stills = true;
 
+  // the player state knows about live streams only after the first update, the decoder picks
+  // its threading when it is opened
+  hint.realtime = m_pInputStream && m_pInputStream->IsRealtime();
+
   if (hint.stereo_mode.empty())
   {
     CGUIComponent *gui = CServiceBroker::GetGUI();
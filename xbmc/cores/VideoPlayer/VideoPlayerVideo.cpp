@@ -943,6 +943,14 @@ std::string CVideoPlayerVideo::GetPlayerInfo()
   else
     s << ", pc:none";
 
+  const CDecodeTimes decodeTimes = m_processInfo.GetVideoDecodeTimes();
+  if (decodeTimes.GetCount() > 0)
+  {
+    s << ", dec:" << std::fixed << std::setprecision(1) << decodeTimes.GetAverageMs();
+    s << "/" << decodeTimes.GetMaxMs() << "ms";
+    s << " (" << decodeTimes.ToString() << ")";
+  }
+
   return s.str();
 }
 
@@ -0,0 +1,117 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "cores/VideoPlayer/DVDDemuxers/DVDDemuxUtils.h"
+
+#include <string.h>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+bool IsPadded(const DemuxPacket* packet)
+{
+  for (int i = 0; i < AV_INPUT_BUFFER_PADDING_SIZE; i++)
+  {
+    if (packet->pData[packet->iSize + i] != 0)
+      return false;
+  }
+  return true;
+}
+
+} // unnamed namespace
+
+TEST(TestDVDDemuxUtils, ReusesBlocksOfSizeClass)
+{
+  DemuxPacket* packet = CDVDDemuxUtils::AllocateDemuxPacket(1000);
+  ASSERT_NE(nullptr, packet);
+  memset(packet->pData, 0xff, 1000 + AV_INPUT_BUFFER_PADDING_SIZE);
+  const uint8_t* data = packet->pData;
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+
+  // a payload of the same size class gets the block back, cleared
+  packet = CDVDDemuxUtils::AllocateDemuxPacket(900);
+  ASSERT_NE(nullptr, packet);
+  EXPECT_EQ(data, packet->pData);
+  EXPECT_EQ(0, packet->iSize);
+  EXPECT_EQ(DVD_NOPTS_VALUE, packet->pts);
+  packet->iSize = 900;
+  EXPECT_TRUE(IsPadded(packet));
+
+  // a larger one doesn't fit into it
+  DemuxPacket* larger = CDVDDemuxUtils::AllocateDemuxPacket(5000);
+  ASSERT_NE(nullptr, larger);
+  EXPECT_NE(data, larger->pData);
+
+  CDVDDemuxUtils::FreeDemuxPacket(larger);
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+
+  // packets without payload have a class of their own
+  packet = CDVDDemuxUtils::AllocateDemuxPacket(0);
+  ASSERT_NE(nullptr, packet);
+  EXPECT_EQ(nullptr, packet->pData);
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+}
+
+TEST(TestDVDDemuxUtils, SharesPaddedPayload)
+{
+  // packets of libavformat are allocated with padding
+  AVPacket avPacket;
+  av_init_packet(&avPacket);
+  ASSERT_EQ(0, av_new_packet(&avPacket, 100));
+  memset(avPacket.data, 0x42, avPacket.size);
+  ASSERT_EQ(1, av_buffer_get_ref_count(avPacket.buf));
+
+  DemuxPacket* packet = CDVDDemuxUtils::AllocateDemuxPacket(avPacket);
+  ASSERT_NE(nullptr, packet);
+  EXPECT_EQ(avPacket.data, packet->pData);
+  EXPECT_EQ(100, packet->iSize);
+  EXPECT_EQ(2, av_buffer_get_ref_count(avPacket.buf));
+
+  // freeing the packet releases its reference
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+  EXPECT_EQ(1, av_buffer_get_ref_count(avPacket.buf));
+
+  av_packet_unref(&avPacket);
+}
+
+TEST(TestDVDDemuxUtils, CopiesPayloadWithoutPadding)
+{
+  // a refcounted payload that ends right at the end of its buffer
+  AVPacket avPacket;
+  av_init_packet(&avPacket);
+  avPacket.buf = av_buffer_alloc(100);
+  ASSERT_NE(nullptr, avPacket.buf);
+  avPacket.data = avPacket.buf->data;
+  avPacket.size = 100;
+  memset(avPacket.data, 0x42, avPacket.size);
+
+  DemuxPacket* packet = CDVDDemuxUtils::AllocateDemuxPacket(avPacket);
+  ASSERT_NE(nullptr, packet);
+  EXPECT_NE(avPacket.data, packet->pData);
+  EXPECT_EQ(100, packet->iSize);
+  EXPECT_EQ(0, memcmp(avPacket.data, packet->pData, 100));
+  EXPECT_TRUE(IsPadded(packet));
+  EXPECT_EQ(1, av_buffer_get_ref_count(avPacket.buf));
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+
+  // payloads that aren't refcounted are copied as well
+  uint8_t data[64 + AV_INPUT_BUFFER_PADDING_SIZE] = {};
+  AVPacket plain;
+  av_init_packet(&plain);
+  plain.data = data;
+  plain.size = 64;
+  packet = CDVDDemuxUtils::AllocateDemuxPacket(plain);
+  ASSERT_NE(nullptr, packet);
+  EXPECT_NE(plain.data, packet->pData);
+  EXPECT_EQ(64, packet->iSize);
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+
+  av_packet_unref(&avPacket);
+}
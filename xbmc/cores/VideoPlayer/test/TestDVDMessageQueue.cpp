@@ -0,0 +1,289 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "cores/VideoPlayer/DVDDemuxers/DVDDemuxUtils.h"
+#include "cores/VideoPlayer/DVDMessageQueue.h"
+#include "cores/VideoPlayer/Interface/Addon/TimingConstants.h"
+#include "threads/IRunnable.h"
+#include "threads/SingleLock.h"
+#include "threads/Thread.h"
+
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+CDVDMsg* CreatePacket(int size, double dts)
+{
+  DemuxPacket* packet = CDVDDemuxUtils::AllocateDemuxPacket(size);
+  packet->iSize = size;
+  packet->dts = dts;
+  return new CDVDMsgDemuxerPacket(packet);
+}
+
+int GetValue(CDVDMessageQueue& queue, int& priority)
+{
+  CDVDMsg* msg = nullptr;
+  if (queue.Get(&msg, 0, priority) != MSGQ_OK)
+    return -1;
+  const int value = *static_cast<CDVDMsgInt*>(msg);
+  msg->Release();
+  return value;
+}
+
+int GetValue(CDVDMessageQueue& queue)
+{
+  int priority = 0;
+  return GetValue(queue, priority);
+}
+
+/*!
+ \brief Puts numbered messages into the queue, the producer is encoded in the
+ upper bits of the number.
+ */
+class CProducer : public IRunnable
+{
+public:
+  CProducer(CDVDMessageQueue& queue, int id, int count) : m_queue(queue), m_id(id), m_count(count) {}
+
+  void Run() override
+  {
+    for (int i = 0; i < m_count; i++)
+    {
+      // a few high priority messages overtake the others
+      const int priority = (i % 1000 == 999) ? 1 : 0;
+      m_queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, (m_id << 24) | i), priority);
+    }
+  }
+
+private:
+  CDVDMessageQueue& m_queue;
+  int m_id;
+  int m_count;
+};
+
+/*!
+ \brief The message queue as it was before, a list item is allocated for
+ every message.
+ */
+class CListQueue
+{
+public:
+  void Put(CDVDMsg* msg)
+  {
+    CSingleLock lock(m_section);
+    m_messages.emplace_front(msg, 0);
+    msg->Release();
+    m_event.Set();
+  }
+
+  CDVDMsg* Get()
+  {
+    while (true)
+    {
+      {
+        CSingleLock lock(m_section);
+        if (!m_messages.empty())
+        {
+          CDVDMsg* msg = m_messages.back().message->Acquire();
+          m_messages.pop_back();
+          return msg;
+        }
+      }
+      m_event.Wait();
+    }
+  }
+
+private:
+  CCriticalSection m_section;
+  CEvent m_event;
+  std::list<DVDMessageListItem> m_messages;
+};
+
+template<class Queue>
+double MeasureRate(Queue& queue, int count)
+{
+  const auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < count / 100; round++)
+  {
+    // the player threads find a few packets queued
+    for (int i = 0; i < 100; i++)
+      queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, i));
+    for (int i = 0; i < 100; i++)
+      queue.Get()->Release();
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return count / elapsed.count();
+}
+
+class CQueueAdapter
+{
+public:
+  CQueueAdapter() : m_queue("bench") { m_queue.Init(); }
+  void Put(CDVDMsg* msg) { m_queue.Put(msg); }
+  CDVDMsg* Get()
+  {
+    CDVDMsg* msg = nullptr;
+    m_queue.Get(&msg, 1000);
+    return msg;
+  }
+
+private:
+  CDVDMessageQueue m_queue;
+};
+
+} // unnamed namespace
+
+TEST(TestDVDMessageQueue, Order)
+{
+  CDVDMessageQueue queue("test");
+  queue.Init();
+
+  for (int i = 0; i < 1000; i++)
+    queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, i));
+  queue.PutBack(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, -2));
+
+  // messages put back are next
+  EXPECT_EQ(-2, GetValue(queue));
+  for (int i = 0; i < 1000; i++)
+    ASSERT_EQ(i, GetValue(queue));
+  EXPECT_EQ(-1, GetValue(queue));
+  queue.End();
+}
+
+TEST(TestDVDMessageQueue, Priority)
+{
+  CDVDMessageQueue queue("test");
+  queue.Init();
+
+  queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, 0));
+  queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, 10), 1);
+  queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, 20), 2);
+  queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, 11), 1);
+  queue.PutBack(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, 12), 1);
+
+  // only messages of at least the given priority
+  int priority = 2;
+  EXPECT_EQ(20, GetValue(queue, priority));
+  EXPECT_EQ(2, priority);
+  EXPECT_EQ(-1, GetValue(queue, priority));
+
+  priority = 1;
+  EXPECT_EQ(12, GetValue(queue, priority));
+  EXPECT_EQ(10, GetValue(queue, priority));
+  EXPECT_EQ(11, GetValue(queue, priority));
+  EXPECT_EQ(-1, GetValue(queue, priority));
+
+  priority = 0;
+  EXPECT_EQ(0, GetValue(queue, priority));
+  queue.End();
+}
+
+TEST(TestDVDMessageQueue, Flush)
+{
+  CDVDMessageQueue queue("test");
+  queue.Init();
+  queue.SetMaxDataSize(10000);
+  queue.SetMaxTimeSize(4.0);
+
+  for (int i = 0; i < 300; i++)
+  {
+    queue.Put(CreatePacket(10, i * DVD_TIME_BASE / 100));
+    if (i % 100 == 0)
+      queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, i));
+  }
+  queue.Put(new CDVDMsgInt(CDVDMsg::GENERAL_RESYNC, 1000), 1);
+
+  EXPECT_EQ(3000, queue.GetDataSize());
+  EXPECT_EQ(2, queue.GetTimeSize());
+  EXPECT_EQ(75, queue.GetLevel());
+  EXPECT_EQ(300u, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+  EXPECT_EQ(4u, queue.GetPacketCount(CDVDMsg::GENERAL_RESYNC));
+
+  queue.Flush();
+  EXPECT_EQ(0, queue.GetDataSize());
+  EXPECT_EQ(0u, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+  EXPECT_EQ(4u, queue.GetPacketCount(CDVDMsg::GENERAL_RESYNC));
+
+  // the order of the remaining messages is kept
+  EXPECT_EQ(1000, GetValue(queue));
+  for (int i = 0; i < 300; i += 100)
+    EXPECT_EQ(i, GetValue(queue));
+  queue.End();
+}
+
+TEST(TestDVDMessageQueue, Stress)
+{
+  const int producers = 4;
+  const int count = 100000;
+
+  CDVDMessageQueue queue("test");
+  queue.Init();
+
+  std::vector<std::unique_ptr<CProducer>> runnables;
+  std::vector<std::unique_ptr<CThread>> threads;
+  for (int i = 0; i < producers; i++)
+  {
+    runnables.emplace_back(new CProducer(queue, i, count));
+    threads.emplace_back(new CThread(runnables.back().get(), "MessageProducer"));
+    threads.back()->Create();
+  }
+
+  // messages of every producer arrive in order, apart from the high priority
+  // ones, which may overtake
+  std::vector<int> next(producers, 0);
+  std::vector<int> received(producers, 0);
+  for (int i = 0; i < producers * count; i++)
+  {
+    CDVDMsg* msg = nullptr;
+    ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 5000));
+    const int value = *static_cast<CDVDMsgInt*>(msg);
+    msg->Release();
+
+    const int producer = value >> 24;
+    const int number = value & 0xffffff;
+    ASSERT_LT(producer, producers);
+    if (number % 1000 != 999)
+    {
+      ASSERT_LE(next[producer], number);
+      next[producer] = number;
+    }
+    received[producer]++;
+  }
+
+  for (auto& thread : threads)
+    thread->StopThread();
+
+  for (int i = 0; i < producers; i++)
+    EXPECT_EQ(count, received[i]);
+  EXPECT_EQ(0u, queue.GetPacketCount(CDVDMsg::GENERAL_RESYNC));
+  queue.End();
+}
+
+/*!
+ Compares the message rate with the list the queue used before. Run it with
+ --gtest_also_run_disabled_tests --gtest_filter=TestDVDMessageQueue.*
+ */
+TEST(TestDVDMessageQueue, DISABLED_Throughput)
+{
+  const int count = 10000000;
+
+  CListQueue list;
+  const double listRate = MeasureRate(list, count);
+
+  CQueueAdapter ring;
+  const double ringRate = MeasureRate(ring, count);
+
+  std::cout << "list: " << listRate << " msg/s, ring: " << ringRate << " msg/s" << std::endl;
+}
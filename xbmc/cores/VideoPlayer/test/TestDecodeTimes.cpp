@@ -0,0 +1,59 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "cores/DecodeTimes.h"
+
+#include "gtest/gtest.h"
+
+TEST(TestDecodeTimes, Buckets)
+{
+  CDecodeTimes times;
+  times.Add(-5);
+  times.Add(999);
+  times.Add(1000);
+  times.Add(1999);
+  times.Add(2000);
+  times.Add(63999);
+  times.Add(64000);
+  times.Add(1000000);
+
+  EXPECT_EQ(8u, times.GetCount());
+  EXPECT_EQ(2u, times.GetBucket(0));
+  EXPECT_EQ(2u, times.GetBucket(1));
+  EXPECT_EQ(1u, times.GetBucket(2));
+  EXPECT_EQ(0u, times.GetBucket(3));
+  EXPECT_EQ(1u, times.GetBucket(6));
+  EXPECT_EQ(2u, times.GetBucket(CDecodeTimes::BUCKETS - 1));
+  EXPECT_DOUBLE_EQ(1000.0, times.GetMaxMs());
+  EXPECT_NEAR(141.75, times.GetAverageMs(), 0.001);
+
+  times.Reset();
+  EXPECT_EQ(0u, times.GetCount());
+  EXPECT_EQ(0u, times.GetBucket(0));
+  EXPECT_DOUBLE_EQ(0.0, times.GetAverageMs());
+  EXPECT_DOUBLE_EQ(0.0, times.GetMaxMs());
+}
+
+TEST(TestDecodeTimes, ToString)
+{
+  CDecodeTimes times;
+  EXPECT_EQ("<1:0 <2:0 <4:0 <8:0 <16:0 <32:0 <64:0 >64:0", times.ToString());
+
+  times.Add(500);
+  times.Add(3000);
+  times.Add(3500);
+  times.Add(100000);
+  EXPECT_EQ("<1:25 <2:0 <4:50 <8:0 <16:0 <32:0 <64:0 >64:25", times.ToString());
+
+  // shares are rounded to the nearest percent
+  times.Reset();
+  times.Add(500);
+  times.Add(3000);
+  times.Add(3000);
+  EXPECT_EQ("<1:33 <2:0 <4:67 <8:0 <16:0 <32:0 <64:0 >64:0", times.ToString());
+}
@@ -0,0 +1,147 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "cores/VideoPlayer/DVDDemuxers/DemuxProbeCache.h"
+
+#include <chrono>
+#include <string.h>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+CDemuxProbeCache::SProbeInfo CreateInfo()
+{
+  CDemuxProbeCache::SProbeInfo info;
+  info.size = 123456789;
+  info.mtime = 1546300800;
+  info.format = "matroska,webm";
+  info.startTime = 0;
+  info.duration = 5400 * AV_TIME_BASE;
+  info.bitRate = 8000000;
+
+  info.streams.resize(2);
+  CDemuxProbeCache::SStreamParams& video = info.streams[0].params;
+  memset(&video, 0, sizeof(video));
+  video.index = 0;
+  video.id = 1;
+  video.codecType = AVMEDIA_TYPE_VIDEO;
+  video.codecId = AV_CODEC_ID_H264;
+  video.profile = 100;
+  video.level = 41;
+  video.width = 1920;
+  video.height = 1080;
+  video.sampleAspectRatio = av_make_q(1, 1);
+  video.timeBase = av_make_q(1, 1000);
+  video.avgFrameRate = av_make_q(24000, 1001);
+  video.rFrameRate = av_make_q(24000, 1001);
+  video.startTime = 0;
+  video.duration = AV_NOPTS_VALUE;
+  info.streams[0].extradata = {0x01, 0x64, 0x00, 0x29, 0xff, 0xe1};
+
+  CDemuxProbeCache::SStreamParams& audio = info.streams[1].params;
+  memset(&audio, 0, sizeof(audio));
+  audio.index = 1;
+  audio.id = 2;
+  audio.codecType = AVMEDIA_TYPE_AUDIO;
+  audio.codecId = AV_CODEC_ID_AC3;
+  audio.channelLayout = 0x60f;
+  audio.channels = 6;
+  audio.sampleRate = 48000;
+  audio.bitRate = 448000;
+  audio.timeBase = av_make_q(1, 1000);
+  audio.codecInfoFrames = 7;
+
+  return info;
+}
+
+} // namespace
+
+TEST(TestDemuxProbeCache, SerializeRoundTrip)
+{
+  const CDemuxProbeCache::SProbeInfo info = CreateInfo();
+  const std::string data = CDemuxProbeCache::Serialize("/movies/movie.mkv", info);
+
+  CDemuxProbeCache::SProbeInfo loaded;
+  ASSERT_TRUE(CDemuxProbeCache::Deserialize("/movies/movie.mkv", data.data(), data.size(), loaded));
+  EXPECT_EQ(info.size, loaded.size);
+  EXPECT_EQ(info.mtime, loaded.mtime);
+  EXPECT_EQ(info.format, loaded.format);
+  EXPECT_EQ(info.duration, loaded.duration);
+  EXPECT_EQ(info.bitRate, loaded.bitRate);
+  ASSERT_EQ(2u, loaded.streams.size());
+  EXPECT_EQ(1920, loaded.streams[0].params.width);
+  EXPECT_EQ(24000, loaded.streams[0].params.avgFrameRate.num);
+  EXPECT_EQ(1001, loaded.streams[0].params.avgFrameRate.den);
+  EXPECT_EQ(AV_NOPTS_VALUE, loaded.streams[0].params.duration);
+  EXPECT_EQ(info.streams[0].extradata, loaded.streams[0].extradata);
+  EXPECT_EQ(0x60fu, loaded.streams[1].params.channelLayout);
+  EXPECT_EQ(48000, loaded.streams[1].params.sampleRate);
+  EXPECT_EQ(7, loaded.streams[1].params.codecInfoFrames);
+  EXPECT_TRUE(loaded.streams[1].extradata.empty());
+
+  // every field makes it through
+  EXPECT_EQ(data, CDemuxProbeCache::Serialize("/movies/movie.mkv", loaded));
+}
+
+TEST(TestDemuxProbeCache, DeserializeRejectsOtherEntries)
+{
+  const std::string data = CDemuxProbeCache::Serialize("/movies/movie.mkv", CreateInfo());
+  CDemuxProbeCache::SProbeInfo loaded;
+
+  EXPECT_FALSE(CDemuxProbeCache::Deserialize("/movies/other.mkv", data.data(), data.size(), loaded));
+
+  for (size_t size = 0; size < data.size(); size++)
+    EXPECT_FALSE(CDemuxProbeCache::Deserialize("/movies/movie.mkv", data.data(), size, loaded)) << size;
+
+  // magic, format version and version of libavcodec lead the file
+  for (size_t offset = 0; offset < 3 * sizeof(uint32_t); offset += sizeof(uint32_t))
+  {
+    std::string other(data);
+    other[offset]++;
+    EXPECT_FALSE(CDemuxProbeCache::Deserialize("/movies/movie.mkv", other.data(), other.size(), loaded)) << offset;
+  }
+}
+
+TEST(TestDemuxProbeCache, GetChecksSizeAndMtime)
+{
+  const std::string key = "special://temp/TestDemuxProbeCache.mkv";
+  CDemuxProbeCache& cache = CDemuxProbeCache::GetInstance();
+
+  AVFormatContext* context = avformat_alloc_context();
+  ASSERT_NE(nullptr, context);
+  AVStream* stream = avformat_new_stream(context, nullptr);
+  ASSERT_NE(nullptr, stream);
+  stream->id = 1;
+  stream->codecpar->codec_type = AVMEDIA_TYPE_AUDIO;
+  stream->codecpar->codec_id = AV_CODEC_ID_AAC;
+  stream->codecpar->channels = 2;
+  stream->codecpar->sample_rate = 44100;
+
+  cache.Set(key, context, 1000, 2000);
+  avformat_free_context(context);
+
+  std::shared_ptr<const CDemuxProbeCache::SProbeInfo> info = cache.Get(key, 1000, 2000);
+  ASSERT_NE(nullptr, info);
+  ASSERT_EQ(1u, info->streams.size());
+  EXPECT_EQ(44100, info->streams[0].params.sampleRate);
+
+  // a changed file is probed again
+  EXPECT_EQ(nullptr, cache.Get(key, 1001, 2000));
+  EXPECT_EQ(nullptr, cache.Get(key, 1000, 2001));
+
+  // the file is removed after it was written
+  cache.Remove(key);
+  for (int i = 0; i < 500 && cache.IsWriting(); i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_FALSE(cache.IsWriting());
+  EXPECT_EQ(nullptr, cache.Get(key, 1000, 2000));
+}
@@ -227,6 +227,8 @@ CDatabase::CDatabase() :
   m_sqlite = true;
   m_bMultiWrite = false;
   m_multipleExecute = false;
+  m_readers = 0;
+  m_inReadScope = false;
 }
 
 CDatabase::~CDatabase(void)
@@ -488,10 +490,16 @@ void CDatabase::DropAnalytics()
 
 bool CDatabase::Connect(const std::string &dbName, const DatabaseSettings &dbSettings, bool create)
 {
+  m_readers = 0;
+
   // create the appropriate database structure
   if (dbSettings.type == "sqlite3")
   {
     m_pDB.reset( new SqliteDatabase() ) ;
+    // readers need WAL to run alongside the writer
+    m_readHost = dbSettings.host;
+    m_readName = dbName;
+    m_readers = dbSettings.wal ? dbSettings.readers : 0;
   }
 #if defined(HAS_MYSQL) || defined(HAS_MARIADB)
   else if (dbSettings.type == "mysql")
@@ -561,6 +569,25 @@ bool CDatabase::Connect(const std::string &dbName, const DatabaseSettings &dbSet
       m_pDS->exec("PRAGMA cache_size=4096\n");
       m_pDS->exec("PRAGMA synchronous='NORMAL'\n");
       m_pDS->exec("PRAGMA count_changes='OFF'\n");
+
+      // WAL lets readers run concurrently with a writer. The journal mode is persistent, so
+      // switch back explicitly when it is disabled.
+      try
+      {
+        m_pDS->exec(dbSettings.wal ? "PRAGMA journal_mode=WAL\n" : "PRAGMA journal_mode=DELETE\n");
+        m_pDS->query("SELECT * FROM pragma_journal_mode\n");
+        if (m_pDS->eof() || !StringUtils::EqualsNoCase(m_pDS->fv(0).get_asString(), dbSettings.wal ? "wal" : "delete"))
+        {
+          CLog::Log(LOGWARNING, "%s unable to change journal mode of %s", __FUNCTION__, dbName.c_str());
+          m_readers = 0;
+        }
+        m_pDS->close();
+      }
+      catch (DbErrors &error)
+      {
+        CLog::Log(LOGWARNING, "%s unable to change journal mode: '%s'", __FUNCTION__, error.getMsg());
+        m_readers = 0;
+      }
     }
   }
   catch (DbErrors &error)
@@ -583,6 +610,93 @@ int CDatabase::GetDBVersion()
   return 0;
 }
 
+bool CDatabase::CreateFullTextIndex(const std::string &index, const std::string &table, const std::string &key, const std::vector<std::string> &columns)
+{
+  if (!m_sqlite)
+    return false;
+
+  const std::string cols = StringUtils::Join(columns, ", ");
+  std::vector<std::string> newColumns;
+  for (const auto& column : columns)
+    newColumns.push_back("new." + column);
+  const std::string values = StringUtils::Join(newColumns, ", ");
+
+  try
+  {
+    // the index table isn't dropped with the other analytics, so start from scratch
+    m_pDS->exec("DROP TABLE IF EXISTS " + index);
+    m_pDS->exec("CREATE VIRTUAL TABLE " + index + " USING fts5(" + cols + ", "
+                "tokenize='unicode61 remove_diacritics 1', prefix='2 3')");
+  }
+  catch (...)
+  {
+    CLog::Log(LOGWARNING, "%s - full-text search is not available, searching %s is unindexed", __FUNCTION__, table.c_str());
+    m_fullTextIndices[index] = false;
+    return false;
+  }
+
+  m_pDS->exec("INSERT INTO " + index + " (rowid, " + cols + ") SELECT " + key + ", " + cols + " FROM " + table);
+
+  const std::string insert = "INSERT INTO " + index + " (rowid, " + cols + ") VALUES (new." + key + ", " + values + "); ";
+  const std::string remove = "DELETE FROM " + index + " WHERE rowid=old." + key + "; ";
+  m_pDS->exec("CREATE TRIGGER " + index + "_insert AFTER INSERT ON " + table + " FOR EACH ROW BEGIN " + insert + "END");
+  m_pDS->exec("CREATE TRIGGER " + index + "_update AFTER UPDATE OF " + cols + " ON " + table + " FOR EACH ROW BEGIN " + remove + insert + "END");
+  m_pDS->exec("CREATE TRIGGER " + index + "_delete AFTER DELETE ON " + table + " FOR EACH ROW BEGIN " + remove + "END");
+  m_fullTextIndices[index] = true;
+  return true;
+}
+
+bool CDatabase::HasFullTextIndex(const std::string &index) const
+{
+  if (!m_sqlite || NULL == m_pDB.get())
+    return false;
+
+  auto it = m_fullTextIndices.find(index);
+  if (it != m_fullTextIndices.end())
+    return it->second;
+
+  // a dataset of its own, this is called while queries are being built
+  bool exists = false;
+  try
+  {
+    std::unique_ptr<Dataset> ds(m_pDB->CreateDataset());
+    exists = ds->query(PrepareSQL("SELECT name FROM sqlite_master WHERE type='table' AND name='%s'", index.c_str())) && ds->num_rows() > 0;
+    ds->close();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s - failed to look up %s", __FUNCTION__, index.c_str());
+    return false;
+  }
+
+  m_fullTextIndices[index] = exists;
+  return exists;
+}
+
+std::string CDatabase::GetFullTextQuery(const std::string &index, const std::vector<std::string> &columns, const std::string &search) const
+{
+  const std::string match = PrepareFullTextMatch(search);
+  if (match.empty() || !HasFullTextIndex(index))
+    return "";
+
+  return PrepareSQL("SELECT rowid FROM %s WHERE %s MATCH '{%s} : (%s)'", index.c_str(), index.c_str(),
+                    StringUtils::Join(columns, " ").c_str(), match.c_str());
+}
+
+std::string CDatabase::PrepareFullTextMatch(const std::string &search)
+{
+  // quote every word so that FTS5 operators in the input are taken literally
+  std::vector<std::string> words;
+  for (std::string word : StringUtils::Split(search, " "))
+  {
+    StringUtils::Replace(word, "\"", "");
+    StringUtils::Trim(word);
+    if (!word.empty())
+      words.push_back("\"" + word + "\"*");
+  }
+  return StringUtils::Join(words, " ");
+}
+
 bool CDatabase::IsOpen()
 {
   return m_openCount > 0;
@@ -601,6 +715,7 @@ void CDatabase::Close()
 
   m_openCount = 0;
   m_multipleExecute = false;
+  m_fullTextIndices.clear();
 
   if (NULL == m_pDB.get() ) return ;
   if (NULL != m_pDS.get()) m_pDS->close();
@@ -694,10 +809,40 @@ void CDatabase::RollbackTransaction()
 
 bool CDatabase::InTransaction()
 {
-  if (NULL != m_pDB.get()) return false;
+  if (NULL == m_pDB.get()) return false;
   return m_pDB->in_transaction();
 }
 
+CDatabase::CReadScope::CReadScope(CDatabase &db) : m_db(db)
+{
+  if (!m_db.m_sqlite || m_db.m_readers == 0 || m_db.m_inReadScope || m_db.InTransaction())
+    return;
+
+  m_conn = CServiceBroker::GetDatabaseManager().AcquireReadConnection(m_db.m_readHost, m_db.m_readName, m_db.m_readers);
+  if (!m_conn)
+    return;
+
+  m_pDS.reset(m_conn->CreateDataset());
+  m_pDS2.reset(m_conn->CreateDataset());
+  m_pDS.swap(m_db.m_pDS);
+  m_pDS2.swap(m_db.m_pDS2);
+  m_db.m_inReadScope = true;
+}
+
+CDatabase::CReadScope::~CReadScope()
+{
+  if (!m_conn)
+    return;
+
+  // the pooled datasets must go before their connection
+  m_pDS.swap(m_db.m_pDS);
+  m_pDS2.swap(m_db.m_pDS2);
+  m_db.m_inReadScope = false;
+  m_pDS.reset();
+  m_pDS2.reset();
+  CServiceBroker::GetDatabaseManager().ReleaseReadConnection(m_db.m_readHost, m_db.m_readName, std::move(m_conn));
+}
+
 bool CDatabase::CreateDatabase()
 {
   BeginTransaction();
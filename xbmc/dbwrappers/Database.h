@@ -13,6 +13,7 @@ namespace dbiplus {
   class Dataset;
 }
 
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -195,6 +196,41 @@ public:
 
   bool Connect(const std::string &dbName, const DatabaseSettings &db, bool create);
 
+  /*! \brief Check whether a full-text search index created by CreateFullTextIndex() exists.
+   */
+  bool HasFullTextIndex(const std::string &index) const;
+
+  /*! \brief Get a query for the rowids of a full-text index matching the prefixes of all words of a search.
+   \param index name of the index table
+   \param columns indexed columns to search in
+   \param search the user input to search for
+   \return the SELECT statement, or an empty string if there is no such index or the search has no words
+   */
+  std::string GetFullTextQuery(const std::string &index, const std::vector<std::string> &columns, const std::string &search) const;
+
+  /*! \brief Run the read queries in its lifetime on a pooled read-only connection.
+
+   While the scope is alive m_pDS and m_pDS2 are datasets on a read-only connection taken
+   from the CDatabaseManager pool, so that large listings do not serialize behind the
+   connection of this object. Only used for sqlite databases in WAL mode outside of a
+   transaction; otherwise, or if no pooled connection is available, the scope does nothing.
+   Must not be used around code that writes to the database.
+   */
+  class CReadScope
+  {
+  public:
+    explicit CReadScope(CDatabase &db);
+    ~CReadScope();
+    CReadScope(const CReadScope&) = delete;
+    CReadScope& operator=(const CReadScope&) = delete;
+
+  private:
+    CDatabase &m_db;
+    std::unique_ptr<dbiplus::Database> m_conn;
+    std::unique_ptr<dbiplus::Dataset> m_pDS;
+    std::unique_ptr<dbiplus::Dataset> m_pDS2;
+  };
+
 protected:
   friend class CDatabaseManager;
 
@@ -234,6 +270,22 @@ protected:
 
   int GetDBVersion();
 
+  /*! \brief Create or rebuild a full-text search index over columns of a table.
+   The index is an sqlite FTS5 table named index, keyed by the rowid of table and kept
+   current by triggers. Not available for other database types or sqlite builds without FTS5.
+   \param index name of the index table
+   \param table name of the table holding the indexed columns
+   \param key integer primary key of table
+   \param columns columns of table to index
+   \return true if the index was created, false otherwise
+   */
+  bool CreateFullTextIndex(const std::string &index, const std::string &table, const std::string &key, const std::vector<std::string> &columns);
+
+  /*! \brief Turn user search input into an FTS5 query matching the prefixes of all its words.
+   \return the query, or an empty string if the input contains no words
+   */
+  static std::string PrepareFullTextMatch(const std::string &search);
+
   bool BuildSQL(const std::string &strQuery, const Filter &filter, std::string &strSQL);
 
   bool m_sqlite; ///< \brief whether we use sqlite (defaults to true)
@@ -255,4 +307,12 @@ private:
 
   bool m_multipleExecute;
   std::vector<std::string> m_multipleQueries;
+
+  mutable std::map<std::string, bool> m_fullTextIndices; ///< known full-text indices of the open database
+
+  // read-only connection pool parameters, set on connection to a sqlite database
+  std::string m_readHost;
+  std::string m_readName;
+  unsigned int m_readers;
+  bool m_inReadScope;
 };
@@ -37,7 +37,8 @@ static const operatorField operators[] = {
   { "notinthelast",    CDatabaseQueryRule::OPERATOR_NOT_IN_THE_LAST,   21411 },
   { "true",            CDatabaseQueryRule::OPERATOR_TRUE,              20122 },
   { "false",           CDatabaseQueryRule::OPERATOR_FALSE,             20424 },
-  { "between",         CDatabaseQueryRule::OPERATOR_BETWEEN,           21456 }
+  { "between",         CDatabaseQueryRule::OPERATOR_BETWEEN,           21456 },
+  { "matches",         CDatabaseQueryRule::OPERATOR_MATCHES,           21484 }
 };
 
 CDatabaseQueryRule::CDatabaseQueryRule()
@@ -273,6 +274,9 @@ std::string CDatabaseQueryRule::GetOperatorString(SEARCH_OPERATOR op) const
       operatorString = " LIKE '%%%s%%'"; break;
     case OPERATOR_DOES_NOT_CONTAIN:
       operatorString = " LIKE '%%%s%%'"; break;
+    case OPERATOR_MATCHES:
+      // fields without a full-text index
+      operatorString = " LIKE '%%%s%%'"; break;
     case OPERATOR_EQUALS:
       if (GetFieldType(m_field) == REAL_FIELD || GetFieldType(m_field) == NUMERIC_FIELD || GetFieldType(m_field) == SECONDS_FIELD)
         operatorString = " = %s";
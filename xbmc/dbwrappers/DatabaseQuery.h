@@ -41,6 +41,7 @@ public:
                          OPERATOR_TRUE,
                          OPERATOR_FALSE,
                          OPERATOR_BETWEEN,
+                         OPERATOR_MATCHES,
                          OPERATOR_END
                        };
 
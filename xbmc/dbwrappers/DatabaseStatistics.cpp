@@ -0,0 +1,207 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "DatabaseStatistics.h"
+
+#include "threads/SingleLock.h"
+#include "utils/StringUtils.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+namespace
+{
+
+bool IsIdentifierChar(char c)
+{
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+}
+
+} // unnamed namespace
+
+unsigned int CDatabaseLatencyHistogram::GetBucket(uint64_t us)
+{
+  if (us < SUB_BUCKETS)
+    return static_cast<unsigned int>(us);
+
+  unsigned int exponent = 0;
+  for (uint64_t v = us; v > 1; v >>= 1)
+    exponent++;
+
+  // the two bits below the highest set bit select the sub bucket
+  const unsigned int sub = static_cast<unsigned int>(us >> (exponent - 2)) & (SUB_BUCKETS - 1);
+  return std::min(SUB_BUCKETS * (exponent - 1) + sub, BUCKETS - 1);
+}
+
+double CDatabaseLatencyHistogram::GetBucketLimitUs(unsigned int bucket)
+{
+  if (bucket < SUB_BUCKETS)
+    return bucket + 1;
+
+  const unsigned int exponent = bucket / SUB_BUCKETS + 1;
+  const unsigned int sub = bucket % SUB_BUCKETS;
+  return std::ldexp(SUB_BUCKETS + sub + 1, exponent - 2);
+}
+
+void CDatabaseLatencyHistogram::Add(std::chrono::microseconds duration)
+{
+  const uint64_t us = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+  m_buckets[GetBucket(us)]++;
+  m_count++;
+  m_totalUs += us;
+  m_maxUs = std::max(m_maxUs, us);
+}
+
+double CDatabaseLatencyHistogram::GetPercentileMs(double fraction) const
+{
+  if (m_count == 0)
+    return 0.0;
+
+  const uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * m_count)));
+  uint64_t seen = 0;
+  for (unsigned int bucket = 0; bucket < BUCKETS; bucket++)
+  {
+    seen += m_buckets[bucket];
+    if (seen >= target)
+      return std::min(GetBucketLimitUs(bucket), static_cast<double>(m_maxUs)) / 1000.0;
+  }
+  return GetMaxMs();
+}
+
+CDatabaseStatistics& CDatabaseStatistics::GetInstance()
+{
+  static CDatabaseStatistics instance;
+  return instance;
+}
+
+bool CDatabaseStatistics::Record(const std::string& database, const std::string& sql, std::chrono::microseconds duration)
+{
+  if (!m_enabled)
+    return false;
+
+  const bool slow = duration >= std::chrono::milliseconds(m_slowQueryTime.load());
+  if (slow)
+    CLog::Log(LOGDEBUG, LOGDATABASE, "%s: slow query on %s took %.1f ms: %s", __FUNCTION__,
+              database.c_str(), duration.count() / 1000.0, sql.c_str());
+
+  Key key(database, Fingerprint(sql));
+
+  CSingleLock lock(m_critical);
+  auto it = m_statements.find(key);
+  if (it == m_statements.end())
+  {
+    if (m_statements.size() >= MAX_STATEMENTS)
+      return false;
+    it = m_statements.emplace(std::move(key), Entry()).first;
+  }
+
+  it->second.histogram.Add(duration);
+  return slow && !it->second.hasPlan;
+}
+
+void CDatabaseStatistics::SetPlan(const std::string& database, const std::string& sql, const std::vector<std::string>& plan)
+{
+  const Key key(database, Fingerprint(sql));
+
+  CSingleLock lock(m_critical);
+  auto it = m_statements.find(key);
+  if (it == m_statements.end())
+    return;
+
+  it->second.hasPlan = true;
+  it->second.plan = plan;
+
+  for (const auto& step : plan)
+    CLog::Log(LOGDEBUG, LOGDATABASE, "%s: query plan: %s", __FUNCTION__, step.c_str());
+}
+
+std::vector<CDatabaseStatistics::Statement> CDatabaseStatistics::GetStatements() const
+{
+  std::vector<Statement> statements;
+
+  CSingleLock lock(m_critical);
+  statements.reserve(m_statements.size());
+  for (const auto& it : m_statements)
+  {
+    const CDatabaseLatencyHistogram& histogram = it.second.histogram;
+
+    Statement statement;
+    statement.database = it.first.first;
+    statement.fingerprint = it.first.second;
+    statement.count = histogram.GetCount();
+    statement.totalMs = histogram.GetTotalMs();
+    statement.p50Ms = histogram.GetPercentileMs(0.50);
+    statement.p99Ms = histogram.GetPercentileMs(0.99);
+    statement.maxMs = histogram.GetMaxMs();
+    statement.plan = it.second.plan;
+    statements.push_back(std::move(statement));
+  }
+  lock.Leave();
+
+  std::sort(statements.begin(), statements.end(), [](const Statement& a, const Statement& b)
+  {
+    return a.totalMs > b.totalMs;
+  });
+  return statements;
+}
+
+void CDatabaseStatistics::Reset()
+{
+  CSingleLock lock(m_critical);
+  m_statements.clear();
+}
+
+std::string CDatabaseStatistics::Fingerprint(const std::string& sql)
+{
+  std::string fingerprint;
+  fingerprint.reserve(sql.size());
+
+  for (size_t i = 0; i < sql.size(); i++)
+  {
+    const char c = sql[i];
+    if (c == '\'')
+    {
+      // string literal, '' is an escaped quote
+      for (i++; i < sql.size(); i++)
+      {
+        if (sql[i] == '\'')
+        {
+          if (i + 1 < sql.size() && sql[i + 1] == '\'')
+            i++;
+          else
+            break;
+        }
+      }
+      fingerprint += '?';
+    }
+    else if (std::isdigit(static_cast<unsigned char>(c)) &&
+             (fingerprint.empty() || !IsIdentifierChar(fingerprint.back())))
+    {
+      while (i + 1 < sql.size() && (std::isdigit(static_cast<unsigned char>(sql[i + 1])) || sql[i + 1] == '.'))
+        i++;
+      fingerprint += '?';
+    }
+    else if (std::isspace(static_cast<unsigned char>(c)))
+    {
+      if (!fingerprint.empty() && fingerprint.back() != ' ')
+        fingerprint += ' ';
+    }
+    else
+      fingerprint += c;
+  }
+  StringUtils::TrimRight(fingerprint);
+
+  // collapse lists of literals, e.g. IN (?, ?, ?)
+  StringUtils::Replace(fingerprint, "?, ", "?,");
+  while (StringUtils::Replace(fingerprint, "?,?", "?") > 0)
+    ;
+
+  return fingerprint;
+}
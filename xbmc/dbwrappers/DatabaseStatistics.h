@@ -0,0 +1,145 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#pragma once
+
+#include "threads/CriticalSection.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*!
+ \brief Latency histogram of a single statement fingerprint.
+
+ Durations are counted in logarithmic buckets with four buckets per power of
+ two of microseconds, so percentiles are accurate to about 20% while the
+ memory used per statement stays constant.
+ */
+class CDatabaseLatencyHistogram
+{
+public:
+  void Add(std::chrono::microseconds duration);
+
+  uint64_t GetCount() const { return m_count; }
+  double GetTotalMs() const { return m_totalUs / 1000.0; }
+  double GetMaxMs() const { return m_maxUs / 1000.0; }
+
+  /*!
+   \brief Gets the duration below which the given fraction of samples fell.
+   \param fraction the percentile as a fraction, e.g. 0.99 for p99
+   \return the upper bound of the matching bucket in milliseconds, clamped to the maximum
+   */
+  double GetPercentileMs(double fraction) const;
+
+private:
+  static constexpr unsigned int SUB_BUCKETS = 4;
+  static constexpr unsigned int BUCKETS = 40 * SUB_BUCKETS;
+
+  static unsigned int GetBucket(uint64_t us);
+  static double GetBucketLimitUs(unsigned int bucket);
+
+  std::array<uint32_t, BUCKETS> m_buckets{};
+  uint64_t m_count = 0;
+  uint64_t m_totalUs = 0;
+  uint64_t m_maxUs = 0;
+};
+
+/*!
+ \brief Collects timing statistics of all executed SQL statements.
+
+ Statements are grouped by their fingerprint, i.e. the SQL text with all
+ literals replaced by placeholders, so that the same query with different
+ ids is counted once. Statements that take longer than the slow query
+ threshold are logged with the LOGDATABASE component and the query plan of
+ the first slow execution is kept with the statistics.
+
+ Collection is disabled by default and costs a single atomic load per
+ statement while off.
+ */
+class CDatabaseStatistics
+{
+public:
+  struct Statement
+  {
+    std::string fingerprint;
+    std::string database;
+    uint64_t count = 0;
+    double totalMs = 0.0;
+    double p50Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+    std::vector<std::string> plan;
+  };
+
+  static CDatabaseStatistics& GetInstance();
+
+  void SetEnabled(bool enabled) { m_enabled = enabled; }
+  bool IsEnabled() const { return m_enabled; }
+
+  void SetSlowQueryTime(unsigned int milliseconds) { m_slowQueryTime = milliseconds; }
+  unsigned int GetSlowQueryTime() const { return m_slowQueryTime; }
+
+  /*!
+   \brief Records an execution of a statement.
+   \param database name of the database the statement ran on
+   \param sql the statement as executed
+   \param duration time taken to execute the statement and fetch its results
+   \return true if the statement was slow and no query plan is known for it yet
+   \sa SetPlan
+   */
+  bool Record(const std::string& database, const std::string& sql, std::chrono::microseconds duration);
+
+  /*!
+   \brief Stores the query plan of a slow statement reported by Record().
+   */
+  void SetPlan(const std::string& database, const std::string& sql, const std::vector<std::string>& plan);
+
+  /*!
+   \brief Gets the statistics of all recorded statements, slowest total time first.
+   */
+  std::vector<Statement> GetStatements() const;
+
+  void Reset();
+
+  /*!
+   \brief Normalizes a statement so that executions differing only in their
+   literal values share the same fingerprint.
+
+   String and numeric literals are replaced by ?, lists of literals such as
+   IN (1,2,3) are collapsed to a single (?) and whitespace is collapsed.
+   */
+  static std::string Fingerprint(const std::string& sql);
+
+private:
+  CDatabaseStatistics() = default;
+  CDatabaseStatistics(const CDatabaseStatistics&) = delete;
+  CDatabaseStatistics& operator=(const CDatabaseStatistics&) = delete;
+
+  struct Entry
+  {
+    CDatabaseLatencyHistogram histogram;
+    bool hasPlan = false;
+    std::vector<std::string> plan;
+  };
+
+  using Key = std::pair<std::string, std::string>;
+
+  //! maximum number of distinct statements kept, further ones are not recorded
+  static constexpr size_t MAX_STATEMENTS = 1000;
+
+  std::atomic<bool> m_enabled{false};
+  std::atomic<unsigned int> m_slowQueryTime{100};
+
+  mutable CCriticalSection m_critical;
+  std::map<Key, Entry> m_statements;
+};
@@ -186,6 +186,63 @@ void Dataset::parse_sql(std::string &sql) {
 }
 
 
+std::string Dataset::bind_sql(const std::string &sql, const BindList &params) {
+  if (db == NULL) throw DbErrors("No Database Connection");
+
+  std::string result;
+  result.reserve(sql.size() + params.size() * 16);
+  size_t param = 0;
+  bool quoted = false;
+  for (char c : sql) {
+    if (c == '\'')
+      quoted = !quoted;
+    if (c != '?' || quoted) {
+      result += c;
+      continue;
+    }
+    if (param >= params.size())
+      throw DbErrors("Not enough parameters bound to query: %s", sql.c_str());
+
+    const field_value &v = params[param++];
+    if (v.get_isNull()) {
+      result += "NULL";
+      continue;
+    }
+    switch (v.get_fType()) {
+      case ft_Boolean:
+        result += v.get_asBool() ? "1" : "0";
+        break;
+      case ft_Float:
+      case ft_Double:
+        result += db->prepare("%.15g", v.get_asDouble());
+        break;
+      case ft_Short:
+      case ft_UShort:
+      case ft_Int:
+      case ft_UInt:
+      case ft_Int64:
+        result += v.get_asString();
+        break;
+      default:
+        result += db->prepare("'%s'", v.get_asString().c_str());
+        break;
+    }
+  }
+  if (param != params.size())
+    throw DbErrors("Too many parameters bound to query: %s", sql.c_str());
+
+  return result;
+}
+
+int Dataset::exec_prepared(const std::string &sql, const BindList &params) {
+  return exec(bind_sql(sql, params));
+}
+
+bool Dataset::query_prepared(const std::string &sql, const BindList &params) {
+  return query(bind_sql(sql, params));
+}
+
+
 void Dataset::close(void) {
   haveError  = false;
   frecno = 0;
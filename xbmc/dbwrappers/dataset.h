@@ -149,6 +149,16 @@ public:
 
   virtual bool in_transaction() {return false;};
 
+/* virtual methods for prepared statements */
+
+  /*! \brief Set the maximum number of compiled statements kept per connection.
+   \param size - number of statements to cache, 0 disables caching.
+   */
+  virtual void setStatementCacheSize(unsigned int size) {}
+
+  /*! \brief Drop all compiled statements held by this connection. */
+  virtual void clearStatementCache() {}
+
 };
 
 
@@ -167,6 +177,7 @@ enum sqlType {sqlSelect,sqlUpdate,sqlInsert,sqlDelete,sqlExec};
 
 typedef std::list<std::string> StringList;
 typedef std::map<std::string,field_value> ParamList;
+typedef std::vector<field_value> BindList;
 
 
 class Dataset  {
@@ -244,6 +255,9 @@ protected:
 /* Parse Sql - replacing fields with prefixes :OLD_ and :NEW_ with current values of OLD or NEW field. */
   void parse_sql(std::string &sql);
 
+/* Substitute '?' placeholders in sql with the escaped literal values of params */
+  std::string bind_sql(const std::string &sql, const BindList &params);
+
 /* Returns old field value (for :OLD) */
   virtual const field_value f_old(const char *f);
 
@@ -292,6 +306,30 @@ public:
   virtual const void* getExecRes()=0;
 /* as open, but with our query exec Sql */
   virtual bool query(const std::string &sql) = 0;
+
+  /*! \brief Execute a statement without results, binding params to its '?' placeholders in order.
+   Backends that support it compile the statement once and reuse it on later calls,
+   others fall back to exec() on the statement with the values substituted.
+   \param sql - statement with '?' placeholders, passed to the backend verbatim.
+   \param params - values to bind, a null field_value binds NULL.
+   \return DB_COMMAND_OK on success, throws DbErrors on failure.
+   */
+  virtual int exec_prepared(const std::string &sql, const BindList &params);
+
+  /*! \brief As exec_prepared, but for a SELECT statement whose results are opened in the dataset.
+   \sa exec_prepared
+   */
+  virtual bool query_prepared(const std::string &sql, const BindList &params);
+
+  /*! \brief Open a SELECT query as a forward-only stream.
+   Backends that support it read rows on demand into a single reused record instead
+   of materializing the whole result set, so only first row access, next(), eof(),
+   fv() and get_sql_record() are valid and num_rows() is the number of rows read so far.
+   Others fall back to query().
+   \param sql - the SELECT statement to run.
+   \return true if the query was opened, throws DbErrors on failure.
+   */
+  virtual bool query_stream(const std::string &sql) { return query(sql); }
 /* Close SQL Query*/
   virtual void close();
 /* This function looks for field Field_name with value equal Field_value
@@ -42,6 +42,13 @@ field_value::field_value(const char *s):
   is_null = false;
 }
 
+field_value::field_value(const std::string &s):
+  str_value(s)
+{
+  field_type = ft_String;
+  is_null = false;
+}
+
 field_value::field_value(const bool b) {
   bool_value = b;
   field_type = ft_Boolean;
@@ -99,7 +106,7 @@ field_value::field_value(const int64_t i) {
 field_value::field_value (const field_value & fv) {
   switch (fv.get_fType()) {
     case ft_String: {
-      set_asString(fv.get_asString());
+      set_asString(fv.str_value);
       break;
     }
     case ft_Boolean:{
@@ -575,7 +582,8 @@ field_value& field_value::operator= (const field_value & fv) {
 
   switch (fv.get_fType()) {
     case ft_String: {
-      set_asString(fv.get_asString());
+      // assign directly to reuse the capacity of our string
+      set_asString(fv.str_value);
       return *this;
       break;
     }
@@ -16,6 +16,7 @@
 #include <sstream>
 
 #include "sqlitedataset.h"
+#include "DatabaseStatistics.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
 
@@ -156,6 +157,9 @@ const std::map<int, const char*> g_SqliteErrorStrings =
 #endif
 };
 #undef X
+
+// Number of compiled statements kept per connection by default
+constexpr unsigned int DEFAULT_STATEMENT_CACHE_SIZE = 64;
 }
 
 namespace dbiplus {
@@ -209,6 +213,10 @@ SqliteDatabase::SqliteDatabase() {
 
   active = false;
   _in_transaction = false;    // for transaction
+  read_only = false;
+  conn = NULL;
+  last_err = SQLITE_OK;
+  stmt_cache_size = DEFAULT_STATEMENT_CACHE_SIZE;
 
   error = "Unknown database error";//S_NO_CONNECTION;
   host = "localhost";
@@ -297,8 +305,8 @@ int SqliteDatabase::connect(bool create) {
   try
   {
     disconnect();
-    int flags = SQLITE_OPEN_READWRITE;
-    if (create)
+    int flags = read_only ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE;
+    if (create && !read_only)
       flags |= SQLITE_OPEN_CREATE;
     int errorCode = sqlite3_open_v2(db_fullpath.c_str(), &conn, flags, NULL);
     if (create && errorCode == SQLITE_CANTOPEN)
@@ -315,7 +323,7 @@ int SqliteDatabase::connect(bool create) {
       {
         throw DbErrors("%s", getErrorMsg());
       }
-      else if (sqlite3_db_readonly(conn, nullptr) == 1)
+      else if (!read_only && sqlite3_db_readonly(conn, nullptr) == 1)
       {
         CLog::Log(LOGFATAL, "SqliteDatabase: %s is read only", db_fullpath.c_str());
         throw std::runtime_error("SqliteDatabase: " + db_fullpath + " is read only");
@@ -352,6 +360,8 @@ bool SqliteDatabase::exists(void)
 
 void SqliteDatabase::disconnect(void) {
   if (active == false) return;
+  // sqlite3_close fails while statements are still compiled
+  clearStatementCache();
   sqlite3_close(conn);
   active = false;
 }
@@ -507,6 +517,59 @@ void SqliteDatabase::rollback_transaction() {
 }
 
 
+// methods for prepared statements
+// ---------------------------------------------
+void SqliteDatabase::setStatementCacheSize(unsigned int size) {
+  stmt_cache_size = size;
+  trimStatementCache(size);
+}
+
+void SqliteDatabase::clearStatementCache() {
+  trimStatementCache(0);
+}
+
+void SqliteDatabase::trimStatementCache(unsigned int size) {
+  while (stmt_cache.size() > size) {
+    sqlite3_finalize(stmt_cache.back().second);
+    stmt_index.erase(stmt_cache.back().first);
+    stmt_cache.pop_back();
+  }
+}
+
+sqlite3_stmt *SqliteDatabase::getStatement(const std::string &sql) {
+  if (!active) throw DbErrors("No Database Connection");
+
+  auto it = stmt_index.find(sql);
+  if (it != stmt_index.end()) {
+    // move to the front of the LRU list
+    stmt_cache.splice(stmt_cache.begin(), stmt_cache, it->second);
+    return it->second->second;
+  }
+
+  sqlite3_stmt *stmt = NULL;
+  if (setErr(sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, NULL), sql.c_str()) != SQLITE_OK) {
+    sqlite3_finalize(stmt);
+    throw DbErrors("%s", getErrorMsg());
+  }
+
+  if (stmt_cache_size > 0) {
+    trimStatementCache(stmt_cache_size - 1);
+    stmt_cache.emplace_front(sql, stmt);
+    stmt_index[sql] = stmt_cache.begin();
+  }
+  return stmt;
+}
+
+int SqliteDatabase::releaseStatement(sqlite3_stmt *stmt) {
+  int rc = sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+  // statements are only left uncached when caching is disabled
+  if (stmt_cache_size == 0)
+    sqlite3_finalize(stmt);
+  return rc;
+}
+
+
 // methods for formatting
 // ---------------------------------------------
 std::string SqliteDatabase::vprepare(const char *format, va_list args)
@@ -580,6 +643,9 @@ SqliteDataset::SqliteDataset():Dataset() {
   db = NULL;
   errmsg = NULL;
   autorefresh = false;
+  stream_stmt = NULL;
+  stream_rows = 0;
+  stream_time = std::chrono::steady_clock::duration::zero();
 }
 
 
@@ -588,9 +654,13 @@ SqliteDataset::SqliteDataset(SqliteDatabase *newDb):Dataset(newDb) {
   db = newDb;
   errmsg = NULL;
   autorefresh = false;
+  stream_stmt = NULL;
+  stream_rows = 0;
+  stream_time = std::chrono::steady_clock::duration::zero();
 }
 
  SqliteDataset::~SqliteDataset(){
+   finish_stream();
    if (errmsg) sqlite3_free(errmsg);
  }
 
@@ -755,8 +825,12 @@ int SqliteDataset::exec(const std::string &sql) {
       qry = qry.substr(0, pos);
   }
 
+  const auto start = std::chrono::steady_clock::now();
   if((res = db->setErr(sqlite3_exec(handle(),qry.c_str(),&callback,&exec_res,&errmsg),qry.c_str())) == SQLITE_OK)
+  {
+    record_statistics(qry, start);
     return res;
+  }
   else
     {
       if (errmsg)
@@ -775,6 +849,93 @@ const void* SqliteDataset::getExecRes() {
 }
 
 
+int SqliteDataset::fetch_rows(sqlite3_stmt *stmt) {
+  // column headers
+  const unsigned int numColumns = sqlite3_column_count(stmt);
+  result.record_header.resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+    result.record_header[i].name = sqlite3_column_name(stmt, i);
+
+  // returned rows
+  int rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+  { // have a row of data
+    sql_record *res = new sql_record;
+    read_row(stmt, *res);
+    result.records.push_back(res);
+  }
+  return rc;
+}
+
+void SqliteDataset::read_row(sqlite3_stmt *stmt, sql_record &rec) {
+  const unsigned int numColumns = sqlite3_column_count(stmt);
+  rec.resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+  {
+    field_value &v = rec[i];
+    v.set_isNull(false);
+    switch (sqlite3_column_type(stmt, i))
+    {
+    case SQLITE_INTEGER:
+      v.set_asInt64(sqlite3_column_int64(stmt, i));
+      break;
+    case SQLITE_FLOAT:
+      v.set_asDouble(sqlite3_column_double(stmt, i));
+      break;
+    case SQLITE_TEXT:
+      v.set_asString((const char *)sqlite3_column_text(stmt, i));
+      break;
+    case SQLITE_BLOB:
+      v.set_asString((const char *)sqlite3_column_text(stmt, i));
+      break;
+    case SQLITE_NULL:
+    default:
+      v.set_asString("");
+      v.set_isNull();
+      break;
+    }
+  }
+}
+
+void SqliteDataset::bind_params(sqlite3_stmt *stmt, const std::string &sql, const BindList &params) {
+  if (sqlite3_bind_parameter_count(stmt) != static_cast<int>(params.size()))
+    throw DbErrors("Expected %d parameters, got %d for query: %s",
+                   sqlite3_bind_parameter_count(stmt), static_cast<int>(params.size()), sql.c_str());
+
+  for (unsigned int i = 0; i < params.size(); i++) {
+    const field_value &v = params[i];
+    const int index = i + 1;
+    int rc = SQLITE_OK;
+    if (v.get_isNull())
+      rc = sqlite3_bind_null(stmt, index);
+    else {
+      switch (v.get_fType()) {
+        case ft_Boolean:
+        case ft_Char:
+        case ft_Short:
+        case ft_UShort:
+        case ft_Int:
+        case ft_UInt:
+        case ft_Int64:
+          rc = sqlite3_bind_int64(stmt, index, v.get_asInt64());
+          break;
+        case ft_Float:
+        case ft_Double:
+          rc = sqlite3_bind_double(stmt, index, v.get_asDouble());
+          break;
+        default:
+        {
+          const std::string str = v.get_asString();
+          rc = sqlite3_bind_text(stmt, index, str.c_str(), str.size(), SQLITE_TRANSIENT);
+          break;
+        }
+      }
+    }
+    if (db->setErr(rc, sql.c_str()) != SQLITE_OK)
+      throw DbErrors("%s", db->getErrorMsg());
+  }
+}
+
 bool SqliteDataset::query(const std::string &query) {
     if(!handle()) throw DbErrors("No Database Connection");
     std::string qry = query;
@@ -785,49 +946,15 @@ bool SqliteDataset::query(const std::string &query) {
 
   close();
 
+  const auto start = std::chrono::steady_clock::now();
   sqlite3_stmt *stmt = NULL;
   if (db->setErr(sqlite3_prepare_v2(handle(),query.c_str(),-1,&stmt, NULL),query.c_str()) != SQLITE_OK)
     throw DbErrors("%s", db->getErrorMsg());
 
-  // column headers
-  const unsigned int numColumns = sqlite3_column_count(stmt);
-  result.record_header.resize(numColumns);
-  for (unsigned int i = 0; i < numColumns; i++)
-    result.record_header[i].name = sqlite3_column_name(stmt, i);
-
-  // returned rows
-  while (sqlite3_step(stmt) == SQLITE_ROW)
-  { // have a row of data
-    sql_record *res = new sql_record;
-    res->resize(numColumns);
-    for (unsigned int i = 0; i < numColumns; i++)
-    {
-      field_value &v = res->at(i);
-      switch (sqlite3_column_type(stmt, i))
-      {
-      case SQLITE_INTEGER:
-        v.set_asInt64(sqlite3_column_int64(stmt, i));
-        break;
-      case SQLITE_FLOAT:
-        v.set_asDouble(sqlite3_column_double(stmt, i));
-        break;
-      case SQLITE_TEXT:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_BLOB:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_NULL:
-      default:
-        v.set_asString("");
-        v.set_isNull();
-        break;
-      }
-    }
-    result.records.push_back(res);
-  }
+  fetch_rows(stmt);
   if (db->setErr(sqlite3_finalize(stmt),query.c_str()) == SQLITE_OK)
   {
+    record_statistics(query, start);
     active = true;
     ds_state = dsSelect;
     this->first();
@@ -839,6 +966,167 @@ bool SqliteDataset::query(const std::string &query) {
   }
 }
 
+int SqliteDataset::exec_prepared(const std::string &sql, const BindList &params) {
+  if (!handle()) throw DbErrors("No Database Connection");
+  exec_res.clear();
+
+  const auto start = std::chrono::steady_clock::now();
+  SqliteDatabase *sqlite = static_cast<SqliteDatabase*>(db);
+  sqlite3_stmt *stmt = sqlite->getStatement(sql);
+  int rc;
+  try {
+    bind_params(stmt, sql, params);
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+      ;
+  }
+  catch (...) {
+    sqlite->releaseStatement(stmt);
+    throw;
+  }
+  sqlite->releaseStatement(stmt);
+
+  if (db->setErr(rc == SQLITE_DONE ? SQLITE_OK : rc, sql.c_str()) != SQLITE_OK)
+    throw DbErrors("%s", db->getErrorMsg());
+  record_statistics(sql, start);
+  return SQLITE_OK;
+}
+
+bool SqliteDataset::query_prepared(const std::string &sql, const BindList &params) {
+  if (!handle()) throw DbErrors("No Database Connection");
+
+  close();
+
+  const auto start = std::chrono::steady_clock::now();
+  SqliteDatabase *sqlite = static_cast<SqliteDatabase*>(db);
+  sqlite3_stmt *stmt = sqlite->getStatement(sql);
+  int rc;
+  try {
+    bind_params(stmt, sql, params);
+    rc = fetch_rows(stmt);
+  }
+  catch (...) {
+    sqlite->releaseStatement(stmt);
+    throw;
+  }
+  sqlite->releaseStatement(stmt);
+
+  if (db->setErr(rc == SQLITE_DONE ? SQLITE_OK : rc, sql.c_str()) != SQLITE_OK)
+    throw DbErrors("%s", db->getErrorMsg());
+  record_statistics(sql, start);
+
+  active = true;
+  ds_state = dsSelect;
+  this->first();
+  return true;
+}
+
+bool SqliteDataset::query_stream(const std::string &sql) {
+  if (!handle()) throw DbErrors("No Database Connection");
+
+  close();
+
+  const auto start = std::chrono::steady_clock::now();
+  if (db->setErr(sqlite3_prepare_v2(handle(), sql.c_str(), -1, &stream_stmt, NULL), sql.c_str()) != SQLITE_OK)
+  {
+    sqlite3_finalize(stream_stmt);
+    stream_stmt = NULL;
+    throw DbErrors("%s", db->getErrorMsg());
+  }
+  stream_sql = sql;
+  stream_time = std::chrono::steady_clock::now() - start;
+
+  // column headers
+  const unsigned int numColumns = sqlite3_column_count(stream_stmt);
+  result.record_header.resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+    result.record_header[i].name = sqlite3_column_name(stream_stmt, i);
+
+  // the current row is kept as the only record and overwritten in place by next()
+  result.records.push_back(new sql_record);
+
+  active = true;
+  ds_state = dsSelect;
+  frecno = 0;
+  fbof = true;
+  step_stream();
+  return true;
+}
+
+void SqliteDataset::step_stream() {
+  // only the time spent in sqlite counts, not the caller's work on each row
+  const auto start = std::chrono::steady_clock::now();
+  const int rc = sqlite3_step(stream_stmt);
+  stream_time += std::chrono::steady_clock::now() - start;
+  if (rc == SQLITE_ROW)
+  {
+    read_row(stream_stmt, *result.records[0]);
+    stream_rows++;
+    feof = false;
+    fill_fields();
+  }
+  else if (rc == SQLITE_DONE)
+  {
+    feof = true;
+    if (stream_rows == 0)
+      fbof = true;
+  }
+  else
+  {
+    feof = true;
+    db->setErr(rc, sqlite3_sql(stream_stmt));
+    throw DbErrors("%s", db->getErrorMsg());
+  }
+}
+
+void SqliteDataset::finish_stream() {
+  if (!stream_stmt)
+    return;
+
+  sqlite3_finalize(stream_stmt);
+  stream_stmt = NULL;
+  stream_rows = 0;
+
+  // the whole stream is one query, from preparing it up to the last row stepped to
+  if (db && handle())
+    record_statistics(stream_sql, stream_time);
+  stream_sql.clear();
+}
+
+void SqliteDataset::record_statistics(const std::string &sql, std::chrono::steady_clock::time_point start) {
+  record_statistics(sql, std::chrono::steady_clock::now() - start);
+}
+
+void SqliteDataset::record_statistics(const std::string &sql, std::chrono::steady_clock::duration elapsed) {
+  CDatabaseStatistics &statistics = CDatabaseStatistics::GetInstance();
+  if (!statistics.IsEnabled())
+    return;
+
+  const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+  if (!statistics.Record(db->getDatabase(), sql, duration))
+    return;
+
+  // only the first statement is explained, any further ones in sql must not run again
+  const std::string explain = "EXPLAIN QUERY PLAN " + sql;
+  sqlite3_stmt *stmt = NULL;
+  if (sqlite3_prepare_v2(handle(), explain.c_str(), -1, &stmt, NULL) != SQLITE_OK || !stmt)
+  {
+    sqlite3_finalize(stmt);
+    return;
+  }
+
+  // the detail column describes each step, e.g. "SCAN TABLE song"
+  std::vector<std::string> plan;
+  while (sqlite3_step(stmt) == SQLITE_ROW)
+  {
+    const unsigned char *detail = sqlite3_column_text(stmt, sqlite3_column_count(stmt) - 1);
+    if (detail)
+      plan.emplace_back(reinterpret_cast<const char*>(detail));
+  }
+  sqlite3_finalize(stmt);
+
+  statistics.SetPlan(db->getDatabase(), sql, plan);
+}
+
 void SqliteDataset::open(const std::string &sql) {
   set_select_sql(sql);
   open();
@@ -855,6 +1143,7 @@ void SqliteDataset::open() {
 
 
 void SqliteDataset::close() {
+  finish_stream();
   Dataset::close();
   result.clear();
   edit_object->clear();
@@ -875,6 +1164,8 @@ void SqliteDataset::cancel() {
 
 
 int SqliteDataset::num_rows() {
+  if (stream_stmt)
+    return stream_rows;
   return result.records.size();
 }
 
@@ -905,6 +1196,15 @@ void SqliteDataset::prev(void) {
 }
 
 void SqliteDataset::next(void) {
+  if (stream_stmt)
+  {
+    if (!feof)
+    {
+      fbof = false;
+      step_stream();
+    }
+    return;
+  }
   Dataset::next();
   if (!eof())
       fill_fields();
@@ -12,7 +12,11 @@
 
 #pragma once
 
+#include <chrono>
+#include <list>
 #include <stdio.h>
+#include <unordered_map>
+#include <utility>
 #include "dataset.h"
 #include <sqlite3.h>
 
@@ -27,8 +31,18 @@ protected:
 /* connect descriptor */
   sqlite3 *conn;
   bool _in_transaction;
+  bool read_only;
   int last_err;
 
+/* compiled statements, most recently used first */
+  typedef std::list<std::pair<std::string, sqlite3_stmt*> > StatementList;
+  StatementList stmt_cache;
+  std::unordered_map<std::string, StatementList::iterator> stmt_index;
+  unsigned int stmt_cache_size;
+
+/* finalize least recently used statements until at most size remain */
+  void trimStatementCache(unsigned int size);
+
 public:
 /* default constructor */
   SqliteDatabase();
@@ -48,6 +62,8 @@ public:
   void setHostName(const char *newHost) override;
 /* sets a database name */
   void setDatabase(const char *newDb) override;
+/* open the database read-only on the next connect */
+  void setReadOnly(bool readOnly) { read_only = readOnly; }
 
 /* func. connects to database-server */
 
@@ -80,6 +96,22 @@ public:
 
   bool in_transaction() override {return _in_transaction;};
 
+/* methods for prepared statements */
+  void setStatementCacheSize(unsigned int size) override;
+  void clearStatementCache() override;
+
+  /*! \brief Get a compiled statement for sql, from the cache if possible.
+   Every statement returned must be handed back through releaseStatement() once stepped.
+   \param sql - the statement to compile.
+   \return the compiled statement, throws DbErrors if it fails to compile.
+   */
+  sqlite3_stmt *getStatement(const std::string &sql);
+
+  /*! \brief Reset a statement obtained from getStatement() so it can be reused.
+   \param stmt - the statement to release.
+   \return the result code of the last evaluation of the statement.
+   */
+  int releaseStatement(sqlite3_stmt *stmt);
 };
 
 
@@ -111,6 +143,27 @@ protected:
 /* Changing field values during dataset navigation */
   virtual void free_row();  // free the memory allocated for the current row
 
+/* Bind params to the placeholders of a compiled statement */
+  void bind_params(sqlite3_stmt *stmt, const std::string &sql, const BindList &params);
+/* Step through a compiled statement and store the rows returned, returns the last step result */
+  int fetch_rows(sqlite3_stmt *stmt);
+/* Read the columns of the current row of a compiled statement into rec */
+  void read_row(sqlite3_stmt *stmt, sql_record &rec);
+/* Step the streamed statement to its next row */
+  void step_stream();
+/* Finalize the streamed statement and record its statistics */
+  void finish_stream();
+/* Record the execution time of a statement and capture its plan if it was slow */
+  void record_statistics(const std::string &sql, std::chrono::steady_clock::time_point start);
+  void record_statistics(const std::string &sql, std::chrono::steady_clock::duration elapsed);
+
+/* statement of a query opened by query_stream(), NULL otherwise */
+  sqlite3_stmt *stream_stmt;
+  int stream_rows;
+/* sql of the streamed statement and the time spent preparing and stepping it */
+  std::string stream_sql;
+  std::chrono::steady_clock::duration stream_time;
+
 public:
 /* constructor */
   SqliteDataset();
@@ -132,6 +185,10 @@ or insert() operations default = false) */
   const void* getExecRes() override;
 /* as open, but with our query exec Sql */
   bool query(const std::string &query) override;
+/* prepared statement variants of exec and query */
+  int exec_prepared(const std::string &sql, const BindList &params) override;
+  bool query_prepared(const std::string &sql, const BindList &params) override;
+  bool query_stream(const std::string &sql) override;
 /* func. closes a query */
   void close(void) override;
 /* Cancel changes, made in insert or edit states of dataset */
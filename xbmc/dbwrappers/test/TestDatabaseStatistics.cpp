@@ -0,0 +1,211 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "FileItem.h"
+#include "dbwrappers/DatabaseStatistics.h"
+#include "dbwrappers/sqlitedataset.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "music/MusicDatabase.h"
+#include "settings/AdvancedSettings.h"
+#include "utils/StringUtils.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono;
+
+class TestDatabaseStatistics : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    statistics.Reset();
+    statistics.SetEnabled(true);
+    statistics.SetSlowQueryTime(100);
+  }
+
+  void TearDown() override
+  {
+    statistics.SetEnabled(false);
+    statistics.Reset();
+  }
+
+  CDatabaseStatistics& statistics = CDatabaseStatistics::GetInstance();
+};
+
+TEST_F(TestDatabaseStatistics, Fingerprint)
+{
+  EXPECT_EQ("SELECT * FROM song WHERE idSong = ?",
+            CDatabaseStatistics::Fingerprint("SELECT * FROM song WHERE idSong = 42"));
+  EXPECT_EQ("SELECT c00, c12 FROM movie WHERE c00 LIKE ? AND rating > ?",
+            CDatabaseStatistics::Fingerprint("SELECT c00, c12 FROM movie\n  WHERE c00 LIKE '%it''s%'  AND rating > 7.5"));
+  EXPECT_EQ("DELETE FROM song WHERE idSong IN (?)",
+            CDatabaseStatistics::Fingerprint("DELETE FROM song WHERE idSong IN (1, 2,3,  4)"));
+  EXPECT_EQ("INSERT INTO art (media_id, type) VALUES (?)",
+            CDatabaseStatistics::Fingerprint("INSERT INTO art (media_id, type) VALUES (7, 'thumb')"));
+}
+
+TEST_F(TestDatabaseStatistics, Percentiles)
+{
+  CDatabaseLatencyHistogram histogram;
+  EXPECT_DOUBLE_EQ(0.0, histogram.GetPercentileMs(0.5));
+
+  for (int i = 0; i < 99; i++)
+    histogram.Add(microseconds(1000));
+  histogram.Add(milliseconds(100));
+
+  EXPECT_EQ(100u, histogram.GetCount());
+  EXPECT_NEAR(1.0, histogram.GetPercentileMs(0.50), 0.25);
+  EXPECT_NEAR(1.0, histogram.GetPercentileMs(0.99), 0.25);
+  EXPECT_DOUBLE_EQ(100.0, histogram.GetPercentileMs(1.0));
+  EXPECT_DOUBLE_EQ(100.0, histogram.GetMaxMs());
+  EXPECT_DOUBLE_EQ(199.0, histogram.GetTotalMs());
+}
+
+TEST_F(TestDatabaseStatistics, Record)
+{
+  EXPECT_FALSE(statistics.Record("db", "SELECT 1 FROM song WHERE idSong = 1", milliseconds(1)));
+  EXPECT_TRUE(statistics.Record("db", "SELECT 1 FROM song WHERE idSong = 2", milliseconds(200)));
+  statistics.SetPlan("db", "SELECT 1 FROM song WHERE idSong = 2", {"SEARCH TABLE song USING INTEGER PRIMARY KEY (rowid=?)"});
+  EXPECT_FALSE(statistics.Record("db", "SELECT 1 FROM song WHERE idSong = 3", milliseconds(200)));
+
+  std::vector<CDatabaseStatistics::Statement> statements = statistics.GetStatements();
+  ASSERT_EQ(1u, statements.size());
+  EXPECT_EQ("db", statements[0].database);
+  EXPECT_EQ("SELECT ? FROM song WHERE idSong = ?", statements[0].fingerprint);
+  EXPECT_EQ(3u, statements[0].count);
+  EXPECT_EQ(1u, statements[0].plan.size());
+
+  statistics.SetEnabled(false);
+  EXPECT_FALSE(statistics.Record("db", "SELECT 1 FROM album", milliseconds(200)));
+  EXPECT_EQ(1u, statistics.GetStatements().size());
+}
+
+TEST_F(TestDatabaseStatistics, StreamedQuery)
+{
+  dbiplus::SqliteDatabase db;
+  db.setHostName(CSpecialProtocol::TranslatePath("special://temp/").c_str());
+  db.setDatabase("TestDatabaseStatistics.db");
+  ASSERT_EQ(DB_CONNECTION_OK, db.connect(true));
+
+  {
+    std::unique_ptr<dbiplus::Dataset> ds(db.CreateDataset());
+    ds->exec("CREATE TABLE item (id INTEGER)");
+    db.start_transaction();
+    for (int id = 1; id <= 100; id++)
+      ds->exec(StringUtils::Format("INSERT INTO item (id) VALUES (%d)", id));
+    db.commit_transaction();
+
+    statistics.Reset();
+    ASSERT_TRUE(ds->query_stream("SELECT id FROM item WHERE id > 10"));
+    int rows = 0;
+    while (!ds->eof())
+    {
+      rows++;
+      ds->next();
+    }
+    EXPECT_EQ(90, rows);
+
+    // the stream is one query, recorded once it is closed
+    EXPECT_TRUE(statistics.GetStatements().empty());
+    ds->close();
+
+    std::vector<CDatabaseStatistics::Statement> statements = statistics.GetStatements();
+    ASSERT_EQ(1u, statements.size());
+    EXPECT_EQ("SELECT id FROM item WHERE id > ?", statements[0].fingerprint);
+    EXPECT_EQ(1u, statements[0].count);
+  }
+
+  db.disconnect();
+  XFILE::CFile::Delete("special://temp/TestDatabaseStatistics.db");
+}
+
+/*!
+ Benchmark of the music library queries on a synthetic library. Run it with
+ --gtest_also_run_disabled_tests --gtest_filter=TestDatabaseStatistics.*
+ and compare the printed statistics before and after a schema change.
+ */
+TEST_F(TestDatabaseStatistics, DISABLED_SyntheticMusicLibrary)
+{
+  const int artists = 2000;
+  const int albumsPerArtist = 5;
+  const int songsPerAlbum = 12;
+
+  DatabaseSettings settings;
+  settings.type = "sqlite3";
+  settings.host = CSpecialProtocol::TranslatePath("special://temp/");
+
+  CMusicDatabase database;
+  ASSERT_TRUE(database.Connect("benchmark", settings, true));
+
+  database.BeginTransaction();
+  database.ExecuteQuery("DELETE FROM song_artist");
+  database.ExecuteQuery("DELETE FROM album_artist");
+  database.ExecuteQuery("DELETE FROM song");
+  database.ExecuteQuery("DELETE FROM album");
+  database.ExecuteQuery("DELETE FROM path");
+  database.ExecuteQuery("DELETE FROM artist WHERE idArtist > 1");
+  int idAlbum = 0;
+  int idSong = 0;
+  for (int idArtist = 2; idArtist < artists + 2; idArtist++)
+  {
+    const std::string artist = StringUtils::Format("Artist %d", idArtist);
+    database.ExecuteQuery(StringUtils::Format("INSERT INTO artist (idArtist, strArtist) VALUES (%d, '%s')", idArtist, artist.c_str()));
+    database.ExecuteQuery(StringUtils::Format("INSERT INTO path (idPath, strPath) VALUES (%d, '/music/%s/')", idArtist, artist.c_str()));
+    for (int album = 0; album < albumsPerArtist; album++)
+    {
+      idAlbum++;
+      database.ExecuteQuery(StringUtils::Format("INSERT INTO album (idAlbum, strAlbum, strArtistDisp, iYear, strReleaseType) VALUES (%d, 'Album %d', '%s', %d, 'album')",
+                                                idAlbum, idAlbum, artist.c_str(), 1950 + idAlbum % 70));
+      database.ExecuteQuery(StringUtils::Format("INSERT INTO album_artist (idArtist, idAlbum, iOrder, strArtist) VALUES (%d, %d, 0, '%s')", idArtist, idAlbum, artist.c_str()));
+      for (int track = 1; track <= songsPerAlbum; track++)
+      {
+        idSong++;
+        database.ExecuteQuery(StringUtils::Format("INSERT INTO song (idSong, idAlbum, idPath, strArtistDisp, strTitle, iTrack, iDuration, strFileName, iTimesPlayed) "
+                                                  "VALUES (%d, %d, %d, '%s', 'Song %d', %d, 240, '%d.flac', %d)",
+                                                  idSong, idAlbum, idArtist, artist.c_str(), idSong, track, idSong, idSong % 7));
+        database.ExecuteQuery(StringUtils::Format("INSERT INTO song_artist (idArtist, idSong, idRole, iOrder, strArtist) VALUES (%d, %d, 1, 0, '%s')", idArtist, idSong, artist.c_str()));
+      }
+    }
+  }
+  ASSERT_TRUE(database.CommitTransaction());
+
+  statistics.Reset();
+  statistics.SetSlowQueryTime(10);
+
+  const auto start = steady_clock::now();
+  for (int i = 0; i < 5; i++)
+  {
+    CFileItemList items;
+    EXPECT_TRUE(database.GetArtistsNav("musicdb://artists/", items));
+    items.Clear();
+    EXPECT_TRUE(database.GetAlbumsNav("musicdb://albums/", items));
+    items.Clear();
+    EXPECT_TRUE(database.GetSongsNav("musicdb://songs/", items, -1, i + 2, -1));
+    items.Clear();
+    EXPECT_TRUE(database.Search(StringUtils::Format("Song %d", i * 100 + 1), items));
+  }
+  const auto elapsed = duration_cast<milliseconds>(steady_clock::now() - start);
+
+  std::cout << "synthetic library of " << idSong << " songs queried in " << elapsed.count() << " ms" << std::endl;
+  for (const auto& statement : statistics.GetStatements())
+  {
+    std::cout << StringUtils::Format("%6u %9.2f ms p50 %8.2f ms p99 %8.2f ms  %s",
+                                     static_cast<unsigned int>(statement.count), statement.totalMs,
+                                     statement.p50Ms, statement.p99Ms, statement.fingerprint.c_str())
+              << std::endl;
+    for (const auto& step : statement.plan)
+      std::cout << "         " << step << std::endl;
+  }
+
+  database.Close();
+}
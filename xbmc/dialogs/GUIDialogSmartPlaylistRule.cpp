@@ -389,6 +389,7 @@ std::vector<std::pair<std::string, int>> CGUIDialogSmartPlaylistRule::GetValidOp
     labels.push_back(OperatorLabel(CDatabaseQueryRule::OPERATOR_DOES_NOT_CONTAIN));
     labels.push_back(OperatorLabel(CDatabaseQueryRule::OPERATOR_STARTS_WITH));
     labels.push_back(OperatorLabel(CDatabaseQueryRule::OPERATOR_ENDS_WITH));
+    labels.push_back(OperatorLabel(CDatabaseQueryRule::OPERATOR_MATCHES));
     break;
 
   case CDatabaseQueryRule::REAL_FIELD:
@@ -352,6 +352,12 @@ bool CDoubleCache::Reset(int64_t iSourcePosition, bool clearAnyway)
   return bRes;
 }
 
+bool CDoubleCache::Resize(size_t iFront, size_t iBack)
+{
+  // the old cache is dropped on the next swap anyway
+  return m_pCache->Resize(iFront, iBack);
+}
+
 void CDoubleCache::EndOfInput()
 {
   m_pCache->EndOfInput();
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <stdint.h>
 #include <string>
 #include "threads/Event.h"
@@ -44,6 +45,15 @@ public:
    */
   virtual bool Reset(int64_t iSourcePosition, bool clearAnyway=true) = 0;
 
+  /*!
+   \brief Change the size of the cache, keeping the cached data
+   Like Reset(), only to be called while the reader doesn't access the cache.
+   \param iFront size of the forward buffer
+   \param iBack size of the back buffer
+   \return false if not supported or the unread data doesn't fit
+   */
+  virtual bool Resize(size_t iFront, size_t iBack) { return false; }
+
   virtual void EndOfInput(); // mark the end of the input stream so that Read will know when to return EOF
   virtual bool IsEndOfInput();
   virtual void ClearEndOfInput();
@@ -56,7 +66,7 @@ public:
 
   CEvent m_space;
 protected:
-  bool  m_bEndOfInput = false;
+  std::atomic<bool> m_bEndOfInput{false};
 };
 
 /**
@@ -111,6 +121,7 @@ public:
 
   int64_t Seek(int64_t iFilePosition) override;
   bool Reset(int64_t iSourcePosition, bool clearAnyway=true) override;
+  bool Resize(size_t iFront, size_t iBack) override;
   void EndOfInput() override;
   bool IsEndOfInput() override;
   void ClearEndOfInput() override;
@@ -8,9 +8,9 @@
 
 #include <algorithm>
 #include "threads/SystemClock.h"
-#include "threads/SingleLock.h"
 #include "CircularCache.h"
 
+#include <new>
 #include <string.h>
 
 using namespace XFILE;
@@ -23,6 +23,8 @@ CCircularCache::CCircularCache(size_t front, size_t back)
  , m_buf(NULL)
  , m_size(front + back)
  , m_size_back(back)
+ , m_readerWaiting(false)
+ , m_writerWaiting(false)
 #ifdef TARGET_WINDOWS
  , m_handle(NULL)
 #endif
@@ -66,16 +68,36 @@ void CCircularCache::Close()
   m_buf = NULL;
 }
 
-size_t CCircularCache::GetMaxWriteSize(const size_t& iRequestSize)
+size_t CCircularCache::GetWriteLimit(bool announce)
 {
-  CSingleLock lock(m_sync);
-
-  size_t back  = (size_t)(m_cur - m_beg); // Backbuffer size
-  size_t front = (size_t)(m_end - m_cur); // Frontbuffer size
-  size_t limit = m_size - std::min(back, m_size_back) - front;
+  auto limit = [this]()
+  {
+    const int64_t cur = m_cur.load();
+    const int64_t beg = m_beg.load(std::memory_order_relaxed);
+    const int64_t end = m_end.load(std::memory_order_relaxed);
+
+    // m_cur is below m_beg while the reader tries to seek back into
+    // history that is being overwritten, see Seek()
+    int64_t back  = std::max<int64_t>(cur - beg, 0); // Backbuffer size
+    int64_t front = end - cur;                         // Frontbuffer size
+    int64_t size  = (int64_t)m_size - std::min(back, (int64_t)m_size_back) - front;
+    return (size_t)std::max<int64_t>(size, 0);
+  };
+
+  size_t size = limit();
+  if (size == 0 && announce)
+  {
+    // ask the reader for a wake-up, look again in case it read in the meantime
+    m_writerWaiting = true;
+    size = limit();
+  }
+  return size;
+}
 
+size_t CCircularCache::GetMaxWriteSize(const size_t& iRequestSize)
+{
   // Never return more than limit and size requested by caller
-  return std::min(iRequestSize, limit);
+  return std::min(iRequestSize, GetWriteLimit(true));
 }
 
 /**
@@ -99,14 +121,14 @@ size_t CCircularCache::GetMaxWriteSize(const size_t& iRequestSize)
  */
 int CCircularCache::WriteToCache(const char *buf, size_t len)
 {
-  CSingleLock lock(m_sync);
+  if (m_buf == NULL)
+    return 0;
 
   // where are we in the buffer
-  size_t pos   = m_end % m_size;
-  size_t back  = (size_t)(m_cur - m_beg);
-  size_t front = (size_t)(m_end - m_cur);
-
-  size_t limit = m_size - std::min(back, m_size_back) - front;
+  const int64_t beg = m_beg.load(std::memory_order_relaxed);
+  const int64_t end = m_end.load(std::memory_order_relaxed);
+  size_t pos   = end % m_size;
+  size_t limit = GetWriteLimit(true);
   size_t wrap  = m_size - pos;
 
   // limit by max forward size
@@ -120,18 +142,26 @@ int CCircularCache::WriteToCache(const char *buf, size_t len)
   if(len == 0)
     return 0;
 
-  if (m_buf == NULL)
-    return 0;
+  // drop history that is going to be overwritten before writing. A reader
+  // seeking back into it at the same time either sees the new beginning and
+  // fails, or its position is seen here and nothing is written.
+  if(end + (int64_t)len - (int64_t)m_size > beg)
+  {
+    m_beg = end + len - m_size;
+    if (m_cur.load() < m_beg.load(std::memory_order_relaxed))
+    {
+      m_beg.store(beg, std::memory_order_relaxed);
+      m_writerWaiting = true;
+      return 0;
+    }
+  }
 
   // write the data
   memcpy(m_buf + pos, buf, len);
-  m_end += len;
+  m_end = end + len;
 
-  // drop history that was overwritten
-  if(m_end - m_beg > (int64_t)m_size)
-    m_beg = m_end - m_size;
-
-  m_written.Set();
+  if (m_readerWaiting.load())
+    m_written.Set();
 
   return len;
 }
@@ -143,18 +173,24 @@ int CCircularCache::WriteToCache(const char *buf, size_t len)
  */
 int CCircularCache::ReadFromCache(char *buf, size_t len)
 {
-  CSingleLock lock(m_sync);
+  if (m_buf == NULL)
+    return 0;
 
-  size_t pos   = m_cur % m_size;
-  size_t front = (size_t)(m_end - m_cur);
+  const int64_t cur = m_cur.load(std::memory_order_relaxed);
+  size_t pos   = cur % m_size;
+  size_t front = (size_t)(m_end.load() - cur);
   size_t avail = std::min(m_size - pos, front);
 
   if(avail == 0)
   {
-    if(IsEndOfInput())
-      return 0;
-    else
+    if(!IsEndOfInput())
       return CACHE_RC_WOULD_BLOCK;
+
+    // the last data may have been written just before the end of input was flagged
+    front = (size_t)(m_end.load() - cur);
+    avail = std::min(m_size - pos, front);
+    if(avail == 0)
+      return 0;
   }
 
   if(len > avail)
@@ -163,13 +199,11 @@ int CCircularCache::ReadFromCache(char *buf, size_t len)
   if(len == 0)
     return 0;
 
-  if (m_buf == NULL)
-    return 0;
-
   memcpy(buf, m_buf + pos, len);
-  m_cur += len;
+  m_cur = cur + len;
 
-  m_space.Set();
+  if (m_writerWaiting.load() && m_writerWaiting.exchange(false))
+    m_space.Set();
 
   return len;
 }
@@ -180,7 +214,6 @@ int CCircularCache::ReadFromCache(char *buf, size_t len)
  */
 int64_t CCircularCache::WaitForData(unsigned int minimum, unsigned int millis)
 {
-  CSingleLock lock(m_sync);
   int64_t avail = m_end - m_cur;
 
   if(millis == 0 || IsEndOfInput())
@@ -192,45 +225,56 @@ int64_t CCircularCache::WaitForData(unsigned int minimum, unsigned int millis)
   XbmcThreads::EndTime endtime(millis);
   while (!IsEndOfInput() && avail < minimum && !endtime.IsTimePast() )
   {
-    lock.Leave();
+    // ask the writer for a wake-up, look again in case it wrote in the meantime
+    m_readerWaiting = true;
+    avail = m_end - m_cur;
+    if (avail >= minimum)
+      break;
     m_written.WaitMSec(50); // may miss the deadline. shouldn't be a problem.
-    lock.Enter();
     avail = m_end - m_cur;
   }
+  m_readerWaiting = false;
 
   return avail;
 }
 
 int64_t CCircularCache::Seek(int64_t pos)
 {
-  CSingleLock lock(m_sync);
-
   // if seek is a bit over what we have, try to wait a few seconds for the data to be available.
   // we try to avoid a (heavy) seek on the source
-  if (pos >= m_end && pos < m_end + 100000)
+  const int64_t end = m_end;
+  if (pos >= end && pos < end + 100000)
   {
     /* Make everything in the cache (back & forward) back-cache, to make sure
      * there's sufficient forward space. Increasing it with only 100000 may not be
      * sufficient due to variable filesystem chunksize
      */
-    m_cur = m_end;
-    lock.Leave();
-    WaitForData((size_t)(pos - m_cur), 5000);
-    lock.Enter();
+    m_cur = end;
+    WaitForData((size_t)(pos - end), 5000);
   }
 
-  if(pos >= m_beg && pos <= m_end)
+  const int64_t cur = m_cur.load(std::memory_order_relaxed);
+  if (pos >= cur && pos <= m_end)
   {
     m_cur = pos;
     return pos;
   }
 
+  // seeking back, the writer may be overwriting the oldest data right now,
+  // see WriteToCache()
+  if (pos < cur)
+  {
+    m_cur = pos;
+    if (pos >= m_beg.load())
+      return pos;
+    m_cur = cur;
+  }
+
   return CACHE_RC_ERROR;
 }
 
 bool CCircularCache::Reset(int64_t pos, bool clearAnyway)
 {
-  CSingleLock lock(m_sync);
   if (!clearAnyway && IsCachedPosition(pos))
   {
     m_cur = pos;
@@ -243,6 +287,57 @@ bool CCircularCache::Reset(int64_t pos, bool clearAnyway)
   return true;
 }
 
+bool CCircularCache::Resize(size_t front, size_t back)
+{
+  const int64_t cur = m_cur;
+  const int64_t end = m_end;
+  const size_t size = front + back;
+
+  // unread data is never dropped
+  if (m_buf == NULL || end - cur > (int64_t)front)
+    return false;
+
+  // keep as much of the back buffer as fits
+  const int64_t beg = std::max<int64_t>(m_beg, end - size);
+
+#ifdef TARGET_WINDOWS
+  HANDLE handle = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, size, NULL);
+  if (handle == NULL)
+    return false;
+  uint8_t *buf = (uint8_t*)MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+  if (buf == NULL)
+  {
+    CloseHandle(handle);
+    return false;
+  }
+#else
+  uint8_t *buf = new (std::nothrow) uint8_t[size];
+  if (buf == NULL)
+    return false;
+#endif
+
+  // copy in pieces that don't wrap in either buffer
+  for (int64_t pos = beg; pos < end;)
+  {
+    const size_t from = pos % m_size;
+    const size_t to = pos % size;
+    const size_t len = std::min<int64_t>({end - pos, (int64_t)(m_size - from), (int64_t)(size - to)});
+    memcpy(buf + to, m_buf + from, len);
+    pos += len;
+  }
+
+  Close();
+#ifdef TARGET_WINDOWS
+  m_handle = handle;
+#endif
+  m_buf = buf;
+  m_size = size;
+  m_size_back = back;
+  m_beg = beg;
+
+  return true;
+}
+
 int64_t CCircularCache::CachedDataEndPosIfSeekTo(int64_t iFilePosition)
 {
   if (IsCachedPosition(iFilePosition))
@@ -264,4 +359,3 @@ CCacheStrategy *CCircularCache::CreateNew()
 {
   return new CCircularCache(m_size - m_size_back, m_size_back);
 }
-
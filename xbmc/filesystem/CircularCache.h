@@ -9,11 +9,22 @@
 #pragma once
 
 #include "CacheStrategy.h"
-#include "threads/CriticalSection.h"
 #include "threads/Event.h"
 
+#include <atomic>
+
 namespace XFILE {
 
+/*!
+ \brief Ring buffer between a single writer and a single reader thread.
+
+ The writer (CFileCache's thread) calls GetMaxWriteSize() and WriteToCache(),
+ the reader calls ReadFromCache(), WaitForData() and Seek(). Neither takes a
+ lock: the writer only advances m_end and m_beg, the reader only moves m_cur.
+ The other side is only woken up through an event if it announced that it is
+ waiting for data or space. Reset() may only be called while the reader
+ doesn't use the cache, CFileCache calls it while the reader waits for a seek.
+ */
 class CCircularCache : public CCacheStrategy
 {
 public:
@@ -30,6 +41,7 @@ public:
 
     int64_t Seek(int64_t pos) override;
     bool Reset(int64_t pos, bool clearAnyway=true) override;
+    bool Resize(size_t front, size_t back) override;
 
     int64_t CachedDataEndPosIfSeekTo(int64_t iFilePosition) override;
     int64_t CachedDataEndPos() override;
@@ -37,13 +49,20 @@ public:
 
     CCacheStrategy *CreateNew() override;
 protected:
-    int64_t           m_beg;       /**< index in file (not buffer) of beginning of valid data */
-    int64_t           m_end;       /**< index in file (not buffer) of end of valid data */
-    int64_t           m_cur;       /**< current reading index in file */
+    /*!
+     \brief Number of bytes that can be written without overwriting unread data or the guaranteed back buffer.
+     \param announce whether the writer is going to wait for space if there is none
+     */
+    size_t GetWriteLimit(bool announce);
+
+    std::atomic<int64_t> m_beg;    /**< index in file (not buffer) of beginning of valid data */
+    std::atomic<int64_t> m_end;    /**< index in file (not buffer) of end of valid data */
+    std::atomic<int64_t> m_cur;    /**< current reading index in file */
     uint8_t          *m_buf;       /**< buffer holding data */
     size_t            m_size;      /**< size of data buffer used (m_buf) */
     size_t            m_size_back; /**< guaranteed size of back buffer (actual size can be smaller, or larger if front buffer doesn't need it) */
-    CCriticalSection  m_sync;
+    std::atomic<bool> m_readerWaiting; /**< reader waits for m_written */
+    std::atomic<bool> m_writerWaiting; /**< writer waits for m_space */
     CEvent            m_written;
 #ifdef TARGET_WINDOWS
     HANDLE            m_handle;
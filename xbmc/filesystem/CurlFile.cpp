@@ -10,6 +10,7 @@
 #include "ServiceBroker.h"
 #include "Util.h"
 #include "URL.h"
+#include "XBDateTime.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "settings/SettingsComponent.h"
@@ -18,6 +19,7 @@
 #include "utils/Base64.h"
 
 #include <algorithm>
+#include <chrono>
 #include <vector>
 #include <climits>
 #include <cassert>
@@ -146,6 +148,9 @@ static inline void* realloc_simple(void *ptr, size_t size)
 static constexpr int CURL_OFF = 0L;
 static constexpr int CURL_ON = 1L;
 
+// size of the ranges requested by each connection when reading in parallel
+static constexpr int64_t PARALLEL_RANGE_SIZE = 2 * 1024 * 1024;
+
 size_t CCurlFile::CReadState::HeaderCallback(void *ptr, size_t size, size_t nmemb)
 {
   std::string inString;
@@ -391,6 +396,314 @@ void CCurlFile::CReadState::Disconnect()
 }
 
 
+/* Reads a file in ranges of PARALLEL_RANGE_SIZE bytes over several connections
+ * at once. Completed ranges are kept until the reader reaches them, so the data
+ * is handed out in file order no matter in which order the ranges arrive.
+ */
+class CCurlFile::CParallelReader
+{
+public:
+  CParallelReader(CURL_HANDLE* easyHandle, const std::string& url, int64_t fileSize,
+                  unsigned int connections, const bool& cancelled);
+  ~CParallelReader();
+
+  void Seek(int64_t pos);
+  int64_t GetPosition() const { return m_filePos; }
+  ssize_t Read(void* lpBuf, size_t uiBufSize);
+  double GetDownloadSpeed() const;
+
+private:
+  struct Range
+  {
+    CURL_HANDLE* easyHandle = nullptr;
+    bool active = false;
+    int64_t start = 0;
+    int64_t length = 0;
+    int retries = 0;
+    std::vector<char> data;
+  };
+
+  static size_t WriteCallback(char *buffer, size_t size, size_t nitems, void *userp);
+  static size_t HeaderCallback(void *ptr, size_t size, size_t nmemb, void *stream);
+
+  int64_t GetWindowStart() const { return m_filePos - m_filePos % PARALLEL_RANGE_SIZE; }
+  int64_t GetWindowEnd() const;
+  void Start(Range& range, int64_t start);
+  void Stop(Range& range);
+  void Schedule();
+  bool Perform();
+  bool Complete(Range& range, CURLcode result);
+
+  CURLM* m_multiHandle;
+  std::vector<Range> m_ranges; // one per connection
+  std::map<int64_t, std::vector<char>> m_completed; // ranges not yet read, by start position
+  int64_t m_fileSize;
+  int64_t m_filePos = 0;
+  const bool& m_cancelled;
+  bool m_failed = false;
+  uint64_t m_received = 0;
+  std::chrono::steady_clock::time_point m_startTime;
+};
+
+CCurlFile::CParallelReader::CParallelReader(CURL_HANDLE* easyHandle, const std::string& url, int64_t fileSize,
+                                            unsigned int connections, const bool& cancelled)
+  : m_multiHandle(g_curlInterface.multi_init())
+  , m_ranges(connections)
+  , m_fileSize(fileSize)
+  , m_cancelled(cancelled)
+  , m_startTime(std::chrono::steady_clock::now())
+{
+  // the connections share all options of the first one, only the data goes elsewhere.
+  // They are private to the reader, the global duphandle would add them to the
+  // session pool, which never hears of their cleanup.
+  for (auto& range : m_ranges)
+  {
+    range.easyHandle = g_curlInterface.DllLibCurl::easy_duphandle(easyHandle);
+    g_curlInterface.easy_setopt(range.easyHandle, CURLOPT_URL, url.c_str());
+    g_curlInterface.easy_setopt(range.easyHandle, CURLOPT_WRITEDATA, &range);
+    g_curlInterface.easy_setopt(range.easyHandle, CURLOPT_WRITEFUNCTION, WriteCallback);
+    g_curlInterface.easy_setopt(range.easyHandle, CURLOPT_WRITEHEADER, nullptr);
+    g_curlInterface.easy_setopt(range.easyHandle, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    g_curlInterface.easy_setopt(range.easyHandle, CURLOPT_RESUME_FROM_LARGE, static_cast<curl_off_t>(0));
+  }
+}
+
+CCurlFile::CParallelReader::~CParallelReader()
+{
+  for (auto& range : m_ranges)
+  {
+    Stop(range);
+    g_curlInterface.easy_cleanup(range.easyHandle);
+  }
+  g_curlInterface.multi_cleanup(m_multiHandle);
+}
+
+size_t CCurlFile::CParallelReader::WriteCallback(char *buffer, size_t size, size_t nitems, void *userp)
+{
+  Range* range = static_cast<Range*>(userp);
+  const size_t amount = size * nitems;
+
+  // more data than requested means the server ignored the range, abort
+  if (static_cast<int64_t>(range->data.size() + amount) > range->length)
+    return 0;
+
+  range->data.insert(range->data.end(), buffer, buffer + amount);
+  return amount;
+}
+
+size_t CCurlFile::CParallelReader::HeaderCallback(void *ptr, size_t size, size_t nmemb, void *stream)
+{
+  return size * nmemb;
+}
+
+int64_t CCurlFile::CParallelReader::GetWindowEnd() const
+{
+  // keep up to two ranges per connection in flight or waiting to be read
+  return std::min(m_fileSize, GetWindowStart() + static_cast<int64_t>(2 * m_ranges.size()) * PARALLEL_RANGE_SIZE);
+}
+
+void CCurlFile::CParallelReader::Start(Range& range, int64_t start)
+{
+  range.active = true;
+  range.start = start;
+  range.length = std::min(PARALLEL_RANGE_SIZE, m_fileSize - start);
+  range.data.clear();
+  range.data.reserve(range.length);
+
+  const std::string bytes = StringUtils::Format("%" PRId64 "-%" PRId64, start, start + range.length - 1);
+  g_curlInterface.easy_setopt(range.easyHandle, CURLOPT_RANGE, bytes.c_str());
+  g_curlInterface.multi_add_handle(m_multiHandle, range.easyHandle);
+}
+
+void CCurlFile::CParallelReader::Stop(Range& range)
+{
+  if (range.active)
+    g_curlInterface.multi_remove_handle(m_multiHandle, range.easyHandle);
+  range.active = false;
+  range.retries = 0;
+  range.data.clear();
+}
+
+void CCurlFile::CParallelReader::Schedule()
+{
+  const int64_t windowEnd = GetWindowEnd();
+  auto idle = m_ranges.begin();
+
+  for (int64_t start = GetWindowStart(); start < windowEnd; start += PARALLEL_RANGE_SIZE)
+  {
+    if (m_completed.find(start) != m_completed.end())
+      continue;
+    if (std::any_of(m_ranges.begin(), m_ranges.end(), [start](const Range& range) { return range.active && range.start == start; }))
+      continue;
+
+    idle = std::find_if(idle, m_ranges.end(), [](const Range& range) { return !range.active; });
+    if (idle == m_ranges.end())
+      break;
+    Start(*idle, start);
+  }
+}
+
+bool CCurlFile::CParallelReader::Complete(Range& range, CURLcode result)
+{
+  g_curlInterface.multi_remove_handle(m_multiHandle, range.easyHandle);
+  range.active = false;
+
+  long response = 0;
+  g_curlInterface.easy_getinfo(range.easyHandle, CURLINFO_RESPONSE_CODE, &response);
+
+  if (result == CURLE_OK && response == 206 && static_cast<int64_t>(range.data.size()) == range.length)
+  {
+    m_received += range.data.size();
+    m_completed[range.start] = std::move(range.data);
+    range.data = std::vector<char>();
+    range.retries = 0;
+    return true;
+  }
+
+  if (response == 200)
+  {
+    CLog::Log(LOGERROR, "CCurlFile::CParallelReader - server ignored range request at %" PRId64, range.start);
+    return false;
+  }
+
+  if (range.retries++ < CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_curlretries)
+  {
+    CLog::Log(LOGWARNING, "CCurlFile::CParallelReader - range at %" PRId64 " failed with %s (%ld), retry %i",
+              range.start, g_curlInterface.easy_strerror(result), response, range.retries);
+    Start(range, range.start);
+    return true;
+  }
+
+  CLog::Log(LOGERROR, "CCurlFile::CParallelReader - range at %" PRId64 " failed with %s (%ld)",
+            range.start, g_curlInterface.easy_strerror(result), response);
+  return false;
+}
+
+bool CCurlFile::CParallelReader::Perform()
+{
+  int running = 0;
+  CURLMcode result = g_curlInterface.multi_perform(m_multiHandle, &running);
+  if (result != CURLM_OK && result != CURLM_CALL_MULTI_PERFORM)
+  {
+    CLog::Log(LOGERROR, "CCurlFile::CParallelReader - multi perform failed with code %d", result);
+    return false;
+  }
+
+  int msgs;
+  CURLMsg* msg;
+  while ((msg = g_curlInterface.multi_info_read(m_multiHandle, &msgs)))
+  {
+    if (msg->msg != CURLMSG_DONE)
+      continue;
+
+    CURL_HANDLE* easyHandle = msg->easy_handle;
+    const CURLcode code = msg->data.result;
+    auto range = std::find_if(m_ranges.begin(), m_ranges.end(), [easyHandle](const Range& range) { return range.easyHandle == easyHandle; });
+    if (range != m_ranges.end() && range->active && !Complete(*range, code))
+      return false;
+  }
+
+  if (m_completed.find(GetWindowStart()) != m_completed.end())
+    return true;
+
+  // wait for any of the connections to receive more data
+  fd_set fdread;
+  fd_set fdwrite;
+  fd_set fdexcep;
+  FD_ZERO(&fdread);
+  FD_ZERO(&fdwrite);
+  FD_ZERO(&fdexcep);
+  int maxfd = -1;
+  g_curlInterface.multi_fdset(m_multiHandle, &fdread, &fdwrite, &fdexcep, &maxfd);
+
+  long timeout = 0;
+  if (CURLM_OK != g_curlInterface.multi_timeout(m_multiHandle, &timeout) || timeout < 0 || timeout > 200)
+    timeout = 200;
+
+  struct timeval wait = { static_cast<int>(timeout) / 1000, (static_cast<int>(timeout) % 1000) * 1000 };
+  if (maxfd == -1)
+  {
+#ifdef TARGET_WINDOWS
+    Sleep(std::min<long>(timeout, 100));
+#else
+    wait = { 0, static_cast<int>(std::min<long>(timeout, 100)) * 1000 };
+    select(0, NULL, NULL, NULL, &wait);
+#endif
+  }
+  else if (select(maxfd + 1, &fdread, &fdwrite, &fdexcep, &wait) == SOCKET_ERROR && errno != EINTR)
+  {
+    CLog::Log(LOGERROR, "CCurlFile::CParallelReader - failed with socket error:%s", strerror(errno));
+    return false;
+  }
+
+  return true;
+}
+
+ssize_t CCurlFile::CParallelReader::Read(void* lpBuf, size_t uiBufSize)
+{
+  if (m_filePos >= m_fileSize)
+    return 0;
+
+  const int64_t start = GetWindowStart();
+  auto it = m_completed.find(start);
+  while (it == m_completed.end())
+  {
+    if (m_cancelled)
+      return 0;
+    if (m_failed)
+      return -1;
+
+    Schedule();
+    if (!Perform())
+    {
+      m_failed = true;
+      return -1;
+    }
+    it = m_completed.find(start);
+  }
+
+  const int64_t offset = m_filePos - start;
+  const size_t want = static_cast<size_t>(std::min<int64_t>(uiBufSize, it->second.size() - offset));
+  memcpy(lpBuf, it->second.data() + offset, want);
+  m_filePos += want;
+
+  if (m_filePos - start == static_cast<int64_t>(it->second.size()))
+  {
+    m_completed.erase(it);
+    Schedule(); // make use of the connection of the range just read
+  }
+
+  return want;
+}
+
+void CCurlFile::CParallelReader::Seek(int64_t pos)
+{
+  m_filePos = pos;
+  m_failed = false;
+
+  // drop everything outside the new window, ranges inside it are reused
+  const int64_t windowStart = GetWindowStart();
+  const int64_t windowEnd = GetWindowEnd();
+  for (auto it = m_completed.begin(); it != m_completed.end();)
+  {
+    if (it->first < windowStart || it->first >= windowEnd)
+      it = m_completed.erase(it);
+    else
+      ++it;
+  }
+  for (auto& range : m_ranges)
+  {
+    if (range.active && (range.start < windowStart || range.start >= windowEnd))
+      Stop(range);
+  }
+}
+
+double CCurlFile::CParallelReader::GetDownloadSpeed() const
+{
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_startTime;
+  return elapsed.count() > 0.0 ? m_received / elapsed.count() : 0.0;
+}
+
 CCurlFile::~CCurlFile()
 {
   Close();
@@ -439,6 +752,7 @@ void CCurlFile::Close()
   if (m_opened && m_forWrite && !m_inError)
       Write(NULL, 0);
 
+  m_parallelReader.reset();
   m_state->Disconnect();
   delete m_oldState;
   m_oldState = NULL;
@@ -1079,6 +1393,27 @@ bool CCurlFile::Open(const CURL& url)
     m_url = efurl;
   }
 
+  // read large files over several connections if the server supports ranges,
+  // i.e. answered the initial 0- range request with partial content
+  const unsigned int connections = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_curlParallelConnections;
+  if (connections > 1 && m_seekable && (url2.IsProtocol("http") || url2.IsProtocol("https")) &&
+      m_state->m_fileSize >= 4 * PARALLEL_RANGE_SIZE)
+  {
+    if (m_httpresponse == 206)
+    {
+      CLog::Log(LOGDEBUG, "CCurlFile::Open - reading <%s> over %u connections", redactPath.c_str(), connections);
+
+      // the initial connection is only kept for its options and headers
+      g_curlInterface.multi_remove_handle(m_state->m_multiHandle, m_state->m_easyHandle);
+      m_state->m_buffer.Clear();
+      m_state->m_stillRunning = 0;
+      m_parallelReader.reset(new CParallelReader(m_state->m_easyHandle, m_url, m_state->m_fileSize,
+                                                 connections, m_state->m_cancelled));
+    }
+    else
+      CLog::Log(LOGDEBUG, "CCurlFile::Open - no range support for <%s>, using a single connection", redactPath.c_str());
+  }
+
   return true;
 }
 
@@ -1161,6 +1496,29 @@ ssize_t CCurlFile::Write(const void* lpBuf, size_t uiBufSize)
   return m_state->m_filePos;
 }
 
+ssize_t CCurlFile::Read(void* lpBuf, size_t uiBufSize)
+{
+  if (m_parallelReader)
+    return m_parallelReader->Read(lpBuf, uiBufSize);
+
+  return m_state->Read(lpBuf, uiBufSize);
+}
+
+bool CCurlFile::ReadString(char *szLine, int iLineLength)
+{
+  if (!m_parallelReader)
+    return m_state->ReadString(szLine, iLineLength);
+
+  char* pLine = szLine;
+  while (pLine - szLine < iLineLength - 1 && m_parallelReader->Read(pLine, 1) == 1)
+  {
+    if (*pLine++ == '\n')
+      break;
+  }
+  *pLine = 0;
+  return pLine > szLine;
+}
+
 bool CCurlFile::CReadState::ReadString(char *szLine, int iLineLength)
 {
   unsigned int want = (unsigned int)iLineLength;
@@ -1289,7 +1647,7 @@ bool CCurlFile::Exists(const CURL& url)
 
 int64_t CCurlFile::Seek(int64_t iFilePosition, int iWhence)
 {
-  int64_t nextPos = m_state->m_filePos;
+  int64_t nextPos = m_parallelReader ? m_parallelReader->GetPosition() : m_state->m_filePos;
 
   if(!m_seekable)
     return -1;
@@ -1315,6 +1673,12 @@ int64_t CCurlFile::Seek(int64_t iFilePosition, int iWhence)
   // We can't seek beyond EOF
   if (m_state->m_fileSize && nextPos > m_state->m_fileSize) return -1;
 
+  if (m_parallelReader)
+  {
+    m_parallelReader->Seek(nextPos);
+    return nextPos;
+  }
+
   if(m_state->Seek(nextPos))
     return nextPos;
 
@@ -1394,9 +1758,29 @@ int64_t CCurlFile::GetLength()
 int64_t CCurlFile::GetPosition()
 {
   if (!m_opened) return 0;
+  if (m_parallelReader) return m_parallelReader->GetPosition();
   return m_state->m_filePos;
 }
 
+int CCurlFile::Stat(struct __stat64* buffer)
+{
+  if (!m_opened || !buffer)
+    return IFile::Stat(buffer);
+
+  memset(buffer, 0, sizeof(struct __stat64));
+  buffer->st_size = GetLength();
+  buffer->st_mode = _S_IFREG;
+
+  CDateTime lastModified;
+  if (lastModified.SetFromRFC1123DateTime(m_state->m_httpheader.GetValue("last-modified")))
+  {
+    time_t mtime;
+    lastModified.GetAsTime(mtime);
+    buffer->st_mtime = mtime;
+  }
+  return 0;
+}
+
 int CCurlFile::Stat(const CURL& url, struct __stat64* buffer)
 {
   // if file is already running, get info from it
@@ -2013,6 +2397,9 @@ const std::vector<std::string> CCurlFile::GetPropertyValues(XFILE::FileProperty
 
 double CCurlFile::GetDownloadSpeed()
 {
+  if (m_parallelReader)
+    return m_parallelReader->GetDownloadSpeed();
+
 #if LIBCURL_VERSION_NUM >= 0x073a00 // 0.7.58.0
   double speed = 0.0;
   if (g_curlInterface.easy_getinfo(m_state->m_easyHandle, CURLINFO_SPEED_DOWNLOAD, &speed) == CURLE_OK)
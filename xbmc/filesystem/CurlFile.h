@@ -11,6 +11,7 @@
 #include "IFile.h"
 #include "utils/RingBuffer.h"
 #include <map>
+#include <memory>
 #include <string>
 #include "utils/HttpHeader.h"
 
@@ -43,9 +44,10 @@ namespace XFILE
       int64_t GetPosition() override;
       int64_t GetLength() override;
       int Stat(const CURL& url, struct __stat64* buffer) override;
+      int Stat(struct __stat64* buffer) override;
       void Close() override;
-      bool ReadString(char *szLine, int iLineLength) override { return m_state->ReadString(szLine, iLineLength); }
-      ssize_t Read(void* lpBuf, size_t uiBufSize) override { return m_state->Read(lpBuf, uiBufSize); }
+      bool ReadString(char *szLine, int iLineLength) override;
+      ssize_t Read(void* lpBuf, size_t uiBufSize) override;
       ssize_t Write(const void* lpBuf, size_t uiBufSize) override;
       const std::string GetProperty(XFILE::FileProperty type, const std::string &name = "") const override;
       const std::vector<std::string> GetPropertyValues(XFILE::FileProperty type, const std::string &name = "") const override;
@@ -78,6 +80,7 @@ namespace XFILE
       void SetBufferSize(unsigned int size);
 
       const CHttpHeader& GetHttpHeader() const { return m_state->m_httpheader; }
+      bool IsReadingInParallel() const { return m_parallelReader != nullptr; } // over several ranged connections
       std::string GetURL(void);
       std::string GetRedirectURL();
 
@@ -136,6 +139,8 @@ namespace XFILE
           void Disconnect();
       };
 
+      class CParallelReader;
+
     protected:
       void ParseAndCorrectUrl(CURL &url);
       void SetCommonOptions(CReadState* state, bool failOnError = true);
@@ -147,6 +152,7 @@ namespace XFILE
     protected:
       CReadState* m_state;
       CReadState* m_oldState;
+      std::unique_ptr<CParallelReader> m_parallelReader; // set while reading over several connections
       unsigned int m_bufferSize;
       int64_t m_writeOffset = 0;
 
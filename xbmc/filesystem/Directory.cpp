@@ -163,8 +163,10 @@ bool CDirectory::GetDirectory(const CURL& url, std::shared_ptr<IDirectory> pDire
     if (!pDirectory.get())
       return false;
 
-    // check our cache for this path
-    if (g_directoryCache.GetDirectory(realURL.Get(), items, (hints.flags & DIR_FLAG_READ_CACHE) == DIR_FLAG_READ_CACHE))
+    // check our cache for this path. Converting files to directories modifies the items,
+    // so they are only shared with the cache if that is disabled.
+    const bool shareItems = (hints.flags & DIR_FLAG_SHARED_ITEMS) && (hints.flags & DIR_FLAG_NO_FILE_DIRS);
+    if (g_directoryCache.GetDirectory(realURL.Get(), items, (hints.flags & DIR_FLAG_READ_CACHE) == DIR_FLAG_READ_CACHE, !shareItems))
       items.SetURL(url);
     else
     {
@@ -288,6 +290,15 @@ bool CDirectory::GetDirectory(const CURL& url, std::shared_ptr<IDirectory> pDire
     const std::string pathToUrl2(realURL.Get());
     if (pathToUrl != pathToUrl2)
     {
+      if (shareItems)
+      {
+        // copy on write, the cached items stay as they are
+        CFileItemList copies;
+        for (const auto& item : items)
+          copies.Add(std::make_shared<CFileItem>(*item));
+        items.ClearItems();
+        items.Append(copies);
+      }
       for (int i = 0; i < items.Size(); ++i)
       {
         CFileItemPtr item = items[i];
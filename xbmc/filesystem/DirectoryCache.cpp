@@ -9,74 +9,152 @@
 #include "Directory.h"
 #include "DirectoryCache.h"
 #include "FileItem.h"
+#include "ServiceBroker.h"
+#include "music/tags/MusicInfoTag.h"
+#include "pictures/PictureInfoTag.h"
+#include "settings/AdvancedSettings.h"
+#include "settings/SettingsComponent.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
 #include "utils/StringUtils.h"
+#include "video/VideoInfoTag.h"
 #include "URL.h"
 #include "climits"
 
 #include <algorithm>
+#include <functional>
 
-// Maximum number of directories to keep in our cache
-#define MAX_CACHED_DIRS 50
+// Size limit used until the advanced settings are available
+#define DEFAULT_CACHE_SIZE (32 * 1024 * 1024)
 
 using namespace XFILE;
 
-CDirectoryCache::CDir::CDir(DIR_CACHE_TYPE cacheType)
+CDirectoryCache::CDir::CDir(DIR_CACHE_TYPE cacheType, std::unique_ptr<CFileItemList> items)
+  : m_Items(std::move(items))
 {
   m_cacheType = cacheType;
+  m_size = EstimateSize(*m_Items);
   m_lastAccess = 0;
-  m_Items = new CFileItemList;
-  m_Items->SetIgnoreURLOptions(true);
-  m_Items->SetFastLookup(true);
 }
 
-CDirectoryCache::CDir::~CDir()
+void CDirectoryCache::CDir::SetLastAccess(std::atomic<unsigned int> &accessCounter)
 {
-  delete m_Items;
+  m_lastAccess = accessCounter++;
 }
 
-void CDirectoryCache::CDir::SetLastAccess(unsigned int &accessCounter)
+std::shared_ptr<const CFileItemList> CDirectoryCache::CDir::GetShared()
 {
-  m_lastAccess = accessCounter++;
+  if (!m_shared)
+  {
+    // only the item pointers are copied, the items are shared with the cache
+    std::shared_ptr<CFileItemList> shared = std::make_shared<CFileItemList>();
+    shared->Copy(*m_Items, false);
+    shared->Append(*m_Items);
+    m_shared = std::move(shared);
+  }
+  return m_shared;
 }
 
 CDirectoryCache::CDirectoryCache(void)
 {
   m_accessCounter = 0;
-#ifdef _DEBUG
+  m_maxSize = 0;
+  m_size = 0;
   m_cacheHits = 0;
   m_cacheMisses = 0;
-#endif
+  m_evictions = 0;
 }
 
 CDirectoryCache::~CDirectoryCache(void) = default;
 
-bool CDirectoryCache::GetDirectory(const std::string& strPath, CFileItemList &items, bool retrieveAll)
+CDirectoryCache::Shard& CDirectoryCache::GetShard(const std::string& storedPath)
+{
+  return m_shards[std::hash<std::string>()(storedPath) % SHARDS];
+}
+
+size_t CDirectoryCache::GetMaxSize() const
+{
+  if (m_maxSize > 0)
+    return m_maxSize;
+
+  const auto settingsComponent = CServiceBroker::GetSettingsComponent();
+  if (settingsComponent && settingsComponent->GetAdvancedSettings())
+    return static_cast<size_t>(settingsComponent->GetAdvancedSettings()->m_directoryCacheSize) * 1024 * 1024;
+
+  return DEFAULT_CACHE_SIZE;
+}
+
+size_t CDirectoryCache::EstimateSize(const CFileItemList &items)
+{
+  size_t size = sizeof(CFileItemList) + items.GetPath().capacity();
+  for (int i = 0; i < items.Size(); i++)
+    size += EstimateSize(*items[i]);
+  return size;
+}
+
+size_t CDirectoryCache::EstimateSize(const CFileItem &item)
 {
-  CSingleLock lock (m_cs);
+  size_t size = sizeof(CFileItem) + 2 * sizeof(void*); // the item and its shared_ptr control block
+  size += item.GetPath().capacity() + item.GetDynPath().capacity();
+  size += item.GetLabel().capacity() + item.GetLabel2().capacity();
+  size += item.GetMimeType().capacity();
+  for (const auto& art : item.GetArt())
+    size += art.first.capacity() + art.second.capacity() + 4 * sizeof(void*);
+  if (item.HasVideoInfoTag())
+    size += sizeof(CVideoInfoTag) + item.GetVideoInfoTag()->m_strPlot.capacity();
+  if (item.HasMusicInfoTag())
+    size += sizeof(MUSIC_INFO::CMusicInfoTag);
+  if (item.HasPictureInfoTag())
+    size += sizeof(CPictureInfoTag);
+  // its entry in the fast lookup map of the list
+  size += sizeof(std::string) + 2 * sizeof(void*);
+  return size;
+}
+
+bool CDirectoryCache::GetDirectory(const std::string& strPath, CFileItemList &items, bool retrieveAll, bool copyItems)
+{
+  std::shared_ptr<const CFileItemList> cached = GetDirectory(strPath, retrieveAll);
+  if (!cached)
+    return false;
+
+  // the snapshot is never modified, so it's copied without holding the lock. Callers that
+  // filter and rename the items they get need their own, the others share the cached items.
+  items.Copy(*cached, copyItems);
+  if (!copyItems)
+    items.Append(*cached);
+  return true;
+}
 
+std::shared_ptr<const CFileItemList> CDirectoryCache::GetDirectory(const std::string& strPath, bool retrieveAll)
+{
   // Get rid of any URL options, else the compare may be wrong
   std::string storedPath = CURL(strPath).GetWithoutOptions();
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ciCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
+  std::shared_ptr<const CFileItemList> cached;
   {
-    CDir* dir = i->second;
-    if (dir->m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
-       (dir->m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll))
+    Shard& shard = GetShard(storedPath);
+    CSingleLock lock(shard.m_cs);
+
+    iCache i = shard.m_cache.find(storedPath);
+    if (i != shard.m_cache.end())
     {
-      items.Copy(*dir->m_Items);
-      dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
-      m_cacheHits+=items.Size();
-#endif
-      return true;
+      CDir& dir = i->second;
+      if (dir.m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
+         (dir.m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll))
+      {
+        cached = dir.GetShared();
+        dir.SetLastAccess(m_accessCounter);
+      }
     }
   }
-  return false;
+
+  if (cached)
+    m_cacheHits++;
+  else
+    m_cacheMisses++;
+  return cached;
 }
 
 void CDirectoryCache::SetDirectory(const std::string& strPath, const CFileItemList &items, DIR_CACHE_TYPE cacheType)
@@ -95,20 +173,34 @@ void CDirectoryCache::SetDirectory(const std::string& strPath, const CFileItemLi
   // IDEALLY, any further processing on the item would actually create a new item
   // instead of altering it, but we can't really enforce that in an easy way, so
   // this is the best solution for now.
-  CSingleLock lock (m_cs);
 
   // Get rid of any URL options, else the compare may be wrong
   std::string storedPath = CURL(strPath).GetWithoutOptions();
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ClearDirectory(storedPath);
+  // copy the items before taking the lock
+  std::unique_ptr<CFileItemList> copy(new CFileItemList);
+  copy->SetIgnoreURLOptions(true);
+  copy->SetFastLookup(true);
+  copy->Copy(items);
 
-  CheckIfFull();
+  CDir dir(cacheType, std::move(copy));
+  dir.SetLastAccess(m_accessCounter);
+  const size_t size = dir.m_size;
+
+  {
+    Shard& shard = GetShard(storedPath);
+    CSingleLock lock(shard.m_cs);
+
+    iCache i = shard.m_cache.find(storedPath);
+    if (i != shard.m_cache.end())
+      Delete(shard.m_cache, i);
 
-  CDir* dir = new CDir(cacheType);
-  dir->m_Items->Copy(items);
-  dir->SetLastAccess(m_accessCounter);
-  m_cache.insert(std::pair<std::string, CDir*>(storedPath, dir));
+    shard.m_cache.emplace(storedPath, std::move(dir));
+    m_size += size;
+  }
+
+  CheckIfFull();
 }
 
 void CDirectoryCache::ClearFile(const std::string& strFile)
@@ -121,55 +213,65 @@ void CDirectoryCache::ClearFile(const std::string& strFile)
 
 void CDirectoryCache::ClearDirectory(const std::string& strPath)
 {
-  CSingleLock lock (m_cs);
-
   // Get rid of any URL options, else the compare may be wrong
   std::string storedPath = CURL(strPath).GetWithoutOptions();
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  iCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
-    Delete(i);
+  Shard& shard = GetShard(storedPath);
+  CSingleLock lock(shard.m_cs);
+
+  iCache i = shard.m_cache.find(storedPath);
+  if (i != shard.m_cache.end())
+    Delete(shard.m_cache, i);
 }
 
 void CDirectoryCache::ClearSubPaths(const std::string& strPath)
 {
-  CSingleLock lock (m_cs);
-
   // Get rid of any URL options, else the compare may be wrong
   std::string storedPath = CURL(strPath).GetWithoutOptions();
 
-  iCache i = m_cache.begin();
-  while (i != m_cache.end())
+  for (Shard& shard : m_shards)
   {
-    if (URIUtils::PathHasParent(i->first, storedPath))
-      Delete(i++);
-    else
-      i++;
+    CSingleLock lock(shard.m_cs);
+
+    iCache i = shard.m_cache.begin();
+    while (i != shard.m_cache.end())
+    {
+      if (URIUtils::PathHasParent(i->first, storedPath))
+        Delete(shard.m_cache, i++);
+      else
+        i++;
+    }
   }
 }
 
 void CDirectoryCache::AddFile(const std::string& strFile)
 {
-  CSingleLock lock (m_cs);
-
   // Get rid of any URL options, else the compare may be wrong
   std::string strPath = URIUtils::GetDirectory(CURL(strFile).GetWithoutOptions());
   URIUtils::RemoveSlashAtEnd(strPath);
 
-  ciCache i = m_cache.find(strPath);
-  if (i != m_cache.end())
+  Shard& shard = GetShard(strPath);
+  CSingleLock lock(shard.m_cs);
+
+  iCache i = shard.m_cache.find(strPath);
+  if (i != shard.m_cache.end())
   {
-    CDir *dir = i->second;
+    CDir& dir = i->second;
+    // readers keep the snapshot they already have, the next one gets a new snapshot
     CFileItemPtr item(new CFileItem(strFile, false));
-    dir->m_Items->Add(item);
-    dir->SetLastAccess(m_accessCounter);
+    dir.m_Items->Add(item);
+    dir.m_shared.reset();
+
+    const size_t size = EstimateSize(*item);
+    m_size += size;
+    dir.m_size += size;
+    dir.SetLastAccess(m_accessCounter);
   }
 }
 
 bool CDirectoryCache::FileExists(const std::string& strFile, bool& bInCache)
 {
-  CSingleLock lock (m_cs);
   bInCache = false;
 
   // Get rid of any URL options, else the compare may be wrong
@@ -178,31 +280,39 @@ bool CDirectoryCache::FileExists(const std::string& strFile, bool& bInCache)
   std::string storedPath = URIUtils::GetDirectory(strPath);
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ciCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
+  bool exists = false;
   {
-    bInCache = true;
-    CDir *dir = i->second;
-    dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
-    m_cacheHits++;
-#endif
-    return (URIUtils::PathEquals(strPath, storedPath) || dir->m_Items->Contains(strFile));
+    Shard& shard = GetShard(storedPath);
+    CSingleLock lock(shard.m_cs);
+
+    iCache i = shard.m_cache.find(storedPath);
+    if (i != shard.m_cache.end())
+    {
+      // a lookup in the path map of the listing, cheap enough to do under the lock
+      bInCache = true;
+      exists = URIUtils::PathEquals(strPath, storedPath) || i->second.m_Items->Contains(strFile);
+      i->second.SetLastAccess(m_accessCounter);
+    }
   }
-#ifdef _DEBUG
-  m_cacheMisses++;
-#endif
-  return false;
+
+  if (bInCache)
+    m_cacheHits++;
+  else
+    m_cacheMisses++;
+  return exists;
 }
 
 void CDirectoryCache::Clear()
 {
   // this routine clears everything
-  CSingleLock lock (m_cs);
+  for (Shard& shard : m_shards)
+  {
+    CSingleLock lock(shard.m_cs);
 
-  iCache i = m_cache.begin();
-  while (i != m_cache.end() )
-    Delete(i++);
+    iCache i = shard.m_cache.begin();
+    while (i != shard.m_cache.end() )
+      Delete(shard.m_cache, i++);
+  }
 }
 
 void CDirectoryCache::InitCache(std::set<std::string>& dirs)
@@ -219,60 +329,83 @@ void CDirectoryCache::InitCache(std::set<std::string>& dirs)
 
 void CDirectoryCache::ClearCache(std::set<std::string>& dirs)
 {
-  iCache i = m_cache.begin();
-  while (i != m_cache.end())
-  {
-    if (dirs.find(i->first) != dirs.end())
-      Delete(i++);
-    else
-      i++;
-  }
+  for (const std::string& dir : dirs)
+    ClearDirectory(dir);
 }
 
 void CDirectoryCache::CheckIfFull()
 {
-  CSingleLock lock (m_cs);
+  const size_t maxSize = GetMaxSize();
 
-  // find the last accessed folder, and remove if the number of cached folders is too many
-  iCache lastAccessed = m_cache.end();
-  unsigned int numCached = 0;
-  for (iCache i = m_cache.begin(); i != m_cache.end(); i++)
+  // evict the least recently used folders until we are within the limit. Only one
+  // shard is locked at a time, so the oldest folder is found approximately.
+  while (m_size > maxSize)
   {
-    // ensure dirs that are always cached aren't cleared
-    if (i->second->m_cacheType != DIR_CACHE_ALWAYS)
+    Shard* oldestShard = nullptr;
+    unsigned int oldestAccess = UINT_MAX;
+    for (Shard& shard : m_shards)
+    {
+      CSingleLock lock(shard.m_cs);
+      for (const auto& it : shard.m_cache)
+      {
+        // ensure dirs that are always cached aren't cleared
+        if (it.second.m_cacheType != DIR_CACHE_ALWAYS && it.second.GetLastAccess() <= oldestAccess)
+        {
+          oldestAccess = it.second.GetLastAccess();
+          oldestShard = &shard;
+        }
+      }
+    }
+
+    if (!oldestShard)
+      return; // nothing left that can be evicted
+
+    CSingleLock lock(oldestShard->m_cs);
+    iCache lastAccessed = oldestShard->m_cache.end();
+    for (iCache i = oldestShard->m_cache.begin(); i != oldestShard->m_cache.end(); i++)
     {
-      if (lastAccessed == m_cache.end() || i->second->GetLastAccess() < lastAccessed->second->GetLastAccess())
+      if (i->second.m_cacheType != DIR_CACHE_ALWAYS &&
+          (lastAccessed == oldestShard->m_cache.end() || i->second.GetLastAccess() < lastAccessed->second.GetLastAccess()))
         lastAccessed = i;
-      numCached++;
+    }
+    if (lastAccessed != oldestShard->m_cache.end())
+    {
+      Delete(oldestShard->m_cache, lastAccessed);
+      m_evictions++;
     }
   }
-  if (lastAccessed != m_cache.end() && numCached >= MAX_CACHED_DIRS)
-    Delete(lastAccessed);
 }
 
-void CDirectoryCache::Delete(iCache it)
+void CDirectoryCache::Delete(DirMap& cache, iCache it)
 {
-  CDir* dir = it->second;
-  delete dir;
-  m_cache.erase(it);
+  m_size -= it->second.m_size;
+  cache.erase(it);
 }
 
-#ifdef _DEBUG
-void CDirectoryCache::PrintStats() const
+CDirectoryCache::Statistics CDirectoryCache::GetStatistics() const
 {
-  CSingleLock lock (m_cs);
-  CLog::Log(LOGDEBUG, "%s - total of %u cache hits, and %u cache misses", __FUNCTION__, m_cacheHits, m_cacheMisses);
-  // run through and find the oldest and the number of items cached
-  unsigned int oldest = UINT_MAX;
-  unsigned int numItems = 0;
-  unsigned int numDirs = 0;
-  for (ciCache i = m_cache.begin(); i != m_cache.end(); i++)
+  Statistics statistics;
+  statistics.hits = m_cacheHits;
+  statistics.misses = m_cacheMisses;
+  statistics.evictions = m_evictions;
+  statistics.size = m_size;
+  statistics.maxSize = GetMaxSize();
+
+  for (const Shard& shard : m_shards)
   {
-    CDir *dir = i->second;
-    oldest = std::min(oldest, dir->GetLastAccess());
-    numItems += dir->m_Items->Size();
-    numDirs++;
+    CSingleLock lock(shard.m_cs);
+    statistics.directories += shard.m_cache.size();
+    for (const auto& it : shard.m_cache)
+      statistics.items += it.second.m_Items->Size();
   }
-  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total.  Oldest is %u, current is %u", __FUNCTION__, numDirs, numItems, oldest, m_accessCounter);
+  return statistics;
+}
+
+void CDirectoryCache::PrintStats() const
+{
+  const Statistics statistics = GetStatistics();
+  CLog::Log(LOGINFO, "%s - total of %" PRIu64" cache hits, %" PRIu64" cache misses and %" PRIu64" evictions", __FUNCTION__,
+            statistics.hits, statistics.misses, statistics.evictions);
+  CLog::Log(LOGINFO, "%s - %zu folders cached, with %zu items total using %" PRIu64" of %" PRIu64" bytes", __FUNCTION__,
+            statistics.directories, statistics.items, statistics.size, statistics.maxSize);
 }
-#endif
@@ -11,35 +11,78 @@
 #include "IDirectory.h"
 #include "threads/CriticalSection.h"
 
-#include <map>
+#include <array>
+#include <atomic>
+#include <memory>
 #include <set>
+#include <unordered_map>
 
 class CFileItem;
 
 namespace XFILE
 {
+  /*!
+   \brief Cache of directory listings.
+
+   Every listing is kept in a list that only the cache modifies, under the lock
+   of its shard. Readers get a snapshot sharing the items of that list, which
+   is made once and handed out until the listing changes, so a large listing
+   is never copied while other threads are waiting for the cache. The items
+   themselves are never modified by the cache; readers that modify them have
+   to ask for copies.
+
+   Paths are hashed onto a number of shards with a lock each. The size of
+   the cache is bounded by the estimated number of bytes used by all cached
+   listings, see <cache><directorycachesize>; the least recently used
+   listings are evicted first, listings cached with DIR_CACHE_ALWAYS never.
+   */
   class CDirectoryCache
   {
     class CDir
     {
     public:
-      explicit CDir(DIR_CACHE_TYPE cacheType);
-      virtual ~CDir();
+      CDir(DIR_CACHE_TYPE cacheType, std::unique_ptr<CFileItemList> items);
 
-      void SetLastAccess(unsigned int &accessCounter);
+      void SetLastAccess(std::atomic<unsigned int> &accessCounter);
       unsigned int GetLastAccess() const { return m_lastAccess; };
 
-      CFileItemList* m_Items;
+      /*!
+       \brief The snapshot of the listing handed out to readers, made on first use.
+       */
+      std::shared_ptr<const CFileItemList> GetShared();
+
+      std::unique_ptr<CFileItemList> m_Items; ///< never handed out, only modified under the lock
+      std::shared_ptr<const CFileItemList> m_shared; ///< reset whenever m_Items changes
       DIR_CACHE_TYPE m_cacheType;
+      size_t m_size;
     private:
-      CDir(const CDir&) = delete;
-      CDir& operator=(const CDir&) = delete;
       unsigned int m_lastAccess;
     };
   public:
+    struct Statistics
+    {
+      uint64_t hits = 0;       ///< listings and file lookups answered from the cache
+      uint64_t misses = 0;     ///< listings and file lookups not found in the cache
+      uint64_t evictions = 0;  ///< listings removed to stay within the size limit
+      uint64_t size = 0;       ///< estimated bytes currently used
+      uint64_t maxSize = 0;    ///< size limit in bytes
+      size_t directories = 0;  ///< number of cached listings
+      size_t items = 0;        ///< number of cached items
+    };
+
     CDirectoryCache(void);
     virtual ~CDirectoryCache(void);
-    bool GetDirectory(const std::string& strPath, CFileItemList &items, bool retrieveAll = false);
+    /*!
+     \brief Get a cached listing.
+     \param copyItems false to share the cached items instead of copying them, the caller must not modify them then
+     */
+    bool GetDirectory(const std::string& strPath, CFileItemList &items, bool retrieveAll = false, bool copyItems = true);
+
+    /*!
+     \brief Get the cached listing itself, it's shared with other readers and must not be modified.
+     \return the listing, nullptr if it isn't cached
+     */
+    std::shared_ptr<const CFileItemList> GetDirectory(const std::string& strPath, bool retrieveAll = false);
     void SetDirectory(const std::string& strPath, const CFileItemList &items, DIR_CACHE_TYPE cacheType);
     void ClearDirectory(const std::string& strPath);
     void ClearFile(const std::string& strFile);
@@ -47,27 +90,55 @@ namespace XFILE
     void Clear();
     void AddFile(const std::string& strFile);
     bool FileExists(const std::string& strPath, bool& bInCache);
-#ifdef _DEBUG
+
+    Statistics GetStatistics() const;
+
+    /*!
+     \brief Overrides the size limit from the advanced settings.
+     \param bytes the limit in bytes, 0 to use the advanced settings again
+     */
+    void SetMaxSize(size_t bytes) { m_maxSize = bytes; }
+
+    /*!
+     \brief Estimates the memory used by a listing and its items.
+     */
+    static size_t EstimateSize(const CFileItemList &items);
+
+    /*!
+     \brief Estimates the memory used by an item of a listing.
+     */
+    static size_t EstimateSize(const CFileItem &item);
+
     void PrintStats() const;
-#endif
   protected:
+    static constexpr size_t SHARDS = 16;
+
+    typedef std::unordered_map<std::string, CDir> DirMap;
+    typedef DirMap::iterator iCache;
+    typedef DirMap::const_iterator ciCache;
+
+    struct Shard
+    {
+      mutable CCriticalSection m_cs;
+      DirMap m_cache;
+    };
+
     void InitCache(std::set<std::string>& dirs);
     void ClearCache(std::set<std::string>& dirs);
     void CheckIfFull();
 
-    std::map<std::string, CDir*> m_cache;
-    typedef std::map<std::string, CDir*>::iterator iCache;
-    typedef std::map<std::string, CDir*>::const_iterator ciCache;
-    void Delete(iCache i);
-
-    mutable CCriticalSection m_cs;
+    Shard& GetShard(const std::string& storedPath);
+    void Delete(DirMap& cache, iCache i);
+    size_t GetMaxSize() const;
 
-    unsigned int m_accessCounter;
+    std::array<Shard, SHARDS> m_shards;
 
-#ifdef _DEBUG
-    unsigned int m_cacheHits;
-    unsigned int m_cacheMisses;
-#endif
+    std::atomic<unsigned int> m_accessCounter;
+    std::atomic<size_t> m_maxSize;
+    std::atomic<uint64_t> m_size;
+    std::atomic<uint64_t> m_cacheHits;
+    std::atomic<uint64_t> m_cacheMisses;
+    std::atomic<uint64_t> m_evictions;
   };
 }
 extern XFILE::CDirectoryCache g_directoryCache;
@@ -0,0 +1,128 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "DirectoryPrefetcher.h"
+
+#include "Directory.h"
+#include "FileItem.h"
+#include "URL.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/Job.h"
+#include "utils/JobManager.h"
+#include "utils/URIUtils.h"
+#include "utils/log.h"
+
+using namespace XFILE;
+
+// a prefetched listing is only used by a navigation within this time
+#define PREFETCH_MAX_AGE 60000
+
+class CDirectoryPrefetcher::CPrefetchJob : public CJob
+{
+public:
+  CPrefetchJob(const std::string& path, std::shared_ptr<State> state)
+    : m_path(path), m_state(std::move(state))
+  {
+  }
+
+  const char* GetType() const override { return "directoryprefetch"; }
+
+  bool DoWork() override
+  {
+    // no prompts from the background, listings that are cached already aren't fetched again
+    CFileItemList items;
+    if (!CDirectory::GetDirectory(m_path, items, "", DIR_FLAG_READ_CACHE))
+      return false;
+
+    CLog::Log(LOGDEBUG, "CDirectoryPrefetcher - prefetched %s with %i items",
+              CURL::GetRedacted(m_path).c_str(), items.Size());
+
+    CSingleLock lock(m_state->m_critical);
+    m_state->m_prefetched[NormalizePath(m_path)] = XbmcThreads::SystemClockMillis();
+    return true;
+  }
+
+private:
+  std::string m_path;
+  std::shared_ptr<State> m_state;
+};
+
+CDirectoryPrefetcher::CDirectoryPrefetcher()
+  : m_state(std::make_shared<State>())
+{
+}
+
+CDirectoryPrefetcher::~CDirectoryPrefetcher()
+{
+  Cancel();
+}
+
+std::string CDirectoryPrefetcher::NormalizePath(const std::string& path)
+{
+  std::string normalized = CURL(path).GetWithoutOptions();
+  URIUtils::RemoveSlashAtEnd(normalized);
+  return normalized;
+}
+
+bool CDirectoryPrefetcher::IsPrefetchable(const CURL& url)
+{
+  // plugins and pvr may do anything when listing a directory, local
+  // directories and the libraries are fast enough already
+  return url.IsProtocol("upnp") ||
+         url.IsProtocol("dav") || url.IsProtocol("davs") ||
+         url.IsProtocol("http") || url.IsProtocol("https") ||
+         url.IsProtocol("ftp") || url.IsProtocol("ftps") ||
+         url.IsProtocol("sftp") ||
+         url.IsProtocol("smb") || url.IsProtocol("nfs");
+}
+
+void CDirectoryPrefetcher::Prefetch(const std::vector<std::string>& paths)
+{
+  Cancel();
+
+  for (const std::string& path : paths)
+  {
+    if (path.empty() || !IsPrefetchable(CURL(path)))
+      continue;
+
+    m_jobs.push_back(CJobManager::GetInstance().AddJob(new CPrefetchJob(path, m_state), nullptr, CJob::PRIORITY_LOW));
+  }
+}
+
+void CDirectoryPrefetcher::Cancel()
+{
+  // running jobs complete and still cache their listing
+  for (unsigned int jobID : m_jobs)
+    CJobManager::GetInstance().CancelJob(jobID);
+  m_jobs.clear();
+}
+
+bool CDirectoryPrefetcher::WasPrefetched(const std::string& path)
+{
+  const std::string normalized = NormalizePath(path);
+  const unsigned int now = XbmcThreads::SystemClockMillis();
+
+  CSingleLock lock(m_state->m_critical);
+
+  // forget about old prefetches
+  for (auto it = m_state->m_prefetched.begin(); it != m_state->m_prefetched.end();)
+  {
+    if (now - it->second > PREFETCH_MAX_AGE)
+      it = m_state->m_prefetched.erase(it);
+    else
+      ++it;
+  }
+
+  auto it = m_state->m_prefetched.find(normalized);
+  if (it == m_state->m_prefetched.end())
+    return false;
+
+  m_state->m_prefetched.erase(it);
+  return true;
+}
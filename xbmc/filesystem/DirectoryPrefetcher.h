@@ -0,0 +1,76 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#pragma once
+
+#include "threads/CriticalSection.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class CURL;
+
+namespace XFILE
+{
+
+/*!
+ \brief Fetches directories the user is likely to open next in the background.
+
+ The listings are fetched by low priority jobs and end up in the directory
+ cache. Directories on most network sources are cached with DIR_CACHE_ONCE,
+ i.e. they are only served from the cache when asked for explicitly, so the
+ prefetched paths are remembered for a short while and the next navigation
+ to one of them can ask for the cached listing, see WasPrefetched().
+ */
+class CDirectoryPrefetcher
+{
+public:
+  CDirectoryPrefetcher();
+  ~CDirectoryPrefetcher();
+
+  /*!
+   \brief Cancels the pending prefetches and queues the given directories.
+   \param paths directories to fetch, most likely first. Paths that can't be
+   fetched without side effects or are cheap to list anyway are skipped.
+   */
+  void Prefetch(const std::vector<std::string>& paths);
+
+  /*!
+   \brief Cancels all prefetches that haven't been started yet.
+   */
+  void Cancel();
+
+  /*!
+   \brief Whether the directory was prefetched recently, forgets about it.
+   */
+  bool WasPrefetched(const std::string& path);
+
+  /*!
+   \brief Whether listing the directory is slow enough to be worth prefetching
+   and has no side effects.
+   */
+  static bool IsPrefetchable(const CURL& url);
+
+private:
+  class CPrefetchJob;
+
+  struct State
+  {
+    CCriticalSection m_critical;
+    std::map<std::string, unsigned int> m_prefetched; ///< normalized path -> time fetched
+  };
+
+  static std::string NormalizePath(const std::string& path);
+
+  std::shared_ptr<State> m_state; ///< shared with the jobs, which may outlive the prefetcher
+  std::vector<unsigned int> m_jobs;
+};
+
+}
@@ -14,6 +14,7 @@
 #include "ServiceBroker.h"
 
 #include "CircularCache.h"
+#include "SegmentCache.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "settings/AdvancedSettings.h"
@@ -21,10 +22,12 @@
 
 #if !defined(TARGET_WINDOWS)
 #include "platform/linux/ConvUtils.h"
+#include "platform/linux/XMemUtils.h"
 #endif
 
 #include <cassert>
 #include <algorithm>
+#include <cmath>
 #include <memory>
 
 #ifdef TARGET_POSIX
@@ -35,6 +38,11 @@ using namespace XFILE;
 
 #define READ_CACHE_CHUNK_SIZE (128*1024)
 
+// bounds and update interval of the adaptive memory cache
+#define CACHE_ADAPTIVE_MIN_SIZE (8*1024*1024)
+#define CACHE_ADAPTIVE_MAX_SIZE (1024*1024*1024)
+#define CACHE_ADAPTIVE_INTERVAL 2000
+
 class CWriteRate
 {
 public:
@@ -81,6 +89,84 @@ private:
 };
 
 
+/*!
+ \brief Chooses the size of the memory cache from the throughput of the source,
+ the bitrate of the stream and the free memory.
+
+ The cache has to cover the stalls of the source. A source that is many times
+ faster than the stream refills the cache quickly, so a few seconds of the
+ stream suffice. Slow sources and sources with a varying throughput, like
+ most internet streams, need a lot more.
+ */
+class CCacheSizer
+{
+public:
+  CCacheSizer(size_t minSize, size_t maxSize)
+    : m_minSize(minSize)
+    , m_maxSize(std::max(minSize, maxSize))
+  {
+  }
+
+  /*!
+   \brief Account for a read from the source.
+   Reads are summed up until they took long enough to be measured reliably.
+   */
+  void AddRead(size_t bytes, unsigned int millis)
+  {
+    m_bytes += bytes;
+    m_millis += millis;
+    if (m_millis < 250 && m_bytes < 16 * 1024 * 1024)
+      return;
+
+    const double rate = 1000.0 * m_bytes / std::max(m_millis, 1u);
+    if (m_samples == 0)
+      m_rate = rate;
+    m_deviation += 0.2 * (std::abs(rate - m_rate) - m_deviation);
+    m_rate += 0.2 * (rate - m_rate);
+    m_samples++;
+    m_bytes = 0;
+    m_millis = 0;
+  }
+
+  void SetLowSpeed() { m_lowSpeed = true; }
+
+  /*!
+   \brief The total size of the cache for a stream of the given rate.
+   \return 0 as long as the source hasn't been measured
+   */
+  size_t GetSize(unsigned streamRate) const
+  {
+    if (m_samples < 3 || streamRate == 0)
+      return 0;
+
+    const double headroom = m_rate / streamRate;
+    double seconds;
+    if (m_lowSpeed || headroom < 2.0)
+      seconds = 60.0;
+    else if (headroom < 8.0)
+      seconds = 20.0;
+    else
+      seconds = 5.0;
+    seconds *= 1.0 + 2.0 * std::min(m_deviation / m_rate, 1.0);
+
+    // a quarter of the cache is back buffer, like the static size
+    const double size = streamRate * seconds * 4 / 3;
+    return static_cast<size_t>(std::min(std::max(size, static_cast<double>(m_minSize)), static_cast<double>(m_maxSize)));
+  }
+
+  double GetRate() const { return m_rate; }
+
+private:
+  size_t m_minSize;
+  size_t m_maxSize;
+  int64_t m_bytes = 0;
+  unsigned int m_millis = 0;
+  unsigned int m_samples = 0;
+  double m_rate = 0.0;      ///< average throughput of the source in bytes per second
+  double m_deviation = 0.0; ///< average deviation of the throughput
+  bool m_lowSpeed = false;
+};
+
 CFileCache::CFileCache(const unsigned int flags)
   : CThread("FileCache")
   , m_pCache(NULL)
@@ -170,6 +256,20 @@ bool CFileCache::Open(const CURL& url)
   m_seekPossible = m_source.IoControl(IOCTRL_SEEK_POSSIBLE, NULL);
   m_chunkSize = CFile::GetChunkSize(m_source.GetChunkSize(), READ_CACHE_CHUNK_SIZE);
   m_fileSize = m_source.GetLength();
+  m_sourcePos = 0;
+
+  // keep what is read from network sources on disk for later sessions. Without a modification
+  // time a replaced file of the same size can't be told apart, so it isn't cached.
+  if (m_seekPossible > 0 && m_fileSize > 0 && CSegmentCache::IsCacheable(url) &&
+      CSegmentCache::GetInstance().IsEnabled())
+  {
+    struct __stat64 buffer;
+    if (m_source.Stat(&buffer) == 0 && buffer.st_mtime != 0)
+      m_segments.reset(new CSegmentCacheFile(url, m_fileSize, buffer.st_mtime));
+    else
+      CLog::Log(LOGDEBUG, "CFileCache::Open - no modification time for %s, not kept in the segment cache",
+                url.GetRedacted().c_str());
+  }
 
   if (!m_pCache)
   {
@@ -192,6 +292,29 @@ bool CFileCache::Open(const CURL& url)
         cacheSize = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_cacheMemSize;
       }
 
+      m_adaptiveMinSize = 0;
+      m_adaptiveMaxSize = 0;
+      if (CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_cacheAdaptive && (m_flags & READ_AUDIO_VIDEO))
+      {
+        // the cache starts at memorysize and is adapted once the source has been
+        // measured, see CCacheSizer. It grows up to adaptivemaxsize if that is set,
+        // otherwise up to an eighth of the free memory.
+        const size_t maxSize = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_cacheAdaptiveMaxSize;
+        m_adaptiveMinSize = std::min<size_t>(cacheSize, CACHE_ADAPTIVE_MIN_SIZE);
+        if (maxSize > 0)
+        {
+          m_adaptiveMaxSize = std::max(m_adaptiveMinSize, maxSize);
+        }
+        else
+        {
+          MEMORYSTATUSEX stat;
+          stat.dwLength = sizeof(MEMORYSTATUSEX);
+          GlobalMemoryStatusEx(&stat);
+          m_adaptiveMaxSize = std::max<size_t>(m_adaptiveMinSize, std::min<uint64_t>(stat.ullAvailPhys / 8, CACHE_ADAPTIVE_MAX_SIZE));
+        }
+        cacheSize = std::min(cacheSize, m_adaptiveMaxSize);
+      }
+
       size_t back = cacheSize / 4;
       size_t front = cacheSize - back;
 
@@ -252,6 +375,8 @@ void CFileCache::Process()
 
   CWriteRate limiter;
   CWriteRate average;
+  CCacheSizer sizer(m_adaptiveMinSize, m_adaptiveMaxSize);
+  unsigned int sizeChecked = XbmcThreads::SystemClockMillis();
   bool cacheReachEOF = false;
 
   while (!m_bStop)
@@ -268,7 +393,16 @@ void CFileCache::Process()
       bool sourceSeekFailed = false;
       if (!cacheReachEOF)
       {
-        m_nSeekResult = m_source.Seek(cacheMaxPos, SEEK_SET);
+        if (m_segments && m_segments->IsCached(cacheMaxPos))
+        {
+          // served from the segment cache, the source is repositioned once it's read again
+          m_nSeekResult = cacheMaxPos;
+        }
+        else
+        {
+          m_nSeekResult = m_source.Seek(cacheMaxPos, SEEK_SET);
+          m_sourcePos = m_nSeekResult;
+        }
         if (m_nSeekResult != cacheMaxPos)
         {
           CLog::Log(LOGERROR,"CFileCache::Process - Error %d seeking. Seek returned %" PRId64, (int)GetLastError(), m_nSeekResult);
@@ -327,7 +461,14 @@ void CFileCache::Process()
 
     ssize_t iRead = 0;
     if (!cacheReachEOF)
-      iRead = m_source.Read(buffer.get(), maxWrite);
+    {
+      // only reads from the source measure its throughput, not segment cache hits
+      const unsigned int readStart = XbmcThreads::SystemClockMillis();
+      bool fromSource;
+      iRead = ReadSource(buffer.get(), maxWrite, fromSource);
+      if (iRead > 0 && fromSource)
+        sizer.AddRead(iRead, XbmcThreads::SystemClockMillis() - readStart);
+    }
     if (iRead == 0)
     {
       // Check for actual EOF and retry as long as we still have data in our cache
@@ -428,7 +569,10 @@ void CFileCache::Process()
       * low read-rate conditions.
       */
       if (m_bFilling && m_writeRateActual < m_writeRate)
+      {
         m_bLowSpeedDetected = true;
+        sizer.SetLowSpeed();
+      }
 
       m_bFilling = false;
     }
@@ -436,7 +580,74 @@ void CFileCache::Process()
     {
       m_bFilling = true;
     }
+
+    if (m_adaptiveMaxSize > 0 && XbmcThreads::SystemClockMillis() - sizeChecked > CACHE_ADAPTIVE_INTERVAL)
+    {
+      sizeChecked = XbmcThreads::SystemClockMillis();
+      AdaptCacheSize(sizer.GetSize(m_writeRate), sizer.GetRate());
+    }
+  }
+}
+
+void CFileCache::AdaptCacheSize(size_t size, double sourceRate)
+{
+  // only resize on larger changes, every resize copies the cached data
+  const size_t current = m_forwardCacheSize * 4 / 3 * ((m_flags & READ_MULTI_STREAM) ? 2 : 1);
+  if (size == 0 || (size > current * 4 / 5 && size < current * 5 / 4))
+    return;
+
+  // the reader must not use the cache while it's resized. It holds the lock
+  // while waiting for data, so don't wait for it.
+  if (!m_sync.try_lock())
+    return;
+
+  size_t back = size / 4;
+  size_t front = size - back;
+  if (m_flags & READ_MULTI_STREAM)
+  {
+    front /= 2;
+    back /= 2;
+  }
+
+  if (m_pCache->Resize(front, back))
+  {
+    CLog::Log(LOGDEBUG, "CFileCache::%s - resized cache to %zu bytes, source rate %.0f bytes/s, stream rate %u bytes/s",
+              __FUNCTION__, size, sourceRate, m_writeRate);
+    m_forwardCacheSize = front;
+  }
+  m_sync.unlock();
+}
+
+ssize_t CFileCache::ReadSource(char* buffer, size_t size, bool& fromSource)
+{
+  fromSource = true;
+  if (!m_segments)
+    return m_source.Read(buffer, size);
+
+  ssize_t iRead = m_segments->Read(m_writePos, buffer, size);
+  if (iRead > 0)
+  {
+    fromSource = false;
+    return iRead;
+  }
+
+  if (m_sourcePos != m_writePos)
+  {
+    if (m_source.Seek(m_writePos, SEEK_SET) != m_writePos)
+    {
+      CLog::Log(LOGERROR, "CFileCache::%s - failed to seek source to %" PRId64, __FUNCTION__, m_writePos);
+      return -1;
+    }
+    m_sourcePos = m_writePos;
+  }
+
+  iRead = m_source.Read(buffer, size);
+  if (iRead > 0)
+  {
+    m_segments->Write(m_writePos, buffer, iRead);
+    m_sourcePos += iRead;
   }
+  return iRead;
 }
 
 void CFileCache::OnExit()
@@ -571,6 +782,7 @@ void CFileCache::Close()
   if (m_pCache)
     m_pCache->Close();
 
+  m_segments.reset();
   m_source.Close();
 }
 
@@ -14,9 +14,11 @@
 #include "File.h"
 #include "threads/Thread.h"
 #include <atomic>
+#include <memory>
 
 namespace XFILE
 {
+  class CSegmentCacheFile;
 
   class CFileCache : public IFile, public CThread
   {
@@ -56,6 +58,18 @@ namespace XFILE
     }
 
   private:
+    /*!
+     \brief Read from the segment cache or the source at the write position.
+     \param fromSource set if the data came from the source, not from the segment cache
+     */
+    ssize_t ReadSource(char* buffer, size_t size, bool& fromSource);
+
+    /*!
+     \brief Resize the memory cache to the total size suggested by CCacheSizer.
+     Called by the cache thread, skipped while the reader uses the cache.
+     */
+    void AdaptCacheSize(size_t size, double sourceRate);
+
     CCacheStrategy *m_pCache;
     bool m_bDeleteCache;
     int m_seekPossible;
@@ -76,6 +90,10 @@ namespace XFILE
     std::atomic<int64_t> m_fileSize;
     unsigned int m_flags;
     CCriticalSection m_sync;
+    std::unique_ptr<CSegmentCacheFile> m_segments;
+    int64_t m_sourcePos = 0;
+    size_t m_adaptiveMinSize = 0; ///< bounds of the adaptive cache size, 0 if the size is fixed
+    size_t m_adaptiveMaxSize = 0;
   };
 
 }
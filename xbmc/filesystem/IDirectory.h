@@ -36,7 +36,8 @@ namespace XFILE
     DIR_FLAG_NO_FILE_INFO  = (2 << 2), ///< Don't read additional file info (stat for example)
     DIR_FLAG_GET_HIDDEN    = (2 << 3), ///< Get hidden files
     DIR_FLAG_READ_CACHE    = (2 << 4), ///< Force reading from the directory cache (if available)
-    DIR_FLAG_BYPASS_CACHE  = (2 << 5)  ///< Completely bypass the directory cache (no reading, no writing)
+    DIR_FLAG_BYPASS_CACHE  = (2 << 5), ///< Completely bypass the directory cache (no reading, no writing)
+    DIR_FLAG_SHARED_ITEMS  = (2 << 6)  ///< Share cached items instead of copying them, the caller must not modify them
   };
 /*!
  \ingroup filesystem
@@ -122,6 +123,7 @@ public:
 
   void SetMask(const std::string& strMask);
   void SetFlags(int flags);
+  int GetFlags() const { return m_flags; }
 
   /*! \brief Process additional requirements before the directory fetch is performed.
    Some directory fetches may require authentication, keyboard input etc.  The IDirectory subclass
@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include <memory>
+#include <stddef.h>
 #include <stdint.h>
 
 namespace XFILE
@@ -46,6 +48,14 @@ struct SNativeIoControl
   void*               param;
 };
 
+struct SMappedView
+{
+  int64_t offset = 0;             /**< in: file position of the first byte of the view */
+  size_t size = 0;                /**< in: requested size, 0 for the rest of the file. out: size of the view */
+  const uint8_t* data = nullptr;  /**< out: the bytes of the file at offset */
+  std::shared_ptr<void> mapping;  /**< out: keeps the view mapped, it is unmapped with the last reference */
+};
+
 struct SCacheStatus
 {
   uint64_t forward;  /**< number of bytes cached forward of current position */
@@ -61,6 +71,9 @@ typedef enum {
   IOCTRL_CACHE_SETRATE = 4,  /**< unsigned int with speed limit for caching in bytes per second */
   IOCTRL_SET_CACHE     = 8,  /**< CFileCache */
   IOCTRL_SET_RETRY     = 16, /**< Enable/disable retry within the protocol handler (if supported) */
+  IOCTRL_MAP_VIEW      = 32, /**< SMappedView, read-only view of the file in memory, returns 0 if it was mapped.
+                                   Accessing the view faults if the file is truncated, only map files nobody
+                                   writes to, see URIUtils::IsInstallPath() */
 } EIoControl;
 
 enum CURLOPTIONTYPE
@@ -11,6 +11,9 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "NFSFile.h"
+#include "ServiceBroker.h"
+#include "settings/AdvancedSettings.h"
+#include "settings/SettingsComponent.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
@@ -24,8 +27,13 @@
 #ifdef TARGET_WINDOWS
 #include <fcntl.h>
 #include <sys\stat.h>
+#else
+#include <poll.h>
 #endif
 
+#include <algorithm>
+#include <vector>
+
 //KEEP_ALIVE_TIMEOUT is decremented every half a second
 //360 * 0.5s == 180s == 3mins
 //so when no read was done for 3mins and files are open
@@ -35,6 +43,9 @@
 //6 mins (360s) cached context timeout
 #define CONTEXT_TIMEOUT 360000
 
+//give up on a read ahead request after 30s without a reply
+#define READ_AHEAD_TIMEOUT 30000
+
 //return codes for getContextForExport
 #define CONTEXT_INVALID  0    //getcontext failed
 #define CONTEXT_NEW      1    //new context created
@@ -408,6 +419,39 @@ void CNfsConnection::keepAlive(std::string _exportPath, struct nfsfh  *_pFileHan
   nfs_lseek(pContext, _pFileHandle, offset, SEEK_SET, &offset);
 }
 
+bool CNfsConnection::serviceAsync(struct nfs_context *pContext, int timeoutMs)
+{
+#if defined(TARGET_WINDOWS)
+  WSAPOLLFD pfd;
+#else
+  struct pollfd pfd;
+#endif
+  pfd.fd = nfs_get_fd(pContext);
+  pfd.events = nfs_which_events(pContext);
+  pfd.revents = 0;
+
+#if defined(TARGET_WINDOWS)
+  int ret = WSAPoll(&pfd, 1, timeoutMs);
+#else
+  int ret = poll(&pfd, 1, timeoutMs);
+  if (ret < 0 && errno == EINTR)
+    return true;
+#endif
+  if (ret < 0)
+  {
+    CLog::Log(LOGERROR, "NFS: Failed to poll for async replies: %s", strerror(errno));
+    return false;
+  }
+
+  //also called without events so that libnfs can handle its timeouts
+  if (nfs_service(pContext, pfd.revents) < 0)
+  {
+    CLog::Log(LOGERROR, "NFS: Failed to service async requests: %s", nfs_get_error(pContext));
+    return false;
+  }
+  return true;
+}
+
 int CNfsConnection::stat(const CURL &url, NFSSTAT *statbuff)
 {
   CSingleLock lock(*this);
@@ -463,6 +507,33 @@ void CNfsConnection::AddIdleConnection()
 
 CNfsConnection gNfsConnection;
 
+//an async read issued for read ahead - owned by the file until cancelled,
+//afterwards the callback frees it once libnfs is done with it
+struct XFILE::CNFSFile::ReadRequest
+{
+  uint64_t offset;
+  uint64_t size;
+  bool done = false;
+  bool cancelled = false;
+  int result = 0;
+  std::vector<char> data;
+};
+
+void CNFSFile::ReadCallback(int err, struct nfs_context *nfs, void *data, void *private_data)
+{
+  ReadRequest *request = static_cast<ReadRequest*>(private_data);
+  if (request->cancelled)
+  {
+    delete request;
+    return;
+  }
+
+  request->result = err;
+  if (err > 0)
+    request->data.assign(static_cast<char*>(data), static_cast<char*>(data) + err);
+  request->done = true;
+}
+
 CNFSFile::CNFSFile()
 : m_pFileHandle(NULL)
 , m_pNfsContext(NULL)
@@ -478,19 +549,8 @@ CNFSFile::~CNFSFile()
 
 int64_t CNFSFile::GetPosition()
 {
-  int ret = 0;
-  uint64_t offset = 0;
-  CSingleLock lock(gNfsConnection);
-
-  if (gNfsConnection.GetNfsContext() == NULL || m_pFileHandle == NULL) return 0;
-
-  ret = nfs_lseek(gNfsConnection.GetNfsContext(), m_pFileHandle, 0, SEEK_CUR, &offset);
-
-  if (ret < 0)
-  {
-    CLog::Log(LOGERROR, "NFS: Failed to lseek(%s)",nfs_get_error(gNfsConnection.GetNfsContext()));
-  }
-  return offset;
+  if (m_pFileHandle == NULL) return 0;
+  return m_filePos;
 }
 
 int64_t CNFSFile::GetLength()
@@ -544,6 +604,8 @@ bool CNFSFile::Open(const CURL& url)
   }
 
   m_fileSize = tmpBuffer.st_size;//cache the size of this file
+  m_filePos = 0;
+  m_readAheadWindow = 1;
   // We've successfully opened the file!
   return true;
 }
@@ -605,6 +667,66 @@ int CNFSFile::Stat(const CURL& url, struct __stat64* buffer)
   return ret;
 }
 
+void CNFSFile::QueueReadAhead(unsigned int window)
+{
+  const uint64_t chunkSize = std::max<uint64_t>(gNfsConnection.GetMaxReadChunkSize(), 32768);
+  uint64_t offset = m_readAhead.empty() ? m_filePos : m_readAhead.back()->offset + m_readAhead.back()->size;
+
+  while (m_readAhead.size() < window && offset < static_cast<uint64_t>(m_fileSize))
+  {
+    ReadRequest *request = new ReadRequest;
+    request->offset = offset;
+    request->size = std::min<uint64_t>(chunkSize, m_fileSize - offset);
+
+    if (nfs_pread_async(m_pNfsContext, m_pFileHandle, request->offset, request->size, ReadCallback, request) != 0)
+    {
+      CLog::Log(LOGERROR, "%s - Error( %s )", __FUNCTION__, nfs_get_error(m_pNfsContext));
+      delete request;
+      break;
+    }
+    m_readAhead.push_back(request);
+    offset += request->size;
+  }
+}
+
+bool CNFSFile::IsInReadAhead(const ReadRequest &request, int64_t position)
+{
+  const uint64_t pos = static_cast<uint64_t>(position);
+  if (pos == request.offset)
+    return true;
+
+  //partly consumed, the rest of the received data is still valid
+  return request.done && request.result > 0 &&
+         pos > request.offset && pos < request.offset + static_cast<uint64_t>(request.result);
+}
+
+void CNFSFile::CancelReadAhead()
+{
+  for (ReadRequest *request : m_readAhead)
+  {
+    if (request->done)
+      delete request;
+    else
+      request->cancelled = true;
+  }
+  m_readAhead.clear();
+}
+
+bool CNFSFile::WaitForReadAhead(bool all)
+{
+  XbmcThreads::EndTime timeout(READ_AHEAD_TIMEOUT);
+  while (!m_readAhead.empty())
+  {
+    if (all ? std::all_of(m_readAhead.begin(), m_readAhead.end(), [](const ReadRequest *request) { return request->done; })
+            : m_readAhead.front()->done)
+      return true;
+
+    if (timeout.IsTimePast() || !gNfsConnection.serviceAsync(m_pNfsContext, 100))
+      return false;
+  }
+  return true;
+}
+
 ssize_t CNFSFile::Read(void *lpBuf, size_t uiBufSize)
 {
   if (uiBufSize > SSIZE_MAX)
@@ -616,7 +738,58 @@ ssize_t CNFSFile::Read(void *lpBuf, size_t uiBufSize)
   if (m_pFileHandle == NULL || m_pNfsContext == NULL )
     return -1;
 
-  numberOfBytesRead = nfs_read(m_pNfsContext, m_pFileHandle, uiBufSize, (char *)lpBuf);
+  const unsigned int maxWindow = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_nfsReadAhead;
+  if (maxWindow <= 1)
+  {
+    numberOfBytesRead = nfs_pread(m_pNfsContext, m_pFileHandle, m_filePos, uiBufSize, (char *)lpBuf);
+  }
+  else
+  {
+    //start over with a single request unless reading on within the data of the first one
+    if (!m_readAhead.empty() && !IsInReadAhead(*m_readAhead.front(), m_filePos))
+    {
+      CancelReadAhead();
+      m_readAheadWindow = 1;
+    }
+
+    QueueReadAhead(m_readAheadWindow);
+
+    if (m_readAhead.empty())
+      numberOfBytesRead = 0; //end of file
+    else if (!WaitForReadAhead(false))
+    {
+      CancelReadAhead();
+      numberOfBytesRead = -1;
+    }
+    else
+    {
+      ReadRequest *request = m_readAhead.front();
+      if (request->result <= 0)
+      {
+        numberOfBytesRead = request->result;
+        CancelReadAhead();
+      }
+      else
+      {
+        const uint64_t consumed = m_filePos - request->offset;
+        numberOfBytesRead = std::min<uint64_t>(uiBufSize, request->result - consumed);
+        memcpy(lpBuf, request->data.data() + consumed, numberOfBytesRead);
+
+        if (consumed + numberOfBytesRead == static_cast<uint64_t>(request->result))
+        {
+          delete request;
+          m_readAhead.pop_front();
+
+          //sequential read - widen the window and keep the pipe full
+          m_readAheadWindow = std::min(m_readAheadWindow * 2, maxWindow);
+          QueueReadAhead(m_readAheadWindow);
+        }
+      }
+    }
+  }
+
+  if (numberOfBytesRead > 0)
+    m_filePos += numberOfBytesRead;
 
   lock.Leave();//no need to keep the connection lock after that
 
@@ -637,6 +810,11 @@ int64_t CNFSFile::Seek(int64_t iFilePosition, int iWhence)
   CSingleLock lock(gNfsConnection);
   if (m_pFileHandle == NULL || m_pNfsContext == NULL) return -1;
 
+  if (iWhence == SEEK_CUR)
+  {
+    iFilePosition += m_filePos;
+    iWhence = SEEK_SET;
+  }
 
   ret = nfs_lseek(m_pNfsContext, m_pFileHandle, iFilePosition, iWhence, &offset);
   if (ret < 0)
@@ -644,6 +822,7 @@ int64_t CNFSFile::Seek(int64_t iFilePosition, int iWhence)
     CLog::Log(LOGERROR, "%s - Error( seekpos: %" PRId64", whence: %i, fsize: %" PRId64", %s)", __FUNCTION__, iFilePosition, iWhence, m_fileSize, nfs_get_error(m_pNfsContext));
     return -1;
   }
+  m_filePos = offset;
   return (int64_t)offset;
 }
 
@@ -675,6 +854,10 @@ void CNFSFile::Close()
     // remove it from keep alive list before closing
     // so keep alive code doesn't process it anymore
     gNfsConnection.removeFromKeepAliveList(m_pFileHandle);
+    // libnfs must be done with the handle before it can be closed
+    if (!WaitForReadAhead(true))
+      CLog::Log(LOGWARNING, "CNFSFile::Close timed out waiting for read ahead of %s", m_url.GetFileName().c_str());
+    CancelReadAhead();
     ret = nfs_close(m_pNfsContext, m_pFileHandle);
 
 	  if (ret < 0)
@@ -684,6 +867,7 @@ void CNFSFile::Close()
     m_pFileHandle = NULL;
     m_pNfsContext = NULL;
     m_fileSize = 0;
+    m_filePos = 0;
     m_exportPath.clear();
   }
 }
@@ -732,6 +916,7 @@ ssize_t CNFSFile::Write(const void* lpBuf, size_t uiBufSize)
       break;
     }
   }
+  m_filePos += numberOfBytesWritten;
   //return total number of written bytes
   return numberOfBytesWritten;
 }
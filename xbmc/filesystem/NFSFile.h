@@ -13,6 +13,7 @@
 #include "IFile.h"
 #include "URL.h"
 #include "threads/CriticalSection.h"
+#include <deque>
 #include <list>
 #include <map>
 
@@ -66,6 +67,10 @@ public:
   void resetKeepAlive(std::string _exportPath, struct nfsfh  *_pFileHandle);
   //removes file handle from keep alive list
   void removeFromKeepAliveList(struct nfsfh  *_pFileHandle);
+  //runs the libnfs event loop of the given context once, waiting at most timeoutMs
+  //for the socket, and dispatches the callbacks of completed async calls
+  //must be called with the connection locked
+  bool serviceAsync(struct nfs_context *pContext, int timeoutMs);
 
   const std::string& GetConnectedIp() const {return m_resolvedHostName;}
   const std::string& GetConnectedExport() const {return m_exportPath;}
@@ -126,9 +131,19 @@ namespace XFILE
     bool Delete(const CURL& url) override;
     bool Rename(const CURL& url, const CURL& urlnew) override;
   protected:
+    struct ReadRequest;
+    static void ReadCallback(int err, struct nfs_context *nfs, void *data, void *private_data);
+
     CURL m_url;
     bool IsValidFile(const std::string& strFileName);
+    void QueueReadAhead(unsigned int window);
+    static bool IsInReadAhead(const ReadRequest &request, int64_t position);
+    void CancelReadAhead();
+    bool WaitForReadAhead(bool all);
     int64_t m_fileSize = 0;
+    int64_t m_filePos = 0;
+    std::deque<ReadRequest*> m_readAhead;//async reads in flight or not yet consumed, in file order
+    unsigned int m_readAheadWindow = 1;//number of reads to keep in flight, grows while reading sequentially
     struct nfsfh *m_pFileHandle;
     struct nfs_context *m_pNfsContext;//current nfs context
     std::string m_exportPath;
@@ -0,0 +1,388 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "SegmentCache.h"
+
+#include "Directory.h"
+#include "FileItem.h"
+#include "ServiceBroker.h"
+#include "URL.h"
+#include "settings/AdvancedSettings.h"
+#include "settings/SettingsComponent.h"
+#include "threads/SingleLock.h"
+#include "utils/Digest.h"
+#include "utils/Job.h"
+#include "utils/JobManager.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <inttypes.h>
+
+using namespace XFILE;
+using KODI::UTILITY::CDigest;
+
+#define SEGMENT_CACHE_PATH "special://temp/segmentcache/"
+
+// segments waiting to be written, more are dropped instead of piling up in memory
+#define SEGMENT_CACHE_MAX_QUEUED 8
+
+class CSegmentCache::CStoreJob : public CJob
+{
+public:
+  CStoreJob(CSegmentCache& cache, std::string key, int64_t index, std::vector<char> data)
+    : m_cache(cache), m_key(std::move(key)), m_index(index), m_data(std::move(data)) {}
+
+  // also reached if the job was cancelled
+  ~CStoreJob() override { m_cache.OnStored(); }
+
+  bool DoWork() override
+  {
+    m_cache.Store(m_key, m_index, m_data);
+    return true;
+  }
+
+  const char* GetType() const override { return "segmentcachestore"; }
+
+private:
+  CSegmentCache& m_cache;
+  std::string m_key;
+  int64_t m_index;
+  std::vector<char> m_data;
+};
+
+double CSegmentCache::Statistics::GetHitRatio() const
+{
+  const uint64_t total = hitBytes + missBytes;
+  return total > 0 ? static_cast<double>(hitBytes) / total : 0.0;
+}
+
+CSegmentCache& CSegmentCache::GetInstance()
+{
+  static CSegmentCache instance;
+  return instance;
+}
+
+bool CSegmentCache::IsEnabled() const
+{
+  return CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_cachePersistentSize > 0;
+}
+
+bool CSegmentCache::IsCacheable(const CURL& url)
+{
+  return url.IsProtocol("http") || url.IsProtocol("https") ||
+         url.IsProtocol("dav") || url.IsProtocol("davs") ||
+         url.IsProtocol("smb") || url.IsProtocol("nfs");
+}
+
+std::string CSegmentCache::GetKey(const CURL& url, int64_t length, int64_t mtime)
+{
+  return CDigest::Calculate(CDigest::Type::SHA256,
+                            StringUtils::Format("%s|%" PRId64 "|%" PRId64, url.GetWithoutUserDetails().c_str(), length, mtime));
+}
+
+std::string CSegmentCache::GetSegmentName(const std::string& key, int64_t index)
+{
+  return StringUtils::Format("%s-%" PRId64 ".seg", key.c_str(), index);
+}
+
+void CSegmentCache::Load()
+{
+  if (m_loaded)
+    return;
+  m_loaded = true;
+
+  if (!CDirectory::Exists(SEGMENT_CACHE_PATH))
+  {
+    CDirectory::Create(SEGMENT_CACHE_PATH);
+    return;
+  }
+
+  CFileItemList items;
+  if (!CDirectory::GetDirectory(SEGMENT_CACHE_PATH, items, ".seg|.tmp", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_BYPASS_CACHE))
+    return;
+
+  // without access times the modification time is the best guess for the lru order
+  std::vector<CFileItemPtr> segments;
+  for (const auto& item : items)
+  {
+    if (item->m_bIsFolder)
+      continue;
+    if (URIUtils::HasExtension(item->GetPath(), ".tmp"))
+      CFile::Delete(item->GetPath()); // left over from an interrupted store
+    else
+      segments.push_back(item);
+  }
+  std::sort(segments.begin(), segments.end(), [](const CFileItemPtr& a, const CFileItemPtr& b)
+  {
+    return a->m_dateTime > b->m_dateTime;
+  });
+
+  for (const auto& item : segments)
+  {
+    const std::string name = URIUtils::GetFileName(item->GetPath());
+    m_lru.push_back(name);
+    m_segments[name] = { item->m_dwSize, std::prev(m_lru.end()) };
+    m_size += item->m_dwSize;
+  }
+
+  CLog::Log(LOGDEBUG, "CSegmentCache::%s - found %zu segments using %" PRIu64 " bytes", __FUNCTION__,
+            m_segments.size(), m_size);
+}
+
+std::string CSegmentCache::Lookup(const std::string& key, int64_t index)
+{
+  const std::string name = GetSegmentName(key, index);
+
+  CSingleLock lock(m_critical);
+  Load();
+
+  auto it = m_segments.find(name);
+  if (it == m_segments.end())
+    return "";
+
+  m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+  return SEGMENT_CACHE_PATH + name;
+}
+
+void CSegmentCache::Store(const std::string& key, int64_t index, const std::vector<char>& data)
+{
+  const std::string name = GetSegmentName(key, index);
+  const std::string path = SEGMENT_CACHE_PATH + name;
+  const std::string tempPath = path + ".tmp";
+
+  {
+    CSingleLock lock(m_critical);
+    Load();
+    if (m_segments.find(name) != m_segments.end())
+      return;
+  }
+
+  // write to a temporary file first so that readers never see a partial segment
+  CFile file;
+  if (!file.OpenForWrite(tempPath, true))
+  {
+    CLog::Log(LOGWARNING, "CSegmentCache::%s - unable to create %s", __FUNCTION__, tempPath.c_str());
+    return;
+  }
+  const bool written = file.Write(data.data(), data.size()) == static_cast<ssize_t>(data.size());
+  file.Close();
+  if (!written || !CFile::Rename(tempPath, path))
+  {
+    CFile::Delete(tempPath);
+    return;
+  }
+
+  const uint64_t maxSize = static_cast<uint64_t>(CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_cachePersistentSize) * 1024 * 1024;
+
+  std::vector<std::string> evicted;
+  {
+    CSingleLock lock(m_critical);
+    if (m_segments.find(name) == m_segments.end())
+    {
+      m_lru.push_front(name);
+      m_segments[name] = { static_cast<int64_t>(data.size()), m_lru.begin() };
+      m_size += data.size();
+    }
+    evicted = Evict(maxSize);
+  }
+
+  for (const auto& segment : evicted)
+    CFile::Delete(SEGMENT_CACHE_PATH + segment);
+}
+
+void CSegmentCache::Queue(const std::string& key, int64_t index, std::vector<char> data)
+{
+  {
+    CSingleLock lock(m_critical);
+    if (m_queued >= SEGMENT_CACHE_MAX_QUEUED)
+      return;
+    m_queued++;
+  }
+
+  CJobManager::GetInstance().AddJob(new CStoreJob(*this, key, index, std::move(data)), nullptr, CJob::PRIORITY_LOW);
+}
+
+void CSegmentCache::OnStored()
+{
+  CSingleLock lock(m_critical);
+  m_queued--;
+  m_stored.notifyAll();
+}
+
+void CSegmentCache::Flush()
+{
+  CSingleLock lock(m_critical);
+  while (m_queued > 0)
+    m_stored.wait(lock);
+}
+
+std::vector<std::string> CSegmentCache::Evict(uint64_t maxSize)
+{
+  std::vector<std::string> evicted;
+  while (m_size > maxSize && !m_lru.empty())
+  {
+    const std::string name = m_lru.back();
+    m_lru.pop_back();
+
+    auto it = m_segments.find(name);
+    m_size -= it->second.size;
+    m_segments.erase(it);
+    evicted.push_back(name);
+  }
+  return evicted;
+}
+
+void CSegmentCache::AddStatistics(uint64_t hitBytes, uint64_t missBytes)
+{
+  CSingleLock lock(m_critical);
+  m_hitBytes += hitBytes;
+  m_missBytes += missBytes;
+}
+
+CSegmentCache::Statistics CSegmentCache::GetStatistics()
+{
+  CSingleLock lock(m_critical);
+  Load();
+
+  Statistics statistics;
+  statistics.hitBytes = m_hitBytes;
+  statistics.missBytes = m_missBytes;
+  statistics.size = m_size;
+  statistics.segments = m_segments.size();
+  return statistics;
+}
+
+void CSegmentCache::Clear()
+{
+  Flush();
+
+  std::vector<std::string> evicted;
+  {
+    CSingleLock lock(m_critical);
+    Load();
+    evicted = Evict(0);
+  }
+
+  for (const auto& segment : evicted)
+    CFile::Delete(SEGMENT_CACHE_PATH + segment);
+}
+
+CSegmentCacheFile::CSegmentCacheFile(const CURL& url, int64_t length, int64_t mtime)
+  : m_key(CSegmentCache::GetKey(url, length, mtime))
+  , m_length(length)
+{
+}
+
+CSegmentCacheFile::~CSegmentCacheFile()
+{
+  m_segment.Close();
+
+  CSegmentCache& cache = CSegmentCache::GetInstance();
+  cache.AddStatistics(m_hitBytes, m_missBytes);
+
+  const CSegmentCache::Statistics statistics = cache.GetStatistics();
+  CLog::Log(LOGDEBUG, "CSegmentCacheFile - read %" PRIu64 " bytes from cache and %" PRIu64 " bytes from source, "
+            "overall hit ratio %.1f%% with %zu segments using %" PRIu64 " bytes",
+            m_hitBytes, m_missBytes, statistics.GetHitRatio() * 100.0, statistics.segments, statistics.size);
+}
+
+int64_t CSegmentCacheFile::GetSegmentLength(int64_t index) const
+{
+  return std::min(CSegmentCache::SEGMENT_SIZE, m_length - index * CSegmentCache::SEGMENT_SIZE);
+}
+
+bool CSegmentCacheFile::OpenSegment(int64_t index)
+{
+  if (index == m_segmentIndex)
+    return true;
+
+  m_segment.Close();
+  m_segmentIndex = -1;
+
+  const std::string path = CSegmentCache::GetInstance().Lookup(m_key, index);
+  if (path.empty() || !m_segment.Open(path, READ_NO_CACHE))
+    return false;
+
+  m_segmentIndex = index;
+  return true;
+}
+
+bool CSegmentCacheFile::IsCached(int64_t position)
+{
+  if (position < 0 || position >= m_length)
+    return false;
+
+  return OpenSegment(position / CSegmentCache::SEGMENT_SIZE);
+}
+
+ssize_t CSegmentCacheFile::Read(int64_t position, char* buffer, size_t size)
+{
+  if (!IsCached(position))
+    return 0;
+
+  const int64_t offset = position % CSegmentCache::SEGMENT_SIZE;
+  size = static_cast<size_t>(std::min<int64_t>(size, GetSegmentLength(m_segmentIndex) - offset));
+
+  ssize_t read = -1;
+  if (m_segment.Seek(offset, SEEK_SET) == offset)
+    read = m_segment.Read(buffer, size);
+
+  if (read <= 0)
+  {
+    // the segment was evicted or is damaged, fall back to the source
+    m_segment.Close();
+    m_segmentIndex = -1;
+    return 0;
+  }
+
+  m_hitBytes += read;
+  return read;
+}
+
+void CSegmentCacheFile::Write(int64_t position, const char* buffer, size_t size)
+{
+  m_missBytes += size;
+
+  while (size > 0 && position < m_length)
+  {
+    const int64_t index = position / CSegmentCache::SEGMENT_SIZE;
+    const int64_t offset = position % CSegmentCache::SEGMENT_SIZE;
+    const int64_t segmentLength = GetSegmentLength(index);
+    const size_t chunk = static_cast<size_t>(std::min<int64_t>(size, segmentLength - offset));
+
+    if (offset == 0)
+    {
+      m_pendingIndex = index;
+      m_pending.clear();
+      m_pending.reserve(segmentLength);
+    }
+
+    if (m_pendingIndex == index && static_cast<int64_t>(m_pending.size()) == offset)
+    {
+      m_pending.insert(m_pending.end(), buffer, buffer + chunk);
+      if (static_cast<int64_t>(m_pending.size()) == segmentLength)
+      {
+        CSegmentCache::GetInstance().Queue(m_key, index, std::move(m_pending));
+        m_pending = std::vector<char>();
+        m_pendingIndex = -1;
+      }
+    }
+    else
+    {
+      // not read from the start of the segment, it can't be stored
+      m_pending.clear();
+      m_pendingIndex = -1;
+    }
+
+    position += chunk;
+    buffer += chunk;
+    size -= chunk;
+  }
+}
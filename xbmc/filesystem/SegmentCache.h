@@ -0,0 +1,175 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#pragma once
+
+#include "File.h"
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class CURL;
+
+namespace XFILE
+{
+
+/*!
+ \brief Persistent, size bounded cache of the data read from network files.
+
+ Files are split into segments of SEGMENT_SIZE bytes. Every segment that was
+ read completely from the source is stored below special://temp/segmentcache/
+ under a digest of the file's URL (without credentials), length and
+ modification time plus the segment index, so the same content is found again
+ by every later session and a replaced file is never served from old
+ segments. Segments are written to disk by a job, not by the reading thread.
+ Once the cache grows beyond <cache><persistentsize> megabytes the least
+ recently used segments are removed.
+ */
+class CSegmentCache
+{
+public:
+  static constexpr int64_t SEGMENT_SIZE = 1024 * 1024;
+
+  struct Statistics
+  {
+    uint64_t hitBytes = 0;   ///< bytes served from the cache
+    uint64_t missBytes = 0;  ///< bytes read from the network
+    uint64_t size = 0;       ///< bytes currently stored
+    size_t segments = 0;     ///< number of segments currently stored
+
+    double GetHitRatio() const;
+  };
+
+  static CSegmentCache& GetInstance();
+
+  /*!
+   \brief Whether a cache size has been configured in advancedsettings.xml.
+   */
+  bool IsEnabled() const;
+
+  /*!
+   \brief Whether files of the given url are worth caching, i.e. come from the network.
+   */
+  static bool IsCacheable(const CURL& url);
+
+  /*!
+   \brief Gets the key identifying the content of a file.
+   \param mtime modification time of the file as reported by Stat()
+   */
+  static std::string GetKey(const CURL& url, int64_t length, int64_t mtime);
+
+  /*!
+   \brief Looks up a segment and marks it as recently used.
+   \return the path of the stored segment or an empty string if not cached
+   */
+  std::string Lookup(const std::string& key, int64_t index);
+
+  /*!
+   \brief Stores a complete segment and evicts old ones if needed.
+   */
+  void Store(const std::string& key, int64_t index, const std::vector<char>& data);
+
+  /*!
+   \brief Stores a complete segment in the background. The segment is dropped
+   if too many segments are waiting to be written already.
+   */
+  void Queue(const std::string& key, int64_t index, std::vector<char> data);
+
+  /*!
+   \brief Waits until all queued segments are stored.
+   */
+  void Flush();
+
+  void AddStatistics(uint64_t hitBytes, uint64_t missBytes);
+  Statistics GetStatistics();
+
+  /*!
+   \brief Removes all stored segments.
+   */
+  void Clear();
+
+private:
+  class CStoreJob;
+
+  CSegmentCache() = default;
+  CSegmentCache(const CSegmentCache&) = delete;
+  CSegmentCache& operator=(const CSegmentCache&) = delete;
+
+  struct Segment
+  {
+    int64_t size;
+    std::list<std::string>::iterator lru;
+  };
+
+  static std::string GetSegmentName(const std::string& key, int64_t index);
+  void Load();
+  std::vector<std::string> Evict(uint64_t maxSize);
+  void OnStored();
+
+  bool m_loaded = false;
+  uint64_t m_size = 0;
+  uint64_t m_hitBytes = 0;
+  uint64_t m_missBytes = 0;
+  std::list<std::string> m_lru; // most recently used first
+  std::unordered_map<std::string, Segment> m_segments;
+  unsigned int m_queued = 0; // segments waiting for a job to store them
+  CCriticalSection m_critical;
+  XbmcThreads::ConditionVariable m_stored;
+};
+
+/*!
+ \brief Reads and fills the segment cache for a single open file.
+
+ Data written through Write() is expected to arrive in file order as read
+ from the source. Only segments that were read from their first to their
+ last byte are stored, partial segments after a seek are dropped.
+ */
+class CSegmentCacheFile
+{
+public:
+  CSegmentCacheFile(const CURL& url, int64_t length, int64_t mtime);
+  ~CSegmentCacheFile();
+
+  /*!
+   \brief Whether the data at the given position is available from the cache.
+   */
+  bool IsCached(int64_t position);
+
+  /*!
+   \brief Reads cached data, never crossing a segment boundary.
+   \return the number of bytes read, 0 if the position is not cached
+   */
+  ssize_t Read(int64_t position, char* buffer, size_t size);
+
+  /*!
+   \brief Passes data read from the source at the given position to the cache.
+   */
+  void Write(int64_t position, const char* buffer, size_t size);
+
+private:
+  bool OpenSegment(int64_t index);
+  int64_t GetSegmentLength(int64_t index) const;
+
+  std::string m_key;
+  int64_t m_length;
+
+  CFile m_segment;
+  int64_t m_segmentIndex = -1;
+
+  std::vector<char> m_pending;
+  int64_t m_pendingIndex = -1;
+
+  uint64_t m_hitBytes = 0;
+  uint64_t m_missBytes = 0;
+};
+
+}
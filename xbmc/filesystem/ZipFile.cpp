@@ -12,10 +12,15 @@
 #include "utils/auto_buffer.h"
 #include "utils/log.h"
 
+#include <algorithm>
+#include <limits.h>
 #include <sys/stat.h>
 
 #define ZIP_CACHE_LIMIT 4*1024*1024
 
+// largest entry that is read from a mapping of the zip file
+#define ZIP_MAP_LIMIT 64*1024*1024
+
 using namespace XFILE;
 
 CZipFile::CZipFile()
@@ -72,6 +77,17 @@ bool CZipFile::Open(const CURL&url)
     return false;
   }
   mFile.Seek(mZipItem.offset,SEEK_SET);
+
+  // zip files installed with Kodi are read from memory, saving the copy into m_szBuffer.
+  // Others, like downloaded add-on packages, may be rewritten while mapped.
+  if (mZipItem.csize > 0 && mZipItem.csize <= ZIP_MAP_LIMIT && URIUtils::IsInstallPath(url.GetHostName()))
+  {
+    m_view = SMappedView();
+    m_view.offset = mZipItem.offset;
+    m_view.size = mZipItem.csize;
+    if (mFile.IoControl(IOCTRL_MAP_VIEW, &m_view) != 0 || m_view.size != mZipItem.csize)
+      m_view = SMappedView();
+  }
   return InitDecompress();
 }
 
@@ -339,6 +355,14 @@ ssize_t CZipFile::Read(void* lpBuf, size_t uiBufSize)
     if (uiBufSize == 0)
       return 0; // we are past eof, this shouldn't happen but test anyway
 
+    if (m_view.data)
+    {
+      memcpy(lpBuf, m_view.data + m_iZipFilePos, uiBufSize);
+      m_iZipFilePos += uiBufSize;
+      m_iFilePos += uiBufSize;
+      return uiBufSize;
+    }
+
     ssize_t iResult = mFile.Read(lpBuf,uiBufSize);
     if (iResult < 0)
       return -1;
@@ -354,12 +378,27 @@ void CZipFile::Close()
 {
   if (mZipItem.method == 8 && !m_bCached && m_iRead != -1)
     inflateEnd(&m_ZStream);
+  m_view = SMappedView();
 
   mFile.Close();
 }
 
 bool CZipFile::FillBuffer()
 {
+  if (m_view.data)
+  {
+    // inflate straight from the mapped zip file
+    const int64_t left = mZipItem.csize - m_iZipFilePos;
+    if (left <= 0)
+      return false; // eof!
+
+    const uInt size = static_cast<uInt>(std::min<int64_t>(left, UINT_MAX));
+    m_ZStream.avail_in = size;
+    m_ZStream.next_in = const_cast<Bytef*>(m_view.data + m_iZipFilePos);
+    m_iZipFilePos += size;
+    return true;
+  }
+
   ssize_t sToRead = 65535;
   if (m_iZipFilePos+65535 > mZipItem.csize)
     sToRead = mZipItem.csize-m_iZipFilePos;
@@ -55,6 +55,7 @@ namespace XFILE
     int m_iRead;
     bool m_bFlush = false;
     bool m_bCached;
+    SMappedView m_view; // the entry's compressed data if the zip file could be mapped
   };
 }
 
@@ -9,28 +9,60 @@
 #include "ZipManager.h"
 
 #include <algorithm>
+#include <atomic>
+#include <set>
+#include <string.h>
 #include <utility>
 
+#include "Directory.h"
 #include "File.h"
 #include "URL.h"
+#include "Util.h"
 #if defined(TARGET_POSIX)
 #include "platform/linux/PlatformDefs.h"
 #endif
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
 #include "utils/CharsetConverter.h"
+#include "utils/CPUInfo.h"
+#include "utils/Crc32.h"
 #include "utils/EndianSwap.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 #include "utils/RegExp.h"
+#include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
 
 using namespace XFILE;
 
 static const size_t ZC_FLAG_EFS = 1 << 11; // general purpose bit 11 - zip holds utf-8 filenames
 
+// archives with fewer entries are cheap to parse, they don't get an index
+static const size_t ZIP_INDEX_MIN_ENTRIES = 128;
+static const uint32_t ZIP_INDEX_MAGIC = 0x3158495a; // "ZIX1"
+static const uint32_t ZIP_INDEX_VERSION = 2;
+static const size_t ZIP_INDEX_ENTRY_MIN_SIZE = 50; // fields of an entry with an empty name
+static const char* ZIP_INDEX_FOLDER = "special://temp/zipindex/";
+
+// files are only extracted in parallel if there are enough of them
+static const size_t ZIP_EXTRACT_MAX_WORKERS = 4;
+static const size_t ZIP_EXTRACT_FILES_PER_WORKER = 8;
+
 CZipManager::CZipManager() = default;
 
 CZipManager::~CZipManager() = default;
 
 bool CZipManager::GetZipList(const CURL& url, std::vector<SZipEntry>& items)
+{
+  std::shared_ptr<const CZipList> list = GetList(url);
+  if (!list)
+    return false;
+
+  items = list->items;
+  return true;
+}
+
+std::shared_ptr<const CZipManager::CZipList> CZipManager::GetList(const CURL& url)
 {
   struct __stat64 m_StatData = {};
 
@@ -39,23 +71,45 @@ bool CZipManager::GetZipList(const CURL& url, std::vector<SZipEntry>& items)
   if (CFile::Stat(strFile,&m_StatData))
   {
     CLog::Log(LOGDEBUG,"CZipManager::GetZipList: failed to stat file %s", url.GetRedacted().c_str());
-    return false;
+    return nullptr;
   }
 
-  std::map<std::string, std::vector<SZipEntry> >::iterator it = mZipMap.find(strFile);
-  if (it != mZipMap.end()) // already listed, just return it if not changed, else release and reread
   {
-    std::map<std::string,int64_t>::iterator it2=mZipDate.find(strFile);
-
-    if (m_StatData.st_mtime == it2->second)
+    CSingleLock lock(m_critSection);
+    auto it = mZipMap.find(strFile);
+    if (it != mZipMap.end()) // already listed, just return it if not changed, else release and reread
     {
-      items = it->second;
-      return true;
+      if (it->second->mtime == m_StatData.st_mtime && it->second->size == m_StatData.st_size)
+        return it->second;
+      mZipMap.erase(it);
     }
-    mZipMap.erase(it);
-    mZipDate.erase(it2);
   }
 
+  // the archive is parsed without holding the lock, files of other archives
+  // can be opened in the meantime
+  auto list = std::make_shared<CZipList>();
+  list->mtime = m_StatData.st_mtime;
+  list->size = m_StatData.st_size;
+
+  if (!LoadIndex(strFile, *list))
+  {
+    if (!ReadCentralDirectory(strFile, list->items))
+      return nullptr;
+    if (list->items.size() >= ZIP_INDEX_MIN_ENTRIES)
+      SaveIndex(strFile, *list);
+  }
+
+  // the first entry of a name wins, like the linear search used to
+  for (size_t i = 0; i < list->items.size(); ++i)
+    list->index.emplace(list->items[i].name, i);
+
+  CSingleLock lock(m_critSection);
+  mZipMap[strFile] = list;
+  return list;
+}
+
+bool CZipManager::ReadCentralDirectory(const std::string& strFile, std::vector<SZipEntry>& items)
+{
   CFile mFile;
   if (!mFile.Open(strFile))
   {
@@ -76,10 +130,6 @@ bool CZipManager::GetZipList(const CURL& url, std::vector<SZipEntry>& items)
   if (Endian_SwapLE32(hdr) == ZIP_SPLIT_ARCHIVE_HEADER)
     CLog::LogF(LOGWARNING, "ZIP split archive header found. Trying to process as a single archive..");
 
-  // push date for update detection
-  mZipDate.insert(make_pair(strFile,m_StatData.st_mtime));
-
-
   // Look for end of central directory record
   // Zipfile comment may be up to 65535 bytes
   // End of central directory record is 22 bytes (ECDREC_SIZE)
@@ -213,7 +263,6 @@ bool CZipManager::GetZipList(const CURL& url, std::vector<SZipEntry>& items)
 
   }
 
-  mZipMap.insert(make_pair(strFile,items));
   mFile.Close();
   return true;
 }
@@ -222,27 +271,24 @@ bool CZipManager::GetZipEntry(const CURL& url, SZipEntry& item)
 {
   std::string strFile = url.GetHostName();
 
-  std::map<std::string, std::vector<SZipEntry> >::iterator it = mZipMap.find(strFile);
-  std::vector<SZipEntry> items;
-  if (it == mZipMap.end()) // we need to list the zip
+  std::shared_ptr<const CZipList> list;
   {
-    GetZipList(url,items);
-  }
-  else
-  {
-    items = it->second;
+    CSingleLock lock(m_critSection);
+    auto it = mZipMap.find(strFile);
+    if (it != mZipMap.end())
+      list = it->second;
   }
+  if (!list) // we need to list the zip
+    list = GetList(url);
+  if (!list)
+    return false;
 
-  std::string strFileName = url.GetFileName();
-  for (std::vector<SZipEntry>::iterator it2=items.begin();it2 != items.end();++it2)
-  {
-    if (std::string(it2->name) == strFileName)
-    {
-      item = *it2;
-      return true;
-    }
-  }
-  return false;
+  auto it = list->index.find(url.GetFileName());
+  if (it == list->index.end())
+    return false;
+
+  item = list->items[it->second];
+  return true;
 }
 
 bool CZipManager::ExtractArchive(const std::string& strArchive, const std::string& strPath)
@@ -253,23 +299,300 @@ bool CZipManager::ExtractArchive(const std::string& strArchive, const std::strin
 
 bool CZipManager::ExtractArchive(const CURL& archive, const std::string& strPath)
 {
-  std::vector<SZipEntry> entry;
+  return ExtractArchive(archive, strPath, "");
+}
+
+bool CZipManager::ExtractArchive(const CURL& archive, const std::string& strPath, const std::string& strRoot)
+{
   CURL url = URIUtils::CreateArchivePath("zip", archive);
-  GetZipList(url, entry);
-  for (std::vector<SZipEntry>::iterator it=entry.begin();it != entry.end();++it)
+  std::shared_ptr<const CZipList> list = GetList(url);
+  if (!list)
+    return false;
+
+  std::vector<std::string> files;
+  std::set<std::string> folders;
+  for (const SZipEntry& entry : list->items)
   {
-    if (it->name[strlen(it->name)-1] == '/') // skip dirs
+    std::string strFilePath(entry.name);
+    if (!StringUtils::StartsWith(strFilePath, strRoot) || strFilePath.size() == strRoot.size())
+      continue;
+
+    const std::string strRelative = strFilePath.substr(strRoot.size());
+    if (URIUtils::HasSlashAtEnd(strRelative)) // dirs are created up front
+    {
+      folders.insert(strRelative);
       continue;
-    std::string strFilePath(it->name);
+    }
+    const std::string strFolder = URIUtils::GetDirectory(strRelative);
+    if (!strFolder.empty())
+      folders.insert(strFolder);
+    files.push_back(strFilePath);
+  }
+
+  // create the folders first, so the files can be extracted in any order
+  if (!files.empty())
+    folders.insert("");
+  for (const std::string& strFolder : folders)
+  {
+    if (!CUtil::CreateDirectoryEx(strPath + strFolder))
+    {
+      CLog::Log(LOGERROR, "ZipManager: unable to create folder %s", CURL::GetRedacted(strPath + strFolder).c_str());
+      return false;
+    }
+  }
+
+  std::atomic<size_t> next(0);
+  std::atomic<bool> failed(false);
+  auto extract = [&]()
+  {
+    for (size_t i = next++; i < files.size() && !failed; i = next++)
+    {
+      CURL zipPath = URIUtils::CreateArchivePath("zip", archive, files[i]);
+      const CURL pathToUrl(strPath + files[i].substr(strRoot.size()));
+      if (!CFile::Copy(zipPath, pathToUrl))
+      {
+        CLog::Log(LOGERROR, "ZipManager: unable to extract %s", files[i].c_str());
+        failed = true;
+      }
+    }
+  };
+
+  // every worker inflates with its own file handle, the work is mostly cpu bound
+  const size_t workers = std::min<size_t>({ static_cast<size_t>(std::max(g_cpuInfo.getCPUCount(), 1)),
+                                            ZIP_EXTRACT_MAX_WORKERS,
+                                            files.size() / ZIP_EXTRACT_FILES_PER_WORKER });
+  if (workers < 2)
+  {
+    extract();
+    return !failed;
+  }
+
+  CEvent done;
+  std::atomic<size_t> running(workers);
+  CJobQueue queue(false, workers, CJob::PRIORITY_DEDICATED);
+  for (size_t i = 0; i < workers; ++i)
+  {
+    queue.Submit([&]()
+    {
+      extract();
+      if (--running == 0)
+        done.Set();
+    });
+  }
+  done.Wait();
+
+  return !failed;
+}
+
+std::string CZipManager::GetIndexPath(const std::string& strFile)
+{
+  return StringUtils::Format("%s%08x.idx", ZIP_INDEX_FOLDER, Crc32::Compute(strFile));
+}
 
-    CURL zipPath = URIUtils::CreateArchivePath("zip", archive, strFilePath);
-    const CURL pathToUrl(strPath + strFilePath);
-    if (!CFile::Copy(zipPath, pathToUrl))
+namespace
+{
+
+/*!
+ \brief Appends the fields of an index in little endian order, like the
+ archive itself stores them.
+ */
+class CZipIndexWriter
+{
+public:
+  void Put16(uint16_t value)
+  {
+    value = Endian_SwapLE16(value);
+    m_buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+  void Put32(uint32_t value)
+  {
+    value = Endian_SwapLE32(value);
+    m_buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+  void Put64(uint64_t value)
+  {
+    value = Endian_SwapLE64(value);
+    m_buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+  void PutString(const char* value, size_t length)
+  {
+    Put32(length);
+    m_buffer.append(value, length);
+  }
+
+  std::string m_buffer;
+};
+
+/*!
+ \brief Reads the fields written by CZipIndexWriter, false once the data ends.
+ */
+class CZipIndexReader
+{
+public:
+  CZipIndexReader(const char* data, size_t size) : m_pos(data), m_end(data + size) {}
+
+  bool Get16(unsigned short& value)
+  {
+    uint16_t field;
+    if (!Get(&field, sizeof(field)))
+      return false;
+    value = Endian_SwapLE16(field);
+    return true;
+  }
+  bool Get32(unsigned int& value)
+  {
+    uint32_t field;
+    if (!Get(&field, sizeof(field)))
+      return false;
+    value = Endian_SwapLE32(field);
+    return true;
+  }
+  bool Get64(int64_t& value)
+  {
+    uint64_t field;
+    if (!Get(&field, sizeof(field)))
       return false;
+    value = static_cast<int64_t>(Endian_SwapLE64(field));
+    return true;
+  }
+  bool GetString(std::string& value)
+  {
+    unsigned int length = 0;
+    if (!Get32(length) || static_cast<size_t>(m_end - m_pos) < length)
+      return false;
+    value.assign(m_pos, length);
+    m_pos += length;
+    return true;
+  }
+  bool AtEnd() const { return m_pos == m_end; }
+
+private:
+  bool Get(void* value, size_t size)
+  {
+    if (static_cast<size_t>(m_end - m_pos) < size)
+      return false;
+    memcpy(value, m_pos, size);
+    m_pos += size;
+    return true;
+  }
+
+  const char* m_pos;
+  const char* m_end;
+};
+
+} // namespace
+
+bool CZipManager::LoadIndex(const std::string& strFile, CZipList& list)
+{
+  const std::string strIndex = GetIndexPath(strFile);
+  if (!CFile::Exists(strIndex))
+    return false;
+
+  CFile file;
+  auto_buffer buffer;
+  if (file.LoadFile(strIndex, buffer) <= 0)
+    return false;
+
+  CZipIndexReader reader(buffer.get(), buffer.size());
+  unsigned int magic = 0, version = 0, count = 0;
+  int64_t mtime = 0, size = 0;
+  std::string path;
+  if (!reader.Get32(magic) || magic != ZIP_INDEX_MAGIC ||
+      !reader.Get32(version) || version != ZIP_INDEX_VERSION ||
+      !reader.Get64(mtime) || !reader.Get64(size) ||
+      !reader.GetString(path) || path != strFile)
+    return false;
+
+  // the archive changed since the index was written
+  if (mtime != list.mtime || size != list.size)
+    return false;
+
+  bool valid = reader.Get32(count);
+  list.items.clear();
+  if (valid)
+    list.items.reserve(std::min<size_t>(count, buffer.size() / ZIP_INDEX_ENTRY_MIN_SIZE));
+  std::string name;
+  for (unsigned int i = 0; valid && i < count; ++i)
+  {
+    SZipEntry entry;
+    valid = reader.Get32(entry.header) && reader.Get16(entry.version) &&
+            reader.Get16(entry.flags) && reader.Get16(entry.method) &&
+            reader.Get16(entry.mod_time) && reader.Get16(entry.mod_date) &&
+            reader.Get32(entry.crc32) && reader.Get32(entry.csize) &&
+            reader.Get32(entry.usize) && reader.Get16(entry.flength) &&
+            reader.Get16(entry.elength) && reader.Get16(entry.eclength) &&
+            reader.Get16(entry.clength) && reader.Get32(entry.lhdrOffset) &&
+            reader.Get64(entry.offset) && reader.GetString(name) &&
+            name.size() < sizeof(entry.name);
+    if (!valid)
+      break;
+    memcpy(entry.name, name.c_str(), name.size() + 1);
+    list.items.push_back(entry);
+  }
+
+  if (!valid || !reader.AtEnd())
+  {
+    CLog::Log(LOGWARNING, "ZipManager: ignoring broken index %s", strIndex.c_str());
+    list.items.clear();
+    return false;
   }
+
+  CLog::Log(LOGDEBUG, "ZipManager: loaded %u entries of %s from index", count, CURL::GetRedacted(strFile).c_str());
   return true;
 }
 
+void CZipManager::SaveIndex(const std::string& strFile, const CZipList& list)
+{
+  // the entries are stored field by field, changes of SZipEntry need a new
+  // ZIP_INDEX_VERSION
+  CZipIndexWriter writer;
+  writer.m_buffer.reserve(32 + strFile.size() + list.items.size() * (ZIP_INDEX_ENTRY_MIN_SIZE + 32));
+  writer.Put32(ZIP_INDEX_MAGIC);
+  writer.Put32(ZIP_INDEX_VERSION);
+  writer.Put64(list.mtime);
+  writer.Put64(list.size);
+  writer.PutString(strFile.data(), strFile.size());
+  writer.Put32(list.items.size());
+  for (const SZipEntry& entry : list.items)
+  {
+    writer.Put32(entry.header);
+    writer.Put16(entry.version);
+    writer.Put16(entry.flags);
+    writer.Put16(entry.method);
+    writer.Put16(entry.mod_time);
+    writer.Put16(entry.mod_date);
+    writer.Put32(entry.crc32);
+    writer.Put32(entry.csize);
+    writer.Put32(entry.usize);
+    writer.Put16(entry.flength);
+    writer.Put16(entry.elength);
+    writer.Put16(entry.eclength);
+    writer.Put16(entry.clength);
+    writer.Put32(entry.lhdrOffset);
+    writer.Put64(entry.offset);
+    writer.PutString(entry.name, strnlen(entry.name, sizeof(entry.name)));
+  }
+  const std::string& buffer = writer.m_buffer;
+
+  if (!CDirectory::Exists(ZIP_INDEX_FOLDER) && !CDirectory::Create(ZIP_INDEX_FOLDER))
+    return;
+
+  // written under a temporary name, an index is either complete or missing
+  const std::string strIndex = GetIndexPath(strFile);
+  const std::string strTemp = strIndex + "." + StringUtils::CreateUUID();
+  CFile file;
+  if (!file.OpenForWrite(strTemp, true))
+    return;
+  const bool written = file.Write(buffer.data(), buffer.size()) == static_cast<ssize_t>(buffer.size());
+  file.Close();
+
+  if (!written || (CFile::Exists(strIndex) && !CFile::Delete(strIndex)) || !CFile::Rename(strTemp, strIndex))
+  {
+    CLog::Log(LOGWARNING, "ZipManager: unable to write index %s", strIndex.c_str());
+    CFile::Delete(strTemp);
+  }
+}
+
 // Read local file header
 void CZipManager::readHeader(const char* buffer, SZipEntry& info)
 {
@@ -310,13 +633,6 @@ void CZipManager::readCHeader(const char* buffer, SZipEntry& info)
 void CZipManager::release(const std::string& strPath)
 {
   CURL url(strPath);
-  std::map<std::string, std::vector<SZipEntry> >::iterator it= mZipMap.find(url.GetHostName());
-  if (it != mZipMap.end())
-  {
-    std::map<std::string,int64_t>::iterator it2=mZipDate.find(url.GetHostName());
-    mZipMap.erase(it);
-    mZipDate.erase(it2);
-  }
+  CSingleLock lock(m_critSection);
+  mZipMap.erase(url.GetHostName());
 }
-
-
@@ -19,9 +19,13 @@
 #define CHDR_SIZE 46
 #define ECDREC_SIZE 22
 
+#include "threads/CriticalSection.h"
+
+#include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
-#include <map>
 
 class CURL;
 
@@ -61,12 +65,45 @@ public:
   bool GetZipEntry(const CURL& url, SZipEntry& item);
   bool ExtractArchive(const std::string& strArchive, const std::string& strPath);
   bool ExtractArchive(const CURL& archive, const std::string& strPath);
+
+  /*!
+   \brief Extracts the files below a folder of an archive, several files at once.
+   \param archive the zip file
+   \param strPath destination folder, with a trailing slash
+   \param strRoot folder in the archive to extract, with a trailing slash, empty for all files
+   \return true if all files were extracted
+   */
+  bool ExtractArchive(const CURL& archive, const std::string& strPath, const std::string& strRoot);
+
   void release(const std::string& strPath); // release resources used by list zip
   static void readHeader(const char* buffer, SZipEntry& info);
   static void readCHeader(const char* buffer, SZipEntry& info);
+
+  /*!
+   \brief The central directories of large archives are kept in special://temp/zipindex/
+   and reused as long as modification time and size of the archive don't change.
+   \param strFile path of the archive
+   \return path of its index, which may not exist
+   */
+  static std::string GetIndexPath(const std::string& strFile);
+
 private:
-  std::map<std::string,std::vector<SZipEntry> > mZipMap;
-  std::map<std::string,int64_t> mZipDate;
+  struct CZipList
+  {
+    int64_t mtime = 0;
+    int64_t size = 0;
+    std::vector<SZipEntry> items;
+    std::unordered_map<std::string, size_t> index; ///< entry name -> position in items
+  };
+
+  std::shared_ptr<const CZipList> GetList(const CURL& url);
+  static bool ReadCentralDirectory(const std::string& strFile, std::vector<SZipEntry>& items);
+
+  static bool LoadIndex(const std::string& strFile, CZipList& list);
+  static void SaveIndex(const std::string& strFile, const CZipList& list);
+
+  CCriticalSection m_critSection;
+  std::map<std::string, std::shared_ptr<const CZipList>> mZipMap;
 };
 
 extern CZipManager g_ZipManager;
@@ -0,0 +1,270 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "filesystem/CircularCache.h"
+#include "threads/IRunnable.h"
+#include "threads/SingleLock.h"
+#include "threads/Thread.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace XFILE;
+
+namespace
+{
+
+const size_t CHUNK_SIZE = 16 * 1024;
+
+uint8_t PatternByte(int64_t pos)
+{
+  return static_cast<uint8_t>((pos * 31) ^ (pos >> 11));
+}
+
+/*!
+ \brief Feeds a known pattern into the cache like the thread of CFileCache does.
+ */
+class CPatternWriter : public IRunnable
+{
+public:
+  CPatternWriter(CCacheStrategy& cache, int64_t length) : m_cache(cache), m_length(length) {}
+
+  void Run() override
+  {
+    std::vector<char> buffer(CHUNK_SIZE);
+    int64_t pos = 0;
+    while (pos < m_length)
+    {
+      const size_t size = m_cache.GetMaxWriteSize(std::min<int64_t>(CHUNK_SIZE, m_length - pos));
+      if (size == 0)
+      {
+        m_cache.m_space.WaitMSec(5);
+        continue;
+      }
+
+      for (size_t i = 0; i < size; i++)
+        buffer[i] = PatternByte(pos + i);
+
+      size_t written = 0;
+      while (written < size)
+      {
+        const int ret = m_cache.WriteToCache(buffer.data() + written, size - written);
+        if (ret <= 0)
+          m_cache.m_space.WaitMSec(5);
+        else
+          written += ret;
+      }
+      pos += size;
+    }
+    m_cache.EndOfInput();
+  }
+
+private:
+  CCacheStrategy& m_cache;
+  int64_t m_length;
+};
+
+/*!
+ \brief Reads the whole stream, returns the number of bytes read or -1 on wrong data.
+ \param seekBack seek back by this many bytes every few megabytes, 0 to read straight through
+ */
+int64_t ReadPattern(CCacheStrategy& cache, size_t readSize, int64_t seekBack)
+{
+  std::vector<char> buffer(readSize);
+  int64_t pos = 0;
+  int64_t nextSeek = 4 * 1024 * 1024;
+  while (true)
+  {
+    const int ret = cache.ReadFromCache(buffer.data(), buffer.size());
+    if (ret == 0)
+      return pos;
+    if (ret == CACHE_RC_WOULD_BLOCK)
+    {
+      cache.WaitForData(1, 1000);
+      continue;
+    }
+    if (ret < 0)
+      return -1;
+
+    for (int i = 0; i < ret; i++)
+    {
+      if (static_cast<uint8_t>(buffer[i]) != PatternByte(pos + i))
+        return -1;
+    }
+    pos += ret;
+
+    if (seekBack > 0 && pos >= nextSeek)
+    {
+      // the guaranteed back buffer can't be overwritten by the writer
+      pos -= seekBack;
+      if (cache.Seek(pos) != pos)
+        return -1;
+      nextSeek += 4 * 1024 * 1024;
+    }
+  }
+}
+
+/*!
+ \brief Locks every call and signals every chunk, like CCircularCache used to.
+ */
+class CLockedCircularCache : public CCircularCache
+{
+public:
+  CLockedCircularCache(size_t front, size_t back) : CCircularCache(front, back) {}
+
+  size_t GetMaxWriteSize(const size_t& iRequestSize) override
+  {
+    CSingleLock lock(m_sync);
+    return CCircularCache::GetMaxWriteSize(iRequestSize);
+  }
+
+  int WriteToCache(const char* buf, size_t len) override
+  {
+    CSingleLock lock(m_sync);
+    const int ret = CCircularCache::WriteToCache(buf, len);
+    m_written.Set();
+    return ret;
+  }
+
+  int ReadFromCache(char* buf, size_t len) override
+  {
+    CSingleLock lock(m_sync);
+    const int ret = CCircularCache::ReadFromCache(buf, len);
+    m_space.Set();
+    return ret;
+  }
+
+private:
+  CCriticalSection m_sync;
+};
+
+double MeasureThroughput(CCacheStrategy& cache, int64_t length)
+{
+  EXPECT_EQ(CACHE_RC_OK, cache.Open());
+
+  CPatternWriter writer(cache, length);
+  CThread thread(&writer, "CacheWriter");
+
+  const auto start = std::chrono::steady_clock::now();
+  thread.Create();
+  EXPECT_EQ(length, ReadPattern(cache, 32 * 1024, 0));
+  thread.StopThread();
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  cache.Close();
+  return length / elapsed.count() / (1024 * 1024);
+}
+
+} // unnamed namespace
+
+TEST(TestCircularCache, ReadWrite)
+{
+  const int64_t length = 32 * 1024 * 1024 + 123;
+
+  CCircularCache cache(1024 * 1024, 256 * 1024);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  CPatternWriter writer(cache, length);
+  CThread thread(&writer, "CacheWriter");
+  thread.Create();
+
+  // the reader moves back and forth while the writer overwrites the oldest data
+  EXPECT_EQ(length, ReadPattern(cache, 10000, 200 * 1024));
+
+  thread.StopThread();
+  EXPECT_TRUE(cache.IsEndOfInput());
+  EXPECT_EQ(length, cache.CachedDataEndPos());
+  EXPECT_EQ(0, cache.WaitForData(0, 0));
+  cache.Close();
+}
+
+TEST(TestCircularCache, Seek)
+{
+  CCircularCache cache(1024, 1024);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  std::vector<char> buffer(2048);
+  for (size_t i = 0; i < buffer.size(); i++)
+    buffer[i] = PatternByte(i);
+
+  EXPECT_EQ(2048, cache.WriteToCache(buffer.data(), buffer.size()));
+  EXPECT_EQ(0u, cache.GetMaxWriteSize(1024));
+  EXPECT_EQ(1536, cache.ReadFromCache(buffer.data(), 1536));
+  EXPECT_EQ(512u, cache.GetMaxWriteSize(1024));
+
+  EXPECT_EQ(100, cache.Seek(100));
+  EXPECT_EQ(1024, cache.Seek(1024));
+  EXPECT_EQ(0, cache.Seek(0));
+  EXPECT_EQ(CACHE_RC_ERROR, cache.Seek(200000));
+
+  // the data at the read position isn't overwritten
+  EXPECT_EQ(0, cache.WriteToCache(buffer.data(), 512));
+  EXPECT_EQ(1536, cache.Seek(1536));
+  EXPECT_EQ(512, cache.WriteToCache(buffer.data(), 512));
+  EXPECT_EQ(CACHE_RC_ERROR, cache.Seek(0));
+  EXPECT_TRUE(cache.IsCachedPosition(512));
+  EXPECT_FALSE(cache.IsCachedPosition(511));
+  EXPECT_FALSE(cache.IsCachedPosition(2561));
+
+  EXPECT_TRUE(cache.Reset(5000));
+  EXPECT_FALSE(cache.IsCachedPosition(0));
+  EXPECT_EQ(5000, cache.CachedDataEndPos());
+  cache.Close();
+}
+
+TEST(TestCircularCache, Resize)
+{
+  CCircularCache cache(1024, 1024);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  std::vector<char> buffer(2048);
+  for (size_t i = 0; i < buffer.size(); i++)
+    buffer[i] = PatternByte(i);
+
+  EXPECT_EQ(2048, cache.WriteToCache(buffer.data(), buffer.size()));
+  EXPECT_EQ(1536, cache.ReadFromCache(buffer.data(), 1536));
+
+  // unread data is kept
+  EXPECT_FALSE(cache.Resize(256, 256));
+
+  // history is dropped as far as needed
+  ASSERT_TRUE(cache.Resize(512, 512));
+  EXPECT_FALSE(cache.IsCachedPosition(1023));
+  EXPECT_TRUE(cache.IsCachedPosition(1024));
+  EXPECT_EQ(1024, cache.Seek(1024));
+  EXPECT_EQ(1024, cache.ReadFromCache(buffer.data(), buffer.size()));
+  for (int i = 0; i < 1024; i++)
+    EXPECT_EQ(PatternByte(1024 + i), static_cast<uint8_t>(buffer[i]));
+
+  ASSERT_TRUE(cache.Resize(4096, 1024));
+  EXPECT_EQ(1536, cache.Seek(1536));
+  EXPECT_EQ(4096u, cache.GetMaxWriteSize(8192));
+  cache.Close();
+}
+
+/*!
+ Compares the throughput with the previous implementation, which locked every
+ call and signalled every chunk. Run it with --gtest_also_run_disabled_tests
+ --gtest_filter=TestCircularCache.*
+ */
+TEST(TestCircularCache, DISABLED_Throughput)
+{
+  const int64_t length = 1024 * 1024 * 1024;
+
+  CLockedCircularCache locked(4 * 1024 * 1024, 1024 * 1024);
+  const double lockedRate = MeasureThroughput(locked, length);
+
+  CCircularCache lockFree(4 * 1024 * 1024, 1024 * 1024);
+  const double lockFreeRate = MeasureThroughput(lockFree, length);
+
+  std::cout << "locked: " << lockedRate << " MiB/s, lock-free: " << lockFreeRate << " MiB/s" << std::endl;
+}
@@ -0,0 +1,135 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "FileItem.h"
+#include "filesystem/DirectoryCache.h"
+#include "utils/StringUtils.h"
+
+#include "gtest/gtest.h"
+
+using namespace XFILE;
+
+namespace
+{
+
+void FillDirectory(CFileItemList& items, const std::string& path, int count)
+{
+  items.SetPath(path);
+  for (int i = 0; i < count; i++)
+    items.Add(std::make_shared<CFileItem>(StringUtils::Format("%sfile%d.mkv", path.c_str(), i), false));
+}
+
+} // unnamed namespace
+
+TEST(TestDirectoryCache, GetDirectory)
+{
+  CDirectoryCache cache;
+  CFileItemList items;
+  FillDirectory(items, "smb://server/share/movies/", 10);
+
+  cache.SetDirectory("smb://server/share/movies/", items, DIR_CACHE_ALWAYS);
+
+  // the cached items are a copy, changing the original doesn't affect the cache
+  items[0]->SetPath("smb://server/share/movies/changed.mkv");
+
+  CFileItemList cached;
+  EXPECT_TRUE(cache.GetDirectory("smb://server/share/movies", cached));
+  ASSERT_EQ(10, cached.Size());
+  EXPECT_EQ("smb://server/share/movies/file0.mkv", cached[0]->GetPath());
+
+  bool inCache = false;
+  EXPECT_TRUE(cache.FileExists("smb://server/share/movies/file3.mkv", inCache));
+  EXPECT_TRUE(inCache);
+  EXPECT_FALSE(cache.FileExists("smb://server/share/movies/missing.mkv", inCache));
+  EXPECT_TRUE(inCache);
+
+  cache.AddFile("smb://server/share/movies/missing.mkv");
+  EXPECT_TRUE(cache.FileExists("smb://server/share/movies/missing.mkv", inCache));
+  EXPECT_EQ(10, cached.Size());
+
+  CFileItemList missing;
+  EXPECT_FALSE(cache.GetDirectory("smb://server/share/tvshows/", missing));
+
+  const CDirectoryCache::Statistics statistics = cache.GetStatistics();
+  EXPECT_EQ(4u, statistics.hits);
+  EXPECT_EQ(1u, statistics.misses);
+  EXPECT_EQ(1u, statistics.directories);
+  EXPECT_EQ(11u, statistics.items);
+}
+
+TEST(TestDirectoryCache, SizeLimit)
+{
+  CFileItemList items;
+  FillDirectory(items, "upnp://server/1/", 1000);
+  const size_t size = CDirectoryCache::EstimateSize(items);
+  EXPECT_GT(size, 1000 * sizeof(CFileItem));
+
+  CDirectoryCache cache;
+  cache.SetMaxSize(size * 7 / 2);
+
+  CFileItemList always;
+  FillDirectory(always, "special://profile/", 1000);
+  cache.SetDirectory(always.GetPath(), always, DIR_CACHE_ALWAYS);
+
+  for (int i = 0; i < 3; i++)
+  {
+    CFileItemList dir;
+    FillDirectory(dir, StringUtils::Format("upnp://server/%d/", i), 1000);
+    cache.SetDirectory(dir.GetPath(), dir, DIR_CACHE_ONCE);
+  }
+
+  // the oldest listing has to go, the one cached with DIR_CACHE_ALWAYS stays
+  CFileItemList cached;
+  EXPECT_TRUE(cache.GetDirectory("special://profile/", cached));
+  EXPECT_FALSE(cache.GetDirectory("upnp://server/0/", cached, true));
+  EXPECT_TRUE(cache.GetDirectory("upnp://server/2/", cached, true));
+
+  const CDirectoryCache::Statistics statistics = cache.GetStatistics();
+  EXPECT_EQ(1u, statistics.evictions);
+  EXPECT_EQ(3u, statistics.directories);
+  EXPECT_LE(statistics.size, statistics.maxSize);
+
+  cache.Clear();
+  EXPECT_EQ(0u, cache.GetStatistics().size);
+}
+
+TEST(TestDirectoryCache, SharedItems)
+{
+  CDirectoryCache cache;
+  CFileItemList items;
+  FillDirectory(items, "nfs://server/export/music/", 5);
+  cache.SetDirectory(items.GetPath(), items, DIR_CACHE_ALWAYS);
+
+  // readers get the same snapshot until the listing changes
+  std::shared_ptr<const CFileItemList> shared = cache.GetDirectory("nfs://server/export/music/");
+  ASSERT_NE(nullptr, shared);
+  EXPECT_EQ(shared, cache.GetDirectory("nfs://server/export/music"));
+  EXPECT_EQ(nullptr, cache.GetDirectory("nfs://server/export/video/"));
+
+  // lists that share the items hold the cached items, copies their own
+  CFileItemList sharing;
+  EXPECT_TRUE(cache.GetDirectory("nfs://server/export/music/", sharing, false, false));
+  ASSERT_EQ(5, sharing.Size());
+  EXPECT_EQ(shared->Get(2).get(), sharing[2].get());
+
+  CFileItemList copied;
+  EXPECT_TRUE(cache.GetDirectory("nfs://server/export/music/", copied));
+  ASSERT_EQ(5, copied.Size());
+  EXPECT_NE(shared->Get(2).get(), copied[2].get());
+  EXPECT_EQ(shared->Get(2)->GetPath(), copied[2]->GetPath());
+
+  // a snapshot that was handed out is never changed, the next reader sees the new file
+  cache.AddFile("nfs://server/export/music/new.flac");
+  EXPECT_EQ(5, shared->Size());
+  std::shared_ptr<const CFileItemList> updated = cache.GetDirectory("nfs://server/export/music/");
+  ASSERT_NE(nullptr, updated);
+  EXPECT_NE(shared, updated);
+  ASSERT_EQ(6, updated->Size());
+  EXPECT_EQ(shared->Get(0).get(), updated->Get(0).get());
+  EXPECT_EQ("nfs://server/export/music/new.flac", updated->Get(5)->GetPath());
+}
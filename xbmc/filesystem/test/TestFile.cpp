@@ -207,3 +207,31 @@ TEST(TestFile, SetHidden)
   EXPECT_TRUE(XFILE::CFile::Exists(XBMC_TEMPFILEPATH(file)));
   EXPECT_TRUE(XBMC_DELETETEMPFILE(file));
 }
+
+#ifndef TARGET_WINDOWS
+TEST(TestFile, MapView)
+{
+  XFILE::CFile file;
+  ASSERT_TRUE(file.Open(XBMC_REF_FILE_PATH("/xbmc/filesystem/test/reffile.txt")));
+
+  XFILE::SMappedView view;
+  view.offset = 5000; // past the end of the file
+  EXPECT_NE(0, file.IoControl(XFILE::IOCTRL_MAP_VIEW, &view));
+
+  // a view that doesn't start at a page boundary and is cut at the end of the file
+  view.offset = 100;
+  view.size = 100000;
+  ASSERT_EQ(0, file.IoControl(XFILE::IOCTRL_MAP_VIEW, &view));
+  ASSERT_NE(nullptr, view.data);
+  EXPECT_EQ(static_cast<size_t>(file.GetLength() - 100), view.size);
+
+  char buf[20];
+  EXPECT_EQ(100, file.Seek(100));
+  EXPECT_EQ(static_cast<ssize_t>(sizeof(buf)), file.Read(buf, sizeof(buf)));
+  EXPECT_EQ(0, memcmp(buf, view.data, sizeof(buf)));
+
+  // the view stays valid after the file is closed
+  file.Close();
+  EXPECT_EQ(0, memcmp(buf, view.data, sizeof(buf)));
+}
+#endif
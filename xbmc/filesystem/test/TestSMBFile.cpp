@@ -0,0 +1,163 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "platform/posix/filesystem/SMBFile.h"
+
+#include <algorithm>
+#include <libsmbclient.h>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+/*!
+ \brief A file that is read from memory instead of a server, remembering
+ the requests that would have been sent.
+ */
+class CMemorySMBFile : public XFILE::CSMBFile
+{
+public:
+  CMemorySMBFile(size_t size, size_t readAheadSize) : m_data(size)
+  {
+    for (size_t i = 0; i < size; i++)
+      m_data[i] = static_cast<char>(i * 7 + i / 4096);
+
+    // looks open to CSMBFile, never passed to libsmbclient
+    m_fd = 1;
+    m_fileSize = size;
+    m_readAheadSize = readAheadSize;
+  }
+
+  ~CMemorySMBFile() override { m_fd = -1; }
+
+  ssize_t ReadSource(void* lpBuf, size_t uiBufSize) override
+  {
+    m_requests.emplace_back(m_sourcePos, uiBufSize);
+    const size_t size = std::min(uiBufSize, m_data.size() - static_cast<size_t>(m_sourcePos));
+    memcpy(lpBuf, m_data.data() + m_sourcePos, size);
+    m_sourcePos += size;
+    return size;
+  }
+
+  int64_t SeekSource(int64_t iFilePosition, int iWhence) override
+  {
+    if (iWhence == SEEK_END)
+      iFilePosition += m_data.size();
+    m_sourcePos = iFilePosition;
+    return iFilePosition;
+  }
+
+  /*!
+   \brief Reads size bytes in chunks and compares them with the file.
+   */
+  void ExpectRead(size_t size, size_t chunkSize)
+  {
+    const int64_t position = GetPosition();
+    std::vector<char> buffer(size);
+    size_t read = 0;
+    while (read < size)
+    {
+      const ssize_t chunk = Read(buffer.data() + read, std::min(chunkSize, size - read));
+      ASSERT_GT(chunk, 0);
+      read += chunk;
+    }
+    EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), m_data.begin() + position));
+  }
+
+  std::vector<char> m_data;
+  std::vector<std::pair<int64_t, size_t>> m_requests; ///< position and size of the reads from the server
+};
+
+const size_t READ_AHEAD = 64 * 1024;
+
+} // unnamed namespace
+
+TEST(TestSMBFile, ReadsAheadInAlignedBlocks)
+{
+  CMemorySMBFile file(10 * READ_AHEAD + 1000, READ_AHEAD);
+  file.ExpectRead(file.m_data.size(), 4096);
+
+  char byte;
+  EXPECT_EQ(0, file.Read(&byte, 1));
+
+  // the last block is cut short by the end of the file
+  ASSERT_LE(11u, file.m_requests.size());
+  for (size_t i = 0; i < 11; i++)
+  {
+    EXPECT_EQ(static_cast<int64_t>(i * READ_AHEAD), file.m_requests[i].first);
+    EXPECT_EQ(READ_AHEAD, file.m_requests[i].second);
+  }
+}
+
+TEST(TestSMBFile, RealignsAfterSeek)
+{
+  CMemorySMBFile file(10 * READ_AHEAD, READ_AHEAD);
+
+  // the read after a seek is passed on as it is
+  const int64_t position = 2 * READ_AHEAD + 1000;
+  ASSERT_EQ(position, file.Seek(position, SEEK_SET));
+  file.ExpectRead(4096, 4096);
+  ASSERT_EQ(1u, file.m_requests.size());
+  EXPECT_EQ(position, file.m_requests[0].first);
+  EXPECT_EQ(4096u, file.m_requests[0].second);
+
+  // the next one only reads up to the following block
+  file.ExpectRead(4096, 4096);
+  ASSERT_EQ(2u, file.m_requests.size());
+  EXPECT_EQ(position + 4096, file.m_requests[1].first);
+  EXPECT_EQ(static_cast<int64_t>(3 * READ_AHEAD), file.m_requests[1].first + file.m_requests[1].second);
+
+  // and whole blocks after that
+  file.ExpectRead(READ_AHEAD, 4096);
+  ASSERT_EQ(3u, file.m_requests.size());
+  EXPECT_EQ(static_cast<int64_t>(3 * READ_AHEAD), file.m_requests[2].first);
+  EXPECT_EQ(READ_AHEAD, file.m_requests[2].second);
+
+  // seeking within the buffered data doesn't ask the server
+  const int64_t buffered = 3 * READ_AHEAD + 100;
+  ASSERT_EQ(buffered, file.Seek(buffered, SEEK_SET));
+  file.ExpectRead(4096, 4096);
+  EXPECT_EQ(3u, file.m_requests.size());
+}
+
+TEST(TestSMBFile, LargeReadsAreNotBuffered)
+{
+  CMemorySMBFile file(10 * READ_AHEAD, READ_AHEAD);
+  file.ExpectRead(2 * READ_AHEAD, 2 * READ_AHEAD);
+  ASSERT_EQ(1u, file.m_requests.size());
+  EXPECT_EQ(2 * READ_AHEAD, file.m_requests[0].second);
+}
+
+TEST(TestSMBFile, SmallFilesAreReadAsRequested)
+{
+  CMemorySMBFile file(READ_AHEAD, 0);
+  file.ExpectRead(8192, 4096);
+  ASSERT_EQ(2u, file.m_requests.size());
+  EXPECT_EQ(4096u, file.m_requests[1].second);
+}
+
+#ifdef DEPRECATED_SMBC_INTERFACE
+TEST(TestSMBFile, FileContextsAreIndependent)
+{
+  // every large file gets a context of its own, none of them is the shared one
+  SMBCCTX* first = smb.NewFileContext();
+  SMBCCTX* second = smb.NewFileContext();
+  ASSERT_NE(nullptr, first);
+  ASSERT_NE(nullptr, second);
+  EXPECT_NE(first, second);
+  EXPECT_NE(smbc_set_context(nullptr), first);
+  EXPECT_NE(smbc_set_context(nullptr), second);
+
+  CSMB::FreeFileContext(first);
+  CSMB::FreeFileContext(second);
+}
+#endif
@@ -19,9 +19,86 @@
 #include "URL.h"
 
 #include <errno.h>
+#include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 
+namespace
+{
+
+void PutLE16(std::string& buffer, uint16_t value)
+{
+  buffer += static_cast<char>(value & 0xff);
+  buffer += static_cast<char>(value >> 8);
+}
+
+void PutLE32(std::string& buffer, uint32_t value)
+{
+  PutLE16(buffer, value & 0xffff);
+  PutLE16(buffer, value >> 16);
+}
+
+/* An archive of stored files, enough of them to be extracted in parallel and
+ * to get an index of its central directory.
+ */
+std::string CreateArchive(const std::vector<std::pair<std::string, std::string>>& files)
+{
+  std::string archive, directory;
+  for (const auto& file : files)
+  {
+    const uint32_t crc = crc32(0, reinterpret_cast<const Bytef*>(file.second.data()), file.second.size());
+    const uint32_t offset = archive.size();
+
+    PutLE32(archive, ZIP_LOCAL_HEADER);
+    PutLE16(archive, 20); // version needed
+    PutLE16(archive, 0); // flags
+    PutLE16(archive, 0); // stored
+    PutLE16(archive, 0); // time
+    PutLE16(archive, 0x21); // date, 1980-01-01
+    PutLE32(archive, crc);
+    PutLE32(archive, file.second.size());
+    PutLE32(archive, file.second.size());
+    PutLE16(archive, file.first.size());
+    PutLE16(archive, 0); // extra field
+    archive += file.first;
+    archive += file.second;
+
+    PutLE32(directory, ZIP_CENTRAL_HEADER);
+    PutLE16(directory, 20); // version made by
+    PutLE16(directory, 20); // version needed
+    PutLE16(directory, 0); // flags
+    PutLE16(directory, 0); // stored
+    PutLE16(directory, 0); // time
+    PutLE16(directory, 0x21); // date
+    PutLE32(directory, crc);
+    PutLE32(directory, file.second.size());
+    PutLE32(directory, file.second.size());
+    PutLE16(directory, file.first.size());
+    PutLE16(directory, 0); // extra field
+    PutLE16(directory, 0); // comment
+    PutLE16(directory, 0); // disk
+    PutLE16(directory, 0); // internal attributes
+    PutLE32(directory, 0); // external attributes
+    PutLE32(directory, offset);
+    directory += file.first;
+  }
+
+  const uint32_t directoryOffset = archive.size();
+  archive += directory;
+  PutLE32(archive, ZIP_END_CENTRAL_HEADER);
+  PutLE16(archive, 0); // disk
+  PutLE16(archive, 0); // disk of the central directory
+  PutLE16(archive, files.size());
+  PutLE16(archive, files.size());
+  PutLE32(archive, directory.size());
+  PutLE32(archive, directoryOffset);
+  PutLE16(archive, 0); // comment
+  return archive;
+}
+
+}
+
 class TestZipFile : public testing::Test
 {
 protected:
@@ -227,3 +304,89 @@ TEST_F(TestZipFile, ExtendedLocalHeader)
   EXPECT_TRUE(strBuffer.substr(0, 6) == "<Data>");
   file.Close();
 }
+
+TEST_F(TestZipFile, ExtractArchive)
+{
+  XFILE::CFile *tmpfile = XBMC_CREATETEMPFILE("");
+  ASSERT_NE(nullptr, tmpfile);
+  const std::string dest = XBMC_TEMPFILEPATH(tmpfile) + "_extract/";
+  XBMC_DELETETEMPFILE(tmpfile);
+
+  const CURL archive(XBMC_REF_FILE_PATH("xbmc/filesystem/test/reffile.txt.zip"));
+  ASSERT_TRUE(g_ZipManager.ExtractArchive(archive, dest, ""));
+
+  XFILE::CFile file;
+  char buf[20] = {};
+  ASSERT_TRUE(file.Open(dest + "reffile.txt"));
+  EXPECT_EQ(static_cast<ssize_t>(sizeof(buf)), file.Read(buf, sizeof(buf)));
+  EXPECT_EQ(0, memcmp(buf, "About\n-----\nXBMC is ", sizeof(buf)));
+  file.Close();
+
+  // only the files below the given folder are extracted
+  EXPECT_TRUE(g_ZipManager.ExtractArchive(archive, dest + "empty/", "missing/"));
+  EXPECT_FALSE(XFILE::CDirectory::Exists(dest + "empty/"));
+
+  XFILE::CDirectory::RemoveRecursive(dest);
+}
+
+TEST_F(TestZipFile, ExtractLargeArchive)
+{
+  std::vector<std::pair<std::string, std::string>> files;
+  for (int i = 0; i < 160; i++)
+    files.emplace_back(StringUtils::Format("folder/file%03d.txt", i), StringUtils::Format("content of file %d\n", i));
+  const std::string data = CreateArchive(files);
+
+  XFILE::CFile *tmpfile = XBMC_CREATETEMPFILE(".zip");
+  ASSERT_NE(nullptr, tmpfile);
+  ASSERT_EQ(static_cast<ssize_t>(data.size()), tmpfile->Write(data.data(), data.size()));
+  tmpfile->Close();
+  const std::string path = XBMC_TEMPFILEPATH(tmpfile);
+  const std::string dest = path + "_extract/";
+  const std::string index = CZipManager::GetIndexPath(path);
+  const CURL archive(path);
+  const CURL zipUrl = URIUtils::CreateArchivePath("zip", archive, "");
+  XFILE::CFile::Delete(index);
+
+  // more than ZIP_EXTRACT_FILES_PER_WORKER files for every worker
+  ASSERT_TRUE(g_ZipManager.ExtractArchive(archive, dest, ""));
+  for (int i : { 0, 1, 80, 159 })
+  {
+    XFILE::CFile file;
+    ASSERT_TRUE(file.Open(dest + StringUtils::Format("folder/file%03d.txt", i)));
+    char buf[64] = {};
+    const std::string expected = StringUtils::Format("content of file %d\n", i);
+    EXPECT_EQ(static_cast<ssize_t>(expected.size()), file.Read(buf, sizeof(buf)));
+    EXPECT_EQ(expected, std::string(buf));
+  }
+  CFileItemList items;
+  ASSERT_TRUE(XFILE::CDirectory::GetDirectory(dest + "folder/", items, "", XFILE::DIR_FLAG_BYPASS_CACHE));
+  EXPECT_EQ(160, items.Size());
+
+  // with ZIP_INDEX_MIN_ENTRIES or more the central directory is kept
+  ASSERT_TRUE(XFILE::CFile::Exists(index));
+
+  // and read again instead of the archive, a name changed in the index only
+  // shows up in the listing if the index is used
+  XFILE::CFile file;
+  XFILE::auto_buffer buffer;
+  ASSERT_GT(file.LoadFile(index, buffer), 0);
+  std::string content(buffer.get(), buffer.size());
+  const size_t pos = content.find("folder/file000.txt");
+  ASSERT_NE(std::string::npos, pos);
+  content.replace(pos, 18, "folder/FILE000.txt");
+  ASSERT_TRUE(file.OpenForWrite(index, true));
+  ASSERT_EQ(static_cast<ssize_t>(content.size()), file.Write(content.data(), content.size()));
+  file.Close();
+
+  g_ZipManager.release(zipUrl.Get());
+  std::vector<SZipEntry> entries;
+  ASSERT_TRUE(g_ZipManager.GetZipList(zipUrl, entries));
+  ASSERT_EQ(160u, entries.size());
+  EXPECT_STREQ("folder/FILE000.txt", entries[0].name);
+  EXPECT_STREQ("folder/file159.txt", entries[159].name);
+
+  g_ZipManager.release(zipUrl.Get());
+  XFILE::CFile::Delete(index);
+  XFILE::CDirectory::RemoveRecursive(dest);
+  XBMC_DELETETEMPFILE(tmpfile);
+}
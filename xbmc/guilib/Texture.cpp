@@ -236,12 +236,28 @@ bool CBaseTexture::LoadFromFileInternal(const std::string& texturePath, unsigned
   unsigned int height = maxHeight ? std::min(maxHeight, CServiceBroker::GetRenderSystem()->GetMaxTextureSize()) :
                                     CServiceBroker::GetRenderSystem()->GetMaxTextureSize();
 
-  // Read image into memory to use our vfs
+  // Read image into memory to use our vfs. The images installed with Kodi are mapped instead, others
+  // like thumbnails may be rewritten while they are in use, which would fault on the mapping.
   XFILE::CFile file;
   XFILE::auto_buffer buf;
+  XFILE::SMappedView view;
+  const unsigned char* data;
+  size_t size;
 
-  if (file.LoadFile(texturePath, buf) <= 0)
-    return false;
+  if (URIUtils::IsInstallPath(texturePath) && file.Open(texturePath, XFILE::READ_TRUNCATED) &&
+      file.IoControl(XFILE::IOCTRL_MAP_VIEW, &view) == 0)
+  {
+    data = view.data;
+    size = view.size;
+  }
+  else
+  {
+    file.Close();
+    if (file.LoadFile(texturePath, buf) <= 0)
+      return false;
+    data = reinterpret_cast<const unsigned char*>(buf.get());
+    size = buf.size();
+  }
 
   CURL url(texturePath);
   // make sure resource:// paths are properly resolved
@@ -260,7 +276,7 @@ bool CBaseTexture::LoadFromFileInternal(const std::string& texturePath, unsigned
       return false;
 
     return LoadFromMemory(xbtFile.GetImageWidth(), xbtFile.GetImageHeight(), 0, xbtFile.GetImageFormat(),
-                          xbtFile.HasImageAlpha(), reinterpret_cast<const unsigned char*>(buf.get()));
+                          xbtFile.HasImageAlpha(), data);
   }
 
   IImage* pImage;
@@ -270,7 +286,8 @@ bool CBaseTexture::LoadFromFileInternal(const std::string& texturePath, unsigned
   else
     pImage = ImageFactory::CreateLoaderFromMimeType(strMimeType);
 
-  if (!LoadIImage(pImage, (unsigned char *)buf.get(), buf.size(), width, height))
+  // the decoders only read from the buffer
+  if (!LoadIImage(pImage, const_cast<unsigned char*>(data), size, width, height))
   {
     CLog::Log(LOGDEBUG, "%s - Load of %s failed.", __FUNCTION__, CURL::GetRedacted(texturePath).c_str());
     delete pImage;
@@ -12,8 +12,10 @@
 #include <sys/stat.h>
 
 #include "XBTFReader.h"
+#include "filesystem/File.h"
 #include "guilib/XBTF.h"
 #include "utils/EndianSwap.h"
+#include "utils/URIUtils.h"
 
 #ifdef TARGET_WINDOWS
 #include "filesystem/SpecialProtocol.h"
@@ -164,6 +166,15 @@ bool CXBTFReader::Open(const std::string& path)
   if (pos != GetHeaderSize())
     return false;
 
+  // the bundles installed with Kodi are never rewritten while we run, so their
+  // frames are read from a mapping instead of seeking and copying for each one
+  if (URIUtils::IsInstallPath(m_path))
+  {
+    XFILE::CFile file;
+    if (!file.Open(m_path, XFILE::READ_TRUNCATED) || file.IoControl(XFILE::IOCTRL_MAP_VIEW, &m_view) != 0)
+      m_view = XFILE::SMappedView();
+  }
+
   return true;
 }
 
@@ -180,6 +191,7 @@ void CXBTFReader::Close()
     m_file = nullptr;
   }
 
+  m_view = XFILE::SMappedView();
   m_path.clear();
   m_files.clear();
 }
@@ -196,11 +208,27 @@ time_t CXBTFReader::GetLastModificationTimestamp() const
   return fileStat.st_mtime;
 }
 
+const uint8_t* CXBTFReader::GetFrameData(const CXBTFFrame& frame) const
+{
+  if (m_view.data == nullptr || frame.GetOffset() > m_view.size ||
+      frame.GetPackedSize() > m_view.size - frame.GetOffset())
+    return nullptr;
+
+  return m_view.data + frame.GetOffset();
+}
+
 bool CXBTFReader::Load(const CXBTFFrame& frame, unsigned char* buffer) const
 {
   if (m_file == nullptr)
     return false;
 
+  const uint8_t* data = GetFrameData(frame);
+  if (data != nullptr)
+  {
+    memcpy(buffer, data, static_cast<size_t>(frame.GetPackedSize()));
+    return true;
+  }
+
 #if defined(TARGET_DARWIN) || defined(TARGET_FREEBSD)
   if (fseeko(m_file, static_cast<off_t>(frame.GetOffset()), SEEK_SET) == -1)
 #elif defined(TARGET_ANDROID)
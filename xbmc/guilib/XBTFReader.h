@@ -15,6 +15,7 @@
 #include <stdint.h>
 
 #include "XBTF.h"
+#include "filesystem/IFileTypes.h"
 
 class CXBTFReader : public CXBTFBase
 {
@@ -30,9 +31,16 @@ public:
 
   bool Load(const CXBTFFrame& frame, unsigned char* buffer) const;
 
+  /*!
+   \brief Packed bytes of the frame if the bundle is mapped into memory.
+   \return pointer to GetPackedSize() bytes, nullptr if the caller has to Load() the frame.
+   */
+  const uint8_t* GetFrameData(const CXBTFFrame& frame) const;
+
 private:
   std::string m_path;
   FILE* m_file = nullptr;
+  XFILE::SMappedView m_view;
 };
 
 typedef std::shared_ptr<CXBTFReader> CXBTFReaderPtr;
@@ -318,6 +318,15 @@ bool CPlayerGUIInfo::GetLabel(std::string& value, const CFileItem *item, int con
     case PLAYER_PROCESS_VIDEOHEIGHT:
       value = StringUtils::FormatNumber(CServiceBroker::GetDataCacheCore().GetVideoHeight());
       return true;
+    case PLAYER_PROCESS_VIDEODECODETHREADS:
+      value = CServiceBroker::GetDataCacheCore().GetVideoDecodeThreads();
+      return true;
+    case PLAYER_PROCESS_VIDEODECODETIME:
+      value = StringUtils::Format("%.1f", CServiceBroker::GetDataCacheCore().GetVideoDecodeTimes().GetAverageMs());
+      return true;
+    case PLAYER_PROCESS_VIDEODECODEHISTOGRAM:
+      value = CServiceBroker::GetDataCacheCore().GetVideoDecodeTimes().ToString();
+      return true;
     case PLAYER_PROCESS_AUDIODECODER:
       value = CServiceBroker::GetDataCacheCore().GetAudioDecoderName();
       return true;
@@ -234,7 +234,8 @@ JsonRpcMethodMap CJSONServiceDescription::m_methodMaps[] = {
 
 // XBMC operations
   { "XBMC.GetInfoLabels",                           CXBMCOperations::GetInfoLabels },
-  { "XBMC.GetInfoBooleans",                         CXBMCOperations::GetInfoBooleans }
+  { "XBMC.GetInfoBooleans",                         CXBMCOperations::GetInfoBooleans },
+  { "XBMC.GetDatabaseStatistics",                   CXBMCOperations::GetDatabaseStatistics }
 };
 
 JSONSchemaTypeDefinition::JSONSchemaTypeDefinition()
@@ -7,6 +7,8 @@
  */
 
 #include "XBMCOperations.h"
+#include "DatabaseManager.h"
+#include "dbwrappers/DatabaseStatistics.h"
 #include "messaging/ApplicationMessenger.h"
 #include "utils/Variant.h"
 #include "powermanagement/PowerManager.h"
@@ -84,3 +86,45 @@ JSONRPC_STATUS CXBMCOperations::GetInfoBooleans(const std::string &method, ITran
 
   return OK;
 }
+
+JSONRPC_STATUS CXBMCOperations::GetDatabaseStatistics(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  CDatabaseStatistics &statistics = CDatabaseStatistics::GetInstance();
+
+  result["enabled"] = statistics.IsEnabled();
+  result["slowquerytime"] = statistics.GetSlowQueryTime();
+  result["statements"] = CVariant(CVariant::VariantTypeArray);
+
+  for (const auto &statement : statistics.GetStatements())
+  {
+    CVariant item(CVariant::VariantTypeObject);
+    item["database"] = statement.database;
+    item["statement"] = statement.fingerprint;
+    item["count"] = statement.count;
+    item["total"] = statement.totalMs;
+    item["p50"] = statement.p50Ms;
+    item["p99"] = statement.p99Ms;
+    item["max"] = statement.maxMs;
+    if (!statement.plan.empty())
+    {
+      item["plan"] = CVariant(CVariant::VariantTypeArray);
+      for (const auto &step : statement.plan)
+        item["plan"].push_back(step);
+    }
+    result["statements"].push_back(item);
+  }
+
+  const CDatabaseManager::ReadPoolStats pool = CServiceBroker::GetDatabaseManager().GetReadPoolStats();
+  result["readpool"]["requests"] = pool.requests;
+  result["readpool"]["hits"] = pool.hits;
+  result["readpool"]["opened"] = pool.opened;
+  result["readpool"]["waits"] = pool.waits;
+  result["readpool"]["timeouts"] = pool.timeouts;
+  result["readpool"]["idle"] = pool.idle;
+  result["readpool"]["busy"] = pool.busy;
+
+  if (parameterObject["reset"].asBoolean())
+    statistics.Reset();
+
+  return OK;
+}
@@ -77,6 +77,31 @@ using namespace CDDB;
 using namespace MEDIA_DETECT;
 #endif
 
+namespace
+{
+struct DeferredIndex
+{
+  const char* name;
+  const char* table;
+  const char* create;
+};
+
+// Indices that are not used while adding albums and songs, so can be built once after a bulk import
+const DeferredIndex deferredIndices[] =
+{
+  { "idxAlbum_1", "album", "CREATE INDEX idxAlbum_1 ON album(bCompilation)" },
+  { "idxAlbum_3", "album", "CREATE INDEX idxAlbum_3 ON album(idInfoSetting)" },
+  { "idxAlbumArtist_2", "album_artist", "CREATE UNIQUE INDEX idxAlbumArtist_2 ON album_artist ( idArtist, idAlbum )" },
+  { "idxArtist_2", "artist", "CREATE INDEX idxArtist_2 ON artist(idInfoSetting)" },
+  { "idxSong", "song", "CREATE INDEX idxSong ON song(strTitle(255))" },
+  { "idxSong1", "song", "CREATE INDEX idxSong1 ON song(iTimesPlayed)" },
+  { "idxSong2", "song", "CREATE INDEX idxSong2 ON song(lastplayed)" },
+  { "idxSongArtist_3", "song_artist", "CREATE INDEX idxSongArtist_3 ON song_artist ( idArtist, idRole )" },
+  { "idxSongArtist_4", "song_artist", "CREATE INDEX idxSongArtist_4 ON song_artist ( idRole )" },
+  { "idxSongGenre_2", "song_genre", "CREATE UNIQUE INDEX idxSongGenre_2 ON song_genre ( idGenre, idSong )" },
+};
+}
+
 static void AnnounceRemove(const std::string& content, int id)
 {
   CVariant data;
@@ -215,18 +240,14 @@ void CMusicDatabase::CreateAnalytics()
 {
   CLog::Log(LOGINFO, "%s - creating indices", __FUNCTION__);
   m_pDS->exec("CREATE INDEX idxAlbum ON album(strAlbum(255))");
-  m_pDS->exec("CREATE INDEX idxAlbum_1 ON album(bCompilation)");
   m_pDS->exec("CREATE UNIQUE INDEX idxAlbum_2 ON album(strMusicBrainzAlbumID(36))");
-  m_pDS->exec("CREATE INDEX idxAlbum_3 ON album(idInfoSetting)");
 
   m_pDS->exec("CREATE UNIQUE INDEX idxAlbumArtist_1 ON album_artist ( idAlbum, idArtist )");
-  m_pDS->exec("CREATE UNIQUE INDEX idxAlbumArtist_2 ON album_artist ( idArtist, idAlbum )");
 
   m_pDS->exec("CREATE INDEX idxGenre ON genre(strGenre(255))");
 
   m_pDS->exec("CREATE INDEX idxArtist ON artist(strArtist(255))");
   m_pDS->exec("CREATE UNIQUE INDEX idxArtist1 ON artist(strMusicBrainzArtistID(36))");
-  m_pDS->exec("CREATE INDEX idxArtist_2 ON artist(idInfoSetting)");
 
   m_pDS->exec("CREATE INDEX idxPath ON path(strPath(255))");
 
@@ -238,9 +259,6 @@ void CMusicDatabase::CreateAnalytics()
   m_pDS->exec("CREATE UNIQUE INDEX idxAlbumSource_1 ON album_source ( idSource, idAlbum )");
   m_pDS->exec("CREATE UNIQUE INDEX idxAlbumSource_2 ON album_source ( idAlbum, idSource )");
 
-  m_pDS->exec("CREATE INDEX idxSong ON song(strTitle(255))");
-  m_pDS->exec("CREATE INDEX idxSong1 ON song(iTimesPlayed)");
-  m_pDS->exec("CREATE INDEX idxSong2 ON song(lastplayed)");
   m_pDS->exec("CREATE INDEX idxSong3 ON song(idAlbum)");
   m_pDS->exec("CREATE INDEX idxSong6 ON song( idPath, strFileName(255) )");
   //Musicbrainz Track ID is not unique on an album, recordings are sometimes repeated e.g. "[silence]" or on a disc set
@@ -248,11 +266,8 @@ void CMusicDatabase::CreateAnalytics()
 
   m_pDS->exec("CREATE UNIQUE INDEX idxSongArtist_1 ON song_artist ( idSong, idArtist, idRole )");
   m_pDS->exec("CREATE INDEX idxSongArtist_2 ON song_artist ( idSong, idRole )");
-  m_pDS->exec("CREATE INDEX idxSongArtist_3 ON song_artist ( idArtist, idRole )");
-  m_pDS->exec("CREATE INDEX idxSongArtist_4 ON song_artist ( idRole )");
 
   m_pDS->exec("CREATE UNIQUE INDEX idxSongGenre_1 ON song_genre ( idSong, idGenre )");
-  m_pDS->exec("CREATE UNIQUE INDEX idxSongGenre_2 ON song_genre ( idGenre, idSong )");
 
   m_pDS->exec("CREATE INDEX idxRole on role(strRole(255))");
 
@@ -260,6 +275,9 @@ void CMusicDatabase::CreateAnalytics()
 
   m_pDS->exec("CREATE INDEX ix_art ON art(media_id, media_type(20), type(20))");
 
+  for (const auto& index : deferredIndices)
+    m_pDS->exec(index.create);
+
   CLog::Log(LOGINFO, "create triggers");
   m_pDS->exec("CREATE TRIGGER tgrDeleteAlbum AFTER delete ON album FOR EACH ROW BEGIN"
               "  DELETE FROM song WHERE song.idAlbum = old.idAlbum;"
@@ -283,6 +301,11 @@ void CMusicDatabase::CreateAnalytics()
               "  DELETE FROM album_source WHERE album_source.idSource = old.idSource;"
               " END");
   
+  CLog::Log(LOGINFO, "%s - creating full-text indices", __FUNCTION__);
+  CreateFullTextIndex("artist_fts", "artist", "idArtist", {"strArtist"});
+  CreateFullTextIndex("album_fts", "album", "idAlbum", {"strAlbum", "strArtistDisp"});
+  CreateFullTextIndex("song_fts", "song", "idSong", {"strTitle", "strArtistDisp"});
+
   // we create views last to ensure all indexes are rolled in
   CreateViews();
 
@@ -412,7 +435,9 @@ void CMusicDatabase::SplitPath(const std::string& strFileNameAndPath, std::strin
 
 bool CMusicDatabase::AddAlbum(CAlbum& album, int idSource)
 {
-  BeginTransaction();
+  // a bulk import commits several albums at once
+  if (!m_bulkImport || !InTransaction())
+    BeginTransaction();
   SetLibraryLastUpdated();
 
   album.idAlbum = AddAlbum(album.strAlbum,
@@ -488,7 +513,11 @@ bool CMusicDatabase::AddAlbum(CAlbum& album, int idSource)
   for (const auto &albumArt : album.art)
     SetArtForItem(album.idAlbum, MediaTypeAlbum, albumArt.first, albumArt.second);
 
-  CommitTransaction();
+  if (!m_bulkImport || ++m_bulkAlbumsPending >= m_bulkAlbumsPerTransaction)
+  {
+    CommitTransaction();
+    m_bulkAlbumsPending = 0;
+  }
   return true;
 }
 
@@ -575,55 +604,61 @@ int CMusicDatabase::AddSong(const int idAlbum,
     SplitPath(strPathAndFileName, strPath, strFileName);
     int idPath = AddPath(strPath);
 
+    bool found;
     if (!strMusicBrainzTrackID.empty())
-      strSQL = PrepareSQL("SELECT idSong FROM song WHERE idAlbum = %i AND iTrack=%i AND strMusicBrainzTrackID = '%s'",
-                          idAlbum,
-                          iTrack,
-                          strMusicBrainzTrackID.c_str());
+    {
+      strSQL = "SELECT idSong FROM song WHERE idAlbum = ? AND iTrack = ? AND strMusicBrainzTrackID = ?";
+      found = m_pDS->query_prepared(strSQL, { dbiplus::field_value(idAlbum),
+                                              dbiplus::field_value(iTrack),
+                                              dbiplus::field_value(strMusicBrainzTrackID) });
+    }
     else
-      strSQL = PrepareSQL("SELECT idSong FROM song WHERE idAlbum=%i AND strFileName='%s' AND strTitle='%s' AND iTrack=%i AND strMusicBrainzTrackID IS NULL",
-                          idAlbum,
-                          strFileName.c_str(),
-                          strTitle.c_str(),
-                          iTrack);
-
-    if (!m_pDS->query(strSQL))
+    {
+      strSQL = "SELECT idSong FROM song WHERE idAlbum = ? AND strFileName = ? AND strTitle = ? AND iTrack = ? AND strMusicBrainzTrackID IS NULL";
+      found = m_pDS->query_prepared(strSQL, { dbiplus::field_value(idAlbum),
+                                              dbiplus::field_value(strFileName),
+                                              dbiplus::field_value(strTitle),
+                                              dbiplus::field_value(iTrack) });
+    }
+    if (!found)
       return -1;
 
     if (m_pDS->num_rows() == 0)
     {
       m_pDS->close();
-      strSQL=PrepareSQL("INSERT INTO song ("
-                                          "idSong,idAlbum,idPath,strArtistDisp,"
-                                          "strTitle,iTrack,iDuration,iYear,strFileName,"
-                                          "strMusicBrainzTrackID, strArtistSort, "
-                                          "iTimesPlayed,iStartOffset, "
-                                          "iEndOffset,lastplayed,rating,userrating,votes,comment,mood,strReplayGain"
-                        ") values (NULL, %i, %i, '%s', '%s', %i, %i, %i, '%s'",
-                    idAlbum,
-                    idPath,
-                    artistDisp.c_str(),
-                    strTitle.c_str(),
-                    iTrack, iDuration, iYear,
-                    strFileName.c_str());
-
-      if (strMusicBrainzTrackID.empty())
-        strSQL += PrepareSQL(",NULL");
-      else
-        strSQL += PrepareSQL(",'%s'", strMusicBrainzTrackID.c_str());
-      if (artistSort.empty())
-        strSQL += PrepareSQL(",NULL");
-      else
-        strSQL += PrepareSQL(",'%s'", artistSort.c_str());
 
-      if (dtLastPlayed.IsValid())
-        strSQL += PrepareSQL(",%i,%i,%i,'%s', %.1f, %i, %i, '%s','%s', '%s')",
-                      iTimesPlayed, iStartOffset, iEndOffset, dtLastPlayed.GetAsDBDateTime().c_str(), rating, userrating, votes,
-                      strComment.c_str(), strMood.c_str(), replayGain.Get().c_str());
-      else
-        strSQL += PrepareSQL(",%i,%i,%i,NULL, %.1f, %i, %i,'%s', '%s', '%s')",
-                      iTimesPlayed, iStartOffset, iEndOffset, rating, userrating, votes, strComment.c_str(), strMood.c_str(), replayGain.Get().c_str());
-      m_pDS->exec(strSQL);
+      dbiplus::field_value nullValue;
+      nullValue.set_isNull();
+
+      strSQL = "INSERT INTO song ("
+                 "idSong,idAlbum,idPath,strArtistDisp,"
+                 "strTitle,iTrack,iDuration,iYear,strFileName,"
+                 "strMusicBrainzTrackID, strArtistSort, "
+                 "iTimesPlayed,iStartOffset, "
+                 "iEndOffset,lastplayed,rating,userrating,votes,comment,mood,strReplayGain"
+               ") values (NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+      m_pDS->exec_prepared(strSQL, {
+          dbiplus::field_value(idAlbum),
+          dbiplus::field_value(idPath),
+          dbiplus::field_value(artistDisp),
+          dbiplus::field_value(strTitle),
+          dbiplus::field_value(iTrack),
+          dbiplus::field_value(iDuration),
+          dbiplus::field_value(iYear),
+          dbiplus::field_value(strFileName),
+          strMusicBrainzTrackID.empty() ? nullValue : dbiplus::field_value(strMusicBrainzTrackID),
+          artistSort.empty() ? nullValue : dbiplus::field_value(artistSort),
+          dbiplus::field_value(iTimesPlayed),
+          dbiplus::field_value(iStartOffset),
+          dbiplus::field_value(iEndOffset),
+          dtLastPlayed.IsValid() ? dbiplus::field_value(dtLastPlayed.GetAsDBDateTime()) : nullValue,
+          dbiplus::field_value(rating),
+          dbiplus::field_value(userrating),
+          dbiplus::field_value(votes),
+          dbiplus::field_value(strComment),
+          dbiplus::field_value(strMood),
+          dbiplus::field_value(replayGain.Get())
+      });
       idSong = (int)m_pDS->lastinsertid();
     }
     else
@@ -1160,6 +1195,14 @@ int CMusicDatabase::AddArtist(const std::string& strArtist, const std::string& s
   if (idArtist < 0 || strSortName.empty())
     return idArtist;
 
+  // applying the same sort name again changes nothing
+  if (m_bulkImport)
+  {
+    auto it = m_artistSortNameCache.find(idArtist);
+    if (it != m_artistSortNameCache.end() && it->second == strSortName)
+      return idArtist;
+  }
+
   /* Artist sort name always taken as the first value provided that is different from name, so only
      update when current sort name is blank. If a new sortname the same as name is provided then
      clear any sortname currently held.
@@ -1190,6 +1233,8 @@ int CMusicDatabase::AddArtist(const std::string& strArtist, const std::string& s
     else if (strSortName.compare(strArtistName) != 0)
         m_pDS->exec(PrepareSQL("UPDATE artist SET strSortName = '%s' WHERE idArtist = %i", strSortName.c_str(), idArtist));
 
+    if (m_bulkImport)
+      m_artistSortNameCache[idArtist] = strSortName;
     return idArtist;
   }
 
@@ -1203,6 +1248,22 @@ int CMusicDatabase::AddArtist(const std::string& strArtist, const std::string& s
 
 int CMusicDatabase::AddArtist(const std::string& strArtist, const std::string& strMusicBrainzArtistID, bool bScrapedMBID /* = false*/)
 {
+  // a bulk import adds the same artists over and over, remember their ids
+  std::string cacheKey;
+  if (m_bulkImport && !bScrapedMBID)
+  {
+    cacheKey = strArtist + '\n' + strMusicBrainzArtistID;
+    auto it = m_artistCache.find(cacheKey);
+    if (it != m_artistCache.end())
+      return it->second;
+  }
+  auto cached = [this, &cacheKey](int idArtist)
+  {
+    if (!cacheKey.empty())
+      m_artistCache[cacheKey] = idArtist;
+    return idArtist;
+  };
+
   std::string strSQL;
   try
   {
@@ -1227,7 +1288,7 @@ int CMusicDatabase::AddArtist(const std::string& strArtist, const std::string& s
           m_pDS->exec(strSQL);
           m_pDS->close();
         }
-        return idArtist;
+        return cached(idArtist);
       }
       m_pDS->close();
 
@@ -1247,7 +1308,7 @@ int CMusicDatabase::AddArtist(const std::string& strArtist, const std::string& s
           bScrapedMBID,
           idArtist);
         m_pDS->exec(strSQL);
-        return idArtist;
+        return cached(idArtist);
       }
 
       // 2) No MusicBrainz - search for any artist (MB ID or non) with the same name.
@@ -1264,7 +1325,7 @@ int CMusicDatabase::AddArtist(const std::string& strArtist, const std::string& s
       {
         int idArtist = m_pDS->fv("idArtist").get_asInt();
         m_pDS->close();
-        return idArtist;
+        return cached(idArtist);
       }
       m_pDS->close();
     }
@@ -1281,7 +1342,7 @@ int CMusicDatabase::AddArtist(const std::string& strArtist, const std::string& s
 
     m_pDS->exec(strSQL);
     int idArtist = (int)m_pDS->lastinsertid();
-    return idArtist;
+    return cached(idArtist);
   }
   catch (...)
   {
@@ -1569,6 +1630,14 @@ int CMusicDatabase::AddRole(const std::string &strRole)
   {
     if (NULL == m_pDB.get()) return -1;
     if (NULL == m_pDS.get()) return -1;
+
+    if (m_bulkImport)
+    {
+      auto it = m_roleCache.find(strRole);
+      if (it != m_roleCache.end())
+        return it->second;
+    }
+
     strSQL = PrepareSQL("SELECT idRole FROM role WHERE strRole LIKE '%s'", strRole.c_str());
     m_pDS->query(strSQL);
     if (m_pDS->num_rows() > 0)
@@ -1582,6 +1651,8 @@ int CMusicDatabase::AddRole(const std::string &strRole)
       idRole = static_cast<int>(m_pDS->lastinsertid());
       m_pDS->close();
     }
+    if (m_bulkImport)
+      m_roleCache[strRole] = idRole;
   }
   catch (...)
   {
@@ -2081,14 +2152,14 @@ int CMusicDatabase::AddPath(const std::string& strPath1)
     if (it != m_pathCache.end())
       return it->second;
 
-    strSQL=PrepareSQL( "select * from path where strPath='%s'", strPath.c_str());
-    m_pDS->query(strSQL);
+    strSQL = "select * from path where strPath = ?";
+    m_pDS->query_prepared(strSQL, { dbiplus::field_value(strPath) });
     if (m_pDS->num_rows() == 0)
     {
       m_pDS->close();
       // doesnt exists, add it
-      strSQL=PrepareSQL("insert into path (idPath, strPath) values( NULL, '%s' )", strPath.c_str());
-      m_pDS->exec(strSQL);
+      strSQL = "insert into path (idPath, strPath) values( NULL, ? )";
+      m_pDS->exec_prepared(strSQL, { dbiplus::field_value(strPath) });
 
       int idPath = (int)m_pDS->lastinsertid();
       m_pathCache.insert(std::pair<std::string, int>(strPath, idPath));
@@ -2448,7 +2519,12 @@ bool CMusicDatabase::SearchArtists(const std::string& search, CFileItemList &art
 
     std::string strVariousArtists = g_localizeStrings.Get(340).c_str();
     std::string strSQL;
-    if (search.size() >= MIN_FULL_SEARCH_LENGTH)
+    std::string match = PrepareFullTextMatch(search);
+    if (!match.empty() && HasFullTextIndex("artist_fts"))
+      strSQL=PrepareSQL("SELECT artist.* FROM artist_fts JOIN artist ON artist.idArtist = artist_fts.rowid "
+                        "WHERE artist_fts MATCH '%s' AND strArtist <> '%s' ORDER BY artist_fts.rank",
+                        match.c_str(), strVariousArtists.c_str());
+    else if (search.size() >= MIN_FULL_SEARCH_LENGTH)
       strSQL=PrepareSQL("select * from artist "
                                 "where (strArtist like '%s%%' or strArtist like '%% %s%%') and strArtist <> '%s' "
                                 , search.c_str(), search.c_str(), strVariousArtists.c_str() );
@@ -2959,6 +3035,101 @@ void CMusicDatabase::EmptyCache()
 {
   m_genreCache.erase(m_genreCache.begin(), m_genreCache.end());
   m_pathCache.erase(m_pathCache.begin(), m_pathCache.end());
+  m_artistCache.clear();
+  m_artistSortNameCache.clear();
+  m_roleCache.clear();
+}
+
+void CMusicDatabase::BeginBulkImport(unsigned int albumsPerTransaction)
+{
+  if (m_bulkImport)
+    return;
+
+  m_bulkImport = true;
+  m_bulkAlbumsPerTransaction = std::max(albumsPerTransaction, 1u);
+  m_bulkAlbumsPending = 0;
+
+  // rebuilding indices only pays off when the whole library is being added
+  m_bulkIndicesDeferred = m_sqlite && GetSongsCount() == 0 && DeferIndices();
+
+  // an interrupted bulk import may have left indices missing
+  if (!m_bulkIndicesDeferred)
+    RestoreDeferredIndices();
+}
+
+void CMusicDatabase::CommitBulkImport()
+{
+  if (!m_bulkImport || m_bulkAlbumsPending == 0)
+    return;
+
+  CommitTransaction();
+  m_bulkAlbumsPending = 0;
+}
+
+void CMusicDatabase::EndBulkImport()
+{
+  if (!m_bulkImport)
+    return;
+
+  CommitBulkImport();
+  m_bulkImport = false;
+
+  if (m_bulkIndicesDeferred)
+  {
+    RestoreDeferredIndices();
+    m_bulkIndicesDeferred = false;
+  }
+  m_artistCache.clear();
+  m_artistSortNameCache.clear();
+  m_roleCache.clear();
+}
+
+bool CMusicDatabase::DeferIndices()
+{
+  try
+  {
+    for (const auto& index : deferredIndices)
+      m_pDS->exec(PrepareSQL("DROP INDEX %s ON %s", index.name, index.table));
+    CLog::Log(LOGDEBUG, "%s - indices dropped for bulk import", __FUNCTION__);
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s - failed to drop indices", __FUNCTION__);
+  }
+  RestoreDeferredIndices();
+  return false;
+}
+
+void CMusicDatabase::RestoreDeferredIndices()
+{
+  if (!m_sqlite)
+    return;
+
+  try
+  {
+    std::set<std::string> indices;
+    m_pDS->query("SELECT name FROM sqlite_master WHERE type = 'index'");
+    while (!m_pDS->eof())
+    {
+      indices.insert(m_pDS->fv(0).get_asString());
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    for (const auto& index : deferredIndices)
+    {
+      if (indices.find(index.name) == indices.end())
+      {
+        CLog::Log(LOGDEBUG, "%s - creating index %s", __FUNCTION__, index.name);
+        m_pDS->exec(index.create);
+      }
+    }
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s - failed to create indices", __FUNCTION__);
+  }
 }
 
 bool CMusicDatabase::Search(const std::string& search, CFileItemList &items)
@@ -2992,8 +3163,13 @@ bool CMusicDatabase::SearchSongs(const std::string& search, CFileItemList &items
     if (!baseUrl.FromString("musicdb://songs/"))
       return false;
 
+    // rank title matches above artist matches
     std::string strSQL;
-    if (search.size() >= MIN_FULL_SEARCH_LENGTH)
+    std::string match = PrepareFullTextMatch(search);
+    if (!match.empty() && HasFullTextIndex("song_fts"))
+      strSQL=PrepareSQL("SELECT songview.* FROM song_fts JOIN songview ON songview.idSong = song_fts.rowid "
+                        "WHERE song_fts MATCH '%s' ORDER BY bm25(song_fts, 10.0, 1.0) LIMIT 1000", match.c_str());
+    else if (search.size() >= MIN_FULL_SEARCH_LENGTH)
       strSQL=PrepareSQL("select * from songview where strTitle like '%s%%' or strTitle like '%% %s%%' limit 1000", search.c_str(), search.c_str());
     else
       strSQL=PrepareSQL("select * from songview where strTitle like '%s%%' limit 1000", search.c_str());
@@ -3029,7 +3205,11 @@ bool CMusicDatabase::SearchAlbums(const std::string& search, CFileItemList &albu
     if (NULL == m_pDS.get()) return false;
 
     std::string strSQL;
-    if (search.size() >= MIN_FULL_SEARCH_LENGTH)
+    std::string match = PrepareFullTextMatch(search);
+    if (!match.empty() && HasFullTextIndex("album_fts"))
+      strSQL=PrepareSQL("SELECT albumview.* FROM album_fts JOIN albumview ON albumview.idAlbum = album_fts.rowid "
+                        "WHERE album_fts MATCH '%s' ORDER BY bm25(album_fts, 10.0, 1.0)", match.c_str());
+    else if (search.size() >= MIN_FULL_SEARCH_LENGTH)
       strSQL=PrepareSQL("select * from albumview where strAlbum like '%s%%' or strAlbum like '%% %s%%'", search.c_str(), search.c_str());
     else
       strSQL=PrepareSQL("select * from albumview where strAlbum like '%s%%'", search.c_str());
@@ -3285,6 +3465,8 @@ bool CMusicDatabase::CleanupArtists()
     m_pDS->exec("CREATE TEMPORARY TABLE tmp_keep (idArtist INTEGER PRIMARY KEY)");
     m_pDS->exec("INSERT INTO tmp_keep SELECT DISTINCT idArtist from tmp_delartists");
     m_pDS->exec("DELETE FROM artist WHERE idArtist NOT IN (SELECT idArtist FROM tmp_keep)");
+    m_artistCache.clear();
+    m_artistSortNameCache.clear();
     // Tidy up temp tables
     m_pDS->exec("DROP TABLE tmp_delartists");
     m_pDS->exec("DROP TABLE tmp_keep");
@@ -3343,6 +3525,7 @@ bool CMusicDatabase::CleanupRoles()
     // Do not remove default role (ROLE_ARTIST)
     std::string strSQL = "DELETE FROM role WHERE idRole > 1 AND idRole NOT IN (SELECT idRole FROM song_artist)";
     m_pDS->exec(strSQL);
+    m_roleCache.clear();
     return true;
   }
   catch (...)
@@ -4204,6 +4387,9 @@ bool CMusicDatabase::GetArtistsByWhere(const std::string& strBaseDir, const Filt
 
   try
   {
+    // listings can be large, run them alongside other users of the database
+    CReadScope readScope(*this);
+
     unsigned int querytime = 0;
     unsigned int time = XbmcThreads::SystemClockMillis();
     int total = -1;
@@ -4397,6 +4583,8 @@ bool CMusicDatabase::GetAlbumsByWhere(const std::string &baseDir, const Filter &
 
   try
   {
+    CReadScope readScope(*this);
+
     unsigned int querytime = 0;
     unsigned int time = XbmcThreads::SystemClockMillis();
     int total = -1;
@@ -4519,6 +4707,8 @@ bool CMusicDatabase::GetSongsFullByWhere(const std::string &baseDir, const Filte
 
   try
   {
+    CReadScope readScope(*this);
+
     unsigned int time = XbmcThreads::SystemClockMillis();
     int total = -1;
 
@@ -4573,13 +4763,22 @@ bool CMusicDatabase::GetSongsFullByWhere(const std::string &baseDir, const Filte
     else
       strSQL = "SELECT songview.* FROM songview " + strSQLExtra;
 
+    // Avoid sorting with limits when have join with songartistview
+    // Limit when SortByNone already applied in SQL,
+    // apply sort later to fileitems list rather than dataset
+    sorting = sortDescription;
+    if (artistData && sortDescription.sortBy != SortByNone)
+      sorting.sortBy = SortByNone;
+    // Rows are used in the order returned unless sorting from the dataset, so
+    // stream them rather than hold the whole result set in memory
+    bool streamed = sorting.sortBy == SortByNone;
+
     CLog::Log(LOGDEBUG, "%s query = %s", __FUNCTION__, strSQL.c_str());
     // run query
-    if (!m_pDS->query(strSQL))
+    if (!(streamed ? m_pDS->query_stream(strSQL) : m_pDS->query(strSQL)))
       return false;
 
-    int iRowsFound = m_pDS->num_rows();
-    if (iRowsFound == 0)
+    if (m_pDS->eof())
     {
       m_pDS->close();
       return true;
@@ -4588,29 +4787,14 @@ bool CMusicDatabase::GetSongsFullByWhere(const std::string &baseDir, const Filte
     // Store the total number of songs as a property
     items.SetProperty("total", total);
 
-    DatabaseResults results;
-    results.reserve(iRowsFound);
-    // Avoid sorting with limits when have join with songartistview
-    // Limit when SortByNone already applied in SQL,
-    // apply sort later to fileitems list rather than dataset
-    sorting = sortDescription;
-    if (artistData && sortDescription.sortBy != SortByNone)
-      sorting.sortBy = SortByNone;
-    if (!SortUtils::SortFromDataset(sorting, MediaTypeSong, m_pDS, results))
-      return false;
-
     // Get songs from returned rows. If join songartistview then there is a row for every artist
     items.Reserve(total);
     int songArtistOffset = song_enumCount;
     int songId = -1;
     VECARTISTCREDITS artistCredits;
-    const dbiplus::query_data &data = m_pDS->get_result_set().records;
     int count = 0;
-    for (const auto &i : results)
+    auto addRecord = [&](const dbiplus::sql_record* const record)
     {
-      unsigned int targetRow = (unsigned int)i.at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
-
       try
       {
         if (songId != record->at(song_idSong).get_asInt())
@@ -4642,7 +4826,33 @@ bool CMusicDatabase::GetSongsFullByWhere(const std::string &baseDir, const Filte
       {
         m_pDS->close();
         CLog::Log(LOGERROR, "%s: out of memory loading query: %s", __FUNCTION__, filter.where.c_str());
-        return (items.Size() > 0);
+        return false;
+      }
+      return true;
+    };
+
+    if (streamed)
+    {
+      while (!m_pDS->eof())
+      {
+        if (!addRecord(m_pDS->get_sql_record()))
+          return (items.Size() > 0);
+        m_pDS->next();
+      }
+    }
+    else
+    {
+      DatabaseResults results;
+      results.reserve(m_pDS->num_rows());
+      if (!SortUtils::SortFromDataset(sorting, MediaTypeSong, m_pDS, results))
+        return false;
+
+      const dbiplus::query_data &data = m_pDS->get_result_set().records;
+      for (const auto &i : results)
+      {
+        unsigned int targetRow = (unsigned int)i.at(FieldRow).asInteger();
+        if (!addRecord(data.at(targetRow)))
+          return (items.Size() > 0);
       }
     }
     if (!artistCredits.empty())
@@ -4678,6 +4888,8 @@ bool CMusicDatabase::GetSongsByWhere(const std::string &baseDir, const Filter &f
 
   try
   {
+    CReadScope readScope(*this);
+
     int total = -1;
 
     std::string strSQL = "SELECT %s FROM songview ";
@@ -7431,7 +7643,7 @@ void CMusicDatabase::UpdateTables(int version)
 
 int CMusicDatabase::GetSchemaVersion() const
 {
-  return 72;
+  return 73;
 }
 
 int CMusicDatabase::GetMusicNeedsTagScan()
@@ -10423,20 +10635,25 @@ void CMusicDatabase::SetArtForItem(int mediaId, const std::string &mediaType, co
     if (artType.find('.') != std::string::npos)
       return;
 
-    std::string sql = PrepareSQL("SELECT art_id FROM art WHERE media_id=%i AND media_type='%s' AND type='%s'", mediaId, mediaType.c_str(), artType.c_str());
-    m_pDS->query(sql);
+    m_pDS->query_prepared("SELECT art_id FROM art WHERE media_id = ? AND media_type = ? AND type = ?",
+                          { dbiplus::field_value(mediaId),
+                            dbiplus::field_value(mediaType),
+                            dbiplus::field_value(artType) });
     if (!m_pDS->eof())
     { // update
       int artId = m_pDS->fv(0).get_asInt();
       m_pDS->close();
-      sql = PrepareSQL("UPDATE art SET url='%s' where art_id=%d", url.c_str(), artId);
-      m_pDS->exec(sql);
+      m_pDS->exec_prepared("UPDATE art SET url = ? where art_id = ?",
+                           { dbiplus::field_value(url), dbiplus::field_value(artId) });
     }
     else
     { // insert
       m_pDS->close();
-      sql = PrepareSQL("INSERT INTO art(media_id, media_type, type, url) VALUES (%d, '%s', '%s', '%s')", mediaId, mediaType.c_str(), artType.c_str(), url.c_str());
-      m_pDS->exec(sql);
+      m_pDS->exec_prepared("INSERT INTO art(media_id, media_type, type, url) VALUES (?, ?, ?, ?)",
+                           { dbiplus::field_value(mediaId),
+                             dbiplus::field_value(mediaType),
+                             dbiplus::field_value(artType),
+                             dbiplus::field_value(url) });
     }
   }
   catch (...)
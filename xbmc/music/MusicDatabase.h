@@ -106,6 +106,23 @@ public:
   bool Open() override;
   bool CommitTransaction() override;
   void EmptyCache();
+
+  /*! \brief Start adding albums in bulk, e.g. when scanning a large source for the first time.
+   Until EndBulkImport() is called, AddAlbum() commits once every albumsPerTransaction albums
+   instead of once per album, artist and role ids are cached in memory, and when the library is
+   empty the indices not needed while adding songs are dropped to be rebuilt once at the end.
+   \param albumsPerTransaction number of albums added per transaction, 1 commits every album.
+   \sa CommitBulkImport, EndBulkImport
+   */
+  void BeginBulkImport(unsigned int albumsPerTransaction);
+
+  /*! \brief Commit the albums added by a bulk import so far, e.g. before scraping them.
+   */
+  void CommitBulkImport();
+
+  /*! \brief Finish a bulk import, committing any pending albums and rebuilding deferred indices.
+   */
+  void EndBulkImport();
   void Clean();
   int  Cleanup(CGUIDialogProgress* progressDialog = nullptr);
   bool LookupCDDBInfo(bool bRequery=false);
@@ -632,6 +649,9 @@ void SetLibraryLastUpdated();
 protected:
   std::map<std::string, int> m_genreCache;
   std::map<std::string, int> m_pathCache;
+  std::map<std::string, int> m_artistCache;        ///< artist id by name and mbid, only during bulk import
+  std::map<int, std::string> m_artistSortNameCache; ///< sort name last applied to an artist, only during bulk import
+  std::map<std::string, int> m_roleCache;          ///< role id by name, only during bulk import
 
   void CreateTables() override;
   void CreateAnalytics() override;
@@ -647,6 +667,16 @@ private:
 
   void SplitPath(const std::string& strFileNameAndPath, std::string& strPath, std::string& strFileName);
 
+  /*! \brief Drop the indices that are not needed while adding albums and songs.
+   \return true if the indices were dropped and need to be restored.
+   \sa RestoreDeferredIndices
+   */
+  bool DeferIndices();
+
+  /*! \brief Recreate any index dropped by DeferIndices() that is missing.
+   */
+  void RestoreDeferredIndices();
+
   CSong GetSongFromDataset();
   CSong GetSongFromDataset(const dbiplus::sql_record* const record, int offset = 0);
   CArtist GetArtistFromDataset(dbiplus::Dataset* pDS, int offset = 0, bool needThumb = true);
@@ -721,6 +751,11 @@ private:
 
   bool m_translateBlankArtist;
 
+  bool m_bulkImport = false;
+  bool m_bulkIndicesDeferred = false;
+  unsigned int m_bulkAlbumsPerTransaction = 1;
+  unsigned int m_bulkAlbumsPending = 0;
+
   // Fields should be ordered as they
   // appear in the songview
   static enum _SongFields
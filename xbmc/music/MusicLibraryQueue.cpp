@@ -197,6 +197,11 @@ void CMusicLibraryQueue::CleanLibrary(bool showDialog /* = false */)
     progress->Wait(20);
 }
 
+void CMusicLibraryQueue::CleanLibrary(const std::set<std::string>& paths)
+{
+  AddJob(new CMusicLibraryCleaningJob(paths));
+}
+
 void CMusicLibraryQueue::CleanLibraryModal()
 {
   // We can't perform a modal library cleaning if other jobs are running
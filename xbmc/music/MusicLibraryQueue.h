@@ -89,6 +89,12 @@ public:
    */
   void CleanLibrary(bool showDialog = false);
 
+  /*!
+   \brief Enqueue an asynchronous cleaning job for folders that have been removed.
+   \param[in] paths Folders whose songs, and those of their subfolders, are removed from the library
+   */
+  void CleanLibrary(const std::set<std::string>& paths);
+
   /*!
    \brief Executes a library cleaning with a modal dialog.
    However UI rendering of dialog is on same thread as the cleaning process, so mouse movement
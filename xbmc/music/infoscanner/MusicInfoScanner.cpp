@@ -46,10 +46,13 @@
 #include "settings/Settings.h"
 #include "settings/SettingsComponent.h"
 #include "TextureCache.h"
+#include "threads/Condition.h"
+#include "threads/SingleLock.h"
 #include "threads/SystemClock.h"
 #include "Util.h"
 #include "utils/Digest.h"
 #include "utils/FileExtensionProvider.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
@@ -62,6 +65,80 @@ using namespace MUSIC_GRABBER;
 using namespace ADDON;
 using KODI::UTILITY::CDigest;
 
+namespace
+{
+/*!
+ \brief Job reading the tags of a music file into its music info tag.
+ */
+class CTagReadJob : public CJob
+{
+public:
+  explicit CTagReadJob(const CFileItemPtr& item) : m_item(item) {}
+
+  bool DoWork() override
+  {
+    std::unique_ptr<IMusicInfoTagLoader> pLoader(CMusicInfoTagLoaderFactory::CreateLoader(*m_item));
+    if (pLoader)
+      pLoader->Load(m_item->GetPath(), *m_item->GetMusicInfoTag());
+    return true;
+  }
+
+  const char* GetType() const override { return "musictagreader"; }
+
+  const CFileItem* GetItem() const { return m_item.get(); }
+
+private:
+  CFileItemPtr m_item;
+};
+
+/*!
+ \brief Runs a bounded number of CTagReadJob at once and keeps track of the items read.
+ */
+class CTagReadQueue : public CJobQueue
+{
+public:
+  explicit CTagReadQueue(unsigned int readers) : CJobQueue(false, readers, CJob::PRIORITY_DEDICATED) {}
+
+  ~CTagReadQueue() override
+  {
+    // make sure no job calls back once our members are gone
+    CancelJobs();
+  }
+
+  void Read(const CFileItemPtr& item)
+  {
+    AddJob(new CTagReadJob(item));
+  }
+
+  /*!
+   \brief Wait for the tags of an item to be read.
+   \return true if the item has been read, false on timeout.
+   */
+  bool WaitForItem(const CFileItem* item, unsigned int milliseconds)
+  {
+    CSingleLock lock(m_readSection);
+    if (m_read.find(item) == m_read.end())
+      m_itemRead.wait(lock, milliseconds);
+    return m_read.find(item) != m_read.end();
+  }
+
+  void OnJobComplete(unsigned int jobID, bool success, CJob* job) override
+  {
+    {
+      CSingleLock lock(m_readSection);
+      m_read.insert(static_cast<CTagReadJob*>(job)->GetItem());
+      m_itemRead.notifyAll();
+    }
+    CJobQueue::OnJobComplete(jobID, success, job);
+  }
+
+private:
+  CCriticalSection m_readSection;
+  XbmcThreads::ConditionVariable m_itemRead;
+  std::set<const CFileItem*> m_read;
+};
+}
+
 CMusicInfoScanner::CMusicInfoScanner()
 : m_fileCountReader(this, "MusicFileCounter")
 {
@@ -122,6 +199,11 @@ void CMusicInfoScanner::Process()
       m_bCanInterrupt = false;
       m_needsCleanup = false;
 
+      // Add albums to the library in batches rather than one transaction each
+      const int importBatchSize = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_iMusicLibraryImportBatchSize;
+      if (importBatchSize > 0)
+        m_musicDatabase.BeginBulkImport(importBatchSize);
+
       bool commit = true;
       for (std::set<std::string>::const_iterator it = m_pathsToScan.begin(); it != m_pathsToScan.end(); ++it)
       {
@@ -141,6 +223,7 @@ void CMusicInfoScanner::Process()
         // Clear list of albums added by this scan
         m_albumsAdded.clear();
         bool scancomplete = DoScan(*it);
+        m_musicDatabase.CommitBulkImport();
         if (scancomplete)
         {
           if (m_albumsAdded.size() > 0)
@@ -162,6 +245,8 @@ void CMusicInfoScanner::Process()
         }
       }
 
+      m_musicDatabase.EndBulkImport();
+
       if (commit)
       {
         CServiceBroker::GetGUI()->GetInfoManager().GetInfoProviders().GetLibraryInfoProvider().ResetLibraryBools();
@@ -262,6 +347,7 @@ void CMusicInfoScanner::Process()
   {
     CLog::Log(LOGERROR, "MusicInfoScanner: Exception while scanning.");
   }
+  m_musicDatabase.EndBulkImport();
   m_musicDatabase.Close();
   CLog::Log(LOGDEBUG, "%s - Finished scan", __FUNCTION__);
 
@@ -554,11 +640,9 @@ CInfoScanner::INFO_RET CMusicInfoScanner::ScanTags(const CFileItemList& items,
 {
   std::vector<std::string> regexps = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_audioExcludeFromScanRegExps;
 
+  std::vector<CFileItemPtr> files;
   for (int i = 0; i < items.Size(); ++i)
   {
-    if (m_bStop)
-      return INFO_CANCELLED;
-
     CFileItemPtr pItem = items[i];
 
     if (CUtil::ExcludeFileOrFolder(pItem->GetPath(), regexps))
@@ -567,10 +651,46 @@ CInfoScanner::INFO_RET CMusicInfoScanner::ScanTags(const CFileItemList& items,
     if (pItem->m_bIsFolder || pItem->IsPlayList() || pItem->IsPicture() || pItem->IsLyrics())
       continue;
 
+    files.push_back(pItem);
+  }
+
+  // Reading tags is mostly waiting on the file system, so read several files at once.
+  // The results are still processed in order on this thread, which does all database writes.
+  std::unique_ptr<CTagReadQueue> readQueue;
+  std::vector<bool> queued(files.size(), false);
+  const int tagReaders = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_iMusicLibraryTagReaders;
+  if (tagReaders > 1 && files.size() > 1)
+  {
+    readQueue.reset(new CTagReadQueue(tagReaders));
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+      if (!files[i]->GetMusicInfoTag()->Loaded())
+      {
+        readQueue->Read(files[i]);
+        queued[i] = true;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < files.size(); ++i)
+  {
+    if (m_bStop)
+      return INFO_CANCELLED;
+
+    CFileItemPtr pItem = files[i];
+    if (queued[i])
+    {
+      while (!readQueue->WaitForItem(pItem.get(), 100))
+      {
+        if (m_bStop)
+          return INFO_CANCELLED;
+      }
+    }
+
     m_currentItem++;
 
     CMusicInfoTag& tag = *pItem->GetMusicInfoTag();
-    if (!tag.Loaded())
+    if (!tag.Loaded() && !queued[i])
     {
       std::unique_ptr<IMusicInfoTagLoader> pLoader (CMusicInfoTagLoaderFactory::CreateLoader(*pItem));
       if (NULL != pLoader.get())
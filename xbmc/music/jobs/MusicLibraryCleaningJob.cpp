@@ -18,6 +18,11 @@ CMusicLibraryCleaningJob::CMusicLibraryCleaningJob(CGUIDialogProgress* progressD
   SetAutoClose(true);
 }
 
+CMusicLibraryCleaningJob::CMusicLibraryCleaningJob(const std::set<std::string>& paths)
+  : CMusicLibraryProgressJob(nullptr),
+    m_paths(paths)
+{ }
+
 CMusicLibraryCleaningJob::~CMusicLibraryCleaningJob() = default;
 
 bool CMusicLibraryCleaningJob::operator==(const CJob* job) const
@@ -29,11 +34,22 @@ bool CMusicLibraryCleaningJob::operator==(const CJob* job) const
   if (cleaningJob == nullptr)
     return false;
 
-  return true;
+  return m_paths == cleaningJob->m_paths;
 }
 
 bool CMusicLibraryCleaningJob::Work(CMusicDatabase &db)
 {
-  db.Cleanup(GetProgressDialog());
+  if (m_paths.empty())
+  {
+    db.Cleanup(GetProgressDialog());
+    return true;
+  }
+
+  for (const auto& path : m_paths)
+  {
+    MAPSONGS songs;
+    db.RemoveSongsFromPath(path, songs, false);
+  }
+  db.CleanupOrphanedItems();
   return true;
 }
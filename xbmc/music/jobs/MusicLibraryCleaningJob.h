@@ -9,6 +9,7 @@
 #pragma once
 
 #include <set>
+#include <string>
 
 #include "music/jobs/MusicLibraryProgressJob.h"
 
@@ -23,6 +24,11 @@ public:
    \param[in] progressDialog Progress dialog to be used to display the cleaning progress
   */
   CMusicLibraryCleaningJob(CGUIDialogProgress* progressDialog);
+  /*!
+   \brief Creates a new music library cleaning job for removed folders.
+   \param[in] paths Folders whose songs, and those of their subfolders, are removed from the library
+  */
+  CMusicLibraryCleaningJob(const std::set<std::string>& paths);
   ~CMusicLibraryCleaningJob() override;
 
   // specialization of CJob
@@ -34,5 +40,5 @@ protected:
   bool Work(CMusicDatabase &db) override;
 
 private:
-
+  std::set<std::string> m_paths;
 };
@@ -21,14 +21,19 @@
 #include "network/WebServer.h"
 #include "network/httprequesthandler/HTTPVfsHandler.h"
 #include "network/httprequesthandler/HTTPJsonRpcHandler.h"
+#include "ServiceBroker.h"
+#include "settings/AdvancedSettings.h"
 #include "settings/MediaSourceSettings.h"
+#include "settings/SettingsComponent.h"
 #include "test/TestUtils.h"
 #include "utils/JSONVariantParser.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
 #include "utils/Variant.h"
 
+#include <algorithm>
 #include <random>
+#include <vector>
 
 using namespace XFILE;
 
@@ -64,6 +69,7 @@ protected:
 protected:
   void SetUp() override
   {
+    m_curlParallelConnections = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_curlParallelConnections;
     SetupMediaSources();
 
     webserver.Start(webserverPort, "", "");
@@ -80,14 +86,22 @@ protected:
     webserver.UnregisterRequestHandler(&m_jsonRpcHandler);
 
     TearDownMediaSources();
+
+    // tests may change the number of connections
+    CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_curlParallelConnections = m_curlParallelConnections;
   }
 
   void SetupMediaSources()
+  {
+    AddMediaSource("WebServer Share", sourcePath);
+  }
+
+  void AddMediaSource(const std::string& name, const std::string& path)
   {
     CMediaSource source;
-    source.strName = "WebServer Share";
-    source.strPath = sourcePath;
-    source.vecPaths.push_back(sourcePath);
+    source.strName = name;
+    source.strPath = path;
+    source.vecPaths.push_back(path);
     source.m_allowSharing = true;
     source.m_iDriveType = CMediaSource::SOURCE_TYPE_LOCAL;
     source.m_iLockMode = LOCK_MODE_EVERYONE;
@@ -114,7 +128,11 @@ protected:
     if (testFile.empty())
       return "";
 
-    std::string path = URIUtils::AddFileToFolder(sourcePath, testFile);
+    return GetUrlOfFile(URIUtils::AddFileToFolder(sourcePath, testFile));
+  }
+
+  std::string GetUrlOfFile(std::string path)
+  {
     path = CURL::Encode(path);
     path = URIUtils::AddFileToFolder("vfs", path);
 
@@ -345,6 +363,7 @@ protected:
   std::string baseUrl;
   std::string sourcePath;
   uint16_t webserverPort;
+  unsigned int m_curlParallelConnections = 1;
 };
 
 TEST_F(TestWebServer, IsStarted)
@@ -897,3 +916,59 @@ TEST_F(TestWebServer, CanGetCachedRangedFileWithNewerIfRange)
   ASSERT_TRUE(curl.Get(GetUrlOfTestFile(TEST_FILES_RANGES), result));
   CheckRangesTestFileResponse(curl, result, ranges);
 }
+
+TEST_F(TestWebServer, CanReadLargeFileOverParallelConnections)
+{
+  // a file of more than four ranges of 2 MiB, the last one incomplete
+  const size_t fileSize = 9 * 1024 * 1024 + 123;
+  std::vector<char> content(fileSize);
+  for (size_t i = 0; i < fileSize; i++)
+    content[i] = static_cast<char>(i * 7 + i / 4096);
+
+  XFILE::CFile* file = XBMC_CREATETEMPFILE(".bin");
+  ASSERT_NE(nullptr, file);
+  ASSERT_EQ(static_cast<ssize_t>(fileSize), file->Write(content.data(), fileSize));
+  file->Close();
+
+  const std::string path = CXBMCTestUtils::Instance().TempFilePath(file);
+  AddMediaSource("WebServer Parallel", CXBMCTestUtils::Instance().TempFileDirectory(file));
+
+  CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_curlParallelConnections = 3;
+
+  {
+    CCurlFile curl;
+    ASSERT_TRUE(curl.Open(CURL(GetUrlOfFile(path))));
+    EXPECT_EQ(static_cast<int64_t>(fileSize), curl.GetLength());
+    ASSERT_TRUE(curl.IsReadingInParallel());
+
+    // the ranges arrive in any order and are joined in file order, also
+    // across reads that don't line up with the ranges
+    std::vector<char> result(fileSize);
+    size_t read = 0;
+    while (read < fileSize)
+    {
+      const ssize_t chunk = curl.Read(result.data() + read, std::min<size_t>(100000, fileSize - read));
+      ASSERT_GT(chunk, 0);
+      read += chunk;
+    }
+    EXPECT_EQ(0, curl.Read(result.data(), 1));
+    EXPECT_TRUE(content == result);
+
+    // seek backwards into the middle of a range
+    const int64_t position = 3 * 1024 * 1024 + 17;
+    ASSERT_EQ(position, curl.Seek(position, SEEK_SET));
+    std::vector<char> part(4 * 1024 * 1024);
+    read = 0;
+    while (read < part.size())
+    {
+      const ssize_t chunk = curl.Read(part.data() + read, part.size() - read);
+      ASSERT_GT(chunk, 0);
+      read += chunk;
+    }
+    EXPECT_TRUE(std::equal(part.begin(), part.end(), content.begin() + position));
+
+    curl.Close();
+  }
+
+  XBMC_DELETETEMPFILE(file);
+}
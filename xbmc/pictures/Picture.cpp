@@ -9,6 +9,7 @@
 #include <algorithm>
 
 #include "Picture.h"
+#include "PictureConverter.h"
 #include "URL.h"
 #include "ServiceBroker.h"
 #include "settings/AdvancedSettings.h"
@@ -24,10 +25,6 @@
 #include "cores/omxplayer/OMXImage.h"
 #endif
 
-extern "C" {
-#include <libswscale/swscale.h>
-}
-
 using namespace XFILE;
 
 bool CPicture::GetThumbnailFromSurface(const unsigned char* buffer, int width, int height, int stride, const std::string &thumbFile, uint8_t* &result, size_t& result_size)
@@ -335,22 +332,21 @@ bool CPicture::ScaleImage(uint8_t *in_pixels, unsigned int in_width, unsigned in
                           uint8_t *out_pixels, unsigned int out_width, unsigned int out_height, unsigned int out_pitch,
                           CPictureScalingAlgorithm::Algorithm scalingAlgorithm /* = CPictureScalingAlgorithm::NoAlgorithm */)
 {
-  struct SwsContext *context = sws_getContext(in_width, in_height, AV_PIX_FMT_BGRA,
-                                                         out_width, out_height, AV_PIX_FMT_BGRA,
-                                                         CPictureScalingAlgorithm::ToSwscale(scalingAlgorithm), NULL, NULL, NULL);
-
-  uint8_t *src[] = { in_pixels, 0, 0, 0 };
-  int     srcStride[] = { (int)in_pitch, 0, 0, 0 };
-  uint8_t *dst[] = { out_pixels , 0, 0, 0 };
-  int     dstStride[] = { (int)out_pitch, 0, 0, 0 };
-
-  if (context)
-  {
-    sws_scale(context, src, srcStride, 0, in_height, dst, dstStride);
-    sws_freeContext(context);
-    return true;
-  }
-  return false;
+  SPictureBuffer src;
+  src.format = AV_PIX_FMT_BGRA;
+  src.width = in_width;
+  src.height = in_height;
+  src.planes[0] = in_pixels;
+  src.strides[0] = in_pitch;
+
+  SPictureBuffer dst;
+  dst.format = AV_PIX_FMT_BGRA;
+  dst.width = out_width;
+  dst.height = out_height;
+  dst.planes[0] = out_pixels;
+  dst.strides[0] = out_pitch;
+
+  return CPictureConverter::GetInstance().Convert(src, dst, CPictureScalingAlgorithm::ToSwscale(scalingAlgorithm));
 }
 
 bool CPicture::OrientateImage(uint32_t *&pixels, unsigned int &width, unsigned int &height, int orientation)
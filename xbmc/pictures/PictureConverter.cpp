@@ -0,0 +1,260 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "PictureConverter.h"
+
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+#include "utils/CPUInfo.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+namespace
+{
+
+// every picture size and band needs its own context
+const size_t MAX_CONTEXTS = 32;
+
+// smaller pictures are converted faster than threads are started
+const int64_t MIN_BAND_PIXELS = 512 * 1024;
+const int MIN_BAND_ROWS = 16;
+const int MAX_BANDS = 8;
+
+// avx2 code of swscale wants 32 bytes
+const int SIMD_ALIGN = 32;
+
+} // unnamed namespace
+
+struct CPictureConverter::SBands
+{
+  std::vector<std::pair<SPictureBuffer, SPictureBuffer>> bands; ///< source and destination
+  int flags = 0;
+  std::atomic<size_t> next{0};
+  std::atomic<size_t> converted{0};
+  std::atomic<bool> failed{false};
+  CEvent done;
+};
+
+bool CPictureConverter::SKey::operator==(const SKey& other) const
+{
+  return srcFormat == other.srcFormat &&
+         srcWidth == other.srcWidth &&
+         srcHeight == other.srcHeight &&
+         srcFullRange == other.srcFullRange &&
+         dstFormat == other.dstFormat &&
+         dstWidth == other.dstWidth &&
+         dstHeight == other.dstHeight &&
+         dstFullRange == other.dstFullRange &&
+         flags == other.flags;
+}
+
+CPictureConverter::CPictureConverter()
+  : m_workers(false, std::max(std::min(g_cpuInfo.getCPUCount(), MAX_BANDS) - 1, 1), CJob::PRIORITY_DEDICATED)
+{
+  // the queue cancels its jobs on destruction, the job manager has to
+  // outlive it
+  CJobManager::GetInstance();
+}
+
+CPictureConverter& CPictureConverter::GetInstance()
+{
+  static CPictureConverter converter;
+  return converter;
+}
+
+CPictureConverter::~CPictureConverter()
+{
+  for (auto& context : m_contexts)
+    sws_freeContext(context.second);
+}
+
+int CPictureConverter::GetAlignedStride(AVPixelFormat format, int width)
+{
+  const int stride = av_image_get_linesize(format, width, 0);
+  if (stride < 0)
+    return stride;
+
+  return (stride + SIMD_ALIGN - 1) & ~(SIMD_ALIGN - 1);
+}
+
+bool CPictureConverter::Convert(const SPictureBuffer& src, const SPictureBuffer& dst, int flags)
+{
+  if (src.width <= 0 || src.height <= 0 || dst.width <= 0 || dst.height <= 0)
+    return false;
+
+  const int bandCount = GetBandCount(src, dst, flags);
+  if (bandCount == 1)
+    return ConvertBand(src, dst, flags);
+
+  // bands start on a full chroma row
+  const int srcAlign = 1 << av_pix_fmt_desc_get(src.format)->log2_chroma_h;
+  const int dstAlign = 1 << av_pix_fmt_desc_get(dst.format)->log2_chroma_h;
+
+  // workers that start after the calling thread took the last band find
+  // nothing to do, the bands are kept alive for them
+  auto bands = std::make_shared<SBands>();
+  bands->flags = flags;
+  int srcBegin = 0;
+  int dstBegin = 0;
+  for (int i = 0; i < bandCount; i++)
+  {
+    int srcEnd = src.height;
+    int dstEnd = dst.height;
+    if (i < bandCount - 1)
+    {
+      dstEnd = dst.height * (i + 1) / bandCount / dstAlign * dstAlign;
+      srcEnd = static_cast<int>(static_cast<int64_t>(dstEnd) * src.height / dst.height) / srcAlign * srcAlign;
+    }
+    bands->bands.emplace_back(GetBand(src, srcBegin, srcEnd), GetBand(dst, dstBegin, dstEnd));
+    srcBegin = srcEnd;
+    dstBegin = dstEnd;
+  }
+
+  for (int i = 1; i < bandCount; i++)
+    m_workers.Submit([this, bands]() { ConvertBands(*bands); });
+  ConvertBands(*bands);
+  bands->done.Wait();
+
+  return !bands->failed;
+}
+
+void CPictureConverter::ConvertBands(SBands& bands)
+{
+  for (size_t i = bands.next++; i < bands.bands.size(); i = bands.next++)
+  {
+    if (!ConvertBand(bands.bands[i].first, bands.bands[i].second, bands.flags))
+      bands.failed = true;
+    if (++bands.converted == bands.bands.size())
+      bands.done.Set();
+  }
+}
+
+void CPictureConverter::SetMaxBands(int maxBands)
+{
+  m_maxBands = maxBands;
+}
+
+int CPictureConverter::GetBandCount(const SPictureBuffer& src, const SPictureBuffer& dst, int flags) const
+{
+  const AVPixFmtDescriptor* srcDesc = av_pix_fmt_desc_get(src.format);
+  const AVPixFmtDescriptor* dstDesc = av_pix_fmt_desc_get(dst.format);
+  if (!srcDesc || !dstDesc ||
+      (srcDesc->flags & AV_PIX_FMT_FLAG_HWACCEL) || (dstDesc->flags & AV_PIX_FMT_FLAG_HWACCEL))
+    return 1;
+
+  // bands are scaled on their own, the rows at the borders and the chroma
+  // of subsampled formats are filtered from the rows of their band only.
+  // That's invisible for filters with a short reach.
+  if (src.height != dst.height && !(flags & (SWS_FAST_BILINEAR | SWS_POINT)))
+    return 1;
+
+  int bands = static_cast<int>(std::min<int64_t>(static_cast<int64_t>(src.width) * src.height / MIN_BAND_PIXELS, MAX_BANDS));
+  bands = std::min(bands, m_maxBands > 0 ? m_maxBands : g_cpuInfo.getCPUCount());
+  bands = std::min(bands, std::min(src.height, dst.height) / MIN_BAND_ROWS);
+  return std::max(bands, 1);
+}
+
+SPictureBuffer CPictureConverter::GetBand(const SPictureBuffer& picture, int begin, int end)
+{
+  const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(picture.format);
+
+  SPictureBuffer band = picture;
+  band.height = end - begin;
+
+  // a palette in the second plane stays where it is
+  const int planes = av_pix_fmt_count_planes(picture.format);
+  for (int i = 0; i < planes; i++)
+  {
+    const int rows = (i == 1 || i == 2) ? begin >> desc->log2_chroma_h : begin;
+    band.planes[i] += static_cast<ptrdiff_t>(rows) * picture.strides[i];
+  }
+  return band;
+}
+
+bool CPictureConverter::ConvertBand(const SPictureBuffer& src, const SPictureBuffer& dst, int flags)
+{
+  const SKey key = { src.format, src.width, src.height, src.fullRange,
+                     dst.format, dst.width, dst.height, dst.fullRange,
+                     flags };
+
+  SwsContext* context = Acquire(key);
+  if (!context)
+    return false;
+
+  const int ret = sws_scale(context, src.planes, src.strides, 0, src.height, dst.planes, dst.strides);
+
+  Release(key, context);
+  return ret > 0;
+}
+
+SwsContext* CPictureConverter::Acquire(const SKey& key)
+{
+  {
+    CSingleLock lock(m_critSection);
+    for (auto it = m_contexts.begin(); it != m_contexts.end(); ++it)
+    {
+      if (it->first == key)
+      {
+        SwsContext* context = it->second;
+        m_contexts.erase(it);
+        return context;
+      }
+    }
+  }
+
+  SwsContext* context = sws_getContext(key.srcWidth, key.srcHeight, key.srcFormat,
+                                       key.dstWidth, key.dstHeight, key.dstFormat,
+                                       key.flags, nullptr, nullptr, nullptr);
+  if (!context)
+  {
+    CLog::Log(LOGERROR, "CPictureConverter::%s - unable to convert %s %dx%d to %s %dx%d", __FUNCTION__,
+              av_get_pix_fmt_name(key.srcFormat), key.srcWidth, key.srcHeight,
+              av_get_pix_fmt_name(key.dstFormat), key.dstWidth, key.dstHeight);
+    return nullptr;
+  }
+
+  if (key.srcFullRange || key.dstFullRange)
+  {
+    int* invTable = nullptr;
+    int* table = nullptr;
+    int srcRange, dstRange, brightness, contrast, saturation;
+    if (sws_getColorspaceDetails(context, &invTable, &srcRange, &table, &dstRange, &brightness, &contrast, &saturation) >= 0)
+    {
+      if (key.srcFullRange)
+        srcRange = 1;
+      if (key.dstFullRange)
+        dstRange = 1;
+      sws_setColorspaceDetails(context, invTable, srcRange, table, dstRange, brightness, contrast, saturation);
+    }
+  }
+
+  return context;
+}
+
+void CPictureConverter::Release(const SKey& key, SwsContext* context)
+{
+  CSingleLock lock(m_critSection);
+
+  m_contexts.emplace_front(key, context);
+  if (m_contexts.size() > MAX_CONTEXTS)
+  {
+    sws_freeContext(m_contexts.back().second);
+    m_contexts.pop_back();
+  }
+}
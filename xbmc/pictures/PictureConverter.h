@@ -0,0 +1,111 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#pragma once
+
+#include "threads/CriticalSection.h"
+#include "utils/JobManager.h"
+
+#include <list>
+#include <stdint.h>
+#include <utility>
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+}
+
+struct SwsContext;
+
+/*!
+ \brief A picture in memory, the planes aren't owned.
+ */
+struct SPictureBuffer
+{
+  AVPixelFormat format = AV_PIX_FMT_NONE;
+  int width = 0;
+  int height = 0;
+  uint8_t* planes[4] = {};
+  int strides[4] = {};
+  bool fullRange = false; ///< yuv with jpeg range, ignored for rgb
+};
+
+/*!
+ \brief Converts and scales pictures with swscale for the software paths
+ like thumbnail extraction and image decoding.
+
+ Scaler contexts are expensive to set up and are kept for the next picture
+ of the same geometry. Large pictures are split into horizontal bands that
+ are converted in parallel, each band with its own context. The bands of all
+ pictures share a small pool of workers, the calling thread converts the
+ bands no worker took.
+
+ swscale picks its SSE2/SSSE3/AVX2 or NEON code at runtime, but only for
+ buffers with 16 byte aligned planes and strides. Use GetAlignedStride() for
+ the destination.
+ */
+class CPictureConverter
+{
+public:
+  static CPictureConverter& GetInstance();
+
+  /*!
+   \brief Converts src into dst, scaling to the size of dst.
+   \param flags swscale flags, e.g. SWS_FAST_BILINEAR
+   */
+  bool Convert(const SPictureBuffer& src, const SPictureBuffer& dst, int flags);
+
+  /*!
+   \brief Stride of the first plane that lets swscale use its simd code.
+   */
+  static int GetAlignedStride(AVPixelFormat format, int width);
+
+  /*!
+   \brief Number of bands Convert() splits the picture into.
+   */
+  int GetBandCount(const SPictureBuffer& src, const SPictureBuffer& dst, int flags) const;
+
+  /*!
+   \brief Limits the bands of a picture, 0 for one per core.
+   */
+  void SetMaxBands(int maxBands);
+
+  ~CPictureConverter();
+
+private:
+  struct SKey
+  {
+    AVPixelFormat srcFormat;
+    int srcWidth;
+    int srcHeight;
+    bool srcFullRange;
+    AVPixelFormat dstFormat;
+    int dstWidth;
+    int dstHeight;
+    bool dstFullRange;
+    int flags;
+
+    bool operator==(const SKey& other) const;
+  };
+
+  struct SBands;
+
+  CPictureConverter();
+  CPictureConverter(const CPictureConverter&) = delete;
+  CPictureConverter& operator=(const CPictureConverter&) = delete;
+
+  static SPictureBuffer GetBand(const SPictureBuffer& picture, int begin, int end);
+  void ConvertBands(SBands& bands);
+  bool ConvertBand(const SPictureBuffer& src, const SPictureBuffer& dst, int flags);
+  SwsContext* Acquire(const SKey& key);
+  void Release(const SKey& key, SwsContext* context);
+
+  CCriticalSection m_critSection;
+  std::list<std::pair<SKey, SwsContext*>> m_contexts; ///< idle contexts, most recently used first
+  int m_maxBands = 0;
+  CJobQueue m_workers;
+};
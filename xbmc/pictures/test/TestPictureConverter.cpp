@@ -0,0 +1,215 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "pictures/PictureConverter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include <libavutil/common.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+namespace
+{
+
+/*!
+ \brief A picture with its own memory, filled with a pattern.
+ */
+class CTestPicture
+{
+public:
+  CTestPicture(AVPixelFormat format, int width, int height)
+  {
+    m_picture.format = format;
+    m_picture.width = width;
+    m_picture.height = height;
+
+    const int size = av_image_get_buffer_size(format, width, height, 32);
+    m_buffer.resize(size + 32);
+    uint8_t* data = m_buffer.data() + (32 - reinterpret_cast<uintptr_t>(m_buffer.data()) % 32);
+    av_image_fill_arrays(m_picture.planes, m_picture.strides, data, format, width, height, 32);
+
+    // smooth gradients, like real pictures
+    const int planes = av_pix_fmt_count_planes(format);
+    for (int i = 0; i < planes; i++)
+    {
+      const int rows = (i == 0) ? height : AV_CEIL_RSHIFT(height, av_pix_fmt_desc_get(format)->log2_chroma_h);
+      for (int y = 0; y < rows; y++)
+      {
+        for (int x = 0; x < m_picture.strides[i]; x++)
+          m_picture.planes[i][y * m_picture.strides[i] + x] = static_cast<uint8_t>(x / 4 + y / 2 + i * 64);
+      }
+    }
+  }
+
+  const SPictureBuffer& Get() const { return m_picture; }
+
+  /*!
+   \brief Largest difference of the bytes of the first plane.
+   */
+  int GetMaxDifference(const CTestPicture& other) const
+  {
+    const int stride = av_image_get_linesize(m_picture.format, m_picture.width, 0);
+    int difference = 0;
+    for (int y = 0; y < m_picture.height; y++)
+    {
+      const uint8_t* row = m_picture.planes[0] + y * m_picture.strides[0];
+      const uint8_t* otherRow = other.m_picture.planes[0] + y * other.m_picture.strides[0];
+      for (int x = 0; x < stride; x++)
+        difference = std::max(difference, std::abs(row[x] - otherRow[x]));
+    }
+    return difference;
+  }
+
+private:
+  SPictureBuffer m_picture;
+  std::vector<uint8_t> m_buffer;
+};
+
+/*!
+ \brief The way pictures were converted before, a new context every time.
+ */
+bool ConvertDirect(const SPictureBuffer& src, const SPictureBuffer& dst, int flags)
+{
+  SwsContext* context = sws_getContext(src.width, src.height, src.format,
+                                       dst.width, dst.height, dst.format,
+                                       flags, nullptr, nullptr, nullptr);
+  if (!context)
+    return false;
+
+  sws_scale(context, src.planes, src.strides, 0, src.height, dst.planes, dst.strides);
+  sws_freeContext(context);
+  return true;
+}
+
+void ExpectSameAsDirect(AVPixelFormat format,
+                        int srcWidth = 1920, int srcHeight = 1080,
+                        int dstWidth = 1920, int dstHeight = 1080,
+                        int tolerance = 4)
+{
+  CTestPicture src(format, srcWidth, srcHeight);
+  CTestPicture direct(AV_PIX_FMT_BGRA, dstWidth, dstHeight);
+  CTestPicture converted(AV_PIX_FMT_BGRA, dstWidth, dstHeight);
+
+  ASSERT_GT(CPictureConverter::GetInstance().GetBandCount(src.Get(), converted.Get(), SWS_FAST_BILINEAR), 1);
+  ASSERT_TRUE(ConvertDirect(src.Get(), direct.Get(), SWS_FAST_BILINEAR));
+  ASSERT_TRUE(CPictureConverter::GetInstance().Convert(src.Get(), converted.Get(), SWS_FAST_BILINEAR));
+
+  // the bands meet without seams, chroma rows at the borders are
+  // interpolated from their band only
+  EXPECT_LE(direct.GetMaxDifference(converted), tolerance);
+}
+
+double MeasureMs(AVPixelFormat format, bool direct, int count)
+{
+  CTestPicture src(format, 3840, 2160);
+  CTestPicture dst(AV_PIX_FMT_BGRA, 1280, 720);
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; i++)
+  {
+    if (direct)
+      ConvertDirect(src.Get(), dst.Get(), SWS_FAST_BILINEAR);
+    else
+      CPictureConverter::GetInstance().Convert(src.Get(), dst.Get(), SWS_FAST_BILINEAR);
+  }
+  const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / count;
+}
+
+} // unnamed namespace
+
+/*!
+ The pictures are split into bands whatever the number of cores of the
+ machine running the tests.
+ */
+class TestPictureConverter : public ::testing::Test
+{
+protected:
+  void SetUp() override { CPictureConverter::GetInstance().SetMaxBands(4); }
+  void TearDown() override { CPictureConverter::GetInstance().SetMaxBands(0); }
+};
+
+TEST_F(TestPictureConverter, YUV420P)
+{
+  ExpectSameAsDirect(AV_PIX_FMT_YUV420P);
+}
+
+TEST_F(TestPictureConverter, NV12)
+{
+  ExpectSameAsDirect(AV_PIX_FMT_NV12);
+}
+
+TEST_F(TestPictureConverter, P010)
+{
+  ExpectSameAsDirect(AV_PIX_FMT_P010);
+}
+
+TEST_F(TestPictureConverter, ScaleSameAsDirect)
+{
+  // the thumbnail case: each band is scaled on its own, rows at the borders
+  // are filtered from the source rows of their band only
+  ExpectSameAsDirect(AV_PIX_FMT_YUV420P, 3840, 2160, 1280, 720, 8);
+}
+
+TEST_F(TestPictureConverter, Scale)
+{
+  CTestPicture src(AV_PIX_FMT_YUV420P, 3840, 2160);
+  CTestPicture dst(AV_PIX_FMT_BGRA, 320, 180);
+  EXPECT_TRUE(CPictureConverter::GetInstance().Convert(src.Get(), dst.Get(), SWS_FAST_BILINEAR));
+  EXPECT_TRUE(CPictureConverter::GetInstance().Convert(src.Get(), dst.Get(), SWS_BICUBIC));
+
+  SPictureBuffer empty = dst.Get();
+  empty.height = 0;
+  EXPECT_FALSE(CPictureConverter::GetInstance().Convert(src.Get(), empty, SWS_BICUBIC));
+}
+
+TEST_F(TestPictureConverter, ConcurrentPictures)
+{
+  // more bands than workers, the calling threads convert what's left
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++)
+    threads.emplace_back([]() { ExpectSameAsDirect(AV_PIX_FMT_YUV420P, 3840, 2160, 1280, 720, 8); });
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+TEST_F(TestPictureConverter, AlignedStride)
+{
+  EXPECT_EQ(1280 * 4, CPictureConverter::GetAlignedStride(AV_PIX_FMT_BGRA, 1280));
+  EXPECT_EQ(328 * 4, CPictureConverter::GetAlignedStride(AV_PIX_FMT_BGRA, 321));
+}
+
+/*!
+ Compares the thumbnail conversion of a 4k frame with a context per call.
+ Run it with --gtest_also_run_disabled_tests --gtest_filter=TestPictureConverter.*
+ */
+TEST_F(TestPictureConverter, DISABLED_Throughput)
+{
+  const int count = 50;
+  CPictureConverter::GetInstance().SetMaxBands(0);
+
+  for (AVPixelFormat format : { AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12, AV_PIX_FMT_P010 })
+  {
+    const double directMs = MeasureMs(format, true, count);
+    const double convertedMs = MeasureMs(format, false, count);
+
+    std::cout << av_get_pix_fmt_name(format) << ": direct " << directMs
+              << " ms, converter " << convertedMs << " ms" << std::endl;
+  }
+}
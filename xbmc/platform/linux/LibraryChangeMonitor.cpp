@@ -0,0 +1,460 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "LibraryChangeMonitor.h"
+
+#include "FDEventMonitor.h"
+#include "MediaSource.h"
+#include "ServiceBroker.h"
+#include "URL.h"
+#include "filesystem/Directory.h"
+#include "interfaces/AnnouncementManager.h"
+#include "music/MusicLibraryQueue.h"
+#include "music/infoscanner/MusicInfoScanner.h"
+#include "settings/AdvancedSettings.h"
+#include "settings/MediaSourceSettings.h"
+#include "settings/Settings.h"
+#include "settings/SettingsComponent.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "utils/log.h"
+#include "video/VideoDatabase.h"
+#include "video/VideoLibraryQueue.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace XFILE;
+
+namespace
+{
+// events that change the contents of a watched folder
+const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                            IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+
+// how often pending changes are looked at, and how long a folder has to be
+// quiet before it is scanned (copying a large file produces a stream of events)
+const uint32_t TIMER_INTERVAL_MS = 2000;
+const unsigned int SETTLE_TIME_MS = 5000;
+}
+
+CLibraryChangeMonitor::CLibraryChangeMonitor()
+  : m_timer(this)
+{ }
+
+CLibraryChangeMonitor::~CLibraryChangeMonitor()
+{
+  Stop();
+}
+
+CLibraryChangeMonitor& CLibraryChangeMonitor::GetInstance()
+{
+  static CLibraryChangeMonitor s_instance;
+  return s_instance;
+}
+
+void CLibraryChangeMonitor::Start()
+{
+  const std::shared_ptr<CAdvancedSettings> advancedSettings = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings();
+  if (!advancedSettings->m_bVideoLibraryMonitorChanges && !advancedSettings->m_bMusicLibraryMonitorChanges)
+    return;
+
+  {
+    CSingleLock lock(m_critical);
+    if (m_fd < 0)
+    {
+      m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+      if (m_fd < 0)
+      {
+        CLog::Log(LOGERROR, "CLibraryChangeMonitor::Start - inotify_init1() failed, error %d", errno);
+        return;
+      }
+
+      g_fdEventMonitor.AddFD(CFDEventMonitor::MonitoredFD(m_fd, POLLIN, FDEventCallback, this),
+                             m_fdMonitorId);
+      CServiceBroker::GetAnnouncementManager()->AddAnnouncer(this);
+      m_timer.Start(TIMER_INTERVAL_MS, true);
+    }
+  }
+
+  Refresh();
+}
+
+void CLibraryChangeMonitor::Stop()
+{
+  if (m_fd < 0)
+    return;
+
+  // these may call back into us, so don't hold our lock while stopping them
+  m_timer.Stop(true);
+  CServiceBroker::GetAnnouncementManager()->RemoveAnnouncer(this);
+  g_fdEventMonitor.RemoveFD(m_fdMonitorId);
+
+  CSingleLock lock(m_critical);
+  // closing the descriptor drops all of its watches
+  close(m_fd);
+  m_fd = -1;
+  m_watchLimitReached = false;
+  m_watches.clear();
+  m_watchedPaths.clear();
+  m_videoRoots.clear();
+  m_musicRoots.clear();
+  m_pendingScan.clear();
+  m_pendingClean.clear();
+}
+
+void CLibraryChangeMonitor::Announce(ANNOUNCEMENT::AnnouncementFlag flag, const char* sender, const char* message, const CVariant& data)
+{
+  if ((flag & (ANNOUNCEMENT::VideoLibrary | ANNOUNCEMENT::AudioLibrary)) &&
+      strcmp(message, "OnScanFinished") == 0)
+    Refresh();
+}
+
+void CLibraryChangeMonitor::Refresh()
+{
+  const std::shared_ptr<CAdvancedSettings> advancedSettings = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings();
+
+  // video content is assigned per path, music is scanned from all music sources
+  std::set<std::string> videoPaths;
+  if (advancedSettings->m_bVideoLibraryMonitorChanges)
+  {
+    CVideoDatabase db;
+    if (db.Open())
+    {
+      db.GetPaths(videoPaths);
+      db.Close();
+    }
+  }
+
+  std::set<std::string> musicPaths;
+  if (advancedSettings->m_bMusicLibraryMonitorChanges)
+  {
+    VECSOURCES* sources = CMediaSourceSettings::GetInstance().GetSources("music");
+    if (sources)
+    {
+      for (const auto& source : *sources)
+        musicPaths.insert(source.vecPaths.begin(), source.vecPaths.end());
+    }
+  }
+
+  // new folders are read without holding the lock, so events keep coming in meanwhile
+  std::vector<std::string> added;
+  {
+    CSingleLock lock(m_critical);
+    if (m_fd < 0)
+      return;
+
+    UpdateRoots(m_videoRoots, m_musicRoots, videoPaths, added);
+    UpdateRoots(m_musicRoots, m_videoRoots, musicPaths, added);
+  }
+
+  for (const auto& path : added)
+    AddWatches(path);
+
+  CSingleLock lock(m_critical);
+  CLog::Log(LOGDEBUG, "CLibraryChangeMonitor::Refresh - watching %u folders below %u video and %u music sources",
+            (unsigned)m_watchedPaths.size(), (unsigned)m_videoRoots.size(), (unsigned)m_musicRoots.size());
+}
+
+void CLibraryChangeMonitor::UpdateRoots(std::set<std::string>& roots,
+                                        const std::set<std::string>& otherRoots,
+                                        const std::set<std::string>& paths,
+                                        std::vector<std::string>& added)
+{
+  // only plain local folders can be watched, and a folder below another one
+  // is already covered by the recursive watch on its parent
+  std::set<std::string> newRoots;
+  for (std::string path : paths)
+  {
+    if (!CURL(path).GetProtocol().empty() || !URIUtils::IsHD(path))
+      continue;
+
+    URIUtils::AddSlashAtEnd(path);
+    if (!IsBelow(newRoots, path))
+      newRoots.insert(path);
+  }
+
+  for (const auto& root : roots)
+  {
+    if (newRoots.find(root) != newRoots.end() || IsBelow(otherRoots, root))
+      continue;
+
+    RemoveWatches(root);
+    // the other library may have sources below the one that went away
+    for (auto it = otherRoots.lower_bound(root); it != otherRoots.end() && StringUtils::StartsWith(*it, root); ++it)
+      added.push_back(*it);
+  }
+
+  added.insert(added.end(), newRoots.begin(), newRoots.end());
+
+  roots.swap(newRoots);
+}
+
+void CLibraryChangeMonitor::AddWatches(const std::string& path)
+{
+  std::vector<std::string> folders{path};
+  while (!folders.empty())
+  {
+    std::string folder = folders.back();
+    folders.pop_back();
+
+    // a watch is known as soon as it is added, events of its folder can't be
+    // read before. The folder is read without holding the lock.
+    {
+      CSingleLock lock(m_critical);
+      if (m_fd < 0 || m_watchLimitReached)
+        return;
+
+      if (m_watchedPaths.find(folder) != m_watchedPaths.end())
+        continue;
+
+      int wd = inotify_add_watch(m_fd, folder.c_str(), WATCH_MASK);
+      if (wd < 0)
+      {
+        if (errno == ENOSPC)
+        {
+          CLog::Log(LOGWARNING, "CLibraryChangeMonitor::AddWatches - out of inotify watches at %u folders, "
+                    "raise fs.inotify.max_user_watches to monitor all library sources", (unsigned)m_watchedPaths.size());
+          m_watchLimitReached = true;
+        }
+        else
+          CLog::Log(LOGDEBUG, "CLibraryChangeMonitor::AddWatches - unable to watch %s, error %d",
+                    CURL::GetRedacted(folder).c_str(), errno);
+        continue;
+      }
+
+      m_watches[wd] = folder;
+      m_watchedPaths[folder] = wd;
+    }
+
+    DIR* dir = opendir(folder.c_str());
+    if (!dir)
+      continue;
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+      if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        continue;
+
+      std::string child = folder + entry->d_name;
+      bool isDir = entry->d_type == DT_DIR;
+      if (entry->d_type == DT_UNKNOWN)
+      {
+        struct stat st;
+        isDir = lstat(child.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+      }
+
+      if (isDir)
+        folders.push_back(child + "/");
+    }
+    closedir(dir);
+  }
+}
+
+void CLibraryChangeMonitor::RemoveWatches(const std::string& path)
+{
+  auto it = m_watchedPaths.lower_bound(path);
+  while (it != m_watchedPaths.end() && StringUtils::StartsWith(it->first, path))
+  {
+    inotify_rm_watch(m_fd, it->second);
+    m_watches.erase(it->second);
+    it = m_watchedPaths.erase(it);
+  }
+}
+
+void CLibraryChangeMonitor::FDEventCallback(int id, int fd, short revents, void* data)
+{
+  static_cast<CLibraryChangeMonitor*>(data)->ReadEvents();
+}
+
+void CLibraryChangeMonitor::ReadEvents()
+{
+  alignas(struct inotify_event) char buffer[4096];
+
+  // created folders are watched after the lock is released
+  std::vector<std::string> created;
+
+  CSingleLock lock(m_critical);
+  while (m_fd >= 0)
+  {
+    ssize_t length = read(m_fd, buffer, sizeof(buffer));
+    if (length <= 0)
+      break;
+
+    for (char* ptr = buffer; ptr < buffer + length; )
+    {
+      const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+      ptr += sizeof(struct inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW)
+      {
+        CLog::Log(LOGWARNING, "CLibraryChangeMonitor::ReadEvents - event queue overflowed, rescanning all monitored sources");
+        m_pendingScan.insert(m_videoRoots.begin(), m_videoRoots.end());
+        m_pendingScan.insert(m_musicRoots.begin(), m_musicRoots.end());
+        continue;
+      }
+
+      auto watch = m_watches.find(event->wd);
+      if (watch == m_watches.end())
+        continue;
+
+      if (event->mask & IN_IGNORED)
+      {
+        m_watchedPaths.erase(watch->second);
+        m_watches.erase(watch);
+        continue;
+      }
+
+      if (event->len == 0)
+        continue;
+
+      const std::string& folder = watch->second;
+      if (event->mask & IN_ISDIR)
+      {
+        std::string path = folder + event->name + "/";
+        if (event->mask & (IN_CREATE | IN_MOVED_TO))
+        {
+          created.push_back(path);
+          m_pendingScan.insert(path);
+        }
+        else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+        {
+          RemoveWatches(path);
+          m_pendingClean.insert(path);
+        }
+      }
+      else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM))
+      {
+        // a new, changed or removed file means its folder needs a rescan,
+        // removed files also need their video library entries cleaned
+        m_pendingScan.insert(folder);
+        if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+          m_pendingClean.insert(folder);
+      }
+      else
+        continue;
+
+      m_lastEvent = XbmcThreads::SystemClockMillis();
+    }
+  }
+  lock.Leave();
+
+  for (const auto& path : created)
+    AddWatches(path);
+}
+
+void CLibraryChangeMonitor::OnTimeout()
+{
+  // the database and the job queues are used without holding the lock, events
+  // coming in meanwhile are collected for the next round
+  std::set<std::string> scan, clean, videoRoots, musicRoots;
+  {
+    CSingleLock lock(m_critical);
+    if (m_pendingScan.empty() && m_pendingClean.empty())
+      return;
+
+    if (XbmcThreads::SystemClockMillis() - m_lastEvent < SETTLE_TIME_MS)
+      return;
+
+    scan.swap(m_pendingScan);
+    clean.swap(m_pendingClean);
+    videoRoots = m_videoRoots;
+    musicRoots = m_musicRoots;
+  }
+
+  CleanPaths(clean, videoRoots, musicRoots);
+  ScanPaths(scan, videoRoots, musicRoots);
+}
+
+bool CLibraryChangeMonitor::IsBelow(const std::set<std::string>& roots, const std::string& path)
+{
+  // roots never contain each other, so the only candidate is the last one
+  // sorting before path
+  auto it = roots.upper_bound(path);
+  if (it == roots.begin())
+    return false;
+  return StringUtils::StartsWith(path, *(--it));
+}
+
+void CLibraryChangeMonitor::ScanPaths(const std::set<std::string>& paths,
+                                      const std::set<std::string>& videoRoots,
+                                      const std::set<std::string>& musicRoots)
+{
+  int musicFlags = MUSIC_INFO::CMusicInfoScanner::SCAN_BACKGROUND;
+  if (CServiceBroker::GetSettingsComponent()->GetSettings()->GetBool(CSettings::SETTING_MUSICLIBRARY_DOWNLOADINFO))
+    musicFlags |= MUSIC_INFO::CMusicInfoScanner::SCAN_ONLINE;
+
+  // the scanners recurse, so a folder below another changed one is covered by it
+  std::string last;
+  for (const auto& path : paths)
+  {
+    if (!last.empty() && StringUtils::StartsWith(path, last))
+      continue;
+    last = path;
+
+    if (!CDirectory::Exists(path))
+      continue;
+
+    if (IsBelow(videoRoots, path))
+    {
+      CLog::Log(LOGDEBUG, "CLibraryChangeMonitor::ScanPaths - video folder %s changed", CURL::GetRedacted(path).c_str());
+      CVideoLibraryQueue::GetInstance().ScanLibrary(path, false, false);
+    }
+    if (IsBelow(musicRoots, path))
+    {
+      CLog::Log(LOGDEBUG, "CLibraryChangeMonitor::ScanPaths - music folder %s changed", CURL::GetRedacted(path).c_str());
+      CMusicLibraryQueue::GetInstance().ScanLibrary(path, musicFlags, false);
+    }
+  }
+}
+
+void CLibraryChangeMonitor::CleanPaths(const std::set<std::string>& paths,
+                                       const std::set<std::string>& videoRoots,
+                                       const std::set<std::string>& musicRoots)
+{
+  std::set<int> videoPaths;
+  std::set<std::string> musicPaths;
+
+  CVideoDatabase db;
+  bool dbOpen = false;
+  for (const auto& path : paths)
+  {
+    if (IsBelow(videoRoots, path) && (dbOpen || (dbOpen = db.Open())))
+    {
+      std::vector<std::pair<int, std::string>> subpaths;
+      db.GetSubPaths(path, subpaths);
+      for (const auto& subpath : subpaths)
+        videoPaths.insert(subpath.first);
+    }
+
+    // removed songs of a folder that still exists are dropped by rescanning it
+    if (IsBelow(musicRoots, path) && !CDirectory::Exists(path))
+      musicPaths.insert(path);
+  }
+  if (dbOpen)
+    db.Close();
+
+  if (!videoPaths.empty())
+  {
+    CLog::Log(LOGDEBUG, "CLibraryChangeMonitor::CleanPaths - cleaning %u video paths", (unsigned)videoPaths.size());
+    CVideoLibraryQueue::GetInstance().CleanLibrary(videoPaths, true);
+  }
+  if (!musicPaths.empty())
+  {
+    CLog::Log(LOGDEBUG, "CLibraryChangeMonitor::CleanPaths - cleaning %u music paths", (unsigned)musicPaths.size());
+    CMusicLibraryQueue::GetInstance().CleanLibrary(musicPaths);
+  }
+}
@@ -0,0 +1,100 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#pragma once
+
+#include "interfaces/IAnnouncer.h"
+#include "threads/CriticalSection.h"
+#include "threads/Timer.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/*!
+ \brief Keeps the video and music libraries up to date from inotify events.
+
+ Local library sources are watched recursively. Files and folders that are
+ created, moved or deleted below them are collected for a few seconds and then
+ turned into scan jobs for the changed folders and clean jobs for the removed
+ ones, so new files show up without a full library update. The set of
+ watched sources is refreshed after every library scan.
+ */
+class CLibraryChangeMonitor : public ANNOUNCEMENT::IAnnouncer, private ITimerCallback
+{
+public:
+  ~CLibraryChangeMonitor() override;
+
+  /*!
+   \brief Gets the singleton instance of the library change monitor.
+   */
+  static CLibraryChangeMonitor& GetInstance();
+
+  /*!
+   \brief Starts watching the local library sources or picks up new ones.
+   Does nothing unless enabled in advancedsettings.xml.
+   */
+  void Start();
+
+  /*!
+   \brief Stops watching and drops all pending changes.
+   */
+  void Stop();
+
+  // implementation of IAnnouncer
+  void Announce(ANNOUNCEMENT::AnnouncementFlag flag, const char* sender, const char* message, const CVariant& data) override;
+
+private:
+  CLibraryChangeMonitor();
+  CLibraryChangeMonitor(const CLibraryChangeMonitor&) = delete;
+  CLibraryChangeMonitor& operator=(const CLibraryChangeMonitor&) = delete;
+
+  static void FDEventCallback(int id, int fd, short revents, void* data);
+  void ReadEvents();
+
+  // implementation of ITimerCallback
+  void OnTimeout() override;
+
+  void Refresh();
+  /*!
+   \brief Replaces roots by the watchable ones of paths and removes the watches of the
+   roots that went away. The roots whose folders need to be watched are added to added,
+   see AddWatches(), which must be called without holding the lock.
+   */
+  void UpdateRoots(std::set<std::string>& roots,
+                   const std::set<std::string>& otherRoots,
+                   const std::set<std::string>& paths,
+                   std::vector<std::string>& added);
+  void AddWatches(const std::string& path);
+  void RemoveWatches(const std::string& path);
+
+  static bool IsBelow(const std::set<std::string>& roots, const std::string& path);
+  static void ScanPaths(const std::set<std::string>& paths,
+                        const std::set<std::string>& videoRoots,
+                        const std::set<std::string>& musicRoots);
+  static void CleanPaths(const std::set<std::string>& paths,
+                         const std::set<std::string>& videoRoots,
+                         const std::set<std::string>& musicRoots);
+
+  int m_fd = -1;
+  int m_fdMonitorId = 0;
+  bool m_watchLimitReached = false;
+
+  std::map<int, std::string> m_watches;
+  std::map<std::string, int> m_watchedPaths;
+  std::set<std::string> m_videoRoots;
+  std::set<std::string> m_musicRoots;
+
+  std::set<std::string> m_pendingScan;
+  std::set<std::string> m_pendingClean;
+  unsigned int m_lastEvent = 0;
+
+  CTimer m_timer;
+  CCriticalSection m_critical;
+};
@@ -11,6 +11,7 @@
 #include "URL.h"
 #include "utils/log.h"
 #include "filesystem/File.h"
+#include "platform/posix/utils/Mmap.h"
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -20,6 +21,7 @@
 #include <algorithm>
 #include <sys/ioctl.h>
 #include <errno.h>
+#include <system_error>
 
 using namespace XFILE;
 
@@ -260,6 +262,39 @@ int CPosixFile::IoControl(EIoControl request, void* param)
         return 0; // size of file is 1 byte or more and seeking not possible
     }
   }
+  else if (request == IOCTRL_MAP_VIEW)
+  {
+    SMappedView* view = static_cast<SMappedView*>(param);
+    if (!view)
+      return -1;
+
+    const int64_t length = GetLength();
+    if (view->offset < 0 || view->offset >= length)
+      return -1;
+
+    size_t size = view->size;
+    if (size == 0 || static_cast<int64_t>(size) > length - view->offset)
+      size = static_cast<size_t>(length - view->offset);
+
+    // mappings have to start at a page boundary
+    static const int64_t pageSize = sysconf(_SC_PAGESIZE);
+    const int64_t start = view->offset - view->offset % pageSize;
+    const size_t skip = static_cast<size_t>(view->offset - start);
+
+    try
+    {
+      auto mapping = std::make_shared<KODI::UTILS::POSIX::CMmap>(nullptr, size + skip, PROT_READ, MAP_PRIVATE, m_fd, start);
+      view->data = static_cast<const uint8_t*>(mapping->Data()) + skip;
+      view->size = size;
+      view->mapping = mapping;
+    }
+    catch (std::system_error const& e)
+    {
+      CLog::Log(LOGDEBUG, "CPosixFile::IoControl - unable to map %zu bytes at %" PRId64 ": %s", size, view->offset, e.what());
+      return -1;
+    }
+    return 0;
+  }
 
   return -1;
 }
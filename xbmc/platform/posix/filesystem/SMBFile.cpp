@@ -27,8 +27,18 @@
 #include "utils/TimeUtils.h"
 #include "commons/Exception.h"
 
+#include <algorithm>
+#include <string.h>
+
 using namespace XFILE;
 
+// files at least this large are read through their own context, these are
+// the ones that are streamed for a long time, e.g. during playback
+#define SMB_FILE_CONTEXT_MIN_SIZE (32 * 1024 * 1024)
+// smaller files are mostly probed by tag and header readers, which only
+// want a few bytes here and there
+#define SMB_READ_AHEAD_MIN_SIZE (32 * 1024 * 1024)
+
 void xb_smbc_log(const char* msg)
 {
   CLog::Log(LOGINFO, "%s%s", "smb: ", msg);
@@ -161,6 +171,16 @@ void CSMB::Init()
     // 48 bytes -> smb_xmalloc_array
     // 32 bytes -> set_param_opt
     // 16 bytes -> set_param_opt
+#ifdef DEPRECATED_SMBC_INTERFACE
+    // the private file contexts are used from several threads at once, the
+    // global state of libsmbclient needs its locks for that
+    static bool threadsInitialized = false;
+    if (!threadsInitialized)
+    {
+      smbc_thread_posix();
+      threadsInitialized = true;
+    }
+#endif
     smbc_init(xb_smbc_auth, 0);
 
     // setup our context
@@ -169,33 +189,13 @@ void CSMB::Init()
     // restore HOME
     setenv("HOME", truehome.c_str(), 1);
 
+    SetupContext(m_context);
 #ifdef DEPRECATED_SMBC_INTERFACE
-    smbc_setDebug(m_context, CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->CanLogComponent(LOGSAMBA) ? 10 : 0);
-    smbc_setFunctionAuthData(m_context, xb_smbc_auth);
     orig_cache = smbc_getFunctionGetCachedServer(m_context);
     smbc_setFunctionGetCachedServer(m_context, xb_smbc_cache);
-    smbc_setOptionOneSharePerServer(m_context, false);
-    smbc_setOptionBrowseMaxLmbCount(m_context, 0);
-    smbc_setTimeout(m_context, CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_sambaclienttimeout * 1000);
-    // we do not need to strdup these, smbc_setXXX below will make their own copies
-    if (settings->GetString(CSettings::SETTING_SMB_WORKGROUP).length() > 0)
-      //! @bug libsmbclient < 4.9 isn't const correct
-      smbc_setWorkgroup(m_context, const_cast<char*>(settings->GetString(CSettings::SETTING_SMB_WORKGROUP).c_str()));
-    std::string guest = "guest";
-    //! @bug libsmbclient < 4.8 isn't const correct
-    smbc_setUser(m_context, const_cast<char*>(guest.c_str()));
 #else
-    m_context->debug = (CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->CanLogComponent(LOGSAMBA) ? 10 : 0);
-    m_context->callbacks.auth_fn = xb_smbc_auth;
     orig_cache = m_context->callbacks.get_cached_srv_fn;
     m_context->callbacks.get_cached_srv_fn = xb_smbc_cache;
-    m_context->options.one_share_per_server = false;
-    m_context->options.browse_max_lmb_count = 0;
-    m_context->timeout = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_sambaclienttimeout * 1000;
-    // we need to strdup these, they will get free'd on smbc_free_context
-    if (settings->GetString(CSettings::SETTING_SMB_WORKGROUP).length() > 0)
-      m_context->workgroup = strdup(settings->GetString(CSettings::SETTING_SMB_WORKGROUP).c_str());
-    m_context->user = strdup("guest");
 #endif
 
     // initialize samba and do some hacking into the settings
@@ -224,6 +224,63 @@ void CSMB::Init()
   m_IdleTimeout = 180;
 }
 
+void CSMB::SetupContext(SMBCCTX *context)
+{
+  const std::shared_ptr<CSettings> settings = CServiceBroker::GetSettingsComponent()->GetSettings();
+
+#ifdef DEPRECATED_SMBC_INTERFACE
+  smbc_setDebug(context, CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->CanLogComponent(LOGSAMBA) ? 10 : 0);
+  smbc_setFunctionAuthData(context, xb_smbc_auth);
+  smbc_setOptionOneSharePerServer(context, false);
+  smbc_setOptionBrowseMaxLmbCount(context, 0);
+  smbc_setTimeout(context, CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_sambaclienttimeout * 1000);
+  // we do not need to strdup these, smbc_setXXX below will make their own copies
+  if (settings->GetString(CSettings::SETTING_SMB_WORKGROUP).length() > 0)
+    //! @bug libsmbclient < 4.9 isn't const correct
+    smbc_setWorkgroup(context, const_cast<char*>(settings->GetString(CSettings::SETTING_SMB_WORKGROUP).c_str()));
+  std::string guest = "guest";
+  //! @bug libsmbclient < 4.8 isn't const correct
+  smbc_setUser(context, const_cast<char*>(guest.c_str()));
+#else
+  context->debug = (CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->CanLogComponent(LOGSAMBA) ? 10 : 0);
+  context->callbacks.auth_fn = xb_smbc_auth;
+  context->options.one_share_per_server = false;
+  context->options.browse_max_lmb_count = 0;
+  context->timeout = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_sambaclienttimeout * 1000;
+  // we need to strdup these, they will get free'd on smbc_free_context
+  if (settings->GetString(CSettings::SETTING_SMB_WORKGROUP).length() > 0)
+    context->workgroup = strdup(settings->GetString(CSettings::SETTING_SMB_WORKGROUP).c_str());
+  context->user = strdup("guest");
+#endif
+}
+
+SMBCCTX* CSMB::NewFileContext()
+{
+#ifdef DEPRECATED_SMBC_INTERFACE
+  // makes sure smb.conf has been written and loaded by libsmbclient
+  Init();
+
+  SMBCCTX *context = smbc_new_context();
+  if (!context)
+    return NULL;
+
+  SetupContext(context);
+  if (!smbc_init_context(context))
+  {
+    smbc_free_context(context, 1);
+    return NULL;
+  }
+  return context;
+#else
+  return NULL;
+#endif
+}
+
+void CSMB::FreeFileContext(SMBCCTX *context)
+{
+  smbc_free_context(context, 1);
+}
+
 std::string CSMB::URLEncode(const CURL &url)
 {
   /* due to smb wanting encoded urls we have to build it manually */
@@ -338,15 +395,14 @@ CSMBFile::~CSMBFile()
 
 int64_t CSMBFile::GetPosition()
 {
-  if (m_fd == -1)
+  if (!IsOpen())
     return -1;
-  CSingleLock lock(smb);
-  return smbc_lseek(m_fd, 0, SEEK_CUR);
+  return m_filePos;
 }
 
 int64_t CSMBFile::GetLength()
 {
-  if (m_fd == -1)
+  if (!IsOpen())
     return -1;
   return m_fileSize;
 }
@@ -397,10 +453,59 @@ bool CSMBFile::Open(const CURL& url)
     m_fd = -1;
     return false;
   }
+  lock.Leave();
+
+  m_filePos = 0;
+  m_sourcePos = 0;
+  m_readAheadSize = 0;
+  if (m_fileSize >= SMB_READ_AHEAD_MIN_SIZE)
+    m_readAheadSize = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_sambaReadAhead * 1024;
+
+  if (m_fileSize >= SMB_FILE_CONTEXT_MIN_SIZE &&
+      CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_sambaFileContexts &&
+      OpenFileContext(strFileName))
+  {
+    // the file is read through its own context from now on
+    CSingleLock lock(smb);
+    smbc_close(m_fd);
+    m_fd = -1;
+  }
+
   // We've successfully opened the file!
   return true;
 }
 
+bool CSMBFile::OpenFileContext(const std::string& strFileName)
+{
+#ifdef DEPRECATED_SMBC_INTERFACE
+  SMBCCTX *context;
+  {
+    CSingleLock lock(smb);
+    context = smb.NewFileContext();
+  }
+  if (!context)
+  {
+    CLog::Log(LOGDEBUG, "CSMBFile::OpenFileContext - unable to create a context, using the shared one");
+    return false;
+  }
+
+  SMBCFILE *file = smbc_getFunctionOpen(context)(context, strFileName.c_str(), O_RDONLY, 0);
+  if (!file)
+  {
+    CLog::Log(LOGDEBUG, "CSMBFile::OpenFileContext - unable to open %s, using the shared context",
+              CURL::GetRedacted(strFileName).c_str());
+    CSMB::FreeFileContext(context);
+    return false;
+  }
+
+  m_context = context;
+  m_file = file;
+  return true;
+#else
+  return false;
+#endif
+}
+
 
 /// \brief Checks authentication against SAMBA share. Reads password cache created in CSMBDirectory::OpenDir().
 /// \param strAuth The SMB style path
@@ -466,13 +571,24 @@ bool CSMBFile::Exists(const CURL& url)
 
 int CSMBFile::Stat(struct __stat64* buffer)
 {
-  if (m_fd == -1)
+  if (!IsOpen())
     return -1;
 
   struct stat tmpBuffer = {0};
+  int iResult;
 
-  CSingleLock lock(smb);
-  int iResult = smbc_fstat(m_fd, &tmpBuffer);
+#ifdef DEPRECATED_SMBC_INTERFACE
+  if (m_file)
+  {
+    CSingleLock lock(m_fileLock);
+    iResult = smbc_getFunctionFstat(m_context)(m_context, m_file, &tmpBuffer);
+  }
+  else
+#endif
+  {
+    CSingleLock lock(smb);
+    iResult = smbc_fstat(m_fd, &tmpBuffer);
+  }
   CUtil::StatToStat64(buffer, &tmpBuffer);
   return iResult;
 }
@@ -491,7 +607,7 @@ int CSMBFile::Stat(const CURL& url, struct __stat64* buffer)
 
 int CSMBFile::Truncate(int64_t size)
 {
-  if (m_fd == -1) return 0;
+  if (!IsOpen()) return 0;
 /*
  * This would force us to be dependant on SMBv3.2 which is GPLv3
  * This is only used by the TagLib writers, which are not currently in use
@@ -508,12 +624,79 @@ int CSMBFile::Truncate(int64_t size)
   return 0;
 }
 
+ssize_t CSMBFile::ReadSource(void *lpBuf, size_t uiBufSize)
+{
+  ssize_t bytesRead;
+
+#ifdef DEPRECATED_SMBC_INTERFACE
+  if (m_file)
+  {
+    CSingleLock lock(m_fileLock);
+    smbc_read_fn read = smbc_getFunctionRead(m_context);
+
+    bytesRead = read(m_context, m_file, lpBuf, uiBufSize);
+    if (m_allowRetry && bytesRead < 0 && errno == EINVAL )
+    {
+      CLog::Log(LOGERROR, "%s - Error( %" PRIdS ", %d, %s ) - Retrying", __FUNCTION__, bytesRead, errno, strerror(errno));
+      bytesRead = read(m_context, m_file, lpBuf, uiBufSize);
+    }
+  }
+  else
+#endif
+  {
+    CSingleLock lock(smb); // Init not called since it has to be "inited" by now
+
+    bytesRead = smbc_read(m_fd, lpBuf, (int)uiBufSize);
+    if (m_allowRetry && bytesRead < 0 && errno == EINVAL )
+    {
+      CLog::Log(LOGERROR, "%s - Error( %" PRIdS ", %d, %s ) - Retrying", __FUNCTION__, bytesRead, errno, strerror(errno));
+      bytesRead = smbc_read(m_fd, lpBuf, (int)uiBufSize);
+    }
+  }
+  smb.SetActivityTime();
+
+  if ( bytesRead < 0 )
+    CLog::Log(LOGERROR, "%s - Error( %" PRIdS ", %d, %s )", __FUNCTION__, bytesRead, errno, strerror(errno));
+  else
+    m_sourcePos += bytesRead;
+
+  return bytesRead;
+}
+
+int64_t CSMBFile::SeekSource(int64_t iFilePosition, int iWhence)
+{
+  int64_t pos;
+
+#ifdef DEPRECATED_SMBC_INTERFACE
+  if (m_file)
+  {
+    CSingleLock lock(m_fileLock);
+    pos = smbc_getFunctionLseek(m_context)(m_context, m_file, iFilePosition, iWhence);
+  }
+  else
+#endif
+  {
+    CSingleLock lock(smb); // Init not called since it has to be "inited" by now
+    pos = smbc_lseek(m_fd, iFilePosition, iWhence);
+  }
+  smb.SetActivityTime();
+
+  if ( pos < 0 )
+  {
+    CLog::Log(LOGERROR, "%s - Error( %" PRId64", %d, %s )", __FUNCTION__, pos, errno, strerror(errno));
+    return -1;
+  }
+
+  m_sourcePos = pos;
+  return pos;
+}
+
 ssize_t CSMBFile::Read(void *lpBuf, size_t uiBufSize)
 {
   if (uiBufSize > SSIZE_MAX)
     uiBufSize = SSIZE_MAX;
 
-  if (m_fd == -1)
+  if (!IsOpen())
     return -1;
 
   // Some external libs (libass) use test read with zero size and
@@ -524,42 +707,103 @@ ssize_t CSMBFile::Read(void *lpBuf, size_t uiBufSize)
   if (uiBufSize == 0 && lpBuf == NULL)
     return 0;
 
-  CSingleLock lock(smb); // Init not called since it has to be "inited" by now
-  smb.SetActivityTime();
+  // serve the request from the data read ahead if possible
+  if (m_filePos >= m_bufferPos && m_filePos < m_bufferPos + static_cast<int64_t>(m_buffer.size()))
+  {
+    const size_t offset = static_cast<size_t>(m_filePos - m_bufferPos);
+    const size_t size = std::min(uiBufSize, m_buffer.size() - offset);
+    memcpy(lpBuf, m_buffer.data() + offset, size);
+    m_filePos += size;
+    return size;
+  }
 
-  ssize_t bytesRead = smbc_read(m_fd, lpBuf, (int)uiBufSize);
+  // small reads that continue where the last read from the server stopped are
+  // turned into a single large read. Reads after a seek are passed on as they
+  // are, larger ones don't gain anything from buffering. The large reads end
+  // on a multiple of their size, after a seek the first one only fills up to
+  // the next one, so the server sees aligned requests again.
+  size_t readAheadSize = 0;
+  if (m_readAheadSize > 0)
+    readAheadSize = m_readAheadSize - static_cast<size_t>(m_filePos % m_readAheadSize);
+  const bool readAhead = readAheadSize > 0 && uiBufSize < readAheadSize && m_filePos == m_sourcePos;
+  const int64_t readPos = m_filePos;
+
+  if (m_sourcePos != readPos && SeekSource(readPos, SEEK_SET) < 0)
+    return -1;
 
-  if (m_allowRetry && bytesRead < 0 && errno == EINVAL )
+  if (!readAhead)
   {
-    CLog::Log(LOGERROR, "%s - Error( %" PRIdS ", %d, %s ) - Retrying", __FUNCTION__, bytesRead, errno, strerror(errno));
-    bytesRead = smbc_read(m_fd, lpBuf, (int)uiBufSize);
+    ssize_t bytesRead = ReadSource(lpBuf, uiBufSize);
+    if (bytesRead > 0)
+      m_filePos += bytesRead;
+    return bytesRead;
   }
 
-  if ( bytesRead < 0 )
-    CLog::Log(LOGERROR, "%s - Error( %" PRIdS ", %d, %s )", __FUNCTION__, bytesRead, errno, strerror(errno));
+  m_buffer.resize(readAheadSize);
+  size_t filled = 0;
+  while (filled < readAheadSize)
+  {
+    ssize_t bytesRead = ReadSource(m_buffer.data() + filled, readAheadSize - filled);
+    if (bytesRead <= 0)
+    {
+      if (bytesRead < 0 && filled == 0)
+      {
+        m_buffer.clear();
+        return -1;
+      }
+      break;
+    }
+    filled += bytesRead;
+  }
+  m_buffer.resize(filled);
+  m_bufferPos = readPos;
 
-  return bytesRead;
+  if (m_filePos >= m_bufferPos + static_cast<int64_t>(m_buffer.size()))
+    return 0; // end of file
+
+  return Read(lpBuf, uiBufSize);
 }
 
 int64_t CSMBFile::Seek(int64_t iFilePosition, int iWhence)
 {
-  if (m_fd == -1) return -1;
+  if (!IsOpen()) return -1;
 
-  CSingleLock lock(smb); // Init not called since it has to be "inited" by now
-  smb.SetActivityTime();
-  int64_t pos = smbc_lseek(m_fd, iFilePosition, iWhence);
+  // seeks are only passed on to the server with the next read from it
+  int64_t pos;
+  if (iWhence == SEEK_SET)
+    pos = iFilePosition;
+  else if (iWhence == SEEK_CUR)
+    pos = m_filePos + iFilePosition;
+  else
+  {
+    pos = SeekSource(iFilePosition, iWhence);
+    if (pos < 0)
+      return -1;
+  }
 
-  if ( pos < 0 )
+  if (pos < 0)
   {
-    CLog::Log(LOGERROR, "%s - Error( %" PRId64", %d, %s )", __FUNCTION__, pos, errno, strerror(errno));
+    CLog::Log(LOGERROR, "%s - Error( %" PRId64", %d, invalid position )", __FUNCTION__, iFilePosition, iWhence);
     return -1;
   }
 
+  m_filePos = pos;
   return pos;
 }
 
 void CSMBFile::Close()
 {
+  if (m_file)
+  {
+    CLog::Log(LOGDEBUG,"CSMBFile::Close closing private context file");
+#ifdef DEPRECATED_SMBC_INTERFACE
+    CSingleLock lock(m_fileLock);
+    smbc_getFunctionClose(m_context)(m_context, m_file);
+#endif
+    CSMB::FreeFileContext(m_context);
+    m_file = NULL;
+    m_context = NULL;
+  }
   if (m_fd != -1)
   {
     CLog::Log(LOGDEBUG,"CSMBFile::Close closing fd %d", m_fd);
@@ -567,16 +811,31 @@ void CSMBFile::Close()
     smbc_close(m_fd);
   }
   m_fd = -1;
+  m_buffer.clear();
+  m_buffer.shrink_to_fit();
+  m_bufferPos = 0;
+  m_filePos = 0;
+  m_sourcePos = 0;
 }
 
 ssize_t CSMBFile::Write(const void* lpBuf, size_t uiBufSize)
 {
   if (m_fd == -1) return -1;
 
+  if (m_sourcePos != m_filePos && SeekSource(m_filePos, SEEK_SET) < 0)
+    return -1;
+  m_buffer.clear();
+
   // lpBuf can be safely casted to void* since xbmc_write will only read from it.
   CSingleLock lock(smb);
 
-  return  smbc_write(m_fd, lpBuf, uiBufSize);
+  ssize_t bytesWritten = smbc_write(m_fd, lpBuf, uiBufSize);
+  if (bytesWritten > 0)
+  {
+    m_filePos += bytesWritten;
+    m_sourcePos = m_filePos;
+  }
+  return bytesWritten;
 }
 
 bool CSMBFile::Delete(const CURL& url)
@@ -638,6 +897,9 @@ bool CSMBFile::OpenForWrite(const CURL& url, bool bOverWrite)
     return false;
   }
 
+  // written data would have to be merged into the read ahead buffer
+  m_readAheadSize = 0;
+
   // We've successfully opened the file!
   return true;
 }
@@ -19,6 +19,8 @@
 #include "URL.h"
 #include "threads/CriticalSection.h"
 
+#include <vector>
+
 #define NT_STATUS_CONNECTION_REFUSED long(0xC0000000 | 0x0236)
 #define NT_STATUS_INVALID_HANDLE long(0xC0000000 | 0x0008)
 #define NT_STATUS_ACCESS_DENIED long(0xC0000000 | 0x0022)
@@ -27,6 +29,8 @@
 
 struct _SMBCCTX;
 typedef _SMBCCTX SMBCCTX;
+struct _SMBCFILE;
+typedef _SMBCFILE SMBCFILE;
 
 class CSMB : public CCriticalSection
 {
@@ -42,8 +46,21 @@ public:
   std::string URLEncode(const std::string &value);
   std::string URLEncode(const CURL &url);
 
+  /*!
+   \brief Creates a separate libsmbclient context for a single file.
+
+   A file read through its own context has its own connection to the server
+   and doesn't need to hold this lock, so reading it doesn't stall other
+   smb operations.
+   \return the new context or NULL if it couldn't be created
+   */
+  SMBCCTX* NewFileContext();
+  static void FreeFileContext(SMBCCTX *context);
+
   DWORD ConvertUnixToNT(int error);
 private:
+  void SetupContext(SMBCCTX *context);
+
   SMBCCTX *m_context;
   int m_OpenConnections;
   unsigned int m_IdleTimeout;
@@ -82,8 +99,22 @@ protected:
   CURL m_url;
   bool IsValidFile(const std::string& strFileName);
   std::string GetAuthenticatedPath(const CURL &url);
+  bool OpenFileContext(const std::string& strFileName);
+  virtual ssize_t ReadSource(void* lpBuf, size_t uiBufSize);
+  virtual int64_t SeekSource(int64_t iFilePosition, int iWhence);
+  bool IsOpen() const { return m_fd != -1 || m_file != NULL; }
   int64_t m_fileSize;
   int m_fd;
   bool m_allowRetry;
+
+  SMBCCTX *m_context = NULL; // private context of a large file opened for reading, see CSMB::NewFileContext
+  SMBCFILE *m_file = NULL;
+  CCriticalSection m_fileLock; // protects m_context
+
+  int64_t m_filePos = 0; // position as seen by the caller
+  int64_t m_sourcePos = 0; // position of the file on the server
+  size_t m_readAheadSize = 0; // size and alignment of the reads ahead, 0 to read as requested
+  std::vector<char> m_buffer; // data read ahead
+  int64_t m_bufferPos = 0; // file position of the first byte in m_buffer
 };
 }
@@ -776,9 +776,39 @@ std::string CSmartPlaylistRule::FormatLinkQuery(const char *field, const char *t
                              field, table, table, table, field, table, field, mediaField.c_str(), table, parameter.c_str(), field, mediaType.c_str());
 }
 
+std::string CSmartPlaylistRule::GetFullTextIndex(const std::string &strType) const
+{
+  // the indices created with the analytics of the music and video databases
+  if (strType == "movies" && (m_field == FieldTitle || m_field == FieldPlot || m_field == FieldPlotOutline || m_field == FieldTagline))
+    return "movie_fts";
+  if (strType == "tvshows" && (m_field == FieldTitle || m_field == FieldPlot))
+    return "tvshow_fts";
+  if (strType == "episodes" && (m_field == FieldTitle || m_field == FieldPlot))
+    return "episode_fts";
+  if (strType == "musicvideos" && m_field == FieldTitle)
+    return "musicvideo_fts";
+  if (strType == "songs" && m_field == FieldTitle)
+    return "song_fts";
+  if (strType == "albums" && m_field == FieldAlbum)
+    return "album_fts";
+  if (strType == "artists" && m_field == FieldArtist)
+    return "artist_fts";
+  return "";
+}
+
 std::string CSmartPlaylistRule::FormatWhereClause(const std::string &negate, const std::string &oper, const std::string &param,
                                                  const CDatabase &db, const std::string &strType) const
 {
+  if (m_operator == OPERATOR_MATCHES)
+  {
+    // the indexed column has the name of the column of the view
+    const std::string index = GetFullTextIndex(strType);
+    const std::string field = GetField(m_field, strType);
+    const std::string fullText = index.empty() ? "" : db.GetFullTextQuery(index, { field.substr(field.find('.') + 1) }, param);
+    if (!fullText.empty())
+      return GetField(FieldId, strType) + " IN (" + fullText + ")";
+  }
+
   std::string parameter = FormatParameter(oper, param, db, strType);
 
   std::string query;
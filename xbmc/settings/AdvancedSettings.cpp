@@ -174,6 +174,11 @@ void CAdvancedSettings::Initialize()
   m_DXVACheckCompatibilityPresent = false;
   m_DXVAForceProcessorRenderer = true;
   m_videoFpsDetect = 1;
+  m_videoProbeCache = true;
+  m_videoLiveFastStart = false;
+  m_videoDecodeThreadType = "auto";
+  m_videoDecodeThreads = 0;
+  m_videoDecodeLowLatency = false;
   m_maxTempo = 1.55f;
   m_videoPreferStereoStream = false;
 
@@ -285,6 +290,8 @@ void CAdvancedSettings::Initialize()
   m_sambaclienttimeout = 30;
   m_sambadoscodepage = "";
   m_sambastatfiles = true;
+  m_sambaReadAhead = 1024;
+  m_sambaFileContexts = true;
 
   m_bHTTPDirectoryStatFilesize = false;
 
@@ -298,6 +305,9 @@ void CAdvancedSettings::Initialize()
   m_bMusicLibraryAllItemsOnBottom = false;
   m_bMusicLibraryCleanOnUpdate = false;
   m_bMusicLibraryArtistSortOnUpdate = false;
+  m_iMusicLibraryImportBatchSize = 50;
+  m_iMusicLibraryTagReaders = 8;
+  m_bMusicLibraryMonitorChanges = false;
   m_iMusicLibraryRecentlyAddedItems = 25;
   m_strMusicLibraryAlbumFormat = "";
   m_prioritiseAPEv2tags = false;
@@ -310,6 +320,8 @@ void CAdvancedSettings::Initialize()
   m_iVideoLibraryRecentlyAddedItems = 25;
   m_bVideoLibraryCleanOnUpdate = false;
   m_bVideoLibraryUseFastHash = true;
+  m_iVideoLibraryScanThreads = 8;
+  m_bVideoLibraryMonitorChanges = false;
   m_bVideoLibraryExportAutoThumbs = false;
   m_bVideoLibraryImportWatchedState = false;
   m_bVideoLibraryImportResumePoint = false;
@@ -365,6 +377,9 @@ void CAdvancedSettings::Initialize()
   m_curlconnecttimeout = 30;
   m_curllowspeedtime = 20;
   m_curlretries = 2;
+  m_curlParallelConnections = 1;
+  m_nfsReadAhead = 4;
+  m_directoryPrefetch = true;
   m_curlDisableIPV6 = false;      //Certain hardware/OS combinations have trouble
                                   //with ipv6.
 
@@ -409,6 +424,10 @@ void CAdvancedSettings::Initialize()
   // the following setting determines the readRate of a player data
   // as multiply of the default data read rate
   m_cacheReadFactor = 4.0f;
+  m_cacheAdaptive = false;
+  m_cacheAdaptiveMaxSize = 0;
+  m_cachePersistentSize = 0;
+  m_directoryCacheSize = 32;
 
   m_addonPackageFolderSize = 200;
 
@@ -426,6 +445,8 @@ void CAdvancedSettings::Initialize()
 
   m_databaseMusic.Reset();
   m_databaseVideo.Reset();
+  m_databaseStatistics = false;
+  m_databaseSlowQueryTime = 100;
 
   m_pictureExtensions = ".png|.jpg|.jpeg|.bmp|.gif|.ico|.tif|.tiff|.tga|.pcx|.cbz|.zip|.rss|.webp|.jp2|.apng";
   m_musicExtensions = ".nsv|.m4a|.flac|.aac|.strm|.pls|.rm|.rma|.mpa|.wav|.wma|.ogg|.mp3|.mp2|.m3u|.gdm|.imf|.m15|.sfx|.uni|.ac3|.dts|.cue|.aif|.aiff|.wpl|.xspf|.ape|.mac|.mpc|.mp+|.mpp|.shn|.zip|.wv|.dsp|.xsp|.xwav|.waa|.wvs|.wam|.gcm|.idsp|.mpdsp|.mss|.spt|.rsd|.sap|.cmc|.cmr|.dmc|.mpt|.mpd|.rmt|.tmc|.tm8|.tm2|.oga|.url|.pxml|.tta|.rss|.wtv|.mka|.tak|.opus|.dff|.dsf|.m4b|.dtshd";
@@ -738,6 +759,11 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetBoolean(pElement, "allowdiscretedecoder", m_allowUseSeparateDeviceForDecoding);
     //0 = disable fps detect, 1 = only detect on timestamps with uniform spacing, 2 detect on all timestamps
     XMLUtils::GetInt(pElement, "fpsdetect", m_videoFpsDetect, 0, 2);
+    XMLUtils::GetBoolean(pElement, "probecache", m_videoProbeCache);
+    XMLUtils::GetBoolean(pElement, "livefaststart", m_videoLiveFastStart);
+    XMLUtils::GetString(pElement, "decodethreadtype", m_videoDecodeThreadType);
+    XMLUtils::GetInt(pElement, "decodethreads", m_videoDecodeThreads, 0, 64);
+    XMLUtils::GetBoolean(pElement, "decodelowlatency", m_videoDecodeLowLatency);
     XMLUtils::GetFloat(pElement, "maxtempo", m_maxTempo, 1.5, 2.1);
     XMLUtils::GetBoolean(pElement, "preferstereostream", m_videoPreferStereoStream);
 
@@ -787,6 +813,9 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetBoolean(pElement, "allitemsonbottom", m_bMusicLibraryAllItemsOnBottom);
     XMLUtils::GetBoolean(pElement, "cleanonupdate", m_bMusicLibraryCleanOnUpdate);
     XMLUtils::GetBoolean(pElement, "artistsortonupdate", m_bMusicLibraryArtistSortOnUpdate);
+    XMLUtils::GetInt(pElement, "importbatchsize", m_iMusicLibraryImportBatchSize, 0, 10000);
+    XMLUtils::GetInt(pElement, "tagreaders", m_iMusicLibraryTagReaders, 1, 32);
+    XMLUtils::GetBoolean(pElement, "monitorchanges", m_bMusicLibraryMonitorChanges);
     XMLUtils::GetString(pElement, "albumformat", m_strMusicLibraryAlbumFormat);
     XMLUtils::GetString(pElement, "itemseparator", m_musicItemSeparator);
     XMLUtils::GetInt(pElement, "dateadded", m_iMusicLibraryDateAdded);
@@ -815,6 +844,8 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetInt(pElement, "recentlyaddeditems", m_iVideoLibraryRecentlyAddedItems, 1, INT_MAX);
     XMLUtils::GetBoolean(pElement, "cleanonupdate", m_bVideoLibraryCleanOnUpdate);
     XMLUtils::GetBoolean(pElement, "usefasthash", m_bVideoLibraryUseFastHash);
+    XMLUtils::GetInt(pElement, "scanthreads", m_iVideoLibraryScanThreads, 1, 32);
+    XMLUtils::GetBoolean(pElement, "monitorchanges", m_bVideoLibraryMonitorChanges);
     XMLUtils::GetString(pElement, "itemseparator", m_videoItemSeparator);
     XMLUtils::GetBoolean(pElement, "exportautothumbs", m_bVideoLibraryExportAutoThumbs);
     XMLUtils::GetBoolean(pElement, "importwatchedstate", m_bVideoLibraryImportWatchedState);
@@ -856,6 +887,9 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetInt(pElement, "curllowspeedtime", m_curllowspeedtime, 1, 1000);
     XMLUtils::GetInt(pElement, "curlretries", m_curlretries, 0, 10);
     XMLUtils::GetBoolean(pElement,"disableipv6", m_curlDisableIPV6);
+    XMLUtils::GetUInt(pElement, "curlparallelconnections", m_curlParallelConnections, 1, 16);
+    XMLUtils::GetUInt(pElement, "nfsreadahead", m_nfsReadAhead, 1, 32);
+    XMLUtils::GetBoolean(pElement, "directoryprefetch", m_directoryPrefetch);
   }
 
   pElement = pRootElement->FirstChildElement("cache");
@@ -864,6 +898,10 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetUInt(pElement, "memorysize", m_cacheMemSize);
     XMLUtils::GetUInt(pElement, "buffermode", m_cacheBufferMode, 0, 4);
     XMLUtils::GetFloat(pElement, "readfactor", m_cacheReadFactor);
+    XMLUtils::GetBoolean(pElement, "adaptive", m_cacheAdaptive);
+    XMLUtils::GetUInt(pElement, "adaptivemaxsize", m_cacheAdaptiveMaxSize);
+    XMLUtils::GetUInt(pElement, "persistentsize", m_cachePersistentSize);
+    XMLUtils::GetUInt(pElement, "directorycachesize", m_directoryCacheSize, 1, 1024);
   }
 
   pElement = pRootElement->FirstChildElement("jsonrpc");
@@ -879,6 +917,8 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetString(pElement,  "doscodepage",   m_sambadoscodepage);
     XMLUtils::GetInt(pElement, "clienttimeout", m_sambaclienttimeout, 5, 100);
     XMLUtils::GetBoolean(pElement, "statfiles", m_sambastatfiles);
+    XMLUtils::GetUInt(pElement, "readahead", m_sambaReadAhead, 0, 16384);
+    XMLUtils::GetBoolean(pElement, "filecontexts", m_sambaFileContexts);
   }
 
   pElement = pRootElement->FirstChildElement("httpdirectory");
@@ -1160,6 +1200,8 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetString(pDatabase, "capath", m_databaseVideo.capath);
     XMLUtils::GetString(pDatabase, "ciphers", m_databaseVideo.ciphers);
     XMLUtils::GetBoolean(pDatabase, "compression", m_databaseVideo.compression);
+    XMLUtils::GetBoolean(pDatabase, "wal", m_databaseVideo.wal);
+    XMLUtils::GetUInt(pDatabase, "readers", m_databaseVideo.readers, 0, 16);
   }
 
   pDatabase = pRootElement->FirstChildElement("musicdatabase");
@@ -1177,6 +1219,8 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetString(pDatabase, "capath", m_databaseMusic.capath);
     XMLUtils::GetString(pDatabase, "ciphers", m_databaseMusic.ciphers);
     XMLUtils::GetBoolean(pDatabase, "compression", m_databaseMusic.compression);
+    XMLUtils::GetBoolean(pDatabase, "wal", m_databaseMusic.wal);
+    XMLUtils::GetUInt(pDatabase, "readers", m_databaseMusic.readers, 0, 16);
   }
 
   pDatabase = pRootElement->FirstChildElement("tvdatabase");
@@ -1194,6 +1238,8 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetString(pDatabase, "capath", m_databaseTV.capath);
     XMLUtils::GetString(pDatabase, "ciphers", m_databaseTV.ciphers);
     XMLUtils::GetBoolean(pDatabase, "compression", m_databaseTV.compression);
+    XMLUtils::GetBoolean(pDatabase, "wal", m_databaseTV.wal);
+    XMLUtils::GetUInt(pDatabase, "readers", m_databaseTV.readers, 0, 16);
   }
 
   pDatabase = pRootElement->FirstChildElement("epgdatabase");
@@ -1211,6 +1257,8 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetString(pDatabase, "capath", m_databaseEpg.capath);
     XMLUtils::GetString(pDatabase, "ciphers", m_databaseEpg.ciphers);
     XMLUtils::GetBoolean(pDatabase, "compression", m_databaseEpg.compression);
+    XMLUtils::GetBoolean(pDatabase, "wal", m_databaseEpg.wal);
+    XMLUtils::GetUInt(pDatabase, "readers", m_databaseEpg.readers, 0, 16);
   }
 
   pDatabase = pRootElement->FirstChildElement("savestatedatabase");
@@ -1228,6 +1276,15 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetString(pDatabase, "capath", m_databaseSavestates.capath);
     XMLUtils::GetString(pDatabase, "ciphers", m_databaseSavestates.ciphers);
     XMLUtils::GetBoolean(pDatabase, "compression", m_databaseSavestates.compression);
+    XMLUtils::GetBoolean(pDatabase, "wal", m_databaseSavestates.wal);
+    XMLUtils::GetUInt(pDatabase, "readers", m_databaseSavestates.readers, 0, 16);
+  }
+
+  pElement = pRootElement->FirstChildElement("databasestatistics");
+  if (pElement)
+  {
+    XMLUtils::GetBoolean(pElement, "enabled", m_databaseStatistics);
+    XMLUtils::GetUInt(pElement, "slowquerytime", m_databaseSlowQueryTime, 1, 60000);
   }
 
   pElement = pRootElement->FirstChildElement("enablemultimediakeys");
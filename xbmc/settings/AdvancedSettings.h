@@ -52,6 +52,8 @@ public:
     capath.clear();
     ciphers.clear();
     compression = false;
+    wal = false;
+    readers = 4;
   };
   std::string type;
   std::string host;
@@ -65,6 +67,8 @@ public:
   std::string capath;
   std::string ciphers;
   bool compression;
+  bool wal; ///< use write-ahead logging for sqlite databases, only safe on local filesystems
+  unsigned int readers; ///< maximum number of pooled read-only sqlite connections, 0 to disable
 };
 
 struct TVShowRegexp
@@ -180,6 +184,11 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     bool m_DXVACheckCompatibilityPresent;
     bool m_DXVAForceProcessorRenderer;
     int  m_videoFpsDetect;
+    bool m_videoProbeCache; ///< skip or shorten probing of inputs whose stream info is cached
+    bool m_videoLiveFastStart; ///< start live tv with cached codec parameters and short probing
+    std::string m_videoDecodeThreadType; ///< "auto", "frame" or "slice" threading of the ffmpeg software decoder
+    int m_videoDecodeThreads; ///< number of decoding threads, 0 picks it by resolution and codec
+    bool m_videoDecodeLowLatency; ///< slice threading for live streams, frame threading delays every frame
     bool m_mediacodecForceSoftwareRendering;
     float m_maxTempo;
     bool m_videoPreferStereoStream = false;
@@ -237,6 +246,8 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     int m_sambaclienttimeout;
     std::string m_sambadoscodepage;
     bool m_sambastatfiles;
+    unsigned int m_sambaReadAhead; ///< size in KB of the reads small sequential reads of large smb files are served from, 0 to disable
+    bool m_sambaFileContexts; ///< read large smb files through their own connection instead of the shared one
 
     bool m_bHTTPDirectoryStatFilesize;
 
@@ -252,6 +263,9 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     bool m_bMusicLibraryAllItemsOnBottom;
     bool m_bMusicLibraryCleanOnUpdate;
     bool m_bMusicLibraryArtistSortOnUpdate;
+    int m_iMusicLibraryImportBatchSize; ///< albums added per transaction when scanning, 0 disables bulk import
+    int m_iMusicLibraryTagReaders; ///< number of files to read tags from at once when scanning
+    bool m_bMusicLibraryMonitorChanges; ///< update local music sources from filesystem change notifications
     std::string m_strMusicLibraryAlbumFormat;
     bool m_prioritiseAPEv2tags;
     std::string m_musicItemSeparator;
@@ -263,6 +277,8 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     int m_iVideoLibraryRecentlyAddedItems;
     bool m_bVideoLibraryCleanOnUpdate;
     bool m_bVideoLibraryUseFastHash;
+    int m_iVideoLibraryScanThreads; ///< number of directories to list and hash at once when scanning
+    bool m_bVideoLibraryMonitorChanges; ///< update local video sources from filesystem change notifications
     bool m_bVideoLibraryExportAutoThumbs;
     bool m_bVideoLibraryImportWatchedState;
     bool m_bVideoLibraryImportResumePoint;
@@ -299,6 +315,9 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     int m_curllowspeedtime;
     int m_curlretries;
     bool m_curlDisableIPV6;
+    unsigned int m_curlParallelConnections; ///< number of connections used to read large http files with range support, 1 to use a single one
+    unsigned int m_nfsReadAhead; ///< maximum number of nfs reads kept in flight while reading sequentially, 1 to disable
+    bool m_directoryPrefetch; ///< fetch the network folders around the focused item in the background
 
     bool m_fullScreen;
     bool m_startFullScreen;
@@ -339,6 +358,8 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     DatabaseSettings m_databaseTV;    // advanced tv database setup
     DatabaseSettings m_databaseEpg;   /*!< advanced EPG database setup */
     DatabaseSettings m_databaseSavestates; /*!< advanced savestate database setup */
+    bool m_databaseStatistics; /*!< @brief collect per statement timing statistics of all databases */
+    unsigned int m_databaseSlowQueryTime; /*!< @brief time in msecs after which a statement is logged as slow and its query plan is captured */
 
     bool m_guiVisualizeDirtyRegions;
     int  m_guiAlgorithmDirtyRegions;
@@ -348,6 +369,10 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     unsigned int m_cacheMemSize;
     unsigned int m_cacheBufferMode;
     float m_cacheReadFactor;
+    bool m_cacheAdaptive; ///< size the memory cache of audio/video streams from throughput, bitrate and free memory, starting at memorysize
+    unsigned int m_cacheAdaptiveMaxSize; ///< upper bound in bytes of the adaptive memory cache, 0 for an eighth of the free memory
+    unsigned int m_cachePersistentSize; ///< size in MB of the on-disk segment cache for network files, 0 to disable
+    unsigned int m_directoryCacheSize; ///< size in MB of the in-memory cache of directory listings
 
     bool m_jsonOutputCompact;
     unsigned int m_jsonTcpPort;
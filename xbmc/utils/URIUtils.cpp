@@ -738,6 +738,18 @@ bool URIUtils::IsHD(const std::string& strFileName)
   return url.GetProtocol().empty() || url.IsProtocol("file") || url.IsProtocol("win-lib");
 }
 
+bool URIUtils::IsInstallPath(const std::string& path)
+{
+  // in portable mode the home folder is below the installation
+  for (const char* writable : { "special://home/", "special://masterprofile/", "special://profile/", "special://temp/" })
+  {
+    if (PathHasParent(path, writable, true))
+      return false;
+  }
+
+  return PathHasParent(path, "special://xbmc/", true) || PathHasParent(path, "special://xbmcbin/", true);
+}
+
 bool URIUtils::IsDVD(const std::string& strFile)
 {
   std::string strFileLow = strFile;
@@ -120,6 +120,12 @@ public:
   static bool IsUDP(const std::string& strFile);
   static bool IsTCP(const std::string& strFile);
   static bool IsHD(const std::string& strFileName);
+  /*! \brief Check whether a path is a local file that was installed with Kodi, like the media of
+   the bundled skins. Kodi never writes to these, unlike the files of the profile or home folder.
+   \param path the path to check, may be a special:// path.
+   \return true if the path is below the installation but not below the home, profile or temp folder.
+   */
+  static bool IsInstallPath(const std::string& path);
   static bool IsInArchive(const std::string& strFile);
   static bool IsInRAR(const std::string& strFile);
   static bool IsInternetStream(const std::string& path, bool bStrictCheck = false);
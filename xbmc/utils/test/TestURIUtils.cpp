@@ -11,6 +11,7 @@
 #include "gtest/gtest.h"
 
 #include "filesystem/MultiPathDirectory.h"
+#include "filesystem/SpecialProtocol.h"
 #include "ServiceBroker.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/SettingsComponent.h"
@@ -286,6 +287,18 @@ TEST_F(TestURIUtils, IsHD)
   EXPECT_TRUE(URIUtils::IsHD("zip://path/to/file"));
 }
 
+TEST_F(TestURIUtils, IsInstallPath)
+{
+  EXPECT_TRUE(URIUtils::IsInstallPath("special://xbmc/media/icon256x256.png"));
+  EXPECT_TRUE(URIUtils::IsInstallPath(URIUtils::AddFileToFolder(CSpecialProtocol::TranslatePath("special://xbmc"), "media/icon256x256.png")));
+
+  // the home folder of the tests is below the installation like in portable mode
+  EXPECT_FALSE(URIUtils::IsInstallPath("special://home/addons/skin.estuary/media/icon.png"));
+  EXPECT_FALSE(URIUtils::IsInstallPath("special://temp/thumb.jpg"));
+  EXPECT_FALSE(URIUtils::IsInstallPath("special://profile/Thumbnails/0/0123.jpg"));
+  EXPECT_FALSE(URIUtils::IsInstallPath("http://server/media/icon256x256.png"));
+}
+
 TEST_F(TestURIUtils, IsInArchive)
 {
   EXPECT_TRUE(URIUtils::IsInArchive("zip://path/to/file"));
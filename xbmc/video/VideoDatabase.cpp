@@ -69,6 +69,242 @@ using namespace ADDON;
 using namespace KODI::MESSAGING;
 using namespace KODI::GUILIB;
 
+namespace
+{
+/*! \brief Media whose genres and years are counted for the library nodes.
+ */
+struct SCountedMedia
+{
+  const char* type;
+  const char* table;
+  const char* key;
+};
+
+const SCountedMedia CountedMedia[] = {
+  { "movie", "movie", "idMovie" },
+  { "musicvideo", "musicvideo", "idMVideo" },
+};
+
+/*! \brief SQL checking in an update trigger whether a column has changed, NULL included.
+ */
+std::string Changed(const std::string& column)
+{
+  return "CASE WHEN old." + column + "=new." + column + " OR (old." + column + " IS NULL AND new." + column + " IS NULL) THEN 0 ELSE 1 END=1";
+}
+
+std::string AndWhere(const std::string& condition)
+{
+  return condition.empty() ? "" : " AND (" + condition + ")";
+}
+
+/*! \brief SQL for the year node of a movie or music video row.
+ */
+std::string GetYearSQL(const std::string& row)
+{
+  return "COALESCE(SUBSTR(" + row + ".premiered, 1, 4), '')";
+}
+
+/*! \brief SQL for the number of watched files (0 or 1) of a movie or music video row.
+ */
+std::string GetWatchedSQL(const std::string& row)
+{
+  return "(SELECT COUNT(playCount) FROM files WHERE idFile=" + row + ".idFile)";
+}
+
+/*! \brief Statements recomputing the materialized episode counts of all tvshows and seasons.
+ */
+std::vector<std::string> GetShowCountsSQL()
+{
+  return {
+    "DELETE FROM tvshowcounts",
+    StringUtils::Format("INSERT INTO tvshowcounts (idShow, lastPlayed, totalCount, watchedcount, totalSeasons, dateAdded) "
+                        "SELECT tvshow.idShow, MAX(files.lastPlayed), COUNT(episode.idEpisode), COUNT(files.playCount),"
+                        "  COUNT(DISTINCT(episode.c%02d)), MAX(files.dateAdded) "
+                        "FROM tvshow"
+                        "  LEFT JOIN episode ON episode.idShow=tvshow.idShow"
+                        "  LEFT JOIN files ON files.idFile=episode.idFile "
+                        "GROUP BY tvshow.idShow",
+                        VIDEODB_ID_EPISODE_SEASON),
+    "DELETE FROM seasoncounts",
+    StringUtils::Format("INSERT INTO seasoncounts (idSeason, idShow, episodes, playCount, aired) "
+                        "SELECT seasons.idSeason, seasons.idShow, COUNT(episode.idEpisode), COUNT(files.playCount),"
+                        "  MIN(episode.c%02d) "
+                        "FROM seasons"
+                        "  LEFT JOIN episode ON episode.idSeason=seasons.idSeason"
+                        "  LEFT JOIN files ON files.idFile=episode.idFile "
+                        "GROUP BY seasons.idSeason, seasons.idShow",
+                        VIDEODB_ID_EPISODE_AIRED)
+  };
+}
+
+/*! \brief Statements recomputing the materialized genre and year counts of movies and music videos.
+ */
+std::vector<std::string> GetNodeCountsSQL()
+{
+  std::vector<std::string> statements = { "DELETE FROM genrecounts", "DELETE FROM yearcounts" };
+  for (const auto& media : CountedMedia)
+  {
+    statements.push_back(StringUtils::Format("INSERT INTO genrecounts (genre_id, media_type, total, watched) "
+                                             "SELECT genre.genre_id, '%s', COUNT(%s.%s), COUNT(files.playCount) "
+                                             "FROM genre"
+                                             "  LEFT JOIN genre_link ON genre_link.genre_id=genre.genre_id AND genre_link.media_type='%s'"
+                                             "  LEFT JOIN %s ON %s.%s=genre_link.media_id"
+                                             "  LEFT JOIN files ON files.idFile=%s.idFile "
+                                             "GROUP BY genre.genre_id",
+                                             media.type, media.table, media.key, media.type,
+                                             media.table, media.table, media.key, media.table));
+    statements.push_back(StringUtils::Format("INSERT INTO yearcounts (year, media_type, total, watched) "
+                                             "SELECT %s, '%s', COUNT(1), COUNT(files.playCount) "
+                                             "FROM %s"
+                                             "  LEFT JOIN files ON files.idFile=%s.idFile "
+                                             "GROUP BY %s",
+                                             GetYearSQL(media.table).c_str(), media.type, media.table,
+                                             media.table, GetYearSQL(media.table).c_str()));
+  }
+  return statements;
+}
+
+/*! \brief Statements adding an episode row of a trigger to the counts of its tvshow and season,
+ or removing it.
+ Only the counts are changed. Latest and earliest dates are recomputed when the removed episode
+ held them, which the next episode rarely does.
+ \param row "new" to add the new row, "old" to remove the old row
+ \param showCondition, seasonsCondition, seasonCondition limit an update to the counts whose
+ inputs have changed, empty for inserts and deletes
+ */
+std::vector<std::string> GetEpisodeCountsSQL(const std::string& row,
+                                             const std::string& showCondition = "",
+                                             const std::string& seasonsCondition = "",
+                                             const std::string& seasonCondition = "")
+{
+  const bool add = row == "new";
+  const std::string sign = add ? "+" : "-";
+  const std::string season = StringUtils::Format("%s.c%02d", row.c_str(), VIDEODB_ID_EPISODE_SEASON);
+  const std::string aired = StringUtils::Format("%s.c%02d", row.c_str(), VIDEODB_ID_EPISODE_AIRED);
+  auto fileValue = [&row](const std::string& column)
+  {
+    return "(SELECT " + column + " FROM files WHERE idFile=" + row + ".idFile)";
+  };
+
+  std::string lastPlayed, dateAdded, firstAired;
+  if (add)
+  {
+    auto later = [&fileValue](const std::string& column)
+    {
+      return "CASE WHEN " + column + " IS NULL OR " + fileValue(column) + ">" + column +
+             " THEN " + fileValue(column) + " ELSE " + column + " END";
+    };
+    lastPlayed = later("lastPlayed");
+    dateAdded = later("dateAdded");
+    firstAired = "CASE WHEN aired IS NULL OR " + aired + "<aired THEN " + aired + " ELSE aired END";
+  }
+  else
+  {
+    auto recount = [&row, &fileValue](const std::string& column)
+    {
+      return "CASE WHEN " + column + "=" + fileValue(column) + " THEN (SELECT MAX(files." + column + ") "
+             "FROM episode JOIN files ON files.idFile=episode.idFile "
+             "WHERE episode.idShow=" + row + ".idShow AND episode.idEpisode<>" + row + ".idEpisode) "
+             "ELSE " + column + " END";
+    };
+    lastPlayed = recount("lastPlayed");
+    dateAdded = recount("dateAdded");
+    firstAired = StringUtils::Format("CASE WHEN aired=%s THEN (SELECT MIN(c%02d) FROM episode "
+                                     "WHERE idSeason=%s.idSeason AND idEpisode<>%s.idEpisode) ELSE aired END",
+                                     aired.c_str(), VIDEODB_ID_EPISODE_AIRED, row.c_str(), row.c_str());
+  }
+
+  return {
+    "UPDATE tvshowcounts SET totalCount=totalCount" + sign + "1, watchedcount=watchedcount" + sign + fileValue("COUNT(playCount)") +
+      ", lastPlayed=" + lastPlayed + ", dateAdded=" + dateAdded +
+      " WHERE idShow=" + row + ".idShow" + AndWhere(showCondition),
+    // a season counts as long as one of its episodes is left
+    StringUtils::Format("UPDATE tvshowcounts SET totalSeasons=totalSeasons%s1 WHERE idShow=%s.idShow AND %s IS NOT NULL AND "
+                        "NOT EXISTS (SELECT 1 FROM episode WHERE idShow=%s.idShow AND c%02d=%s AND idEpisode<>%s.idEpisode)",
+                        sign.c_str(), row.c_str(), season.c_str(), row.c_str(), VIDEODB_ID_EPISODE_SEASON,
+                        season.c_str(), row.c_str()) + AndWhere(seasonsCondition),
+    "UPDATE seasoncounts SET episodes=episodes" + sign + "1, playCount=playCount" + sign + fileValue("COUNT(playCount)") +
+      ", aired=" + firstAired +
+      " WHERE idSeason=" + row + ".idSeason" + AndWhere(seasonCondition)
+  };
+}
+
+/*! \brief Statements adding a movie or music video row of a trigger to the count of its year,
+ or removing it.
+ \param row "new" to add the new row, "old" to remove the old row
+ \param condition limits an update to changes of year or file, empty for inserts and deletes
+ */
+std::vector<std::string> GetYearCountsSQL(const SCountedMedia& media, const std::string& row, const std::string& condition = "")
+{
+  const std::string year = GetYearSQL(row);
+  if (row != "new")
+    return { StringUtils::Format("UPDATE yearcounts SET total=total-1, watched=watched-%s WHERE year=%s AND media_type='%s'",
+                                 GetWatchedSQL(row).c_str(), year.c_str(), media.type) + AndWhere(condition) };
+
+  return {
+    StringUtils::Format("INSERT INTO yearcounts (year, media_type, total, watched) SELECT %s, '%s', 0, 0 FROM %s "
+                        "WHERE %s=new.%s AND NOT EXISTS (SELECT 1 FROM yearcounts WHERE year=%s AND media_type='%s')",
+                        year.c_str(), media.type, media.table, media.key, media.key, year.c_str(), media.type),
+    StringUtils::Format("UPDATE yearcounts SET total=total+1, watched=watched+%s WHERE year=%s AND media_type='%s'",
+                        GetWatchedSQL(row).c_str(), year.c_str(), media.type) + AndWhere(condition)
+  };
+}
+
+/*! \brief Statements moving the watched state and dates of a changed or deleted file in the counts of its media.
+ \param playCount, lastPlayed, dateAdded the new values of the file, "NULL" for a deleted file
+ */
+std::vector<std::string> GetFileCountsSQL(const std::string& playCount, const std::string& lastPlayed, const std::string& dateAdded)
+{
+  const std::string watched = "(CASE WHEN " + playCount + " IS NULL THEN 0 ELSE 1 END-"
+                              "CASE WHEN old.playCount IS NULL THEN 0 ELSE 1 END)";
+  auto moved = [](const std::string& column, const std::string& value)
+  {
+    return "CASE WHEN " + value + " IS NOT NULL AND (" + column + " IS NULL OR " + value + ">=" + column + ") THEN " + value +
+           " WHEN " + column + "=old." + column + " THEN (SELECT MAX(files." + column + ") "
+           "FROM episode JOIN files ON files.idFile=episode.idFile WHERE episode.idShow=tvshowcounts.idShow) "
+           "ELSE " + column + " END";
+  };
+
+  std::vector<std::string> statements = {
+    "UPDATE tvshowcounts SET watchedcount=watchedcount+" + watched + ", lastPlayed=" + moved("lastPlayed", lastPlayed) +
+      ", dateAdded=" + moved("dateAdded", dateAdded) +
+      " WHERE idShow IN (SELECT idShow FROM episode WHERE idFile=old.idFile)",
+    "UPDATE seasoncounts SET playCount=playCount+" + watched + " WHERE idSeason IN (SELECT idSeason FROM episode WHERE idFile=old.idFile)"
+  };
+  for (const auto& media : CountedMedia)
+  {
+    statements.push_back(StringUtils::Format("UPDATE genrecounts SET watched=watched+%s WHERE media_type='%s' AND genre_id IN "
+                                             "(SELECT genre_id FROM genre_link JOIN %s ON %s.%s=genre_link.media_id "
+                                             "WHERE genre_link.media_type='%s' AND %s.idFile=old.idFile)",
+                                             watched.c_str(), media.type, media.table, media.table, media.key,
+                                             media.type, media.table));
+    statements.push_back(StringUtils::Format("UPDATE yearcounts SET watched=watched+%s WHERE media_type='%s' AND year IN "
+                                             "(SELECT %s FROM %s WHERE idFile=old.idFile)",
+                                             watched.c_str(), media.type, GetYearSQL(media.table).c_str(), media.table));
+  }
+  return statements;
+}
+
+/*! \brief SQL for the number of watched files (0 or 1) of the media of a genre_link row.
+ */
+std::string GetLinkWatchedSQL(const std::string& row)
+{
+  std::string sql = "CASE " + row + ".media_type";
+  for (const auto& media : CountedMedia)
+    sql += StringUtils::Format(" WHEN '%s' THEN (SELECT COUNT(files.playCount) FROM %s JOIN files ON files.idFile=%s.idFile WHERE %s.%s=%s.media_id)",
+                               media.type, media.table, media.table, media.table, media.key, row.c_str());
+  return sql + " ELSE 0 END";
+}
+
+std::string GetTriggerSQL(const std::vector<std::string>& statements)
+{
+  std::string sql;
+  for (const auto& statement : statements)
+    sql += statement + "; ";
+  return sql;
+}
+}
+
 //********************************************************************************************************************************
 CVideoDatabase::CVideoDatabase(void) = default;
 
@@ -154,6 +390,12 @@ void CVideoDatabase::CreateTables()
   CLog::Log(LOGINFO, "create tvshowlinkpath table");
   m_pDS->exec("CREATE TABLE tvshowlinkpath (idShow integer, idPath integer)\n");
 
+  CLog::Log(LOGINFO, "create tvshowcounts table");
+  CreateShowCountsTables();
+
+  CLog::Log(LOGINFO, "create genrecounts and yearcounts tables");
+  CreateNodeCountsTables();
+
   CLog::Log(LOGINFO, "create movielinktvshow table");
   m_pDS->exec("CREATE TABLE movielinktvshow ( idMovie integer, IdShow integer)\n");
 
@@ -195,6 +437,45 @@ void CVideoDatabase::CreateTables()
   m_pDS->exec("CREATE TABLE uniqueid (uniqueid_id INTEGER PRIMARY KEY, media_id INTEGER, media_type TEXT, value TEXT, type TEXT)");
 }
 
+void CVideoDatabase::CreateShowCountsTables()
+{
+  // episode counts of tvshows and seasons, kept current by the triggers
+  // created in CreateAnalytics()
+  m_pDS->exec("CREATE TABLE tvshowcounts (idShow integer primary key, lastPlayed text, totalCount integer, "
+              "watchedcount integer, totalSeasons integer, dateAdded text)");
+  m_pDS->exec("CREATE TABLE seasoncounts (idSeason integer primary key, idShow integer, episodes integer, "
+              "playCount integer, aired text)");
+}
+
+void CVideoDatabase::CreateNodeCountsTables()
+{
+  // number of movies and music videos of the genre and year nodes, kept current by
+  // the triggers created in CreateAnalytics()
+  m_pDS->exec("CREATE TABLE genrecounts (genre_id integer, media_type text, total integer, watched integer)");
+  m_pDS->exec("CREATE TABLE yearcounts (year text, media_type text, total integer, watched integer)");
+}
+
+std::string CVideoDatabase::GetSearchCondition(const std::string& table, const std::string& key, const std::vector<int>& columns, const std::string& search)
+{
+  std::vector<std::string> names;
+  for (int column : columns)
+    names.push_back(StringUtils::Format("c%02d", column));
+
+  std::vector<std::string> conditions;
+  for (const auto& name : names)
+    conditions.push_back(PrepareSQL("%s.%s LIKE '%%%s%%'", table.c_str(), name.c_str(), search.c_str()));
+  const std::string substring = "(" + StringUtils::Join(conditions, " OR ") + ")";
+
+  const std::string query = GetFullTextQuery(table + "_fts", names, search);
+  if (query.empty())
+    return substring;
+
+  // words are looked up in the index. Only if no word starts with the search,
+  // e.g. "atrix" for "The Matrix", fall back to a substring match.
+  return StringUtils::Format("(%s.%s IN (%s) OR (NOT EXISTS (%s) AND %s))",
+                             table.c_str(), key.c_str(), query.c_str(), query.c_str(), substring.c_str());
+}
+
 void CVideoDatabase::CreateLinkIndex(const char *table)
 {
   m_pDS->exec(PrepareSQL("CREATE UNIQUE INDEX ix_%s_1 ON %s (name(255))", table, table));
@@ -247,6 +528,9 @@ void CVideoDatabase::CreateAnalytics()
   m_pDS->exec(createColIndex);
   m_pDS->exec("CREATE INDEX ix_episode_show1 on episode(idEpisode,idShow)");
   m_pDS->exec("CREATE INDEX ix_episode_show2 on episode(idShow,idEpisode)");
+  createColIndex = StringUtils::Format("CREATE INDEX ix_episode_show_season on episode (idShow, c%02d)", VIDEODB_ID_EPISODE_SEASON);
+  m_pDS->exec(createColIndex);
+  m_pDS->exec("CREATE INDEX ix_episode_idseason on episode (idSeason)");
 
   m_pDS->exec("CREATE UNIQUE INDEX ix_musicvideo_file_1 on musicvideo (idMVideo, idFile)");
   m_pDS->exec("CREATE UNIQUE INDEX ix_musicvideo_file_2 on musicvideo (idFile, idMVideo)");
@@ -257,6 +541,9 @@ void CVideoDatabase::CreateAnalytics()
 
   m_pDS->exec("CREATE INDEX ix_streamdetails ON streamdetails (idFile)");
   m_pDS->exec("CREATE INDEX ix_seasons ON seasons (idShow, season)");
+  m_pDS->exec("CREATE INDEX ix_seasoncounts ON seasoncounts (idShow)");
+  m_pDS->exec("CREATE UNIQUE INDEX ix_genrecounts ON genrecounts (genre_id, media_type(20))");
+  m_pDS->exec("CREATE UNIQUE INDEX ix_yearcounts ON yearcounts (year(4), media_type(20))");
   m_pDS->exec("CREATE INDEX ix_art ON art(media_id, media_type(20), type(20))");
 
   m_pDS->exec("CREATE INDEX ix_rating ON rating(media_id, media_type(20))");
@@ -273,7 +560,12 @@ void CVideoDatabase::CreateAnalytics()
   CreateLinkIndex("country");
 
   CLog::Log(LOGINFO, "%s - creating triggers", __FUNCTION__);
-  m_pDS->exec("CREATE TRIGGER delete_movie AFTER DELETE ON movie FOR EACH ROW BEGIN "
+  // the genre links of deleted media can't find their file anymore, so take the
+  // watched state off the genre counts first
+  m_pDS->exec("CREATE TRIGGER delete_movie AFTER DELETE ON movie FOR EACH ROW BEGIN " +
+              GetTriggerSQL(GetYearCountsSQL(CountedMedia[0], "old")) +
+              "UPDATE genrecounts SET watched=watched-" + GetWatchedSQL("old") + " WHERE media_type='movie' AND "
+              "genre_id IN (SELECT genre_id FROM genre_link WHERE media_id=old.idMovie AND media_type='movie'); "
               "DELETE FROM genre_link WHERE media_id=old.idMovie AND media_type='movie'; "
               "DELETE FROM actor_link WHERE media_id=old.idMovie AND media_type='movie'; "
               "DELETE FROM director_link WHERE media_id=old.idMovie AND media_type='movie'; "
@@ -298,8 +590,12 @@ void CVideoDatabase::CreateAnalytics()
               "DELETE FROM tag_link WHERE media_id=old.idShow AND media_type='tvshow'; "
               "DELETE FROM rating WHERE media_id=old.idShow AND media_type='tvshow'; "
               "DELETE FROM uniqueid WHERE media_id=old.idShow AND media_type='tvshow'; "
+              "DELETE FROM tvshowcounts WHERE idShow=old.idShow; "
               "END");
-  m_pDS->exec("CREATE TRIGGER delete_musicvideo AFTER DELETE ON musicvideo FOR EACH ROW BEGIN "
+  m_pDS->exec("CREATE TRIGGER delete_musicvideo AFTER DELETE ON musicvideo FOR EACH ROW BEGIN " +
+              GetTriggerSQL(GetYearCountsSQL(CountedMedia[1], "old")) +
+              "UPDATE genrecounts SET watched=watched-" + GetWatchedSQL("old") + " WHERE media_type='musicvideo' AND "
+              "genre_id IN (SELECT genre_id FROM genre_link WHERE media_id=old.idMVideo AND media_type='musicvideo'); "
               "DELETE FROM actor_link WHERE media_id=old.idMVideo AND media_type='musicvideo'; "
               "DELETE FROM director_link WHERE media_id=old.idMVideo AND media_type='musicvideo'; "
               "DELETE FROM genre_link WHERE media_id=old.idMVideo AND media_type='musicvideo'; "
@@ -313,10 +609,12 @@ void CVideoDatabase::CreateAnalytics()
               "DELETE FROM writer_link WHERE media_id=old.idEpisode AND media_type='episode'; "
               "DELETE FROM art WHERE media_id=old.idEpisode AND media_type='episode'; "
               "DELETE FROM rating WHERE media_id=old.idEpisode AND media_type='episode'; "
-              "DELETE FROM uniqueid WHERE media_id=old.idEpisode AND media_type='episode'; "
+              "DELETE FROM uniqueid WHERE media_id=old.idEpisode AND media_type='episode'; " +
+              GetTriggerSQL(GetEpisodeCountsSQL("old")) +
               "END");
   m_pDS->exec("CREATE TRIGGER delete_season AFTER DELETE ON seasons FOR EACH ROW BEGIN "
               "DELETE FROM art WHERE media_id=old.idSeason AND media_type='season'; "
+              "DELETE FROM seasoncounts WHERE idSeason=old.idSeason; "
               "END");
   m_pDS->exec("CREATE TRIGGER delete_set AFTER DELETE ON sets FOR EACH ROW BEGIN "
               "DELETE FROM art WHERE media_id=old.idSet AND media_type='set'; "
@@ -331,9 +629,82 @@ void CVideoDatabase::CreateAnalytics()
               "DELETE FROM bookmark WHERE idFile=old.idFile; "
               "DELETE FROM settings WHERE idFile=old.idFile; "
               "DELETE FROM stacktimes WHERE idFile=old.idFile; "
-              "DELETE FROM streamdetails WHERE idFile=old.idFile; "
+              "DELETE FROM streamdetails WHERE idFile=old.idFile; " +
+              GetTriggerSQL(GetFileCountsSQL("NULL", "NULL", "NULL")) +
               "END");
 
+  // keep the materialized counts current, one row at a time. Playcounts and dates live in files.
+  m_pDS->exec("CREATE TRIGGER insert_tvshow AFTER INSERT ON tvshow FOR EACH ROW BEGIN "
+              "INSERT INTO tvshowcounts (idShow, totalCount, watchedcount, totalSeasons) VALUES (new.idShow, 0, 0, 0); "
+              "END");
+  m_pDS->exec("CREATE TRIGGER insert_season AFTER INSERT ON seasons FOR EACH ROW BEGIN "
+              "INSERT INTO seasoncounts (idSeason, idShow, episodes, playCount) VALUES (new.idSeason, new.idShow, 0, 0); "
+              "END");
+  m_pDS->exec("CREATE TRIGGER insert_episode AFTER INSERT ON episode FOR EACH ROW BEGIN " +
+              GetTriggerSQL(GetEpisodeCountsSQL("new")) +
+              "END");
+  const std::string showChanged = "old.idShow<>new.idShow OR old.idFile<>new.idFile";
+  const std::string seasonsChanged = "old.idShow<>new.idShow OR " + Changed(StringUtils::Format("c%02d", VIDEODB_ID_EPISODE_SEASON));
+  const std::string seasonChanged = Changed("idSeason") + " OR old.idFile<>new.idFile OR " + Changed(StringUtils::Format("c%02d", VIDEODB_ID_EPISODE_AIRED));
+  m_pDS->exec("CREATE TRIGGER update_episode AFTER UPDATE ON episode FOR EACH ROW BEGIN " +
+              GetTriggerSQL(GetEpisodeCountsSQL("old", showChanged, seasonsChanged, seasonChanged)) +
+              GetTriggerSQL(GetEpisodeCountsSQL("new", showChanged, seasonsChanged, seasonChanged)) +
+              "END");
+  m_pDS->exec("CREATE TRIGGER update_file AFTER UPDATE ON files FOR EACH ROW BEGIN " +
+              GetTriggerSQL(GetFileCountsSQL("new.playCount", "new.lastPlayed", "new.dateAdded")) +
+              "END");
+  for (const auto& media : CountedMedia)
+  {
+    const std::string changed = GetYearSQL("old") + "<>" + GetYearSQL("new") + " OR old.idFile<>new.idFile";
+    m_pDS->exec(StringUtils::Format("CREATE TRIGGER insert_%s_counts AFTER INSERT ON %s FOR EACH ROW BEGIN ", media.type, media.table) +
+                GetTriggerSQL(GetYearCountsSQL(media, "new")) +
+                "END");
+    m_pDS->exec(StringUtils::Format("CREATE TRIGGER update_%s_counts AFTER UPDATE ON %s FOR EACH ROW BEGIN ", media.type, media.table) +
+                GetTriggerSQL(GetYearCountsSQL(media, "old", changed)) +
+                GetTriggerSQL(GetYearCountsSQL(media, "new", changed)) +
+                StringUtils::Format("UPDATE genrecounts SET watched=watched-%s+%s WHERE media_type='%s' AND "
+                                    "genre_id IN (SELECT genre_id FROM genre_link WHERE media_id=new.%s AND media_type='%s') AND "
+                                    "old.idFile<>new.idFile; ",
+                                    GetWatchedSQL("old").c_str(), GetWatchedSQL("new").c_str(), media.type,
+                                    media.key, media.type) +
+                "END");
+  }
+  std::string genreCounts;
+  for (const auto& media : CountedMedia)
+    genreCounts += PrepareSQL("INSERT INTO genrecounts (genre_id, media_type, total, watched) VALUES (new.genre_id, '%s', 0, 0); ", media.type);
+  m_pDS->exec("CREATE TRIGGER insert_genre AFTER INSERT ON genre FOR EACH ROW BEGIN " +
+              genreCounts +
+              "END");
+  m_pDS->exec("CREATE TRIGGER delete_genre AFTER DELETE ON genre FOR EACH ROW BEGIN "
+              "DELETE FROM genrecounts WHERE genre_id=old.genre_id; "
+              "END");
+  m_pDS->exec("CREATE TRIGGER insert_genre_link AFTER INSERT ON genre_link FOR EACH ROW BEGIN "
+              "UPDATE genrecounts SET total=total+1, watched=watched+" + GetLinkWatchedSQL("new") + " "
+              "WHERE genre_id=new.genre_id AND media_type=new.media_type; "
+              "END");
+  m_pDS->exec("CREATE TRIGGER delete_genre_link AFTER DELETE ON genre_link FOR EACH ROW BEGIN "
+              "UPDATE genrecounts SET total=total-1, watched=watched-" + GetLinkWatchedSQL("old") + " "
+              "WHERE genre_id=old.genre_id AND media_type=old.media_type; "
+              "END");
+
+  CLog::Log(LOGINFO, "%s - creating full-text indices", __FUNCTION__);
+  CreateFullTextIndex("movie_fts", "movie", "idMovie",
+                      {StringUtils::Format("c%02d", VIDEODB_ID_TITLE), StringUtils::Format("c%02d", VIDEODB_ID_PLOT),
+                       StringUtils::Format("c%02d", VIDEODB_ID_PLOTOUTLINE), StringUtils::Format("c%02d", VIDEODB_ID_TAGLINE)});
+  CreateFullTextIndex("tvshow_fts", "tvshow", "idShow",
+                      {StringUtils::Format("c%02d", VIDEODB_ID_TV_TITLE), StringUtils::Format("c%02d", VIDEODB_ID_TV_PLOT)});
+  CreateFullTextIndex("episode_fts", "episode", "idEpisode",
+                      {StringUtils::Format("c%02d", VIDEODB_ID_EPISODE_TITLE), StringUtils::Format("c%02d", VIDEODB_ID_EPISODE_PLOT)});
+  CreateFullTextIndex("musicvideo_fts", "musicvideo", "idMVideo",
+                      {StringUtils::Format("c%02d", VIDEODB_ID_MUSICVIDEO_TITLE), StringUtils::Format("c%02d", VIDEODB_ID_MUSICVIDEO_ARTIST)});
+
+  // the triggers are dropped while updating the schema, so rebuild the counts
+  CLog::Log(LOGINFO, "%s - updating tvshow, genre and year counts", __FUNCTION__);
+  for (const auto& statement : GetShowCountsSQL())
+    m_pDS->exec(statement);
+  for (const auto& statement : GetNodeCountsSQL())
+    m_pDS->exec(statement);
+
   CreateViews();
 }
 
@@ -381,22 +752,6 @@ void CVideoDatabase::CreateViews()
                                       VIDEODB_ID_EPISODE_IDENT_ID);
   m_pDS->exec(episodeview);
 
-  CLog::Log(LOGINFO, "create tvshowcounts");
-  std::string tvshowcounts = PrepareSQL("CREATE VIEW tvshowcounts AS SELECT "
-                                       "      tvshow.idShow AS idShow,"
-                                       "      MAX(files.lastPlayed) AS lastPlayed,"
-                                       "      NULLIF(COUNT(episode.c12), 0) AS totalCount,"
-                                       "      COUNT(files.playCount) AS watchedcount,"
-                                       "      NULLIF(COUNT(DISTINCT(episode.c12)), 0) AS totalSeasons, "
-                                       "      MAX(files.dateAdded) as dateAdded "
-                                       "    FROM tvshow"
-                                       "      LEFT JOIN episode ON"
-                                       "        episode.idShow=tvshow.idShow"
-                                       "      LEFT JOIN files ON"
-                                       "        files.idFile=episode.idFile "
-                                       "GROUP BY tvshow.idShow");
-  m_pDS->exec(tvshowcounts);
-
   CLog::Log(LOGINFO, "create tvshowlinkpath_minview");
   // This view only exists to workaround a limitation in MySQL <5.7 which is not able to
   // perform subqueries in joins.
@@ -417,7 +772,10 @@ void CVideoDatabase::CreateViews()
                                      "  path.idParentPath AS idParentPath,"
                                      "  path.strPath AS strPath,"
                                      "  tvshowcounts.dateAdded AS dateAdded,"
-                                     "  lastPlayed, totalCount, watchedcount, totalSeasons, "
+                                     "  tvshowcounts.lastPlayed AS lastPlayed,"
+                                     "  NULLIF(tvshowcounts.totalCount, 0) AS totalCount,"
+                                     "  tvshowcounts.watchedcount AS watchedcount,"
+                                     "  NULLIF(tvshowcounts.totalSeasons, 0) AS totalSeasons, "
                                      "  rating.rating AS rating, "
                                      "  rating.votes AS votes, "
                                      "  rating.rating_type AS rating_type, "
@@ -451,31 +809,14 @@ void CVideoDatabase::CreateViews()
                                      "  tvshow_view.c%02d AS genre,"
                                      "  tvshow_view.c%02d AS studio,"
                                      "  tvshow_view.c%02d AS mpaa,"
-                                     "  count(DISTINCT episode.idEpisode) AS episodes,"
-                                     "  count(files.playCount) AS playCount,"
-                                     "  min(episode.c%02d) AS aired "
+                                     "  seasoncounts.episodes AS episodes,"
+                                     "  seasoncounts.playCount AS playCount,"
+                                     "  seasoncounts.aired AS aired "
                                      "FROM seasons"
                                      "  JOIN tvshow_view ON"
                                      "    tvshow_view.idShow = seasons.idShow"
-                                     "  JOIN episode ON"
-                                     "    episode.idShow = seasons.idShow AND episode.c%02d = seasons.season"
-                                     "  JOIN files ON"
-                                     "    files.idFile = episode.idFile "
-                                     "GROUP BY seasons.idSeason,"
-                                     "         seasons.idShow,"
-                                     "         seasons.season,"
-                                     "         seasons.name,"
-                                     "         seasons.userrating,"
-                                     "         tvshow_view.strPath,"
-                                     "         tvshow_view.c%02d,"
-                                     "         tvshow_view.c%02d,"
-                                     "         tvshow_view.c%02d,"
-                                     "         tvshow_view.c%02d,"
-                                     "         tvshow_view.c%02d,"
-                                     "         tvshow_view.c%02d ",
-                                     VIDEODB_ID_TV_TITLE, VIDEODB_ID_TV_PLOT, VIDEODB_ID_TV_PREMIERED,
-                                     VIDEODB_ID_TV_GENRE, VIDEODB_ID_TV_STUDIOS, VIDEODB_ID_TV_MPAA,
-                                     VIDEODB_ID_EPISODE_AIRED, VIDEODB_ID_EPISODE_SEASON,
+                                     "  JOIN seasoncounts ON"
+                                     "    seasoncounts.idSeason = seasons.idSeason AND seasoncounts.episodes > 0",
                                      VIDEODB_ID_TV_TITLE, VIDEODB_ID_TV_PLOT, VIDEODB_ID_TV_PREMIERED,
                                      VIDEODB_ID_TV_GENRE, VIDEODB_ID_TV_STUDIOS, VIDEODB_ID_TV_MPAA);
   m_pDS->exec(seasonview);
@@ -754,21 +1095,13 @@ int CVideoDatabase::AddPath(const std::string& strPath, const std::string &paren
     int idParentPath = GetPathId(parentPath.empty() ? URIUtils::GetParentPath(strPath1) : parentPath);
 
     // add the path
-    if (idParentPath < 0)
-    {
-      if (dateAdded.IsValid())
-        strSQL=PrepareSQL("insert into path (idPath, strPath, dateAdded) values (NULL, '%s', '%s')", strPath1.c_str(), dateAdded.GetAsDBDateTime().c_str());
-      else
-        strSQL=PrepareSQL("insert into path (idPath, strPath) values (NULL, '%s')", strPath1.c_str());
-    }
-    else
-    {
-      if (dateAdded.IsValid())
-        strSQL = PrepareSQL("insert into path (idPath, strPath, dateAdded, idParentPath) values (NULL, '%s', '%s', %i)", strPath1.c_str(), dateAdded.GetAsDBDateTime().c_str(), idParentPath);
-      else
-        strSQL=PrepareSQL("insert into path (idPath, strPath, idParentPath) values (NULL, '%s', %i)", strPath1.c_str(), idParentPath);
-    }
-    m_pDS->exec(strSQL);
+    dbiplus::field_value nullValue;
+    nullValue.set_isNull();
+    strSQL = "insert into path (idPath, strPath, dateAdded, idParentPath) values (NULL, ?, ?, ?)";
+    m_pDS->exec_prepared(strSQL, {
+        dbiplus::field_value(strPath1),
+        dateAdded.IsValid() ? dbiplus::field_value(dateAdded.GetAsDBDateTime()) : nullValue,
+        idParentPath < 0 ? nullValue : dbiplus::field_value(idParentPath) });
     idPath = (int)m_pDS->lastinsertid();
     return idPath;
   }
@@ -900,9 +1233,8 @@ int CVideoDatabase::AddFile(const std::string& strFileNameAndPath)
     if (idPath < 0)
       return -1;
 
-    std::string strSQL=PrepareSQL("select idFile from files where strFileName='%s' and idPath=%i", strFileName.c_str(),idPath);
-
-    m_pDS->query(strSQL);
+    strSQL = "select idFile from files where strFileName = ? and idPath = ?";
+    m_pDS->query_prepared(strSQL, { dbiplus::field_value(strFileName), dbiplus::field_value(idPath) });
     if (m_pDS->num_rows() > 0)
     {
       idFile = m_pDS->fv("idFile").get_asInt() ;
@@ -911,8 +1243,8 @@ int CVideoDatabase::AddFile(const std::string& strFileNameAndPath)
     }
     m_pDS->close();
 
-    strSQL=PrepareSQL("insert into files (idFile, idPath, strFileName) values(NULL, %i, '%s')", idPath, strFileName.c_str());
-    m_pDS->exec(strSQL);
+    strSQL = "insert into files (idFile, idPath, strFileName) values(NULL, ?, ?)";
+    m_pDS->exec_prepared(strSQL, { dbiplus::field_value(idPath), dbiplus::field_value(strFileName) });
     idFile = (int)m_pDS->lastinsertid();
     return idFile;
   }
@@ -4472,24 +4804,27 @@ void CVideoDatabase::SetArtForItem(int mediaId, const MediaType &mediaType, cons
     if (artType.find('.') != std::string::npos)
       return;
 
-    std::string sql = PrepareSQL("SELECT art_id,url FROM art WHERE media_id=%i AND media_type='%s' AND type='%s'", mediaId, mediaType.c_str(), artType.c_str());
-    m_pDS->query(sql);
+    m_pDS->query_prepared("SELECT art_id,url FROM art WHERE media_id = ? AND media_type = ? AND type = ?",
+                          { dbiplus::field_value(mediaId),
+                            dbiplus::field_value(mediaType),
+                            dbiplus::field_value(artType) });
     if (!m_pDS->eof())
     { // update
       int artId = m_pDS->fv(0).get_asInt();
       std::string oldUrl = m_pDS->fv(1).get_asString();
       m_pDS->close();
       if (oldUrl != url)
-      {
-        sql = PrepareSQL("UPDATE art SET url='%s' where art_id=%d", url.c_str(), artId);
-        m_pDS->exec(sql);
-      }
+        m_pDS->exec_prepared("UPDATE art SET url = ? where art_id = ?",
+                             { dbiplus::field_value(url), dbiplus::field_value(artId) });
     }
     else
     { // insert
       m_pDS->close();
-      sql = PrepareSQL("INSERT INTO art(media_id, media_type, type, url) VALUES (%d, '%s', '%s', '%s')", mediaId, mediaType.c_str(), artType.c_str(), url.c_str());
-      m_pDS->exec(sql);
+      m_pDS->exec_prepared("INSERT INTO art(media_id, media_type, type, url) VALUES (?, ?, ?, ?)",
+                           { dbiplus::field_value(mediaId),
+                             dbiplus::field_value(mediaType),
+                             dbiplus::field_value(artType),
+                             dbiplus::field_value(url) });
     }
   }
   catch (...)
@@ -5577,11 +5912,18 @@ void CVideoDatabase::UpdateTables(int iVersion)
     }
     m_pDS->close();
   }
+
+  // counts are filled in by CreateAnalytics()
+  if (iVersion < 117)
+  {
+    CreateShowCountsTables();
+    CreateNodeCountsTables();
+  }
 }
 
 int CVideoDatabase::GetSchemaVersion() const
 {
-  return 116;
+  return 117;
 }
 
 bool CVideoDatabase::LookupByFolders(const std::string &path, bool shows)
@@ -6052,13 +6394,23 @@ bool CVideoDatabase::GetNavCommon(const std::string& strBaseDir, CFileItemList&
         return false;
 
       strSQL = "SELECT %s " + PrepareSQL("FROM %s ", type);
-      extFilter.fields = PrepareSQL("%s.%s_id, %s.name", type, type, type);
-      extFilter.AppendField(extraField);
-      extFilter.AppendJoin(PrepareSQL("JOIN %s_link ON %s.%s_id = %s_link.%s_id", type, type, type, type, type));
-      extFilter.AppendJoin(PrepareSQL("JOIN %s_view ON %s_link.media_id = %s_view.%s AND %s_link.media_type='%s'",
-                                      view.c_str(), type, view.c_str(), view_id.c_str(), type, media_type.c_str()));
-      extFilter.AppendJoin(extraJoin);
-      extFilter.AppendGroup(PrepareSQL("%s.%s_id", type, type));
+      if (StringUtils::EqualsNoCase(type, "genre") && !extraField.empty() && IsUnfiltered(strBaseDir, filter))
+      {
+        // the counts of all genres are kept by triggers
+        extFilter.fields = "genre.genre_id, genre.name, genrecounts.total, genrecounts.watched";
+        extFilter.AppendJoin(PrepareSQL("JOIN genrecounts ON genrecounts.genre_id = genre.genre_id AND genrecounts.media_type='%s'", media_type.c_str()));
+        extFilter.AppendWhere("genrecounts.total > 0");
+      }
+      else
+      {
+        extFilter.fields = PrepareSQL("%s.%s_id, %s.name", type, type, type);
+        extFilter.AppendField(extraField);
+        extFilter.AppendJoin(PrepareSQL("JOIN %s_link ON %s.%s_id = %s_link.%s_id", type, type, type, type, type));
+        extFilter.AppendJoin(PrepareSQL("JOIN %s_view ON %s_link.media_id = %s_view.%s AND %s_link.media_type='%s'",
+                                        view.c_str(), type, view.c_str(), view_id.c_str(), type, media_type.c_str()));
+        extFilter.AppendJoin(extraJoin);
+        extFilter.AppendGroup(PrepareSQL("%s.%s_id", type, type));
+      }
     }
 
     if (countOnly)
@@ -6614,6 +6966,13 @@ bool CVideoDatabase::GetPeopleNav(const std::string& strBaseDir, CFileItemList&
   return false;
 }
 
+bool CVideoDatabase::IsUnfiltered(const std::string& strBaseDir, const Filter& filter)
+{
+  CVideoDbUrl videoUrl;
+  return filter.where.empty() && filter.join.empty() &&
+         videoUrl.FromString(strBaseDir) && videoUrl.GetOptions().empty();
+}
+
 bool CVideoDatabase::GetYearsNav(const std::string& strBaseDir, CFileItemList& items, int idContent /* = -1 */, const Filter &filter /* = Filter() */)
 {
   try
@@ -6646,7 +7005,14 @@ bool CVideoDatabase::GetYearsNav(const std::string& strBaseDir, CFileItemList& i
     else
     {
       std::string group;
-      if (idContent == VIDEODB_CONTENT_MOVIES)
+      if ((idContent == VIDEODB_CONTENT_MOVIES || idContent == VIDEODB_CONTENT_MUSICVIDEOS) && IsUnfiltered(strBaseDir, filter))
+      {
+        // the counts of all years are kept by triggers
+        strSQL = "select yearcounts.year, yearcounts.total, yearcounts.watched from yearcounts ";
+        extFilter.AppendWhere(PrepareSQL("yearcounts.media_type = '%s' AND yearcounts.total > 0",
+                                         idContent == VIDEODB_CONTENT_MOVIES ? MediaTypeMovie : MediaTypeMusicVideo));
+      }
+      else if (idContent == VIDEODB_CONTENT_MOVIES)
       {
         strSQL = "select movie_view.premiered, count(1), count(files.playCount) from movie_view ";
         extFilter.AppendJoin("join files on files.idFile = movie_view.idFile");
@@ -7111,6 +7477,9 @@ bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filte
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
+    // listings can be large, run them alongside other users of the database
+    CReadScope readScope(*this);
+
     // parse the base path to get additional filters
     CVideoDbUrl videoUrl;
     Filter extFilter = filter;
@@ -7136,6 +7505,52 @@ bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filte
 
     strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
 
+    auto addRecord = [&](const dbiplus::sql_record* const record)
+    {
+      CVideoInfoTag movie = GetDetailsForMovie(record, getDetails);
+      if (m_profileManager.GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
+          g_passwordManager.bMasterUser                                   ||
+          g_passwordManager.IsDatabasePathUnlocked(movie.m_strPath, *CMediaSourceSettings::GetInstance().GetSources("video")))
+      {
+        CFileItemPtr pItem(new CFileItem(movie));
+
+        CVideoDbUrl itemUrl = videoUrl;
+        std::string path = StringUtils::Format("%i", movie.m_iDbId);
+        itemUrl.AppendPath(path);
+        pItem->SetPath(itemUrl.ToString());
+        pItem->SetDynPath(movie.m_strFileNameAndPath);
+
+        pItem->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED,movie.GetPlayCount() > 0);
+        items.Add(pItem);
+      }
+    };
+
+    // Rows are used in the order returned unless sorting from the dataset, so
+    // stream them rather than hold the whole result set in memory
+    if (sortDescription.sortBy == SortByNone)
+    {
+      unsigned int time = XbmcThreads::SystemClockMillis();
+      if (!m_pDS->query_stream(strSQL))
+        return false;
+
+      while (!m_pDS->eof())
+      {
+        addRecord(m_pDS->get_sql_record());
+        m_pDS->next();
+      }
+      int iRowsFound = m_pDS->num_rows();
+      CLog::Log(LOGDEBUG, LOGDATABASE, "%s took %d ms for %d items query: %s", __FUNCTION__, XbmcThreads::SystemClockMillis() - time, iRowsFound, strSQL.c_str());
+      m_pDS->close();
+      if (iRowsFound == 0)
+        return true;
+
+      // store the total value of items as a property
+      if (total < iRowsFound)
+        total = iRowsFound;
+      items.SetProperty("total", total);
+      return true;
+    }
+
     int iRowsFound = RunQuery(strSQL);
     if (iRowsFound <= 0)
       return iRowsFound == 0;
@@ -7157,24 +7572,7 @@ bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filte
     for (const auto &i : results)
     {
       unsigned int targetRow = (unsigned int)i.at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
-
-      CVideoInfoTag movie = GetDetailsForMovie(record, getDetails);
-      if (m_profileManager.GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
-          g_passwordManager.bMasterUser                                   ||
-          g_passwordManager.IsDatabasePathUnlocked(movie.m_strPath, *CMediaSourceSettings::GetInstance().GetSources("video")))
-      {
-        CFileItemPtr pItem(new CFileItem(movie));
-
-        CVideoDbUrl itemUrl = videoUrl;
-        std::string path = StringUtils::Format("%i", movie.m_iDbId);
-        itemUrl.AppendPath(path);
-        pItem->SetPath(itemUrl.ToString());
-        pItem->SetDynPath(movie.m_strFileNameAndPath);
-
-        pItem->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED,movie.GetPlayCount() > 0);
-        items.Add(pItem);
-      }
+      addRecord(data.at(targetRow));
     }
 
     // cleanup
@@ -7224,6 +7622,8 @@ bool CVideoDatabase::GetTvShowsByWhere(const std::string& strBaseDir, const Filt
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
+    CReadScope readScope(*this);
+
     int total = -1;
 
     std::string strSQL = "SELECT %s FROM tvshow_view ";
@@ -7350,6 +7750,8 @@ bool CVideoDatabase::GetEpisodesByWhere(const std::string& strBaseDir, const Fil
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
+    CReadScope readScope(*this);
+
     int total = -1;
 
     std::string strSQL = "select %s from episode_view ";
@@ -8192,6 +8594,8 @@ bool CVideoDatabase::GetMusicVideosByWhere(const std::string &baseDir, const Fil
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
+    CReadScope readScope(*this);
+
     int total = -1;
 
     std::string strSQL = "select %s from musicvideo_view ";
@@ -8352,10 +8756,12 @@ void CVideoDatabase::GetMoviesByName(const std::string& strSearch, CFileItemList
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::string condition = GetSearchCondition("movie", "idMovie", {VIDEODB_ID_TITLE}, strSearch);
+
     if (m_profileManager.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("SELECT movie.idMovie, movie.c%02d, path.strPath, movie.idSet FROM movie INNER JOIN files ON files.idFile=movie.idFile INNER JOIN path ON path.idPath=files.idPath WHERE movie.c%02d LIKE '%%%s%%'", VIDEODB_ID_TITLE, VIDEODB_ID_TITLE, strSearch.c_str());
+      strSQL = StringUtils::Format("SELECT movie.idMovie, movie.c%02d, path.strPath, movie.idSet FROM movie INNER JOIN files ON files.idFile=movie.idFile INNER JOIN path ON path.idPath=files.idPath WHERE %s", VIDEODB_ID_TITLE, condition.c_str());
     else
-      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d, movie.idSet from movie where movie.c%02d like '%%%s%%'",VIDEODB_ID_TITLE,VIDEODB_ID_TITLE,strSearch.c_str());
+      strSQL = StringUtils::Format("select movie.idMovie,movie.c%02d, movie.idSet from movie where %s",VIDEODB_ID_TITLE,condition.c_str());
     m_pDS->query( strSQL );
 
     while (!m_pDS->eof())
@@ -8397,10 +8803,12 @@ void CVideoDatabase::GetTvShowsByName(const std::string& strSearch, CFileItemLis
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::string condition = GetSearchCondition("tvshow", "idShow", {VIDEODB_ID_TV_TITLE}, strSearch);
+
     if (m_profileManager.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("SELECT tvshow.idShow, tvshow.c%02d, path.strPath FROM tvshow INNER JOIN tvshowlinkpath ON tvshowlinkpath.idShow=tvshow.idShow INNER JOIN path ON path.idPath=tvshowlinkpath.idPath WHERE tvshow.c%02d LIKE '%%%s%%'", VIDEODB_ID_TV_TITLE, VIDEODB_ID_TV_TITLE, strSearch.c_str());
+      strSQL = StringUtils::Format("SELECT tvshow.idShow, tvshow.c%02d, path.strPath FROM tvshow INNER JOIN tvshowlinkpath ON tvshowlinkpath.idShow=tvshow.idShow INNER JOIN path ON path.idPath=tvshowlinkpath.idPath WHERE %s", VIDEODB_ID_TV_TITLE, condition.c_str());
     else
-      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d from tvshow where tvshow.c%02d like '%%%s%%'",VIDEODB_ID_TV_TITLE,VIDEODB_ID_TV_TITLE,strSearch.c_str());
+      strSQL = StringUtils::Format("select tvshow.idShow,tvshow.c%02d from tvshow where %s",VIDEODB_ID_TV_TITLE,condition.c_str());
     m_pDS->query( strSQL );
 
     while (!m_pDS->eof())
@@ -8438,10 +8846,12 @@ void CVideoDatabase::GetEpisodesByName(const std::string& strSearch, CFileItemLi
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::string condition = GetSearchCondition("episode", "idEpisode", {VIDEODB_ID_EPISODE_TITLE}, strSearch);
+
     if (m_profileManager.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("SELECT episode.idEpisode, episode.c%02d, episode.c%02d, episode.idShow, tvshow.c%02d, path.strPath FROM episode INNER JOIN tvshow ON tvshow.idShow=episode.idShow INNER JOIN files ON files.idFile=episode.idFile INNER JOIN path ON path.idPath=files.idPath WHERE episode.c%02d LIKE '%%%s%%'", VIDEODB_ID_EPISODE_TITLE, VIDEODB_ID_EPISODE_SEASON, VIDEODB_ID_TV_TITLE, VIDEODB_ID_EPISODE_TITLE, strSearch.c_str());
+      strSQL = StringUtils::Format("SELECT episode.idEpisode, episode.c%02d, episode.c%02d, episode.idShow, tvshow.c%02d, path.strPath FROM episode INNER JOIN tvshow ON tvshow.idShow=episode.idShow INNER JOIN files ON files.idFile=episode.idFile INNER JOIN path ON path.idPath=files.idPath WHERE %s", VIDEODB_ID_EPISODE_TITLE, VIDEODB_ID_EPISODE_SEASON, VIDEODB_ID_TV_TITLE, condition.c_str());
     else
-      strSQL = PrepareSQL("SELECT episode.idEpisode, episode.c%02d, episode.c%02d, episode.idShow, tvshow.c%02d FROM episode INNER JOIN tvshow ON tvshow.idShow=episode.idShow WHERE episode.c%02d like '%%%s%%'", VIDEODB_ID_EPISODE_TITLE, VIDEODB_ID_EPISODE_SEASON, VIDEODB_ID_TV_TITLE, VIDEODB_ID_EPISODE_TITLE, strSearch.c_str());
+      strSQL = StringUtils::Format("SELECT episode.idEpisode, episode.c%02d, episode.c%02d, episode.idShow, tvshow.c%02d FROM episode INNER JOIN tvshow ON tvshow.idShow=episode.idShow WHERE %s", VIDEODB_ID_EPISODE_TITLE, VIDEODB_ID_EPISODE_SEASON, VIDEODB_ID_TV_TITLE, condition.c_str());
     m_pDS->query( strSQL );
 
     while (!m_pDS->eof())
@@ -8481,10 +8891,12 @@ void CVideoDatabase::GetMusicVideosByName(const std::string& strSearch, CFileIte
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::string condition = GetSearchCondition("musicvideo", "idMVideo", {VIDEODB_ID_MUSICVIDEO_TITLE}, strSearch);
+
     if (m_profileManager.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("SELECT musicvideo.idMVideo, musicvideo.c%02d, path.strPath FROM musicvideo INNER JOIN files ON files.idFile=musicvideo.idFile INNER JOIN path ON path.idPath=files.idPath WHERE musicvideo.c%02d LIKE '%%%s%%'", VIDEODB_ID_MUSICVIDEO_TITLE, VIDEODB_ID_MUSICVIDEO_TITLE, strSearch.c_str());
+      strSQL = StringUtils::Format("SELECT musicvideo.idMVideo, musicvideo.c%02d, path.strPath FROM musicvideo INNER JOIN files ON files.idFile=musicvideo.idFile INNER JOIN path ON path.idPath=files.idPath WHERE %s", VIDEODB_ID_MUSICVIDEO_TITLE, condition.c_str());
     else
-      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d from musicvideo where musicvideo.c%02d like '%%%s%%'",VIDEODB_ID_MUSICVIDEO_TITLE,VIDEODB_ID_MUSICVIDEO_TITLE,strSearch.c_str());
+      strSQL = StringUtils::Format("select musicvideo.idMVideo,musicvideo.c%02d from musicvideo where %s",VIDEODB_ID_MUSICVIDEO_TITLE,condition.c_str());
     m_pDS->query( strSQL );
 
     while (!m_pDS->eof())
@@ -8528,10 +8940,12 @@ void CVideoDatabase::GetEpisodesByPlot(const std::string& strSearch, CFileItemLi
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::string condition = GetSearchCondition("episode", "idEpisode", {VIDEODB_ID_EPISODE_PLOT}, strSearch);
+
     if (m_profileManager.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("SELECT episode.idEpisode, episode.c%02d, episode.c%02d, episode.idShow, tvshow.c%02d, path.strPath FROM episode INNER JOIN tvshow ON tvshow.idShow=episode.idShow INNER JOIN files ON files.idFile=episode.idFile INNER JOIN path ON path.idPath=files.idPath WHERE episode.c%02d LIKE '%%%s%%'", VIDEODB_ID_EPISODE_TITLE, VIDEODB_ID_EPISODE_SEASON, VIDEODB_ID_TV_TITLE, VIDEODB_ID_EPISODE_PLOT, strSearch.c_str());
+      strSQL = StringUtils::Format("SELECT episode.idEpisode, episode.c%02d, episode.c%02d, episode.idShow, tvshow.c%02d, path.strPath FROM episode INNER JOIN tvshow ON tvshow.idShow=episode.idShow INNER JOIN files ON files.idFile=episode.idFile INNER JOIN path ON path.idPath=files.idPath WHERE %s", VIDEODB_ID_EPISODE_TITLE, VIDEODB_ID_EPISODE_SEASON, VIDEODB_ID_TV_TITLE, condition.c_str());
     else
-      strSQL = PrepareSQL("SELECT episode.idEpisode, episode.c%02d, episode.c%02d, episode.idShow, tvshow.c%02d FROM episode INNER JOIN tvshow ON tvshow.idShow=episode.idShow WHERE episode.c%02d LIKE '%%%s%%'", VIDEODB_ID_EPISODE_TITLE, VIDEODB_ID_EPISODE_SEASON, VIDEODB_ID_TV_TITLE, VIDEODB_ID_EPISODE_PLOT, strSearch.c_str());
+      strSQL = StringUtils::Format("SELECT episode.idEpisode, episode.c%02d, episode.c%02d, episode.idShow, tvshow.c%02d FROM episode INNER JOIN tvshow ON tvshow.idShow=episode.idShow WHERE %s", VIDEODB_ID_EPISODE_TITLE, VIDEODB_ID_EPISODE_SEASON, VIDEODB_ID_TV_TITLE, condition.c_str());
     m_pDS->query( strSQL );
 
     while (!m_pDS->eof())
@@ -8567,10 +8981,12 @@ void CVideoDatabase::GetMoviesByPlot(const std::string& strSearch, CFileItemList
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::string condition = GetSearchCondition("movie", "idMovie", {VIDEODB_ID_PLOT, VIDEODB_ID_PLOTOUTLINE, VIDEODB_ID_TAGLINE}, strSearch);
+
     if (m_profileManager.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select movie.idMovie, movie.c%02d, path.strPath FROM movie INNER JOIN files ON files.idFile=movie.idFile INNER JOIN path ON path.idPath=files.idPath WHERE movie.c%02d LIKE '%%%s%%' OR movie.c%02d LIKE '%%%s%%' OR movie.c%02d LIKE '%%%s%%'", VIDEODB_ID_TITLE,VIDEODB_ID_PLOT, strSearch.c_str(), VIDEODB_ID_PLOTOUTLINE, strSearch.c_str(), VIDEODB_ID_TAGLINE,strSearch.c_str());
+      strSQL = StringUtils::Format("select movie.idMovie, movie.c%02d, path.strPath FROM movie INNER JOIN files ON files.idFile=movie.idFile INNER JOIN path ON path.idPath=files.idPath WHERE %s", VIDEODB_ID_TITLE, condition.c_str());
     else
-      strSQL = PrepareSQL("SELECT movie.idMovie, movie.c%02d FROM movie WHERE (movie.c%02d LIKE '%%%s%%' OR movie.c%02d LIKE '%%%s%%' OR movie.c%02d LIKE '%%%s%%')", VIDEODB_ID_TITLE, VIDEODB_ID_PLOT, strSearch.c_str(), VIDEODB_ID_PLOTOUTLINE, strSearch.c_str(), VIDEODB_ID_TAGLINE, strSearch.c_str());
+      strSQL = StringUtils::Format("SELECT movie.idMovie, movie.c%02d FROM movie WHERE %s", VIDEODB_ID_TITLE, condition.c_str());
 
     m_pDS->query( strSQL );
 
@@ -958,6 +958,28 @@ private:
   void CreateLinkIndex(const char *table);
   void CreateForeignLinkIndex(const char *table, const char *foreignkey);
 
+  /*! \brief Create the tables holding the episode counts of tvshows and seasons
+   */
+  void CreateShowCountsTables();
+
+  /*! \brief Create the tables holding the movie and music video counts of genres and years
+   */
+  void CreateNodeCountsTables();
+
+  /*! \brief Whether a node listing has no filters, so that it may read the materialized counts
+   */
+  static bool IsUnfiltered(const std::string& strBaseDir, const Filter& filter);
+
+  /*! \brief Get an SQL condition matching a search against columns of a media table.
+   Uses the full-text index of the table if there is one and any word starts with the
+   search, otherwise a substring match.
+   \param table media table, e.g. "movie"
+   \param key primary key of the table
+   \param columns indices of the columns to search in
+   \param search the user input to search for
+   */
+  std::string GetSearchCondition(const std::string& table, const std::string& key, const std::vector<int>& columns, const std::string& search);
+
   /*! \brief (Re)Create the generic database views for movies, tvshows,
      episodes and music videos
    */
@@ -9,6 +9,7 @@
 #include "VideoInfoScanner.h"
 
 #include <algorithm>
+#include <atomic>
 #include <utility>
 
 #include "ServiceBroker.h"
@@ -35,11 +36,14 @@
 #include "settings/Settings.h"
 #include "settings/SettingsComponent.h"
 #include "TextureCache.h"
+#include "threads/Condition.h"
+#include "threads/SingleLock.h"
 #include "threads/SystemClock.h"
 #include "URL.h"
 #include "Util.h"
 #include "utils/Digest.h"
 #include "utils/FileExtensionProvider.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 #include "utils/RegExp.h"
 #include "utils/StringUtils.h"
@@ -59,6 +63,305 @@ using KODI::UTILITY::CDigest;
 
 namespace VIDEO
 {
+  namespace
+  {
+    struct SDirectoryHashRequest
+    {
+      std::string path;
+      CONTENT_TYPE content;
+      std::string dbHash;
+      std::vector<std::string> excludes;
+    };
+
+    struct SDirectoryHashResult
+    {
+      CONTENT_TYPE content = CONTENT_NONE;
+      std::string fastHash;
+      std::string hash;
+      bool listed = false;  ///< whether items holds the listing of the directory
+      CFileItemList items;
+    };
+
+    /*!
+     \brief Job doing the directory listing and hashing of CVideoInfoScanner::DoScan()
+     */
+    class CDirectoryHashJob : public CJob
+    {
+    public:
+      CDirectoryHashJob(CDirectoryHasher &hasher, SDirectoryHashRequest request)
+        : m_hasher(hasher), m_request(std::move(request)), m_result(new SDirectoryHashResult) {}
+      ~CDirectoryHashJob() override;
+
+      bool DoWork() override;
+
+      const char *GetType() const override { return "videodirectoryhash"; }
+
+      const std::string &GetPath() const { return m_request.path; }
+      std::unique_ptr<SDirectoryHashResult> TakeResult() { return std::move(m_result); }
+
+    private:
+      CDirectoryHasher &m_hasher;
+      SDirectoryHashRequest m_request;
+      std::unique_ptr<SDirectoryHashResult> m_result;
+    };
+  }
+
+  /*!
+   \brief Lists and hashes directories on job workers ahead of CVideoInfoScanner::DoScan().
+
+   On network shares the hash checks of a rescan mostly wait on round trips, so a bounded number
+   of directories are examined at once. Directories are worked on in the order they were queued,
+   and at most a few results per worker are kept waiting for the scanner.
+
+   Jobs are added and cancelled without holding m_hashSection, the job manager calls back into
+   us and deletes jobs with its own lock held.
+   */
+  class CDirectoryHasher : public CJobQueue
+  {
+  public:
+    CDirectoryHasher(const CVideoInfoScanner &scanner, unsigned int threads)
+      : CJobQueue(false, threads, CJob::PRIORITY_DEDICATED), m_scanner(scanner), m_threads(threads), m_window(threads * 4) {}
+
+    ~CDirectoryHasher() override
+    {
+      {
+        CSingleLock lock(m_hashSection);
+        m_stopping = true;
+        m_pending.clear();
+      }
+
+      // jobs refer to us until they are deleted, which the job manager does
+      // whether they completed or were cancelled
+      CancelJobs();
+      CSingleLock lock(m_hashSection);
+      while (m_running > m_cancelled)
+        m_resultReady.wait(lock, 100);
+    }
+
+    void Queue(SDirectoryHashRequest request, bool front)
+    {
+      std::vector<SDirectoryHashRequest> start;
+      {
+        CSingleLock lock(m_hashSection);
+        if (!m_queued.insert(request.path).second)
+        {
+          // already queued, but may be needed sooner now
+          auto it = std::find_if(m_pending.begin(), m_pending.end(), [&request](const SDirectoryHashRequest &pending)
+                                 { return pending.path == request.path; });
+          if (front && it != m_pending.end())
+          {
+            SDirectoryHashRequest moved = std::move(*it);
+            m_pending.erase(it);
+            m_pending.push_front(std::move(moved));
+          }
+          return;
+        }
+
+        if (front)
+          m_pending.push_front(std::move(request));
+        else
+          m_pending.push_back(std::move(request));
+        start = Dispatch();
+      }
+      AddJobs(start);
+    }
+
+    /*!
+     \brief Get the listing and hashes of a queued directory, waiting for them if need be.
+     \param path the directory.
+     \param stop set when the scan is cancelled.
+     \return the result, or nullptr if the directory was not queued, not started yet, dropped or the scan was cancelled.
+     */
+    std::unique_ptr<SDirectoryHashResult> Take(const std::string &path, const bool &stop)
+    {
+      std::unique_ptr<SDirectoryHashResult> hashes;
+      std::vector<SDirectoryHashRequest> start;
+      {
+        CSingleLock lock(m_hashSection);
+        if (m_queued.find(path) == m_queued.end())
+          return nullptr;
+
+        m_taken++;
+        DropStaleResults();
+
+        // not started yet, the scanner may as well do it itself
+        auto pending = std::find_if(m_pending.begin(), m_pending.end(), [&path](const SDirectoryHashRequest &request)
+                                    { return request.path == path; });
+        if (pending != m_pending.end())
+        {
+          m_pending.erase(pending);
+          m_queued.erase(path);
+          start = Dispatch();
+        }
+        else
+        {
+          auto result = m_results.find(path);
+          while (result == m_results.end())
+          {
+            // dropped while we waited
+            if (stop || m_queued.find(path) == m_queued.end())
+              return nullptr;
+            m_resultReady.wait(lock, 100);
+            result = m_results.find(path);
+          }
+
+          hashes = std::move(result->second.result);
+          m_results.erase(result);
+          m_queued.erase(path);
+          start = Dispatch();
+        }
+      }
+      AddJobs(start);
+      return hashes;
+    }
+
+    /*!
+     \brief Do the listing and hashing of a directory as DoScan() would.
+     */
+    void HashDirectory(const SDirectoryHashRequest &request, SDirectoryHashResult &result) const
+    {
+      const std::string &path = request.path;
+      result.content = request.content;
+      if (request.content == CONTENT_TVSHOWS)
+      {
+        CDirectory::GetDirectory(path, result.items, CServiceBroker::GetFileExtensionProvider().GetVideoExtensions(),
+                                 DIR_FLAG_DEFAULTS);
+        result.items.SetPath(path);
+        CVideoInfoScanner::GetPathHash(result.items, result.hash);
+        result.listed = true;
+        return;
+      }
+
+      if (CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_bVideoLibraryUseFastHash)
+        result.fastHash = m_scanner.GetFastHash(path, request.excludes);
+
+      if (!result.fastHash.empty() && StringUtils::EqualsNoCase(result.fastHash, request.dbHash))
+      {
+        result.hash = result.fastHash;
+        return;
+      }
+
+      CDirectory::GetDirectory(path, result.items, CServiceBroker::GetFileExtensionProvider().GetVideoExtensions(),
+                               DIR_FLAG_DEFAULTS);
+      result.items.Stack();
+      if (!m_scanner.CanFastHash(result.items, request.excludes) || result.fastHash.empty())
+        CVideoInfoScanner::GetPathHash(result.items, result.hash);
+      else
+        result.hash = result.fastHash;
+      result.listed = true;
+    }
+
+    void OnJobComplete(unsigned int jobID, bool success, CJob *job) override
+    {
+      std::vector<SDirectoryHashRequest> start;
+      {
+        CSingleLock lock(m_hashSection);
+        CDirectoryHashJob *hashJob = static_cast<CDirectoryHashJob*>(job);
+        std::unique_ptr<SDirectoryHashResult> result = hashJob->TakeResult();
+        m_running--;
+
+        // a directory that was taken or dropped meanwhile has no use for its result
+        if (!m_stopping && m_queued.find(hashJob->GetPath()) != m_queued.end())
+          m_results[hashJob->GetPath()] = { std::move(result), m_taken };
+
+        if (!m_stopping)
+          start = Dispatch();
+      }
+      CJobQueue::OnJobComplete(jobID, success, job);
+      AddJobs(start);
+      m_resultReady.notifyAll();
+    }
+
+    /*!
+     \brief Called by jobs that are deleted without being completed, with the lock of the job manager held.
+     */
+    void OnJobCancelled()
+    {
+      m_cancelled++;
+      m_resultReady.notifyAll();
+    }
+
+  private:
+    struct SStoredResult
+    {
+      std::unique_ptr<SDirectoryHashResult> result;
+      unsigned int taken; ///< directories taken by the scanner before the result was stored
+    };
+
+    /*!
+     \brief Pick the requests to start next, to be added with AddJobs() after releasing the lock.
+     */
+    std::vector<SDirectoryHashRequest> Dispatch()
+    {
+      std::vector<SDirectoryHashRequest> start;
+      unsigned int running = m_running - m_cancelled;
+      while (running < m_threads && running + m_results.size() < m_window && !m_pending.empty())
+      {
+        start.push_back(std::move(m_pending.front()));
+        m_pending.pop_front();
+        running++;
+        m_running++;
+      }
+      return start;
+    }
+
+    void AddJobs(std::vector<SDirectoryHashRequest> &requests)
+    {
+      for (auto &request : requests)
+        AddJob(new CDirectoryHashJob(*this, std::move(request)));
+    }
+
+    /*!
+     \brief Results the scanner didn't take while it took a window of other directories
+     won't be asked for anymore, e.g. because DoScan() skipped their parent.
+     The scanner does such directories itself if it comes back to them after all.
+     */
+    void DropStaleResults()
+    {
+      for (auto it = m_results.begin(); it != m_results.end(); )
+      {
+        if (m_taken - it->second.taken > m_window)
+        {
+          m_queued.erase(it->first);
+          it = m_results.erase(it);
+        }
+        else
+          ++it;
+      }
+    }
+
+    const CVideoInfoScanner &m_scanner;
+    const unsigned int m_threads;
+    const unsigned int m_window;
+    unsigned int m_running = 0;  ///< jobs added and not completed, including cancelled ones
+    std::atomic<unsigned int> m_cancelled{0};  ///< jobs deleted without completing
+    unsigned int m_taken = 0;    ///< directories taken by the scanner
+    bool m_stopping = false;
+    std::deque<SDirectoryHashRequest> m_pending;
+    std::set<std::string> m_queued;
+    std::map<std::string, SStoredResult> m_results;
+    CCriticalSection m_hashSection;
+    XbmcThreads::ConditionVariable m_resultReady;
+  };
+
+  namespace
+  {
+    CDirectoryHashJob::~CDirectoryHashJob()
+    {
+      // the result is taken when the job completes
+      if (m_result)
+        m_hasher.OnJobCancelled();
+    }
+
+    bool CDirectoryHashJob::DoWork()
+    {
+      if (ShouldCancel(0, 0))
+        return false;
+
+      m_hasher.HashDirectory(m_request, *m_result);
+      return true;
+    }
+  }
 
   CVideoInfoScanner::CVideoInfoScanner()
   {
@@ -112,6 +415,15 @@ namespace VIDEO
       // result in unexpected behaviour.
       m_bCanInterrupt = false;
 
+      // Work out the directory hashes ahead of the scan so that unchanged folders are skipped quickly
+      const int scanThreads = CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_iVideoLibraryScanThreads;
+      if (scanThreads > 1)
+      {
+        m_directoryHasher.reset(new CDirectoryHasher(*this, scanThreads));
+        for (const auto &path : m_pathsToScan)
+          QueueDirectoryHash(path);
+      }
+
       bool bCancelled = false;
       while (!bCancelled && !m_pathsToScan.empty())
       {
@@ -135,10 +447,13 @@ namespace VIDEO
            */
           CLog::Log(LOGWARNING, "%s directory '%s' does not exist - skipping scan%s.", __FUNCTION__, CURL::GetRedacted(directory).c_str(), m_bClean ? " and clean" : "");
           m_pathsToScan.erase(m_pathsToScan.begin());
+          if (m_directoryHasher)
+            m_directoryHasher->Take(directory, m_bStop);
         }
         else if (!DoScan(directory))
           bCancelled = true;
       }
+      m_directoryHasher.reset();
 
       if (!bCancelled)
       {
@@ -162,6 +477,7 @@ namespace VIDEO
     {
       CLog::Log(LOGERROR, "VideoInfoScanner: Exception while scanning.");
     }
+    m_directoryHasher.reset();
 
     m_bRunning = false;
     CServiceBroker::GetAnnouncementManager()->Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnScanFinished");
@@ -239,6 +555,11 @@ namespace VIDEO
     if (it != m_pathsToScan.end())
       m_pathsToScan.erase(it);
 
+    // pick up the listing and hashes worked out ahead, if any
+    std::unique_ptr<SDirectoryHashResult> prefetched;
+    if (m_directoryHasher)
+      prefetched = m_directoryHasher->Take(strDirectory, m_bStop);
+
     // load subfolder
     CFileItemList items;
     bool foundDirectly = false;
@@ -247,6 +568,8 @@ namespace VIDEO
     SScanSettings settings;
     ScraperPtr info = m_database.GetScraperForPath(strDirectory, settings, foundDirectly);
     CONTENT_TYPE content = info ? info->Content() : CONTENT_NONE;
+    if (prefetched && prefetched->content != content)
+      prefetched.reset();
 
     // exclude folders that match our exclude regexps
     const std::vector<std::string> &regexps = content == CONTENT_TVSHOWS ? CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_tvshowExcludeFromScanRegExps
@@ -278,13 +601,20 @@ namespace VIDEO
       }
 
       std::string fastHash;
-      if (CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_bVideoLibraryUseFastHash && !URIUtils::IsPlugin(strDirectory))
+      if (prefetched)
+        fastHash = prefetched->fastHash;
+      else if (CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_bVideoLibraryUseFastHash && !URIUtils::IsPlugin(strDirectory))
         fastHash = GetFastHash(strDirectory, regexps);
 
       if (m_database.GetPathHash(strDirectory, dbHash) && !fastHash.empty() && StringUtils::EqualsNoCase(fastHash, dbHash))
       { // fast hashes match - no need to process anything
         hash = fastHash;
       }
+      else if (prefetched && prefetched->listed)
+      { // folder already fetched
+        items.Assign(prefetched->items);
+        hash = prefetched->hash;
+      }
       else
       { // need to fetch the folder
         CDirectory::GetDirectory(strDirectory, items, CServiceBroker::GetFileExtensionProvider().GetVideoExtensions(),
@@ -326,10 +656,18 @@ namespace VIDEO
 
       if (foundDirectly && !settings.parent_name_root)
       {
-        CDirectory::GetDirectory(strDirectory, items, CServiceBroker::GetFileExtensionProvider().GetVideoExtensions(),
-                                 DIR_FLAG_DEFAULTS);
-        items.SetPath(strDirectory);
-        GetPathHash(items, hash);
+        if (prefetched && prefetched->listed)
+        {
+          items.Assign(prefetched->items);
+          hash = prefetched->hash;
+        }
+        else
+        {
+          CDirectory::GetDirectory(strDirectory, items, CServiceBroker::GetFileExtensionProvider().GetVideoExtensions(),
+                                   DIR_FLAG_DEFAULTS);
+          items.SetPath(strDirectory);
+          GetPathHash(items, hash);
+        }
         bSkip = true;
         if (!m_database.GetPathHash(strDirectory, dbHash) || !StringUtils::EqualsNoCase(dbHash, hash))
           bSkip = false;
@@ -373,6 +711,17 @@ namespace VIDEO
     if (m_handle)
       OnDirectoryScanned(strDirectory);
 
+    // the subfolders are scanned next, in order
+    if (m_directoryHasher && settings.recurse > 0 && content != CONTENT_TVSHOWS)
+    {
+      for (int i = items.Size() - 1; i >= 0; --i)
+      {
+        const CFileItemPtr &pItem = items[i];
+        if (pItem->m_bIsFolder && !pItem->IsParentFolder() && !pItem->IsPlayList())
+          QueueDirectoryHash(pItem->GetPath(), true);
+      }
+    }
+
     for (int i = 0; i < items.Size(); ++i)
     {
       CFileItemPtr pItem = items[i];
@@ -393,6 +742,39 @@ namespace VIDEO
     return !m_bStop;
   }
 
+  void CVideoInfoScanner::QueueDirectoryHash(const std::string& strDirectory, bool front /* = false */)
+  {
+    // plugins are not listed off the scanner thread
+    if (URIUtils::IsPlugin(strDirectory))
+      return;
+
+    SScanSettings settings;
+    bool foundDirectly = false;
+    ScraperPtr info = m_database.GetScraperForPath(strDirectory, settings, foundDirectly);
+    CONTENT_TYPE content = info ? info->Content() : CONTENT_NONE;
+    if (!m_scanAll && settings.noupdate)
+      return;
+    if (content == CONTENT_TVSHOWS)
+    {
+      // only shows found directly are hashed by DoScan()
+      if (!foundDirectly || settings.parent_name_root)
+        return;
+    }
+    else if (content != CONTENT_MOVIES && content != CONTENT_MUSICVIDEOS)
+      return;
+
+    SDirectoryHashRequest request;
+    request.excludes = content == CONTENT_TVSHOWS ? CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_tvshowExcludeFromScanRegExps
+                                                  : CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_moviesExcludeFromScanRegExps;
+    if (CUtil::ExcludeFileOrFolder(strDirectory, request.excludes))
+      return;
+
+    request.path = strDirectory;
+    request.content = content;
+    m_database.GetPathHash(strDirectory, request.dbHash);
+    m_directoryHasher->Queue(std::move(request), front);
+  }
+
   bool CVideoInfoScanner::RetrieveVideoInfo(CFileItemList& items, bool bDirNames, CONTENT_TYPE content, bool useLocal, CScraperUrl* pURL, bool fetchEpisodes, CGUIDialogProgress* pDlgProgress)
   {
     if (pDlgProgress)
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -23,6 +24,7 @@ class CFileItemList;
 namespace VIDEO
 {
   class IVideoInfoTagLoader;
+  class CDirectoryHasher;
 
   typedef struct SScanSettings
   {
@@ -36,6 +38,8 @@ namespace VIDEO
 
   class CVideoInfoScanner : public CInfoScanner
   {
+    friend class CDirectoryHasher;
+
   public:
     CVideoInfoScanner();
     ~CVideoInfoScanner() override;
@@ -225,12 +229,20 @@ namespace VIDEO
     bool EnumerateSeriesFolder(CFileItem* item, EPISODELIST& episodeList);
     bool ProcessItemByVideoInfoTag(const CFileItem *item, EPISODELIST &episodeList);
 
+    /*! \brief Queue a directory to be listed and hashed on a worker thread ahead of DoScan().
+     Does nothing if DoScan() would not hash the directory.
+     \param strDirectory the directory to queue.
+     \param front whether to work on this directory before those already queued.
+     */
+    void QueueDirectoryHash(const std::string& strDirectory, bool front = false);
+
     bool m_bStop;
     bool m_scanAll;
     std::string m_strStartDir;
     CVideoDatabase m_database;
     std::set<std::string> m_pathsToCount;
     std::set<int> m_pathsToClean;
+    std::unique_ptr<CDirectoryHasher> m_directoryHasher;
   };
 }
 
@@ -0,0 +1,209 @@
+/*
+ *  Copyright (C) 2019 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "settings/AdvancedSettings.h"
+#include "utils/StringUtils.h"
+#include "video/VideoDatabase.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+const char* TestDatabaseName = "TestVideoDatabase";
+const char* TestDatabaseFile = "special://temp/TestVideoDatabase.db";
+}
+
+/*!
+ The tvshow, season, genre and year counts are kept up to date by triggers.
+ After every change they have to match the counts the views used to compute
+ with COUNT() over the whole library.
+ */
+class TestVideoDatabase : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    XFILE::CFile::Delete(TestDatabaseFile);
+
+    DatabaseSettings settings;
+    settings.type = "sqlite3";
+    settings.host = CSpecialProtocol::TranslatePath("special://temp/");
+    ASSERT_TRUE(database.Connect(TestDatabaseName, settings, true));
+  }
+
+  void TearDown() override
+  {
+    database.Close();
+    XFILE::CFile::Delete(TestDatabaseFile);
+  }
+
+  void Execute(const std::string& sql)
+  {
+    ASSERT_TRUE(database.ExecuteQuery(sql)) << sql;
+  }
+
+  /*! \brief All rows of a query selecting a single column r, joined by ';'.
+   */
+  std::string Rows(const std::string& query)
+  {
+    return database.GetSingleValue("SELECT GROUP_CONCAT(r, ';') FROM (" + query + ")");
+  }
+
+  std::string ShowCounts()
+  {
+    return Rows("SELECT idShow || ',' || totalCount || ',' || watchedcount || ',' || totalSeasons || ',' ||"
+                "  COALESCE(lastPlayed, '') || ',' || COALESCE(dateAdded, '') AS r "
+                "FROM tvshowcounts ORDER BY idShow");
+  }
+
+  std::string ExpectedShowCounts()
+  {
+    return Rows(StringUtils::Format("SELECT tvshow.idShow || ',' || COUNT(episode.idEpisode) || ',' ||"
+                                    "  COUNT(files.playCount) || ',' || COUNT(DISTINCT episode.c%02d) || ',' ||"
+                                    "  COALESCE(MAX(files.lastPlayed), '') || ',' || COALESCE(MAX(files.dateAdded), '') AS r "
+                                    "FROM tvshow"
+                                    "  LEFT JOIN episode ON episode.idShow=tvshow.idShow"
+                                    "  LEFT JOIN files ON files.idFile=episode.idFile "
+                                    "GROUP BY tvshow.idShow ORDER BY tvshow.idShow",
+                                    VIDEODB_ID_EPISODE_SEASON));
+  }
+
+  std::string SeasonCounts()
+  {
+    return Rows("SELECT idSeason || ',' || episodes || ',' || playCount || ',' || COALESCE(aired, '') AS r "
+                "FROM seasoncounts ORDER BY idSeason");
+  }
+
+  std::string ExpectedSeasonCounts()
+  {
+    return Rows(StringUtils::Format("SELECT seasons.idSeason || ',' || COUNT(episode.idEpisode) || ',' ||"
+                                    "  COUNT(files.playCount) || ',' || COALESCE(MIN(episode.c%02d), '') AS r "
+                                    "FROM seasons"
+                                    "  LEFT JOIN episode ON episode.idSeason=seasons.idSeason"
+                                    "  LEFT JOIN files ON files.idFile=episode.idFile "
+                                    "GROUP BY seasons.idSeason ORDER BY seasons.idSeason",
+                                    VIDEODB_ID_EPISODE_AIRED));
+  }
+
+  std::string GenreCounts()
+  {
+    return Rows("SELECT genre_id || ',' || media_type || ',' || total || ',' || watched AS r "
+                "FROM genrecounts WHERE total<>0 OR watched<>0 ORDER BY genre_id, media_type");
+  }
+
+  std::string ExpectedGenreCounts()
+  {
+    return Rows("SELECT genre_id || ',' || media_type || ',' || COUNT(1) || ',' || COUNT(playCount) AS r FROM ("
+                "  SELECT genre_link.genre_id, genre_link.media_type, files.playCount FROM genre_link"
+                "    JOIN movie ON movie.idMovie=genre_link.media_id"
+                "    LEFT JOIN files ON files.idFile=movie.idFile"
+                "  WHERE genre_link.media_type='movie'"
+                "  UNION ALL"
+                "  SELECT genre_link.genre_id, genre_link.media_type, files.playCount FROM genre_link"
+                "    JOIN musicvideo ON musicvideo.idMVideo=genre_link.media_id"
+                "    LEFT JOIN files ON files.idFile=musicvideo.idFile"
+                "  WHERE genre_link.media_type='musicvideo') "
+                "GROUP BY genre_id, media_type ORDER BY genre_id, media_type");
+  }
+
+  std::string YearCounts()
+  {
+    return Rows("SELECT year || ',' || media_type || ',' || total || ',' || watched AS r "
+                "FROM yearcounts WHERE total<>0 OR watched<>0 ORDER BY year, media_type");
+  }
+
+  std::string ExpectedYearCounts()
+  {
+    return Rows("SELECT year || ',' || media_type || ',' || COUNT(1) || ',' || COUNT(playCount) AS r FROM ("
+                "  SELECT COALESCE(SUBSTR(movie.premiered, 1, 4), '') AS year, 'movie' AS media_type, files.playCount"
+                "  FROM movie LEFT JOIN files ON files.idFile=movie.idFile"
+                "  UNION ALL"
+                "  SELECT COALESCE(SUBSTR(musicvideo.premiered, 1, 4), '') AS year, 'musicvideo' AS media_type, files.playCount"
+                "  FROM musicvideo LEFT JOIN files ON files.idFile=musicvideo.idFile) "
+                "GROUP BY year, media_type ORDER BY year, media_type");
+  }
+
+  void ExpectCounts(const char* step)
+  {
+    SCOPED_TRACE(step);
+    EXPECT_EQ(ExpectedShowCounts(), ShowCounts());
+    EXPECT_EQ(ExpectedSeasonCounts(), SeasonCounts());
+    EXPECT_EQ(ExpectedGenreCounts(), GenreCounts());
+    EXPECT_EQ(ExpectedYearCounts(), YearCounts());
+  }
+
+  void InsertEpisode(int idEpisode, int idFile, int idShow, int idSeason, int season, const char* aired)
+  {
+    Execute(StringUtils::Format("INSERT INTO episode (idEpisode, idFile, idShow, idSeason, c%02d, c%02d) "
+                                "VALUES (%d, %d, %d, %d, '%d', '%s')",
+                                VIDEODB_ID_EPISODE_SEASON, VIDEODB_ID_EPISODE_AIRED,
+                                idEpisode, idFile, idShow, idSeason, season, aired));
+  }
+
+  CVideoDatabase database;
+};
+
+TEST_F(TestVideoDatabase, CountsFollowLibraryChanges)
+{
+  Execute("INSERT INTO genre (genre_id, name) VALUES (1, 'Action')");
+  Execute("INSERT INTO genre (genre_id, name) VALUES (2, 'Drama')");
+  Execute("INSERT INTO path (idPath, strPath) VALUES (1, '/videos/')");
+  for (int idFile = 1; idFile <= 8; idFile++)
+    Execute(StringUtils::Format("INSERT INTO files (idFile, idPath, strFilename, dateAdded) "
+                                "VALUES (%d, 1, '%d.mkv', '2020-01-0%d 00:00:00')",
+                                idFile, idFile, idFile));
+
+  Execute("INSERT INTO movie (idMovie, idFile, premiered) VALUES (1, 1, '2001-05-01')");
+  Execute("INSERT INTO movie (idMovie, idFile, premiered) VALUES (2, 2, '2001-07-01')");
+  Execute("INSERT INTO movie (idMovie, idFile, premiered) VALUES (3, 3, '2005-01-01')");
+  Execute("INSERT INTO genre_link (genre_id, media_id, media_type) VALUES (1, 1, 'movie')");
+  Execute("INSERT INTO genre_link (genre_id, media_id, media_type) VALUES (2, 1, 'movie')");
+  Execute("INSERT INTO genre_link (genre_id, media_id, media_type) VALUES (1, 2, 'movie')");
+  Execute("INSERT INTO genre_link (genre_id, media_id, media_type) VALUES (2, 3, 'movie')");
+  Execute("INSERT INTO musicvideo (idMVideo, idFile, premiered) VALUES (1, 4, '2001-01-01')");
+  Execute("INSERT INTO genre_link (genre_id, media_id, media_type) VALUES (1, 1, 'musicvideo')");
+
+  Execute("INSERT INTO tvshow (idShow) VALUES (1)");
+  Execute("INSERT INTO tvshow (idShow) VALUES (2)");
+  Execute("INSERT INTO seasons (idSeason, idShow, season) VALUES (1, 1, 1)");
+  Execute("INSERT INTO seasons (idSeason, idShow, season) VALUES (2, 1, 2)");
+  Execute("INSERT INTO seasons (idSeason, idShow, season) VALUES (3, 2, 1)");
+  InsertEpisode(1, 5, 1, 1, 1, "2010-01-01");
+  InsertEpisode(2, 6, 1, 1, 1, "2010-01-08");
+  InsertEpisode(3, 7, 1, 2, 2, "2011-01-01");
+  InsertEpisode(4, 8, 2, 3, 1, "2012-01-01");
+  ExpectCounts("insert");
+
+  Execute("UPDATE files SET playCount=1, lastPlayed='2020-02-01 00:00:00' WHERE idFile IN (1, 4, 5, 7)");
+  ExpectCounts("watched");
+  // make sure the comparison isn't between two empty results
+  EXPECT_EQ("1,3,2,2,2020-02-01 00:00:00,2020-01-07 00:00:00;2,1,0,1,,2020-01-08 00:00:00", ShowCounts());
+  EXPECT_EQ("1,movie,2,1;1,musicvideo,1,1;2,movie,2,1", GenreCounts());
+
+  // links, years and seasons that change after the media was watched
+  Execute("INSERT INTO genre_link (genre_id, media_id, media_type) VALUES (2, 2, 'movie')");
+  Execute("UPDATE movie SET premiered='2005-03-01' WHERE idMovie=2");
+  Execute("UPDATE movie SET premiered='2002-03-01' WHERE idMovie=1");
+  Execute(StringUtils::Format("UPDATE episode SET idSeason=2, c%02d='2' WHERE idEpisode=2", VIDEODB_ID_EPISODE_SEASON));
+  ExpectCounts("update");
+
+  Execute("DELETE FROM episode WHERE idEpisode=1");
+  Execute("DELETE FROM movie WHERE idMovie=1");
+  Execute("DELETE FROM files WHERE idFile=7");
+  Execute("UPDATE files SET playCount=NULL, lastPlayed=NULL WHERE idFile=4");
+  Execute("DELETE FROM genre_link WHERE media_id=3 AND media_type='movie'");
+  ExpectCounts("delete");
+
+  Execute("DELETE FROM episode WHERE idShow=1");
+  ExpectCounts("delete show episodes");
+  EXPECT_EQ("1,0,0,0,,;2,1,0,1,,2020-01-08 00:00:00", ShowCounts());
+}
@@ -75,6 +75,12 @@
 
 #define PLUGIN_REFRESH_DELAY 200
 
+// time the focus has to stay on an item before the folders around it are prefetched
+#define PREFETCH_DELAY 300
+
+// maximum number of folders prefetched for a focused item
+#define PREFETCH_MAX_DIRS 3
+
 using namespace ADDON;
 using namespace KODI::MESSAGING;
 
@@ -250,6 +256,9 @@ bool CGUIMediaWindow::OnMessage(CGUIMessage& message)
   case GUI_MSG_WINDOW_DEINIT:
     {
       CancelUpdateItems();
+      m_prefetcher.Cancel();
+      m_prefetchFocus.clear();
+      m_prefetchTimer.Stop();
 
       m_iLastControl = GetFocusedControlID();
       CGUIWindow::OnMessage(message);
@@ -1293,6 +1302,12 @@ void CGUIMediaWindow::SaveSelectedItemInHistory()
   {
     CFileItemPtr pItem = m_vecItems->Get(iItem);
     GetDirectoryHistoryString(pItem.get(), strSelectedItem);
+
+    // remembered for prefetching, the history only knows how to find the item again
+    if (pItem->m_bIsFolder && !pItem->IsParentFolder())
+      m_selectedFolders[m_vecItems->GetPath()] = pItem->GetPath();
+    else
+      m_selectedFolders.erase(m_vecItems->GetPath());
   }
 
   m_history.SetSelectedItem(strSelectedItem, m_vecItems->GetPath());
@@ -1687,6 +1702,65 @@ void CGUIMediaWindow::OnInitWindow()
   CGUIWindow::OnInitWindow();
 }
 
+void CGUIMediaWindow::FrameMove()
+{
+  if (CServiceBroker::GetSettingsComponent()->GetAdvancedSettings()->m_directoryPrefetch)
+  {
+    // restart the timer whenever the focus moves, prefetch once it settled
+    CFileItemPtr focused = GetCurrentListItem();
+    const std::string focus = focused ? focused->GetPath() : "";
+    if (focus != m_prefetchFocus)
+    {
+      m_prefetchFocus = focus;
+      m_prefetcher.Cancel();
+      m_prefetchTimer.StartZero();
+    }
+    else if (m_prefetchTimer.IsRunning() && m_prefetchTimer.GetElapsedMilliseconds() > PREFETCH_DELAY)
+    {
+      m_prefetchTimer.Stop();
+      PrefetchDirectories();
+    }
+  }
+
+  CGUIWindow::FrameMove();
+}
+
+void CGUIMediaWindow::PrefetchDirectories()
+{
+  if (m_vecItemsUpdating || m_updateJobActive)
+    return;
+
+  const int focused = m_viewControl.GetSelectedItem();
+  if (focused < 0 || focused >= m_vecItems->Size())
+    return;
+
+  // the focused folder first, then the folder opened last time from it,
+  // then the folders next to it in the direction the user is likely to scroll
+  std::vector<std::string> paths;
+  const auto addFolder = [&paths](const CFileItemPtr& item)
+  {
+    if (item && item->m_bIsFolder && !item->IsParentFolder() && paths.size() < PREFETCH_MAX_DIRS &&
+        std::find(paths.begin(), paths.end(), item->GetPath()) == paths.end())
+      paths.push_back(item->GetPath());
+  };
+
+  const CFileItemPtr item = m_vecItems->Get(focused);
+  addFolder(item);
+
+  if (item->m_bIsFolder && !item->IsParentFolder())
+  {
+    const auto lastSelected = m_selectedFolders.find(item->GetPath());
+    if (lastSelected != m_selectedFolders.end() && paths.size() < PREFETCH_MAX_DIRS &&
+        std::find(paths.begin(), paths.end(), lastSelected->second) == paths.end())
+      paths.push_back(lastSelected->second);
+  }
+
+  addFolder(m_vecItems->Get(focused + 1));
+  addFolder(m_vecItems->Get(focused - 1));
+
+  m_prefetcher.Prefetch(paths);
+}
+
 void CGUIMediaWindow::SaveControlStates()
 {
   CGUIWindow::SaveControlStates();
@@ -2202,9 +2276,14 @@ bool CGUIMediaWindow::ProcessRenderLoop(bool renderOnly)
 
 bool CGUIMediaWindow::GetDirectoryItems(CURL &url, CFileItemList &items, bool useDir)
 {
+  // a prefetched listing is only served from the directory cache when asked for
+  const int flags = m_rootDir.GetFlags();
+  if (m_prefetcher.WasPrefetched(url.Get()))
+    m_rootDir.SetFlags(flags | XFILE::DIR_FLAG_READ_CACHE);
+
+  bool ret = true;
   if (m_backgroundLoad)
   {
-    bool ret = true;
     CGetDirectoryItems getItems(m_rootDir, url, items, useDir);
 
     if (!WaitGetDirectoryItems(getItems))
@@ -2226,12 +2305,14 @@ bool CGUIMediaWindow::GetDirectoryItems(CURL &url, CFileItemList &items, bool us
 
     m_updateJobActive = false;
     m_rootDir.ReleaseDirImpl();
-    return ret;
   }
   else
   {
-    return m_rootDir.GetDirectory(url, items, useDir, false);
+    ret = m_rootDir.GetDirectory(url, items, useDir, false);
   }
+
+  m_rootDir.SetFlags(flags);
+  return ret;
 }
 
 bool CGUIMediaWindow::WaitGetDirectoryItems(CGetDirectoryItems &items)
@@ -10,12 +10,15 @@
 
 #include "dialogs/GUIDialogContextMenu.h"
 #include "filesystem/DirectoryHistory.h"
+#include "filesystem/DirectoryPrefetcher.h"
 #include "filesystem/VirtualDirectory.h"
 #include "guilib/GUIWindow.h"
 #include "playlists/SmartPlayList.h"
+#include "utils/Stopwatch.h"
 #include "view/GUIViewControl.h"
 
 #include <atomic>
+#include <map>
 
 class CFileItemList;
 class CGUIViewState;
@@ -40,6 +43,7 @@ public:
   void OnWindowLoaded() override;
   void OnWindowUnload() override;
   void OnInitWindow() override;
+  void FrameMove() override;
   bool IsMediaWindow() const  override { return true; }
   int GetViewContainerID() const  override { return m_viewControl.GetCurrentControl(); }
   int GetViewCount() const  override { return m_viewControl.GetViewModeCount(); };
@@ -163,6 +167,11 @@ protected:
   bool WaitGetDirectoryItems(CGetDirectoryItems &items);
   void CancelUpdateItems();
 
+  /*! \brief Prefetches the folders the user is likely to open next from the focused item
+   and the directory history
+   */
+  void PrefetchDirectories();
+
   /*! \brief Translate the folder to start in from the given quick path
    \param url the folder the user wants
    \return the resulting path */
@@ -184,6 +193,10 @@ protected:
   CFileItemList* m_vecItems;
   CFileItemList* m_unfilteredItems;        ///< \brief items prior to filtering using FilterItems()
   CDirectoryHistory m_history;
+  XFILE::CDirectoryPrefetcher m_prefetcher;
+  std::string m_prefetchFocus;  ///< path of the item the prefetch timer was started for
+  std::map<std::string, std::string> m_selectedFolders; ///< folder selected last in a listing, by path of the listing
+  CStopWatch m_prefetchTimer;
   std::unique_ptr<CGUIViewState> m_guiState;
   std::atomic_bool m_vecItemsUpdating = {false};
   class CUpdateGuard